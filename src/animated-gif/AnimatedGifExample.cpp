@@ -27,14 +27,9 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-#include <Corrade/Containers/ArrayView.h>
-#include <Corrade/Containers/Optional.h>
-#include <Corrade/PluginManager/Manager.h>
 #include <Corrade/Utility/Arguments.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Timeline.h>
-#include <Magnum/Animation/Track.h>
-#include <Magnum/Animation/Player.h>
 #include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Mesh.h>
@@ -46,10 +41,10 @@
 #include <Magnum/Platform/Sdl2Application.h>
 #include <Magnum/Primitives/Square.h>
 #include <Magnum/Shaders/FlatGL.h>
-#include <Magnum/Trade/AbstractImporter.h>
-#include <Magnum/Trade/ImageData.h>
 #include <Magnum/Trade/MeshData.h>
 
+#include "FrameDecoder.h"
+
 namespace Magnum { namespace Examples {
 
 class AnimatedGifExample: public Platform::Application {
@@ -62,17 +57,20 @@ class AnimatedGifExample: public Platform::Application {
         void drawEvent() override;
         void tickEvent() override;
 
+        void uploadFrame(const FrameDecoder::Frame& frame);
+
         GL::Mesh _mesh{NoCreate};
         Shaders::FlatGL2D _shader{Shaders::FlatGL2D::Configuration{}
-            .setFlags(Shaders::FlatGL2D::Flag::Textured|
-                      Shaders::FlatGL2D::Flag::TextureTransformation)};
+            .setFlags(Shaders::FlatGL2D::Flag::Textured)};
+        /* Holds just the frame that's currently shown */
         GL::Texture2D _texture;
-        Vector2i _gridSize, _imageSize;
 
-        Animation::Track<Float, Int> _frames;
-        Animation::Player<Float> _player;
+        FrameDecoder _decoder;
         Timeline _timeline;
-        Int _currentFrame = ~Int{};
+        /* Time at which the next frame should be shown and, while paused,
+           how much of the current frame was left */
+        Float _nextFrameTime{}, _pausedRemaining{};
+        bool _paused = false;
 };
 
 AnimatedGifExample::AnimatedGifExample(const Arguments& arguments):
@@ -84,40 +82,27 @@ AnimatedGifExample::AnimatedGifExample(const Arguments& arguments):
     args.addArgument("file").setHelp("file", "GIF to load", "file.gif")
         .addOption("importer", "StbImageImporter")
             .setHelp("importer", "importer plugin to use")
+        .addOption("frames", "4")
+            .setHelp("frames", "how many frames to decode ahead", "N")
         .addSkippedPrefix("magnum", "engine-specific options")
         .setGlobalHelp("Plays back an animated GIF")
         .parse(arguments.argc, arguments.argv);
 
-    /* Load GIF importer plugin */
-    PluginManager::Manager<Trade::AbstractImporter> manager;
-    Containers::Pointer<Trade::AbstractImporter> importer =
-        manager.loadAndInstantiate(args.value("importer"));
-    if(!importer || !importer->openFile(args.value("file")))
+    /* Open the file and start decoding frames in the background, looping
+       forever */
+    if(!_decoder.open(args.value("importer"), args.value("file"),
+        args.value<std::size_t>("frames"), true))
         std::exit(1);
 
-    /* Get the first image */
-    Containers::Optional<Trade::ImageData2D> image = importer->image2D(0);
-    if(!image) std::exit(2);
-
-    /* Query total image count and allocate a 2D texture */
-    const Int imageCount = importer->image2DCount();
-    _gridSize.x() = Math::sqrt(imageCount);
-    _gridSize.y() = (imageCount + _gridSize.x() - 1)/_gridSize.x();
-    _imageSize = image->size();
+    /* A texture for a single frame, each new frame gets uploaded over the
+       previous one */
     _texture.setWrapping(GL::SamplerWrapping::ClampToEdge)
         .setMagnificationFilter(GL::SamplerFilter::Linear)
         .setMinificationFilter(GL::SamplerFilter::Linear)
-        .setStorage(1, GL::textureFormat(image->format()), _imageSize*_gridSize)
-        .setSubImage(0, {}, *image);
-
-    /* Upload remaining images */
-    for(Int i = 1; i != imageCount; ++i) {
-        if(!(image = importer->image2D(i))) std::exit(3);
-        CORRADE_INTERNAL_ASSERT(image->size() == _imageSize);
+        .setStorage(1, GL::textureFormat(_decoder.format()), _decoder.size());
 
-        _texture.setSubImage(0,
-            Vector2i{i/_gridSize.x(), i%_gridSize.x()}*_imageSize, *image);
-    }
+    /* The first frame is decoded already */
+    uploadFrame(*_decoder.acquire());
 
     /* Set up a "projector" quad, make its transformation follow the window
        and gif aspect ratio */
@@ -126,54 +111,34 @@ AnimatedGifExample::AnimatedGifExample(const Arguments& arguments):
     _shader.setTransformationProjectionMatrix(
         Matrix3::projection({1.5f*Vector2{windowSize()}.aspectRatio(), 1.5f})*
         Matrix3::scaling(Vector2::yScale(1.0f/
-            Vector2{_imageSize}.aspectRatio())));
-
-    /* Set up the animation. Right now, until a better API for video playback
-       is in place, StbImageImporter gives the delays as ints in its importer
-       state (in case this is an animated GIF). Convert them to floats and set
-       up a player to trigger a redraw. */
-    if(importer->importerState()) {
-        const auto frameDelays = Containers::arrayView(
-            reinterpret_cast<const Int*>(importer->importerState()), imageCount);
-
-        Containers::Array<std::pair<Float, Int>> frames{std::size_t(imageCount)};
-        Float frameTime = 0.0f;
-        for(std::size_t i = 0; i != frames.size(); ++i) {
-            frames[i] = {frameTime, i};
-            frameTime += frameDelays[i]/1000.0f;
-        }
-        _frames = Animation::Track<Float, Int>{std::move(frames), Math::select};
-        _player.addWithCallbackOnChange(_frames,
-            [](Float, const Int& frame, AnimatedGifExample& app) {
-                app._shader.setTextureMatrix(
-                    Matrix3::scaling(1.0f/Vector2{app._gridSize})*
-                    Matrix3::translation(Vector2{Vector2i{frame/
-                        app._gridSize.x(), frame%app._gridSize.x()}}));
-                app.redraw();
-            }, _currentFrame, *this);
-    }
+            Vector2{_decoder.size()}.aspectRatio())));
 
     _timeline.start();
-    _player
-        .setPlayCount(0)
-        .play(_timeline.previousFrameTime());
 
     setMinimalLoopPeriod(16);
 }
 
+void AnimatedGifExample::uploadFrame(const FrameDecoder::Frame& frame) {
+    _texture.setSubImage(0, {}, frame.image);
+    _nextFrameTime += frame.delay/1000.0f;
+    _decoder.release();
+}
+
 void AnimatedGifExample::keyPressEvent(KeyEvent& event) {
     if(event.key() == KeyEvent::Key::Space) {
-        if(_player.state() == Animation::State::Playing) {
-            _player.pause(_timeline.previousFrameTime());
+        const Float time = _timeline.previousFrameTime();
+        if(!_paused) {
+            _pausedRemaining = Math::max(_nextFrameTime - time, 0.0f);
             setWindowTitle("[⏸] Magnum Animated Gif Example");
         } else {
-            _player.play(_timeline.previousFrameTime());
+            _nextFrameTime = time + _pausedRemaining;
             setWindowTitle("[⏵] Magnum Animated Gif Example");
         }
+        _paused = !_paused;
     } else return;
 
     event.setAccepted();
-    /* Player callback does a redraw(), if needed */
+    /* The tick event does a redraw(), if needed */
 }
 
 void AnimatedGifExample::drawEvent() {
@@ -183,12 +148,25 @@ void AnimatedGifExample::drawEvent() {
         .draw(_mesh);
 
     swapBuffers();
-    /* Player callback does a redraw(), if needed */
+    /* The tick event does a redraw(), if needed */
 }
 
 void AnimatedGifExample::tickEvent() {
-    _player.advance(_timeline.previousFrameTime());
+    const Float time = _timeline.previousFrameTime();
     _timeline.nextFrame();
+    if(_paused || time < _nextFrameTime) return;
+
+    /* If the frame isn't decoded yet, keep showing the current one and try
+       again on the next tick */
+    const FrameDecoder::Frame* frame = _decoder.tryAcquire();
+    if(!frame) return;
+
+    /* If late by more than the whole frame delay, for example because the
+       decoder couldn't keep up, continue from now instead of skipping
+       frames to catch up */
+    if(_nextFrameTime + frame->delay/1000.0f < time) _nextFrameTime = time;
+    uploadFrame(*frame);
+    redraw();
 }
 
 }}
@@ -0,0 +1,154 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "FrameDecoder.h"
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/ConfigurationGroup.h>
+#include <Corrade/Utility/Debug.h>
+
+namespace Magnum { namespace Examples {
+
+FrameDecoder::~FrameDecoder() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _quit = true;
+    }
+    _condition.notify_all();
+    if(_thread.joinable()) _thread.join();
+}
+
+bool FrameDecoder::open(const std::string& plugin, const std::string& filename, const std::size_t ringSize, const bool loop, const Int channelCount) {
+    CORRADE_INTERNAL_ASSERT(!_importer);
+
+    /* Coming from the command line, so not an assert */
+    if(!ringSize) {
+        Error{} << "At least one frame has to be decoded ahead";
+        return false;
+    }
+
+    _importer = _manager.loadAndInstantiate(plugin);
+    if(!_importer) return false;
+    if(channelCount)
+        _importer->configuration().setValue("forceChannelCount", channelCount);
+    if(!_importer->openFile(filename)) return false;
+
+    Containers::Optional<Trade::ImageData2D> image = _importer->image2D(0);
+    if(!image) return false;
+
+    _frameCount = _importer->image2DCount();
+    _size = image->size();
+    _format = image->format();
+
+    /* Right now, until a better API for video playback is in place,
+       StbImageImporter gives the delays as ints in its importer state (in
+       case this is an animated GIF). Copy them as the state is not safe to
+       access while the decoding thread uses the importer. */
+    if(_importer->importerState()) {
+        const auto frameDelays = Containers::arrayView(
+            reinterpret_cast<const Int*>(_importer->importerState()), _frameCount);
+        _delays.assign(frameDelays.begin(), frameDelays.end());
+    }
+    _loop = loop && isAnimated() && _frameCount > 1;
+
+    /* The first frame is already there */
+    _ring.resize(ringSize);
+    _ring[0].emplace(Frame{std::move(*image), 0, isAnimated() ? _delays[0] : 0});
+    _count = 1;
+
+    if(isAnimated() && _frameCount > 1)
+        _thread = std::thread{&FrameDecoder::run, this, 1};
+    else _finished = true;
+    return true;
+}
+
+void FrameDecoder::run(Int index) {
+    for(;;) {
+        if(index == _frameCount) {
+            if(!_loop) break;
+            index = 0;
+        }
+
+        /* Wait until there's space in the ring */
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _condition.wait(lock, [this]{ return _quit || _count < _ring.size(); });
+            if(_quit) return;
+        }
+
+        /* Decode without holding the lock, so the consumer can take frames
+           meanwhile */
+        Containers::Optional<Trade::ImageData2D> image = _importer->image2D(index);
+        if(!image) break;
+        if(image->size() != _size || image->format() != _format) {
+            Error{} << "Frame" << index << "has a different size or format than the first one";
+            break;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock{_mutex};
+            _ring[(_first + _count) % _ring.size()].emplace(Frame{std::move(*image), index, _delays[index]});
+            ++_count;
+        }
+        _condition.notify_all();
+        ++index;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _finished = true;
+    }
+    _condition.notify_all();
+}
+
+const FrameDecoder::Frame* FrameDecoder::tryAcquire() {
+    std::lock_guard<std::mutex> lock{_mutex};
+    return _count ? &*_ring[_first] : nullptr;
+}
+
+const FrameDecoder::Frame* FrameDecoder::acquire() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    _condition.wait(lock, [this]{ return _count || _finished; });
+    return _count ? &*_ring[_first] : nullptr;
+}
+
+void FrameDecoder::release() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        CORRADE_INTERNAL_ASSERT(_count);
+        /* Frees the image right away */
+        _ring[_first] = Containers::NullOpt;
+        _first = (_first + 1) % _ring.size();
+        --_count;
+    }
+    _condition.notify_all();
+}
+
+}}
@@ -0,0 +1,120 @@
+#ifndef Magnum_Examples_AnimatedGif_FrameDecoder_h
+#define Magnum_Examples_AnimatedGif_FrameDecoder_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Magnum/Trade/AbstractImporter.h>
+#include <Magnum/Trade/ImageData.h>
+
+namespace Magnum { namespace Examples {
+
+/* Decodes frames of an animated image on a background thread into a ring
+   of a fixed size, staying at most that many frames ahead of the consumer.
+   Only a few frames are thus kept in memory at a time. The consumer takes
+   frames one by one in playback order with acquire() or tryAcquire() and
+   gives them back with release(), all from the same thread. */
+class FrameDecoder {
+    public:
+        struct Frame {
+            Trade::ImageData2D image;
+            Int index;
+            /* How long to show the frame, in milliseconds */
+            Int delay;
+        };
+
+        explicit FrameDecoder() = default;
+
+        FrameDecoder(const FrameDecoder&) = delete;
+        FrameDecoder& operator=(const FrameDecoder&) = delete;
+
+        ~FrameDecoder();
+
+        /* Opens the file with given importer plugin, decodes the first
+           frame and starts decoding the rest in the background, keeping up
+           to ringSize frames. With loop enabled, the first frame follows
+           after the last one again. If channelCount is not zero, the
+           importer is asked to produce images with that many channels.
+           Returns false if the file can't be opened or ringSize is zero.
+           Can be called only once. */
+        bool open(const std::string& plugin, const std::string& filename, std::size_t ringSize, bool loop, Int channelCount = 0);
+
+        Int frameCount() const { return _frameCount; }
+        Vector2i size() const { return _size; }
+        PixelFormat format() const { return _format; }
+
+        /* Whether there are frame delays. If not, only the first frame is
+           decoded. */
+        bool isAnimated() const { return !_delays.empty(); }
+
+        /* Next frame, or nullptr if it isn't decoded yet or there's no more
+           frames. Stays valid until release(). */
+        const Frame* tryAcquire();
+
+        /* Next frame, waiting for it to be decoded if needed, or nullptr if
+           there's no more frames */
+        const Frame* acquire();
+
+        /* Gives back the frame from the last acquire() or tryAcquire(),
+           making space for another */
+        void release();
+
+    private:
+        void run(Int index);
+
+        PluginManager::Manager<Trade::AbstractImporter> _manager;
+        Containers::Pointer<Trade::AbstractImporter> _importer;
+        Int _frameCount{};
+        Vector2i _size;
+        PixelFormat _format{};
+        std::vector<Int> _delays;
+        bool _loop{};
+
+        /* The ring and everything below is protected by the mutex. The
+           consumer owns the first frame if _count is not zero, the decoder
+           thread writes to the slot after the last. */
+        std::vector<Containers::Optional<Frame>> _ring;
+        std::size_t _first{}, _count{};
+        bool _finished{}, _quit{};
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::thread _thread;
+};
+
+}}
+
+#endif
@@ -27,75 +27,78 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-#include <Corrade/Containers/ArrayView.h>
-#include <Corrade/Containers/Optional.h>
+#include <chrono>
 #include <Corrade/Containers/StridedArrayView.h>
-#include <Corrade/PluginManager/Manager.h>
 #include <Corrade/Utility/Arguments.h>
-#include <Corrade/Utility/ConfigurationGroup.h>
 #include <Corrade/Utility/Format.h>
 #include <Corrade/Utility/System.h>
 #include <Magnum/Math/Color.h>
-#include <Magnum/Trade/AbstractImporter.h>
-#include <Magnum/Trade/ImageData.h>
+
+#include "FrameDecoder.h"
 
 using namespace Magnum;
+using namespace Magnum::Examples;
 
 int main(int argc, char** argv) {
     Utility::Arguments args;
     args.addArgument("file").setHelp("file", "GIF to load", "file.gif")
         .addOption("importer", "StbImageImporter")
             .setHelp("importer", "importer plugin to use")
+        .addOption("frames", "4")
+            .setHelp("frames", "how many frames to decode ahead", "N")
+        .addBooleanOption("throughput")
+            .setHelp("throughput", "decode all frames as fast as possible and print the decoding throughput instead of playing")
         .setGlobalHelp("Plays back an animated GIF. In the terminal.")
         .parse(argc, argv);
 
-    if(!Debug::isTty()) {
+    const bool throughput = args.isSet("throughput");
+    if(!throughput && !Debug::isTty()) {
         Error{} << "Not running in a TTY, can't play.";
         return 1;
     }
 
-    /* Load GIF importer plugin */
-    PluginManager::Manager<Trade::AbstractImporter> manager;
-    Containers::Pointer<Trade::AbstractImporter> importer =
-        manager.loadAndInstantiate(args.value("importer"));
-    importer->configuration().setValue("forceChannelCount", 4);
-    if(!importer || !importer->openFile(args.value("file")))
+    /* Open the file with the same decoder as the GUI version, just not
+       looping. Force four channels so the frames can be printed. */
+    const std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    FrameDecoder decoder;
+    if(!decoder.open(args.value("importer"), args.value("file"),
+        args.value<std::size_t>("frames"), false, 4))
         return 2;
 
-    /* Get the first image, decide how many pixels to cut away to fit on 80
-       chars */
-    Containers::Optional<Trade::ImageData2D> image = importer->image2D(0);
-    if(!image) return 3;
-
-    #ifndef CORRADE_NO_ASSERT
-    const Vector2i imageSize = image->size();
-    #endif
-    const std::ptrdiff_t skip = (image->size().x() + 39)/40;
-    Debug{} << Debug::color << Debug::packed
-        << image->pixels<Color4ub>().every({skip, skip}).flipped<0>();
-
-    /* Right now, until a better API for video playback is in place,
-       StbImageImporter frame delays as ints in its importer state. If nothing
-       is there, this is not an animation -- print just the first image and
-       exit. */
-    if(!importer->importerState()) return 0;
-
-    /* Query total image count, frame delays in milliseconds */
-    const Int imageCount = importer->image2DCount();
-    const auto frameDelays = Containers::arrayView(
-        reinterpret_cast<const Int*>(importer->importerState()), imageCount);
-
-    /* Loop through the images, print them */
-    for(Int i = 1; i != imageCount; ++i) {
-        if(!(image = importer->image2D(i))) return 3;
-        CORRADE_INTERNAL_ASSERT(image->size() == imageSize);
-
-        /* Move the cursor back */
-        auto pixels = image->pixels<Color4ub>().every({skip, skip}).flipped<0>();
-        Utility::print("\033[{}A", pixels.size()[0]);
-
-        /* Print another frame and wait */
+    /* Take the frames as soon as they're decoded. This includes the time
+       spent in opening the file, as some importers decode everything
+       there. */
+    if(throughput) {
+        std::size_t frameCount = 0, byteCount = 0;
+        while(const FrameDecoder::Frame* frame = decoder.acquire()) {
+            ++frameCount;
+            byteCount += frame->image.data().size();
+            decoder.release();
+        }
+        const Double seconds = std::chrono::duration<Double>{std::chrono::steady_clock::now() - start}.count();
+
+        Utility::print("Decoded {} frames of {}x{} in {:.4} s: {:.1} frames/s, {:.1} MB/s\n",
+            frameCount, decoder.size().x(), decoder.size().y(), seconds,
+            frameCount/seconds, byteCount/seconds/1000000.0);
+        return 0;
+    }
+
+    /* Decide how many pixels to cut away to fit on 80 chars */
+    const std::ptrdiff_t skip = (decoder.size().x() + 39)/40;
+
+    /* Print the frames as they come, moving the cursor back before each
+       except the first. If this is not an animation, there's just the first
+       one. */
+    bool first = true;
+    while(const FrameDecoder::Frame* frame = decoder.acquire()) {
+        auto pixels = frame->image.pixels<Color4ub>().every({skip, skip}).flipped<0>();
+        if(!first) Utility::print("\033[{}A", pixels.size()[0]);
+        first = false;
+
+        /* Print the frame and wait */
         Debug{} << Debug::color << Debug::packed << pixels;
-        Utility::System::sleep(frameDelays[i]);
+        const Int delay = frame->delay;
+        decoder.release();
+        Utility::System::sleep(delay);
     }
 }
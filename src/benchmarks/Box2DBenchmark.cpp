@@ -0,0 +1,128 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cmath>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <Magnum/Math/Complex.h>
+#include <Magnum/Math/Matrix3.h>
+
+#include "BodyInstanceWriter.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* Boxes on a grid far enough apart to never touch, without gravity, so the
+   world doesn't need to be stepped. Every awakeEvery-th box is left awake,
+   the others are put to sleep. */
+void generateBoxes(b2World& world, Int count, Int awakeEvery, BodyInstanceWriter& writer) {
+    std::mt19937 rng{0};
+    std::uniform_real_distribution<Float> distribution{-1.0f, 1.0f};
+    const Int side = Int(std::sqrt(Float(count))) + 1;
+
+    b2PolygonShape shape;
+    shape.SetAsBox(0.5f, 0.5f);
+    for(Int i = 0; i != count; ++i) {
+        b2BodyDef bodyDefinition;
+        bodyDefinition.type = b2_dynamicBody;
+        bodyDefinition.position.Set(Float(i%side)*2.0f, Float(i/side)*2.0f);
+        bodyDefinition.angle = distribution(rng)*3.0f;
+        b2Body* body = world.CreateBody(&bodyDefinition);
+        body->CreateFixture(&shape, 1.0f);
+        body->SetAwake(i % awakeEvery == 0);
+        writer.add(*body, {0.5f, 0.5f}, Color3{1.0f});
+    }
+}
+
+/* Problem size is the box count. Everything is serial, so there's no thread
+   count. All boxes moving. */
+void bodyInstanceWriterAwake(benchmark::State& state) {
+    b2World world{b2Vec2{0.0f, 0.0f}};
+    BodyInstanceWriter writer;
+    generateBoxes(world, Int(state.range(0)), 1, writer);
+    writer.write();
+
+    BodyInstanceWriter::Range changed{};
+    for(auto _: state)
+        changed = writer.write();
+
+    state.counters["changed"] = Double(changed.end - changed.begin);
+}
+
+/* Most of a pile at rest, only every tenth box gets written */
+void bodyInstanceWriterSleeping(benchmark::State& state) {
+    b2World world{b2Vec2{0.0f, 0.0f}};
+    BodyInstanceWriter writer;
+    generateBoxes(world, Int(state.range(0)), 10, writer);
+    writer.write();
+
+    BodyInstanceWriter::Range changed{};
+    for(auto _: state)
+        changed = writer.write();
+
+    state.counters["changed"] = Double(changed.end - changed.begin);
+}
+
+/* What the example did before, minus the scene graph: walking the body list
+   and going from the angle to a rotation matrix for every body */
+void bodyInstanceWriterBodyList(benchmark::State& state) {
+    b2World world{b2Vec2{0.0f, 0.0f}};
+    BodyInstanceWriter writer;
+    generateBoxes(world, Int(state.range(0)), 10, writer);
+
+    std::vector<Matrix3> transformations(std::size_t(state.range(0)));
+    for(auto _: state) {
+        std::size_t i = 0;
+        for(b2Body* body = world.GetBodyList(); body; body = body->GetNext())
+            transformations[i++] = Matrix3::from(
+                Complex::rotation(Rad(body->GetAngle())).toMatrix(),
+                {body->GetPosition().x, body->GetPosition().y})*
+                Matrix3::scaling(Vector2{0.5f});
+        benchmark::DoNotOptimize(transformations.data());
+    }
+
+    state.counters["changed"] = Double(state.range(0));
+}
+
+}
+
+BENCHMARK(bodyInstanceWriterAwake)->Name("BodyInstanceWriter::write/awake")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(bodyInstanceWriterSleeping)->Name("BodyInstanceWriter::write/sleeping")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(bodyInstanceWriterBodyList)->Name("BodyInstanceWriter::write/bodyList")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,111 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <random>
+#include <benchmark/benchmark.h>
+
+#include "ThreadCounts.h"
+#include "TaskScheduler.h"
+#include "DataStructures/PCGSolver.h"
+#include "FluidSolver/ApicSolver2D.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* The pressure solver is serial, so it's run just once per size. A Poisson
+   equation on the whole grid with a random right hand side is a harder case
+   than what the solver usually gets, as the fluid occupies just a part of
+   the grid and the previous pressure is a good guess. */
+void pcgSolverSolve(benchmark::State& state) {
+    const Int size = Int(state.range(0));
+    const UnsignedInt rows = UnsignedInt(size*size);
+    SparseMatrix<Double> matrix{rows};
+    for(Int j = 0; j < size; ++j) {
+        for(Int i = 0; i < size; ++i) {
+            const Int row = i + j*size;
+            matrix.addToElement(row, row, 4.0);
+            if(i > 0) matrix.addToElement(row, row - 1, -1.0);
+            if(i + 1 < size) matrix.addToElement(row, row + 1, -1.0);
+            if(j > 0) matrix.addToElement(row, row - size, -1.0);
+            if(j + 1 < size) matrix.addToElement(row, row + size, -1.0);
+        }
+    }
+
+    std::mt19937 rng{0};
+    std::uniform_real_distribution<Double> distribution{-1.0, 1.0};
+    std::vector<Double> rhs(rows);
+    for(Double& value: rhs) value = distribution(rng);
+
+    PCGSolver<Double> solver;
+    std::vector<Double> result;
+    for(auto _: state) {
+        result.assign(rows, 0.0);
+        solver.solve(matrix, rhs, result);
+    }
+
+    state.counters["rows"] = Double(rows);
+    state.counters["pcgIterations"] = Double(solver.lastIterationCount());
+}
+
+/* The scene of the example scaled to the grid size, each repetition starts
+   from the initial state */
+void apicSolver2DAdvanceFrame(benchmark::State& state) {
+    const Int size = Int(state.range(0));
+    TaskScheduler::setThreadCount(std::size_t(state.range(1)));
+
+    const Float scale = Float(size)/100.0f;
+    const Vector2 center{Float(size)*0.5f};
+    auto sceneObjs = new SceneObjects;
+    sceneObjs->emitterT0 = SDFObject{center + Vector2{10.0f, 10.0f}*scale, 30.0f*scale, SDFObject::ObjectType::Circle};
+    sceneObjs->emitter = SDFObject{center + Vector2{15.0f, 20.0f}*scale, 15.0f*scale, SDFObject::ObjectType::Circle};
+    sceneObjs->boundary = SDFObject{center, 45.0f*scale, SDFObject::ObjectType::Circle, false};
+    ApicSolver2D solver{Vector2{0.0f}, 1.0f, size, size, sceneObjs};
+
+    for(auto _: state)
+        solver.advanceFrame(1.0f/60.0f);
+
+    state.counters["particles"] = Double(solver.numParticles());
+    state.counters["activeTiles"] = Double(solver.numActiveGridTiles());
+}
+
+}
+
+/* Problem size is the grid resolution along each axis, the example itself
+   runs on a 100x100 grid */
+BENCHMARK(pcgSolverSolve)->Name("PCGSolver::solve")
+    ->ArgName("size")->Arg(100)->Arg(200)->Arg(400)
+    ->Unit(benchmark::kMillisecond);
+BENCHMARK(apicSolver2DAdvanceFrame)->Name("ApicSolver2D::advanceFrame")
+    ->ArgNames({"size", "threads"})
+    ->ArgsProduct({{100, 200, 400}, benchmarkThreadCounts()})
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
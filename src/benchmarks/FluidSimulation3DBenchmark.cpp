@@ -0,0 +1,102 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <numeric>
+#include <benchmark/benchmark.h>
+
+#include "ThreadCounts.h"
+#include "TaskScheduler.h"
+#include "SPH/DomainBox.h"
+#include "SPH/SPHSolver.h"
+#include "SPH/SimulationThread.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* Problem size is the count of particles across the water column of the
+   example scene, which is 0.5 units wide. The total particle count grows
+   with its cube, 16 gives about 26 thousand particles. */
+Float particleRadius(const benchmark::State& state) {
+    return 0.25f/Float(state.range(0));
+}
+
+/* Neighbor search alone, on the initial particle lattice */
+void domainBoxFindNeighbors(benchmark::State& state) {
+    TaskScheduler::setThreadCount(std::size_t(state.range(1)));
+
+    const Float radius = particleRadius(state);
+    const std::vector<Vector3> positions = initialParticlePositions(radius);
+    std::vector<UnsignedInt> particles(positions.size());
+    std::iota(particles.begin(), particles.end(), 0);
+    std::vector<std::vector<UnsignedInt>> neighbors(positions.size());
+    std::vector<std::vector<Vector3>> relativePositions(positions.size());
+    DomainBox domainBox{radius, Vector3{radius},
+        Vector3{3.0f, 3.0f, 1.0f} - Vector3{radius}};
+
+    for(auto _: state)
+        domainBox.findNeighbors(positions, particles, neighbors, relativePositions);
+
+    std::size_t neighborCount = 0;
+    for(const std::vector<UnsignedInt>& n: neighbors)
+        neighborCount += n.size();
+    state.counters["particles"] = Double(positions.size());
+    state.counters["neighbors"] = Double(neighborCount)/Double(positions.size());
+}
+
+/* Whole steps of the dam break from the example, starting from the initial
+   state in every repetition. Sleeping is disabled so the work done in a step
+   doesn't depend on how far the simulation got. */
+void sphSolverAdvance(benchmark::State& state) {
+    TaskScheduler::setThreadCount(std::size_t(state.range(1)));
+
+    const Float radius = particleRadius(state);
+    SPHSolver solver{radius};
+    solver.setPositions(initialParticlePositions(radius));
+    solver.simulationParameters().sleeping = false;
+
+    for(auto _: state)
+        solver.advance();
+
+    state.counters["particles"] = Double(solver.numParticles());
+}
+
+}
+
+BENCHMARK(domainBoxFindNeighbors)->Name("DomainBox::findNeighbors")
+    ->ArgNames({"size", "threads"})
+    ->ArgsProduct({{12, 16, 24}, benchmarkThreadCounts()})
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+BENCHMARK(sphSolverAdvance)->Name("SPHSolver::advance")
+    ->ArgNames({"size", "threads"})
+    ->ArgsProduct({{12, 16, 24}, benchmarkThreadCounts()})
+    ->UseRealTime()->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
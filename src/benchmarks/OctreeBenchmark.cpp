@@ -0,0 +1,119 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <random>
+#include <benchmark/benchmark.h>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Math/Functions.h>
+
+#include "LooseOctree.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* Same distribution of points and velocities as in the example, except that
+   it's generated from a fixed seed */
+void generatePoints(Int count, Containers::Array<Vector3>& positions, Containers::Array<Vector3>& velocities) {
+    std::mt19937 rng{0};
+    std::uniform_real_distribution<Float> distribution{-1.0f, 1.0f};
+    positions = Containers::Array<Vector3>{NoInit, std::size_t(count)};
+    velocities = Containers::Array<Vector3>{NoInit, std::size_t(count)};
+    for(std::size_t i = 0; i != positions.size(); ++i) {
+        positions[i] = Vector3{distribution(rng), distribution(rng)*0.5f, distribution(rng)};
+        velocities[i] = Vector3{distribution(rng), distribution(rng), distribution(rng)}.resized(0.05f);
+    }
+}
+
+/* Same as OctreeExample::movePoints() */
+void movePoints(Containers::Array<Vector3>& positions, Containers::Array<Vector3>& velocities) {
+    constexpr Float dt = 1.0f/120.0f;
+    for(std::size_t i = 0; i != positions.size(); ++i) {
+        Vector3 pos = positions[i] + velocities[i]*dt;
+        for(std::size_t j = 0; j != 3; ++j) {
+            if(pos[j] < -1.0f || pos[j] > 1.0f)
+                velocities[i][j] = -velocities[i][j];
+            pos[j] = Math::clamp(pos[j], -1.0f, 1.0f);
+        }
+        positions[i] = pos;
+    }
+}
+
+/* Problem size is the point count. The octree is serial, so there's no
+   thread count. */
+void looseOctreeBuild(benchmark::State& state) {
+    Containers::Array<Vector3> positions, velocities;
+    generatePoints(Int(state.range(0)), positions, velocities);
+    LooseOctree octree{Vector3{0.0f}, 1.0f, 0.1f};
+    octree.setPoints(positions);
+
+    /* build() prints info about the tree every time */
+    {
+        Debug silence{nullptr};
+        for(auto _: state)
+            octree.build();
+    }
+
+    state.counters["nodes"] = Double(octree.numAllocatedNodes());
+    state.counters["maxPointsInNode"] = Double(octree.maxNumPointInNodes());
+}
+
+/* Includes moving the points, but that's just a fraction of the incremental
+   update */
+void looseOctreeUpdate(benchmark::State& state) {
+    Containers::Array<Vector3> positions, velocities;
+    generatePoints(Int(state.range(0)), positions, velocities);
+    LooseOctree octree{Vector3{0.0f}, 1.0f, 0.1f};
+    octree.setPoints(positions);
+    {
+        Debug silence{nullptr};
+        octree.build();
+    }
+
+    for(auto _: state) {
+        movePoints(positions, velocities);
+        octree.update();
+    }
+
+    state.counters["nodes"] = Double(octree.numAllocatedNodes());
+    state.counters["maxPointsInNode"] = Double(octree.maxNumPointInNodes());
+}
+
+}
+
+BENCHMARK(looseOctreeBuild)->Name("LooseOctree::build")
+    ->ArgName("size")->Arg(2000)->Arg(20000)->Arg(200000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(looseOctreeUpdate)->Name("LooseOctree::update")
+    ->ArgName("size")->Arg(2000)->Arg(20000)->Arg(200000)
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
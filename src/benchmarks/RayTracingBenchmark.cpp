@@ -0,0 +1,76 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstdlib>
+#include <benchmark/benchmark.h>
+#include <Magnum/Math/Angle.h>
+
+#include "RayTracer.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+using namespace Math::Literals;
+
+namespace {
+
+/* Problem size is the image width, with a 4:3 aspect ratio. Blocks are
+   rendered one by one on the calling thread, same as in the example, so
+   there's no thread count. */
+void rayTracerRenderBlock(benchmark::State& state) {
+    const Int size = Int(state.range(0));
+    const Vector2i imageSize{size, size*3/4};
+    RayTracer rayTracer{{5.0f, 1.0f, 5.5f}, {1.0f, 0.5f, 0.0f},
+        {0.0f, 1.0f, 0.0f}, 45.0_degf, Vector2{imageSize}.aspectRatio(),
+        0.0f, imageSize, 64, ~UnsignedInt{}, 16};
+    rayTracer.markNextBlock() = false;
+
+    /* The constructor seeds the scene generator with current time,
+       regenerate it from a fixed seed. The seed applies to the samples as
+       well. */
+    std::srand(0);
+    rayTracer.generateSceneObjects();
+    rayTracer.clearBuffers();
+
+    /* One iteration is one sample of every pixel, i.e. all blocks */
+    for(auto _: state) {
+        const UnsignedInt pass = rayTracer.iteration();
+        do rayTracer.renderBlock();
+        while(rayTracer.iteration() == pass);
+    }
+
+    state.counters["pixels"] = Double(imageSize.product());
+}
+
+}
+
+BENCHMARK(rayTracerRenderBlock)->Name("RayTracer::renderBlock")
+    ->ArgName("size")->Arg(160)->Arg(320)->Arg(640)
+    ->Unit(benchmark::kMillisecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,181 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Vector4.h>
+
+#include "ShadowCascadeScheduler.h"
+#include "ShadowCasterIndex.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* Casters scattered over a flat area of 1000x1000 units, like objects
+   standing on a large terrain */
+void generateCasters(Int count, ShadowCasterIndex& index) {
+    std::mt19937 rng{0};
+    std::uniform_real_distribution<Float> distribution{-1.0f, 1.0f};
+    index.setSphereCount(std::size_t(count));
+    for(std::size_t i = 0; i != index.sphereCount(); ++i)
+        index.setSphere(i, {distribution(rng)*500.0f, distribution(rng)*2.5f + 2.5f,
+            distribution(rng)*500.0f}, 1.0f + distribution(rng)*0.5f);
+}
+
+/* Side and far planes of a shadow cascade of a 50x50 unit area looking
+   down at an angle, normalized and pointing inside */
+void cascadePlanes(Vector4(&planes)[5]) {
+    const Vector3 forward = Vector3{0.0f, -1.0f, 1.0f}.normalized();
+    const Vector3 right = Vector3::xAxis();
+    const Vector3 up = Math::cross(right, forward);
+    planes[0] = {-forward, 200.0f};
+    planes[1] = {right, 25.0f};
+    planes[2] = {-right, 25.0f};
+    planes[3] = {up, 25.0f};
+    planes[4] = {-up, 25.0f};
+}
+
+/* Problem size is the caster count. Everything is serial, so there's no
+   thread count. */
+void shadowCasterIndexBuild(benchmark::State& state) {
+    ShadowCasterIndex index;
+    for(auto _: state) {
+        generateCasters(Int(state.range(0)), index);
+        index.update();
+    }
+
+    state.counters["nodes"] = Double(index.nodeCount());
+}
+
+/* A few casters moved, the time should follow their count and not the
+   size */
+void shadowCasterIndexRefit(benchmark::State& state) {
+    ShadowCasterIndex index;
+    generateCasters(Int(state.range(0)), index);
+    index.update();
+    std::mt19937 rng{1};
+    std::uniform_real_distribution<Float> distribution{-0.1f, 0.1f};
+
+    for(auto _: state) {
+        for(Int i = 0; i != 16; ++i) {
+            const std::size_t id = rng()%index.sphereCount();
+            index.setSphere(id, index.center(id) + Vector3{distribution(rng), 0.0f, distribution(rng)}, index.radius(id));
+        }
+        index.update();
+    }
+
+    state.counters["rebuilt"] = index.lastUpdateRebuilt() ? 1.0 : 0.0;
+}
+
+void shadowCasterIndexQuery(benchmark::State& state) {
+    ShadowCasterIndex index;
+    generateCasters(Int(state.range(0)), index);
+    index.update();
+    Vector4 planes[5];
+    cascadePlanes(planes);
+
+    std::vector<UnsignedInt> ids;
+    for(auto _: state) {
+        ids.clear();
+        index.query(planes, ids);
+    }
+
+    state.counters["casters"] = Double(ids.size());
+}
+
+/* What the example did before, for comparison */
+void shadowCasterIndexQueryLinear(benchmark::State& state) {
+    ShadowCasterIndex index;
+    generateCasters(Int(state.range(0)), index);
+    Vector4 planes[5];
+    cascadePlanes(planes);
+
+    std::vector<UnsignedInt> ids;
+    for(auto _: state) {
+        ids.clear();
+        for(std::size_t i = 0; i != index.sphereCount(); ++i) {
+            bool visible = true;
+            for(const Vector4& plane: planes)
+                if(Math::dot(plane.xyz(), index.center(i)) + plane.w() < -index.radius(i))
+                    visible = false;
+            if(visible) ids.push_back(UnsignedInt(i));
+        }
+    }
+
+    state.counters["casters"] = Double(ids.size());
+}
+
+/* Four layers with dynamic casters in all of them, a static caster moves
+   every 100th frame. The counters are layers drawn per frame, which the
+   shadow rendering cost follows, compared to drawing all four every frame
+   without the cache. */
+void shadowCascadeSchedulerSchedule(benchmark::State& state) {
+    ShadowCascadeScheduler scheduler;
+    scheduler.setLayerCount(4);
+    for(std::size_t i = 0; i != scheduler.layerCount(); ++i)
+        scheduler.setDynamicCasters(i, true);
+
+    std::size_t frames = 0, full = 0, dynamic = 0;
+    for(auto _: state) {
+        for(Int i = 0; i != 1000; ++i) {
+            if(frames % 100 == 0)
+                scheduler.invalidate(frames/100 % scheduler.layerCount());
+            scheduler.schedule();
+            full += scheduler.updateCount(ShadowCascadeScheduler::Update::Full);
+            dynamic += scheduler.updateCount(ShadowCascadeScheduler::Update::Dynamic);
+            ++frames;
+        }
+    }
+
+    state.counters["full"] = Double(full)/Double(frames);
+    state.counters["dynamic"] = Double(dynamic)/Double(frames);
+}
+
+}
+
+BENCHMARK(shadowCasterIndexBuild)->Name("ShadowCasterIndex::update/build")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(shadowCasterIndexRefit)->Name("ShadowCasterIndex::update/refit")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(shadowCasterIndexQuery)->Name("ShadowCasterIndex::query")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(shadowCasterIndexQueryLinear)->Name("ShadowCasterIndex::query/linear")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(shadowCascadeSchedulerSchedule)->Name("ShadowCascadeScheduler::schedule")
+    ->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
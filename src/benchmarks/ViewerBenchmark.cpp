@@ -0,0 +1,177 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <algorithm>
+#include <random>
+#include <vector>
+#include <benchmark/benchmark.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "ThreadCounts.h"
+#include "Culler.h"
+#include "TransformHierarchy.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* Random forest where each object has an earlier object as a parent, with
+   a few percent of roots. Shuffled, so the importer order doesn't match the
+   order the nodes end up in, as is usual for real scenes. */
+TransformHierarchy generateHierarchy(Int count) {
+    std::mt19937 rng{0};
+    std::vector<UnsignedInt> order(count);
+    for(std::size_t i = 0; i != order.size(); ++i) order[i] = UnsignedInt(i);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    std::vector<Int> parents(std::size_t(count), -1);
+    for(std::size_t i = 1; i != order.size(); ++i) {
+        if(rng()%32 == 0) continue;
+        parents[order[i]] = Int(order[rng()%i]);
+    }
+
+    TransformHierarchy hierarchy{parents};
+    std::uniform_real_distribution<Float> distribution{-1.0f, 1.0f};
+    for(UnsignedInt node = 0; node != hierarchy.nodeCount(); ++node)
+        hierarchy.setTransformation(node, Matrix4::translation({
+            distribution(rng), distribution(rng), distribution(rng)}));
+    hierarchy.update();
+    return hierarchy;
+}
+
+/* Spheres scattered in a box in front of the camera and past its sides,
+   so a part of them is outside of the frustum */
+void generateSpheres(Int count, Culler& culler) {
+    std::mt19937 rng{0};
+    std::uniform_real_distribution<Float> distribution{-1.0f, 1.0f};
+    culler.setSphereCount(std::size_t(count));
+    for(std::size_t i = 0; i != culler.sphereCount(); ++i)
+        culler.setSphere(i, {distribution(rng)*50.0f, distribution(rng)*50.0f,
+            -50.0f + distribution(rng)*45.0f}, 0.5f + distribution(rng)*0.25f);
+}
+
+/* A unit cube, scaled and placed as a wall */
+const Vector3 CubePositions[]{
+    {-1.0f, -1.0f, -1.0f}, { 1.0f, -1.0f, -1.0f},
+    {-1.0f,  1.0f, -1.0f}, { 1.0f,  1.0f, -1.0f},
+    {-1.0f, -1.0f,  1.0f}, { 1.0f, -1.0f,  1.0f},
+    {-1.0f,  1.0f,  1.0f}, { 1.0f,  1.0f,  1.0f}
+};
+const UnsignedInt CubeIndices[]{
+    0, 2, 1, 1, 2, 3,   4, 5, 6, 5, 7, 6,
+    0, 1, 4, 1, 5, 4,   2, 6, 3, 3, 6, 7,
+    0, 4, 2, 2, 4, 6,   1, 3, 5, 3, 7, 5
+};
+
+const Matrix4 ViewProjection = Matrix4::perspectiveProjection(
+    Deg(35.0f), 16.0f/9.0f, 0.1f, 200.0f);
+
+/* Problem size is the node count. The hierarchy update is serial, so
+   there's no thread count. Every node changed, which is the worst case. */
+void transformHierarchyUpdateAll(benchmark::State& state) {
+    TransformHierarchy hierarchy = generateHierarchy(Int(state.range(0)));
+
+    std::size_t updated = 0;
+    for(auto _: state) {
+        for(UnsignedInt node = 0; node != hierarchy.nodeCount(); ++node)
+            hierarchy.setTransformation(node, hierarchy.transformation(node));
+        updated = hierarchy.update();
+    }
+
+    state.counters["updatedNodes"] = Double(updated);
+}
+
+/* A few random nodes changed, the time should follow the count of updated
+   nodes and not the size */
+void transformHierarchyUpdateSparse(benchmark::State& state) {
+    TransformHierarchy hierarchy = generateHierarchy(Int(state.range(0)));
+    std::mt19937 rng{1};
+
+    std::size_t updated = 0;
+    for(auto _: state) {
+        for(Int i = 0; i != 16; ++i) {
+            const UnsignedInt node = UnsignedInt(rng()%hierarchy.nodeCount());
+            hierarchy.setTransformation(node, hierarchy.transformation(node));
+        }
+        updated = hierarchy.update();
+    }
+
+    state.counters["updatedNodes"] = Double(updated);
+}
+
+/* Problem size is the bounding sphere count */
+void cullerCullFrustum(benchmark::State& state) {
+    Culler culler{std::size_t(state.range(1))};
+    generateSpheres(Int(state.range(0)), culler);
+
+    std::vector<UnsignedInt> visible;
+    for(auto _: state)
+        culler.cull(ViewProjection, visible);
+
+    state.counters["visible"] = Double(visible.size());
+}
+
+/* A few walls across the view hide a large part of what's behind them */
+void cullerCullOcclusion(benchmark::State& state) {
+    Culler culler{std::size_t(state.range(1))};
+    generateSpheres(Int(state.range(0)), culler);
+
+    std::vector<UnsignedInt> visible;
+    for(auto _: state) {
+        for(Int i = 0; i != 4; ++i)
+            culler.addOccluder(
+                Matrix4::translation({-12.0f + Float(i)*8.0f, 0.0f, -10.0f - Float(i)*5.0f})*
+                Matrix4::scaling({3.0f, 6.0f, 0.5f}),
+                CubePositions, CubeIndices);
+        culler.cull(ViewProjection, visible);
+    }
+
+    state.counters["visible"] = Double(visible.size());
+    state.counters["occluded"] = Double(culler.occlusionCulledCount());
+}
+
+}
+
+BENCHMARK(transformHierarchyUpdateAll)->Name("TransformHierarchy::update/all")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(transformHierarchyUpdateSparse)->Name("TransformHierarchy::update/sparse")
+    ->ArgName("size")->Arg(1000)->Arg(10000)->Arg(100000)
+    ->Unit(benchmark::kMicrosecond);
+BENCHMARK(cullerCullFrustum)->Name("Culler::cull/frustum")
+    ->ArgNames({"size", "threads"})
+    ->ArgsProduct({{1000, 10000, 100000}, benchmarkThreadCounts()})
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+BENCHMARK(cullerCullOcclusion)->Name("Culler::cull/occlusion")
+    ->ArgNames({"size", "threads"})
+    ->ArgsProduct({{1000, 10000, 100000}, benchmarkThreadCounts()})
+    ->UseRealTime()->Unit(benchmark::kMicrosecond);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,125 @@
+#ifndef Magnum_Examples_Box2D_BodyInstanceWriter_h
+#define Magnum_Examples_Box2D_BodyInstanceWriter_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2018 — Michal Mikula <miso.mikula@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix3.h>
+
+/* Box2D 2.3 (from 2014) uses mixed case, 2.4 (from 2020) uses lowercase */
+#ifdef __has_include
+#if __has_include(<box2d/box2d.h>)
+#include <box2d/box2d.h>
+#else
+#include <Box2D/Box2D.h>
+#endif
+/* If the compiler doesn't have __has_include, assume it's extremely old, and
+   thus an extremely old Box2D is more likely as well */
+#else
+#include <Box2D/Box2D.h>
+#endif
+
+namespace Magnum { namespace Examples {
+
+/* Instance data of Box2D bodies drawn as scaled squares. Every body gets an
+   instance when added and write() then fills transformation matrices
+   straight from the body transforms, in a single pass over all bodies that
+   skips the ones that were asleep already in the previous call, as their
+   matrices are already there from before.
+   Transformations and colors are in separate arrays, colors only ever
+   change when a body is added, so they can be uploaded separately. */
+class BodyInstanceWriter {
+    public:
+        /* Range of instances, empty if begin == end */
+        struct Range {
+            std::size_t begin, end;
+        };
+
+        /* Adds a body, the square is scaled by halfSize. Returns the
+           instance index. */
+        std::size_t add(b2Body& body, const Vector2& halfSize, const Color3& color) {
+            _bodies.push_back(&body);
+            _halfSizes.push_back(halfSize);
+            _transformations.emplace_back();
+            _colors.push_back(color);
+            /* So it gets written in the next call even if it's asleep */
+            _wasAwake.push_back(1);
+            return _bodies.size() - 1;
+        }
+
+        std::size_t size() const { return _bodies.size(); }
+
+        /* Updates transformations of bodies that are awake, were awake in
+           the last call or were added since, returns the range that
+           changed. A body that fell asleep still moved in the step that put
+           it to sleep, so it's written once more. */
+        Range write() {
+            Range changed{_bodies.size(), 0};
+            for(std::size_t i = 0; i != _bodies.size(); ++i) {
+                const b2Body& body = *_bodies[i];
+                const bool awake = body.IsAwake();
+                const bool wasAwake = _wasAwake[i];
+                _wasAwake[i] = awake;
+                if(!awake && !wasAwake) continue;
+
+                /* Rotation is stored as a sine and cosine already, no need
+                   to go through the angle */
+                const b2Transform& transform = body.GetTransform();
+                const Vector2& halfSize = _halfSizes[i];
+                _transformations[i] = Matrix3{
+                    { transform.q.c*halfSize.x(), transform.q.s*halfSize.x(), 0.0f},
+                    {-transform.q.s*halfSize.y(), transform.q.c*halfSize.y(), 0.0f},
+                    { transform.p.x,              transform.p.y,              1.0f}};
+
+                if(changed.begin == _bodies.size()) changed.begin = i;
+                changed.end = i + 1;
+            }
+
+            if(!changed.end) changed.begin = 0;
+            return changed;
+        }
+
+        const std::vector<Matrix3>& transformations() const { return _transformations; }
+        const std::vector<Color3>& colors() const { return _colors; }
+
+    private:
+        std::vector<b2Body*> _bodies;
+        std::vector<Vector2> _halfSizes;
+        std::vector<Matrix3> _transformations;
+        std::vector<Color3> _colors;
+        /* Whether the body was awake in the last write() */
+        std::vector<UnsignedByte> _wasAwake;
+};
+
+}}
+
+#endif
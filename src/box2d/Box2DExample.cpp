@@ -28,38 +28,26 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
-#include <Corrade/Containers/GrowableArray.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/Optional.h>
 #include <Corrade/Utility/Arguments.h>
+#include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/Context.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
-#include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/Math/ConfigurationValue.h>
 #include <Magnum/Math/DualComplex.h>
+#include <Magnum/Math/Functions.h>
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/Platform/Sdl2Application.h>
 #include <Magnum/Primitives/Square.h>
 #include <Magnum/SceneGraph/Camera.h>
-#include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/TranslationRotationScalingTransformation2D.h>
 #include <Magnum/SceneGraph/Scene.h>
 #include <Magnum/Shaders/FlatGL.h>
 #include <Magnum/Trade/MeshData.h>
 
-/* Box2D 2.3 (from 2014) uses mixed case, 2.4 (from 2020) uses lowercase */
-#ifdef __has_include
-#if __has_include(<box2d/box2d.h>)
-#include <box2d/box2d.h>
-#else
-#include <Box2D/Box2D.h>
-#define IT_IS_THE_OLD_BOX2D
-#endif
-/* If the compiler doesn't have __has_include, assume it's extremely old, and
-   thus an extremely old Box2D is more likely as well */
-#else
-#include <Box2D/Box2D.h>
-#define IT_IS_THE_OLD_BOX2D
-#endif
+#include "BodyInstanceWriter.h"
 
 namespace Magnum { namespace Examples {
 
@@ -68,11 +56,6 @@ typedef SceneGraph::Scene<SceneGraph::TranslationRotationScalingTransformation2D
 
 using namespace Math::Literals;
 
-struct InstanceData {
-    Matrix3 transformation;
-    Color3 color;
-};
-
 class Box2DExample: public Platform::Application {
     public:
         explicit Box2DExample(const Arguments& arguments);
@@ -81,34 +64,24 @@ class Box2DExample: public Platform::Application {
         void drawEvent() override;
         void mousePressEvent(MouseEvent& event) override;
 
-        b2Body* createBody(Object2D& object, const Vector2& size, b2BodyType type, const DualComplex& transformation, Float density = 1.0f);
+        b2Body* createBody(const Vector2& halfSize, b2BodyType type, const DualComplex& transformation, const Color3& color, Float density = 1.0f);
 
-        GL::Mesh _mesh{NoCreate};
-        GL::Buffer _instanceBuffer{NoCreate};
         Shaders::FlatGL2D _shader{NoCreate};
-        Containers::Array<InstanceData> _instanceData;
+        GL::Mesh _mesh{NoCreate};
+
+        /* Instance data go straight from the bodies to the buffers, the
+           scene graph is there just for the camera */
+        BodyInstanceWriter _instances;
+        GL::Buffer _transformationBuffer{NoCreate}, _colorBuffer{NoCreate};
+        std::size_t _instanceCapacity{}, _uploadedColorCount{};
 
         Scene2D _scene;
         Object2D* _cameraObject;
         SceneGraph::Camera2D* _camera;
-        SceneGraph::DrawableGroup2D _drawables;
         Containers::Optional<b2World> _world;
 };
 
-class BoxDrawable: public SceneGraph::Drawable2D {
-    public:
-        explicit BoxDrawable(Object2D& object, Containers::Array<InstanceData>& instanceData, const Color3& color, SceneGraph::DrawableGroup2D& drawables): SceneGraph::Drawable2D{object, &drawables}, _instanceData(instanceData), _color{color} {}
-
-    private:
-        void draw(const Matrix3& transformation, SceneGraph::Camera2D&) override {
-            arrayAppend(_instanceData, InPlaceInit, transformation, _color);
-        }
-
-        Containers::Array<InstanceData>& _instanceData;
-        Color3 _color;
-};
-
-b2Body* Box2DExample::createBody(Object2D& object, const Vector2& halfSize, const b2BodyType type, const DualComplex& transformation, const Float density) {
+b2Body* Box2DExample::createBody(const Vector2& halfSize, const b2BodyType type, const DualComplex& transformation, const Color3& color, const Float density) {
     b2BodyDef bodyDefinition;
     bodyDefinition.position.Set(transformation.translation().x(), transformation.translation().y());
     bodyDefinition.angle = Float(transformation.rotation().angle());
@@ -124,15 +97,7 @@ b2Body* Box2DExample::createBody(Object2D& object, const Vector2& halfSize, cons
     fixture.shape = &shape;
     body->CreateFixture(&fixture);
 
-    #ifndef IT_IS_THE_OLD_BOX2D
-    /* Why keep things simple if there's an awful and backwards-incompatible
-       way, eh? https://github.com/erincatto/box2d/pull/658 */
-    body->GetUserData().pointer = reinterpret_cast<std::uintptr_t>(&object);
-    #else
-    body->SetUserData(&object);
-    #endif
-    object.setScaling(halfSize);
-
+    _instances.add(*body, halfSize, color);
     return body;
 }
 
@@ -140,10 +105,15 @@ Box2DExample::Box2DExample(const Arguments& arguments): Platform::Application{ar
     /* Make it possible for the user to have some fun */
     Utility::Arguments args;
     args.addOption("transformation", "1 0 0 0").setHelp("transformation", "initial pyramid transformation")
+        .addOption("rows", "15").setHelp("rows", "pyramid row count, 447 rows is about 100k boxes", "N")
         .addSkippedPrefix("magnum", "engine-specific options")
         .parse(arguments.argc, arguments.argv);
 
     const DualComplex globalTransformation = args.value<DualComplex>("transformation").normalized();
+    const UnsignedInt rows = args.value<UnsignedInt>("rows");
+    /* Grow the ground and the view with the pyramid, keeping the bottom
+       where it was */
+    const Float scale = Math::max(1.0f, Float(rows)/15.0f);
 
     /* Try 8x MSAA, fall back to zero samples if not possible. Enable only 2x
        MSAA if we have enough DPI. */
@@ -160,9 +130,10 @@ Box2DExample::Box2DExample(const Arguments& arguments): Platform::Application{ar
 
     /* Configure camera */
     _cameraObject = new Object2D{&_scene};
+    _cameraObject->setTranslation(Vector2::yAxis(10.0f*(scale - 1.0f)));
     _camera = new SceneGraph::Camera2D{*_cameraObject};
     _camera->setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::Extend)
-        .setProjectionMatrix(Matrix3::projection({20.0f, 20.0f}))
+        .setProjectionMatrix(Matrix3::projection(Vector2{20.0f*scale}))
         .setViewport(GL::defaultFramebuffer.viewport().size());
 
     /* Create the Box2D world with the usual gravity vector */
@@ -173,26 +144,25 @@ Box2DExample::Box2DExample(const Arguments& arguments): Platform::Application{ar
         .setFlags(Shaders::FlatGL2D::Flag::VertexColor|
                   Shaders::FlatGL2D::Flag::InstancedTransformation)};
 
-    /* Box mesh with an (initially empty) instance buffer */
+    /* Box mesh with a buffer for instance transformations and another for
+       colors, which get updated only when boxes are added */
+    _transformationBuffer = GL::Buffer{};
+    _colorBuffer = GL::Buffer{};
     _mesh = MeshTools::compile(Primitives::squareSolid());
-    _instanceBuffer = GL::Buffer{};
-    _mesh.addVertexBufferInstanced(_instanceBuffer, 1, 0,
-        Shaders::FlatGL2D::TransformationMatrix{},
-        Shaders::FlatGL2D::Color3{});
+    _mesh.addVertexBufferInstanced(_transformationBuffer, 1, 0,
+            Shaders::FlatGL2D::TransformationMatrix{})
+        .addVertexBufferInstanced(_colorBuffer, 1, 0,
+            Shaders::FlatGL2D::Color3{});
 
     /* Create the ground */
-    auto ground = new Object2D{&_scene};
-    createBody(*ground, {11.0f, 0.5f}, b2_staticBody, DualComplex::translation(Vector2::yAxis(-8.0f)));
-    new BoxDrawable{*ground, _instanceData, 0xa5c9ea_rgbf, _drawables};
+    createBody({11.0f*scale, 0.5f}, b2_staticBody, DualComplex::translation(Vector2::yAxis(-8.0f)), 0xa5c9ea_rgbf);
 
     /* Create a pyramid of boxes */
-    for(std::size_t row = 0; row != 15; ++row) {
-        for(std::size_t item = 0; item != 15 - row; ++item) {
-            auto box = new Object2D{&_scene};
+    for(UnsignedInt row = 0; row != rows; ++row) {
+        for(UnsignedInt item = 0; item != rows - row; ++item) {
             const DualComplex transformation = globalTransformation*DualComplex::translation(
-                {Float(row)*0.6f + Float(item)*1.2f - 8.5f, Float(row)*1.0f - 6.0f});
-            createBody(*box, {0.5f, 0.5f}, b2_dynamicBody, transformation);
-            new BoxDrawable{*box, _instanceData, 0x2f83cc_rgbf, _drawables};
+                {Float(row)*0.6f + Float(item)*1.2f - Float(rows)*0.6f + 0.5f, Float(row)*1.0f - 6.0f});
+            createBody({0.5f, 0.5f}, b2_dynamicBody, transformation, 0x2f83cc_rgbf);
         }
     }
 
@@ -207,38 +177,41 @@ void Box2DExample::mousePressEvent(MouseEvent& event) {
 
     /* Calculate mouse position in the Box2D world. Make it relative to window,
        with origin at center and then scale to world size with Y inverted. */
-    const auto position = _camera->projectionSize()*Vector2::yScale(-1.0f)*(Vector2{event.position()}/Vector2{windowSize()} - Vector2{0.5f});
+    const auto position = _cameraObject->translation() + _camera->projectionSize()*Vector2::yScale(-1.0f)*(Vector2{event.position()}/Vector2{windowSize()} - Vector2{0.5f});
 
-    auto destroyer = new Object2D{&_scene};
-    createBody(*destroyer, {0.5f, 0.5f}, b2_dynamicBody, DualComplex::translation(position), 2.0f);
-    new BoxDrawable{*destroyer, _instanceData, 0xffff66_rgbf, _drawables};
+    createBody({0.5f, 0.5f}, b2_dynamicBody, DualComplex::translation(position), 0xffff66_rgbf, 2.0f);
 }
 
 void Box2DExample::drawEvent() {
     GL::defaultFramebuffer.clear(GL::FramebufferClear::Color);
 
-    /* Step the world and update all object positions */
+    /* Step the world and write transformations of bodies that moved */
     _world->Step(1.0f/60.0f, 6, 2);
-    for(b2Body* body = _world->GetBodyList(); body; body = body->GetNext()) {
-        #ifndef IT_IS_THE_OLD_BOX2D
-        /* Why keep things simple if there's an awful backwards-incompatible
-           way, eh? https://github.com/erincatto/box2d/pull/658 */
-        (*reinterpret_cast<Object2D*>(body->GetUserData().pointer))
-        #else
-        (*static_cast<Object2D*>(body->GetUserData()))
-        #endif
-            .setTranslation({body->GetPosition().x, body->GetPosition().y})
-            .setRotation(Complex::rotation(Rad(body->GetAngle())));
+    const BodyInstanceWriter::Range changed = _instances.write();
+
+    /* If there's more boxes than the buffers can hold, reallocate them with
+       some headroom and upload everything. Otherwise upload just the part
+       that changed, and colors of boxes that were added. */
+    const std::size_t count = _instances.size();
+    if(count > _instanceCapacity) {
+        _instanceCapacity = Math::max(count, _instanceCapacity*2);
+        _transformationBuffer.setData({nullptr, _instanceCapacity*sizeof(Matrix3)}, GL::BufferUsage::DynamicDraw);
+        _colorBuffer.setData({nullptr, _instanceCapacity*sizeof(Color3)}, GL::BufferUsage::StaticDraw);
+        _transformationBuffer.setSubData(0, Containers::arrayView(_instances.transformations()));
+        _uploadedColorCount = 0;
+    } else if(changed.begin != changed.end) {
+        _transformationBuffer.setSubData(changed.begin*sizeof(Matrix3),
+            Containers::arrayView(_instances.transformations().data() + changed.begin, changed.end - changed.begin));
+    }
+    if(_uploadedColorCount != count) {
+        _colorBuffer.setSubData(_uploadedColorCount*sizeof(Color3),
+            Containers::arrayView(_instances.colors().data() + _uploadedColorCount, count - _uploadedColorCount));
+        _uploadedColorCount = count;
     }
 
-    /* Populate instance data with transformations and colors */
-    arrayResize(_instanceData, 0);
-    _camera->draw(_drawables);
-
-    /* Upload instance data to the GPU and draw everything in a single call */
-    _instanceBuffer.setData(_instanceData, GL::BufferUsage::DynamicDraw);
-    _mesh.setInstanceCount(_instanceData.size());
-    _shader.setTransformationProjectionMatrix(_camera->projectionMatrix())
+    /* Draw everything in a single call */
+    _mesh.setInstanceCount(count);
+    _shader.setTransformationProjectionMatrix(_camera->projectionMatrix()*_camera->cameraMatrix())
         .draw(_mesh);
 
     swapBuffers();
@@ -29,21 +29,14 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <vector>
 #include <btBulletDynamicsCommon.h>
-#include <Corrade/Containers/GrowableArray.h>
-#include <Corrade/Containers/Optional.h>
-#include <Corrade/Containers/Pointer.h>
-#include <Magnum/Timeline.h>
-#include <Magnum/BulletIntegration/Integration.h>
-#include <Magnum/BulletIntegration/MotionState.h>
 #include <Magnum/BulletIntegration/DebugDraw.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/Math/Constants.h>
 #include <Magnum/Math/Color.h>
-#include <Magnum/MeshTools/Compile.h>
-#include <Magnum/MeshTools/Transform.h>
 #include <Magnum/Platform/Sdl2Application.h>
 #include <Magnum/Primitives/Cube.h>
 #include <Magnum/Primitives/UVSphere.h>
@@ -54,6 +47,9 @@
 #include <Magnum/Shaders/PhongGL.h>
 #include <Magnum/Trade/MeshData.h>
 
+#include "InstanceBatcher.h"
+#include "PhysicsWorld.h"
+
 #ifdef BT_USE_DOUBLE_PRECISION
 #error sorry, this example does not support Bullet with double precision enabled
 #endif
@@ -71,6 +67,9 @@ struct InstanceData {
     Color3 color;
 };
 
+typedef InstanceBatcher<InstanceData> InstanceBatcher3D;
+typedef InstancedDrawable<InstanceData> InstancedDrawable3D;
+
 class BulletExample: public Platform::Application {
     public:
         explicit BulletExample(const Arguments& arguments);
@@ -80,83 +79,53 @@ class BulletExample: public Platform::Application {
         void keyPressEvent(KeyEvent& event) override;
         void mousePressEvent(MouseEvent& event) override;
 
-        GL::Mesh _box{NoCreate}, _sphere{NoCreate};
-        GL::Buffer _boxInstanceBuffer{NoCreate}, _sphereInstanceBuffer{NoCreate};
+        void addBody(btCollisionShape& shape, Float mass, const Matrix4& transformation, const Vector3& linearVelocity, UnsignedInt mesh, const Color3& color, const Matrix4& primitiveTransformation);
+
         Shaders::PhongGL _shader{NoCreate};
         BulletIntegration::DebugDraw _debugDraw{NoCreate};
-        Containers::Array<InstanceData> _boxInstanceData, _sphereInstanceData;
 
-        btDbvtBroadphase _bBroadphase;
-        btDefaultCollisionConfiguration _bCollisionConfig;
-        btCollisionDispatcher _bDispatcher{&_bCollisionConfig};
-        btSequentialImpulseConstraintSolver _bSolver;
+        /* Groups the drawables by mesh, everything uses the same shader */
+        InstanceBatcher3D _batcher{
+            Shaders::PhongGL::TransformationMatrix{},
+            Shaders::PhongGL::NormalMatrix{},
+            Shaders::PhongGL::Color3{}};
+        UnsignedInt _box, _sphere;
+
+        /* The shapes have to live longer than the world as bodies in it
+           reference them */
+        btBoxShape _bBoxShape{{0.5f, 0.5f, 0.5f}};
+        btSphereShape _bSphereShape{0.25f};
+        btBoxShape _bGroundShape{{4.0f, 0.5f, 4.0f}};
 
-        /* The world has to live longer than the scene because RigidBody
-           instances have to remove themselves from it on destruction */
-        btDiscreteDynamicsWorld _bWorld{&_bDispatcher, &_bBroadphase, &_bSolver, &_bCollisionConfig};
+        PhysicsWorld _physics{{0.0f, -10.0f, 0.0f}};
 
         Scene3D _scene;
         SceneGraph::Camera3D* _camera;
-        SceneGraph::DrawableGroup3D _drawables;
-        Timeline _timeline;
 
         Object3D *_cameraRig, *_cameraObject;
 
-        btBoxShape _bBoxShape{{0.5f, 0.5f, 0.5f}};
-        btSphereShape _bSphereShape{0.25f};
-        btBoxShape _bGroundShape{{4.0f, 0.5f, 4.0f}};
+        /* Objects of physics bodies indexed by their ID, null for IDs that
+           aren't used, and scratch space for removed IDs */
+        std::vector<Object3D*> _bodies;
+        std::vector<UnsignedInt> _removed;
 
         bool _drawCubes{true}, _drawDebug{true}, _shootBox{true};
 };
 
-class ColoredDrawable: public SceneGraph::Drawable3D {
+class ColoredDrawable: public InstancedDrawable3D {
     public:
-        explicit ColoredDrawable(Object3D& object, Containers::Array<InstanceData>& instanceData, const Color3& color, const Matrix4& primitiveTransformation, SceneGraph::DrawableGroup3D& drawables): SceneGraph::Drawable3D{object, &drawables}, _instanceData(instanceData), _color{color}, _primitiveTransformation{primitiveTransformation} {}
+        explicit ColoredDrawable(Object3D& object, InstanceBatcher3D& batcher, UnsignedInt mesh, const Color3& color, const Matrix4& primitiveTransformation): InstancedDrawable3D{object, batcher, mesh, 0}, _color{color}, _primitiveTransformation{primitiveTransformation} {}
 
     private:
-        void draw(const Matrix4& transformation, SceneGraph::Camera3D&) override {
+        InstanceData instance(const Matrix4& transformation) const override {
             const Matrix4 t = transformation*_primitiveTransformation;
-            arrayAppend(_instanceData, InPlaceInit, t, t.normalMatrix(), _color);
+            return {t, t.normalMatrix(), _color};
         }
 
-        Containers::Array<InstanceData>& _instanceData;
         Color3 _color;
         Matrix4 _primitiveTransformation;
 };
 
-class RigidBody: public Object3D {
-    public:
-        RigidBody(Object3D* parent, Float mass, btCollisionShape* bShape, btDynamicsWorld& bWorld): Object3D{parent}, _bWorld(bWorld) {
-            /* Calculate inertia so the object reacts as it should with
-               rotation and everything */
-            btVector3 bInertia(0.0f, 0.0f, 0.0f);
-            if(!Math::TypeTraits<Float>::equals(mass, 0.0f))
-                bShape->calculateLocalInertia(mass, bInertia);
-
-            /* Bullet rigid body setup */
-            auto* motionState = new BulletIntegration::MotionState{*this};
-            _bRigidBody.emplace(btRigidBody::btRigidBodyConstructionInfo{
-                mass, &motionState->btMotionState(), bShape, bInertia});
-            _bRigidBody->forceActivationState(DISABLE_DEACTIVATION);
-            bWorld.addRigidBody(_bRigidBody.get());
-        }
-
-        ~RigidBody() {
-            _bWorld.removeRigidBody(_bRigidBody.get());
-        }
-
-        btRigidBody& rigidBody() { return *_bRigidBody; }
-
-        /* needed after changing the pose from Magnum side */
-        void syncPose() {
-            _bRigidBody->setWorldTransform(btTransform(transformationMatrix()));
-        }
-
-    private:
-        btDynamicsWorld& _bWorld;
-        Containers::Pointer<btRigidBody> _bRigidBody;
-};
-
 BulletExample::BulletExample(const Arguments& arguments): Platform::Application(arguments, NoCreate) {
     /* Try 8x MSAA, fall back to zero samples if not possible. Enable only 2x
        MSAA if we have enough DPI. */
@@ -191,19 +160,9 @@ BulletExample::BulletExample(const Arguments& arguments): Platform::Application(
            .setSpecularColor(0x330000_rgbf)
            .setLightPositions({{10.0f, 15.0f, 5.0f, 0.0f}});
 
-    /* Box and sphere mesh, with an (initially empty) instance buffer */
-    _box = MeshTools::compile(Primitives::cubeSolid());
-    _sphere = MeshTools::compile(Primitives::uvSphereSolid(16, 32));
-    _boxInstanceBuffer = GL::Buffer{};
-    _sphereInstanceBuffer = GL::Buffer{};
-    _box.addVertexBufferInstanced(_boxInstanceBuffer, 1, 0,
-        Shaders::PhongGL::TransformationMatrix{},
-        Shaders::PhongGL::NormalMatrix{},
-        Shaders::PhongGL::Color3{});
-    _sphere.addVertexBufferInstanced(_sphereInstanceBuffer, 1, 0,
-        Shaders::PhongGL::TransformationMatrix{},
-        Shaders::PhongGL::NormalMatrix{},
-        Shaders::PhongGL::Color3{});
+    /* Box and sphere mesh, the batcher gives each its own instance buffers */
+    _box = _batcher.addMesh(Primitives::cubeSolid());
+    _sphere = _batcher.addMesh(Primitives::uvSphereSolid(16, 32));
 
     /* Setup the renderer so we can draw the debug lines on top */
     GL::Renderer::enable(GL::Renderer::Feature::DepthTest);
@@ -214,25 +173,20 @@ BulletExample::BulletExample(const Arguments& arguments): Platform::Application(
     /* Bullet setup */
     _debugDraw = BulletIntegration::DebugDraw{};
     _debugDraw.setMode(BulletIntegration::DebugDraw::Mode::DrawWireframe);
-    _bWorld.setGravity({0.0f, -10.0f, 0.0f});
-    _bWorld.setDebugDrawer(&_debugDraw);
 
     /* Create the ground */
-    auto* ground = new RigidBody{&_scene, 0.0f, &_bGroundShape, _bWorld};
-    new ColoredDrawable{*ground, _boxInstanceData, 0xffffff_rgbf,
-        Matrix4::scaling({4.0f, 0.5f, 4.0f}), _drawables};
+    addBody(_bGroundShape, 0.0f, {}, {}, _box, 0xffffff_rgbf,
+        Matrix4::scaling({4.0f, 0.5f, 4.0f}));
 
     /* Create boxes with random colors */
     Deg hue = 42.0_degf;
     for(Int i = 0; i != 5; ++i) {
         for(Int j = 0; j != 5; ++j) {
             for(Int k = 0; k != 5; ++k) {
-                auto* o = new RigidBody{&_scene, 1.0f, &_bBoxShape, _bWorld};
-                o->translate({i - 2.0f, j + 4.0f, k - 2.0f});
-                o->syncPose();
-                new ColoredDrawable{*o, _boxInstanceData,
-                    Color3::fromHsv({hue += 137.5_degf, 0.75f, 0.9f}),
-                    Matrix4::scaling(Vector3{0.5f}), _drawables};
+                addBody(_bBoxShape, 1.0f,
+                    Matrix4::translation({i - 2.0f, j + 4.0f, k - 2.0f}), {},
+                    _box, Color3::fromHsv({hue += 137.5_degf, 0.75f, 0.9f}),
+                    Matrix4::scaling(Vector3{0.5f}));
             }
         }
     }
@@ -240,43 +194,44 @@ BulletExample::BulletExample(const Arguments& arguments): Platform::Application(
     /* Loop at 60 Hz max */
     setSwapInterval(1);
     setMinimalLoopPeriod(16);
-    _timeline.start();
+}
+
+void BulletExample::addBody(btCollisionShape& shape, const Float mass, const Matrix4& transformation, const Vector3& linearVelocity, const UnsignedInt mesh, const Color3& color, const Matrix4& primitiveTransformation) {
+    const UnsignedInt id = _physics.addBody(shape, mass, transformation, linearVelocity);
+    if(id >= _bodies.size()) _bodies.resize(id + 1);
+
+    /* The object is placed right away, the physics thread takes over once
+       it adds the body */
+    auto* object = new Object3D{&_scene};
+    object->setTransformation(transformation);
+    new ColoredDrawable{*object, _batcher, mesh, color, primitiveTransformation};
+    _bodies[id] = object;
 }
 
 void BulletExample::drawEvent() {
     GL::defaultFramebuffer.clear(GL::FramebufferClear::Color|GL::FramebufferClear::Depth);
 
-    /* Housekeeping: remove any objects which are far away from the origin */
-    for(Object3D* obj = _scene.children().first(); obj; )
-    {
-        Object3D* next = obj->nextSibling();
-        if(obj->transformation().translation().dot() > 100*100)
-            delete obj;
-
-        obj = next;
+    /* Take the latest poses from the physics thread. Bodies it removed for
+       being too far away are deleted here together, which removes their
+       drawables from the batcher as well. */
+    _physics.sync(_removed);
+    for(const UnsignedInt id: _removed) {
+        delete _bodies[id];
+        _bodies[id] = nullptr;
     }
-
-    /* Step bullet simulation */
-    _bWorld.stepSimulation(_timeline.previousFrameDuration(), 5);
+    _physics.interpolate([this](UnsignedInt id, const Matrix4& transformation) {
+        _bodies[id]->setTransformation(transformation);
+    });
 
     if(_drawCubes) {
-        /* Populate instance data with transformations and colors */
-        arrayResize(_boxInstanceData, 0);
-        arrayResize(_sphereInstanceData, 0);
-        _camera->draw(_drawables);
-
         _shader.setProjectionMatrix(_camera->projectionMatrix());
 
-        /* Upload instance data to the GPU (orphaning the previous buffer
-           contents) and draw all cubes in one call, and all spheres (if any)
-           in another call */
-        _boxInstanceBuffer.setData(_boxInstanceData, GL::BufferUsage::DynamicDraw);
-        _box.setInstanceCount(_boxInstanceData.size());
-        _shader.draw(_box);
-
-        _sphereInstanceBuffer.setData(_sphereInstanceData, GL::BufferUsage::DynamicDraw);
-        _sphere.setInstanceCount(_sphereInstanceData.size());
-        _shader.draw(_sphere);
+        /* Fill and upload instance data with transformations and colors and
+           draw all cubes in one call, and all spheres (if any) in another
+           call */
+        _batcher.draw(*_camera, [this](UnsignedInt, GL::Mesh& mesh) {
+            _shader.draw(mesh);
+        });
     }
 
     /* Debug draw. If drawing on top of cubes, avoid flickering by setting
@@ -287,14 +242,13 @@ void BulletExample::drawEvent() {
 
         _debugDraw.setTransformationProjectionMatrix(
             _camera->projectionMatrix()*_camera->cameraMatrix());
-        _bWorld.debugDrawWorld();
+        _physics.debugDraw(_debugDraw);
 
         if(_drawCubes)
             GL::Renderer::setDepthFunction(GL::Renderer::DepthFunction::Less);
     }
 
     swapBuffers();
-    _timeline.nextFrame();
     redraw();
 }
 
@@ -339,24 +293,15 @@ void BulletExample::mousePressEvent(MouseEvent& event) {
         const Vector2 clickPoint = Vector2::yScale(-1.0f)*(Vector2{position}/Vector2{framebufferSize()} - Vector2{0.5f})*_camera->projectionSize();
         const Vector3 direction = (_cameraObject->absoluteTransformation().rotationScaling()*Vector3{clickPoint, -1.0f}).normalized();
 
-        auto* object = new RigidBody{
-            &_scene,
+        /* Create either a box or a sphere, with an initial velocity */
+        addBody(
+            _shootBox ? static_cast<btCollisionShape&>(_bBoxShape) : _bSphereShape,
             _shootBox ? 1.0f : 5.0f,
-            _shootBox ? static_cast<btCollisionShape*>(&_bBoxShape) : &_bSphereShape,
-            _bWorld};
-        object->translate(_cameraObject->absoluteTransformation().translation());
-        /* Has to be done explicitly after the translate() above, as Magnum ->
-           Bullet updates are implicitly done only for kinematic bodies */
-        object->syncPose();
-
-        /* Create either a box or a sphere */
-        new ColoredDrawable{*object,
-            _shootBox ? _boxInstanceData : _sphereInstanceData,
+            Matrix4::translation(_cameraObject->absoluteTransformation().translation()),
+            direction*25.0f,
+            _shootBox ? _box : _sphere,
             _shootBox ? 0x880000_rgbf : 0x220000_rgbf,
-            Matrix4::scaling(Vector3{_shootBox ? 0.5f : 0.25f}), _drawables};
-
-        /* Give it an initial velocity */
-        object->rigidBody().setLinearVelocity(btVector3{direction*25.f});
+            Matrix4::scaling(Vector3{_shootBox ? 0.5f : 0.25f}));
 
         event.setAccepted();
     }
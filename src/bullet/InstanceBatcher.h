@@ -0,0 +1,240 @@
+#ifndef Magnum_Examples_Bullet_InstanceBatcher_h
+#define Magnum_Examples_Bullet_InstanceBatcher_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <algorithm>
+#include <functional>
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/MeshTools/Compile.h>
+#include <Magnum/SceneGraph/AbstractObject.h>
+#include <Magnum/SceneGraph/Camera.h>
+#include <Magnum/SceneGraph/Drawable.h>
+#include <Magnum/Trade/MeshData.h>
+
+namespace Magnum { namespace Examples {
+
+template<class T> class InstanceBatcher;
+
+/* Drawable that doesn't draw anything on its own, it only provides instance
+   data for its batch in an InstanceBatcher */
+template<class T> class InstancedDrawable: public SceneGraph::Drawable3D {
+    public:
+        explicit InstancedDrawable(SceneGraph::AbstractObject3D& object, InstanceBatcher<T>& batcher, UnsignedInt mesh, UnsignedInt material): SceneGraph::Drawable3D{object, &batcher.drawables()}, _batch{batcher.batch(mesh, material)} {}
+
+        UnsignedInt batch() const { return _batch; }
+
+        /* Instance data for given transformation relative to the camera */
+        virtual T instance(const Matrix4& transformation) const = 0;
+
+    private:
+        /* Drawn together with the rest of the batch by the batcher */
+        void draw(const Matrix4&, SceneGraph::Camera3D&) override {}
+
+        UnsignedInt _batch;
+};
+
+/* Draws all InstancedDrawable instances that share the same mesh and
+   material in a single instanced draw call. Meshes are added with addMesh(),
+   each drawable then picks a mesh and an arbitrary material ID and a batch
+   is created for every such combination on first use.
+
+   In draw(), transformations of all drawables are calculated in a single
+   pass over the scene and their instance data filled into a persistent
+   staging array, already grouped by batch. Each batch has a ring
+   of FrameCount instance buffers, every frame the next one is taken. The
+   buffers are allocated once and grow only when the batch does, so the
+   upload doesn't reallocate anything and doesn't overwrite data the GPU may
+   still be drawing from.
+
+   This is a helper of this example and not a general-purpose batcher. The
+   fill is serial, which for the few hundred bodies here costs less than the
+   transformation pass before it, and only 3D scenes are handled. */
+template<class T> class InstanceBatcher {
+    public:
+        /* Instance buffers in the ring of each batch */
+        enum: std::size_t { FrameCount = 3 };
+
+        /* The attributes describe the layout of T and get added to the
+           instance buffer of every batch */
+        template<class ...Attributes> explicit InstanceBatcher(const Attributes&... attributes): _addAttributes{[attributes...](GL::Mesh& mesh, GL::Buffer& buffer) {
+            mesh.addVertexBufferInstanced(buffer, 1, 0, attributes...);
+        }} {}
+
+        SceneGraph::DrawableGroup3D& drawables() { return _drawables; }
+
+        /* Uploads the vertex and index data and returns ID of the mesh. The
+           data are kept so every batch can get meshes of its own that share
+           these buffers and differ only in the instance buffer. */
+        UnsignedInt addMesh(Trade::MeshData&& data) {
+            _meshes.emplace_back(std::move(data));
+            Mesh& mesh = _meshes.back();
+            mesh.vertices.setData(mesh.data.vertexData());
+            if(mesh.data.isIndexed())
+                mesh.indices.setData(mesh.data.indexData());
+            return UnsignedInt(_meshes.size() - 1);
+        }
+
+        std::size_t batchCount() const { return _batches.size(); }
+
+        /* Returns ID of a batch with given mesh and material, creating it
+           if it doesn't exist yet */
+        UnsignedInt batch(UnsignedInt mesh, UnsignedInt material) {
+            for(std::size_t i = 0; i != _batches.size(); ++i)
+                if(_batches[i].mesh == mesh && _batches[i].material == material)
+                    return UnsignedInt(i);
+
+            CORRADE_INTERNAL_ASSERT(mesh < _meshes.size());
+            _batches.emplace_back();
+            Batch& batch = _batches.back();
+            batch.mesh = mesh;
+            batch.material = material;
+            for(std::size_t i = 0; i != FrameCount; ++i) {
+                batch.meshes[i] = MeshTools::compile(_meshes[mesh].data, _meshes[mesh].indices, _meshes[mesh].vertices);
+                _addAttributes(batch.meshes[i], batch.buffers[i]);
+            }
+
+            /* Batches are drawn ordered by material and then mesh to have
+               as few state changes as possible */
+            const UnsignedInt id = UnsignedInt(_batches.size() - 1);
+            _order.insert(std::upper_bound(_order.begin(), _order.end(), id, [this](UnsignedInt a, UnsignedInt b) {
+                return _batches[a].material < _batches[b].material ||
+                    (_batches[a].material == _batches[b].material && _batches[a].mesh < _batches[b].mesh);
+            }), id);
+            _cursors.push_back(0);
+            return id;
+        }
+
+        /* Instance count of given batch in the last draw() */
+        std::size_t instanceCount(UnsignedInt batch) const {
+            return _batches[batch].count;
+        }
+
+        /* Fills and uploads instance data of all drawables and calls
+           drawBatch(material, mesh) for every batch that isn't empty, with
+           the instance count already set on the mesh */
+        template<class Function> void draw(SceneGraph::Camera3D& camera, Function&& drawBatch) {
+            fill(camera.object().scene(), camera.cameraMatrix());
+
+            _frame = (_frame + 1) % FrameCount;
+            for(const UnsignedInt id: _order) {
+                Batch& batch = _batches[id];
+                if(!batch.count) continue;
+
+                GL::Buffer& buffer = batch.buffers[_frame];
+                std::size_t& capacity = batch.capacities[_frame];
+                if(capacity < batch.count) {
+                    capacity = Math::max(batch.count, 2*capacity);
+                    buffer.setData({nullptr, capacity*sizeof(T)}, GL::BufferUsage::DynamicDraw);
+                }
+                buffer.setSubData(0, Containers::arrayView(_staging.data() + batch.offset, batch.count));
+
+                GL::Mesh& mesh = batch.meshes[_frame];
+                mesh.setInstanceCount(Int(batch.count));
+                drawBatch(batch.material, mesh);
+            }
+        }
+
+    private:
+        struct Mesh {
+            explicit Mesh(Trade::MeshData&& data): data{std::move(data)} {}
+
+            Trade::MeshData data;
+            GL::Buffer vertices;
+            GL::Buffer indices{GL::Buffer::TargetHint::ElementArray};
+        };
+
+        struct Batch {
+            UnsignedInt mesh, material;
+            GL::Buffer buffers[FrameCount];
+            GL::Mesh meshes[FrameCount];
+            std::size_t capacities[FrameCount]{};
+            /* Range in the staging array in the last draw() */
+            std::size_t offset = 0, count = 0;
+        };
+
+        InstancedDrawable<T>& drawable(std::size_t i) {
+            return static_cast<InstancedDrawable<T>&>(_drawables[i]);
+        }
+
+        void fill(SceneGraph::AbstractObject3D* scene, const Matrix4& cameraMatrix) {
+            for(Batch& batch: _batches) batch.count = 0;
+
+            const std::size_t count = _drawables.size();
+            if(!count || !scene) return;
+
+            /* Transformations of all drawables relative to the camera, in a
+               single pass over the scene */
+            _objects.clear();
+            for(std::size_t i = 0; i != count; ++i)
+                _objects.push_back(_drawables[i].object());
+            _transformations = scene->transformationMatrices(_objects, cameraMatrix);
+
+            /* Give each drawable a slot in the staging array so the batches
+               end up contiguous, in the order they're drawn */
+            _slots.resize(count);
+            for(std::size_t i = 0; i != count; ++i)
+                ++_batches[drawable(i).batch()].count;
+            std::size_t offset = 0;
+            for(const UnsignedInt id: _order) {
+                _batches[id].offset = offset;
+                _cursors[id] = UnsignedInt(offset);
+                offset += _batches[id].count;
+            }
+            for(std::size_t i = 0; i != count; ++i)
+                _slots[i] = _cursors[drawable(i).batch()]++;
+
+            if(_staging.size() < count) _staging.resize(count);
+            for(std::size_t i = 0; i != count; ++i)
+                _staging[_slots[i]] = drawable(i).instance(_transformations[i]);
+        }
+
+        std::function<void(GL::Mesh&, GL::Buffer&)> _addAttributes;
+        SceneGraph::DrawableGroup3D _drawables;
+        std::vector<Mesh> _meshes;
+        std::vector<Batch> _batches;
+        std::vector<UnsignedInt> _order, _cursors;
+        std::size_t _frame = 0;
+
+        /* Scratch state of draw(), kept to avoid allocating every frame */
+        std::vector<std::reference_wrapper<SceneGraph::AbstractObject3D>> _objects;
+        std::vector<Matrix4> _transformations;
+        std::vector<UnsignedInt> _slots;
+        std::vector<T> _staging;
+};
+
+}}
+
+#endif
@@ -0,0 +1,218 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include "PhysicsWorld.h"
+
+#include <Magnum/Math/Functions.h>
+#include <Magnum/BulletIntegration/Integration.h>
+
+namespace Magnum { namespace Examples {
+
+PhysicsWorld::PhysicsWorld(const Vector3& gravity, const Float fixedStep, const UnsignedInt maxSubsteps, const Float removalDistance): _fixedStep{fixedStep}, _removalDistanceSquared{removalDistance*removalDistance}, _maxSubsteps{maxSubsteps}, _fixedStepDuration{std::chrono::duration_cast<Clock::duration>(std::chrono::duration<Float>{fixedStep})} {
+    _bWorld.setGravity(btVector3{gravity});
+    _nextStep = _state.time = Clock::now();
+    _thread = std::thread{&PhysicsWorld::run, this};
+}
+
+PhysicsWorld::~PhysicsWorld() {
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        _quit = true;
+    }
+    _condition.notify_one();
+    _thread.join();
+
+    for(Containers::Pointer<btRigidBody>& body: _bodies)
+        if(body) _bWorld.removeRigidBody(body.get());
+}
+
+UnsignedInt PhysicsWorld::addBody(btCollisionShape& shape, const Float mass, const Matrix4& transformation, const Vector3& linearVelocity) {
+    UnsignedInt id;
+    if(!_freeIds.empty()) {
+        id = _freeIds.back();
+        _freeIds.pop_back();
+    } else id = _nextId++;
+
+    std::lock_guard<std::mutex> lock{_mutex};
+    _commands.push_back({id, &shape, mass, transformation, linearVelocity});
+    return id;
+}
+
+void PhysicsWorld::sync(std::vector<UnsignedInt>& removed) {
+    removed.clear();
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        if(_fresh) {
+            std::swap(_front, _latest);
+            _fresh = false;
+        }
+
+        /* The removals come together with the snapshot they happened in, so
+           an ID can't be reused while an older snapshot still has the body
+           in it */
+        removed.swap(_removedShared);
+    }
+    _freeIds.insert(_freeIds.end(), removed.begin(), removed.end());
+
+    /* Everything is shown one step late, so there's always a pair of steps
+       to interpolate between */
+    const Float elapsed = std::chrono::duration<Float>{Clock::now() - _front->time}.count();
+    _alpha = Math::clamp(elapsed/_fixedStep, 0.0f, 1.0f);
+}
+
+void PhysicsWorld::debugDraw(btIDebugDraw& drawer) {
+    std::lock_guard<std::mutex> lock{_worldMutex};
+    _bWorld.setDebugDrawer(&drawer);
+    _bWorld.debugDrawWorld();
+}
+
+void PhysicsWorld::run() {
+    std::vector<Command> commands;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _condition.wait_until(lock, _nextStep, [this]{ return _quit; });
+            if(_quit) return;
+            commands.swap(_commands);
+        }
+
+        const Clock::time_point now = Clock::now();
+        {
+            std::lock_guard<std::mutex> lock{_worldMutex};
+            addBodies(commands);
+            commands.clear();
+
+            /* Catch up with the wall clock in fixed steps. If too far
+               behind, drop the rest instead of spending even more time in
+               the next iteration. */
+            for(UnsignedInt i = 0; i != _maxSubsteps && _nextStep <= now; ++i) {
+                step();
+                _state.time = _nextStep;
+                _nextStep += _fixedStepDuration;
+            }
+            if(_nextStep <= now) {
+                _state.time = now;
+                _nextStep = now + _fixedStepDuration;
+            }
+        }
+
+        publish();
+    }
+}
+
+void PhysicsWorld::addBodies(const std::vector<Command>& commands) {
+    for(const Command& command: commands) {
+        /* Calculate inertia so the object reacts as it should with rotation
+           and everything */
+        btVector3 bInertia{0.0f, 0.0f, 0.0f};
+        if(!Math::TypeTraits<Float>::equals(command.mass, 0.0f))
+            command.shape->calculateLocalInertia(command.mass, bInertia);
+
+        btRigidBody::btRigidBodyConstructionInfo info{command.mass, nullptr, command.shape, bInertia};
+        info.m_startWorldTransform = btTransform{command.transformation};
+
+        const UnsignedInt id = command.id;
+        if(id >= _bodies.size()) {
+            _bodies.resize(id + 1);
+            _state.previousPositions.resize(id + 1);
+            _state.positions.resize(id + 1);
+            _state.previousRotations.resize(id + 1);
+            _state.rotations.resize(id + 1);
+            _state.valid.resize(id + 1);
+            _wasActive.resize(id + 1);
+        }
+
+        Containers::Pointer<btRigidBody>& body = _bodies[id];
+        body.emplace(info);
+        body->setLinearVelocity(btVector3{command.linearVelocity});
+        _bWorld.addRigidBody(body.get());
+
+        const btTransform& transformation = body->getWorldTransform();
+        _state.previousPositions[id] = _state.positions[id] = Vector3{transformation.getOrigin()};
+        _state.previousRotations[id] = _state.rotations[id] = Quaternion{transformation.getRotation()};
+        _state.valid[id] = 1;
+        _wasActive[id] = 1;
+    }
+}
+
+void PhysicsWorld::step() {
+    _state.previousPositions = _state.positions;
+    _state.previousRotations = _state.rotations;
+
+    _bWorld.stepSimulation(_fixedStep, 0);
+
+    /* Sleeping and static bodies keep their pose. A body that fell asleep
+       in this step still moved in it, so bodies that were active in the
+       previous step get their pose updated as well. Bodies too far away are
+       removed only after going through all, so the world isn't modified
+       while iterating. */
+    const std::size_t removedBefore = _removed.size();
+    for(std::size_t id = 0; id != _bodies.size(); ++id) {
+        btRigidBody* body = _bodies[id].get();
+        if(!body || body->isStaticObject()) continue;
+        const bool active = body->isActive();
+        const bool wasActive = _wasActive[id];
+        _wasActive[id] = active;
+        if(!active && !wasActive) continue;
+
+        const btTransform& transformation = body->getWorldTransform();
+        const Vector3 position{transformation.getOrigin()};
+        if(position.dot() > _removalDistanceSquared) {
+            _removed.push_back(UnsignedInt(id));
+            continue;
+        }
+
+        _state.positions[id] = position;
+        _state.rotations[id] = Quaternion{transformation.getRotation()};
+    }
+
+    for(std::size_t i = removedBefore; i != _removed.size(); ++i) {
+        const UnsignedInt id = _removed[i];
+        _bWorld.removeRigidBody(_bodies[id].get());
+        _bodies[id] = nullptr;
+        _state.valid[id] = 0;
+    }
+}
+
+void PhysicsWorld::publish() {
+    /* Copying into the back buffer reuses its memory, so it's just a few
+       memcpy()s */
+    *_back = _state;
+
+    {
+        std::lock_guard<std::mutex> lock{_mutex};
+        std::swap(_back, _latest);
+        _fresh = true;
+        _removedShared.insert(_removedShared.end(), _removed.begin(), _removed.end());
+    }
+    _removed.clear();
+}
+
+}}
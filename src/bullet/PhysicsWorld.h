@@ -0,0 +1,167 @@
+#ifndef Magnum_Examples_Bullet_PhysicsWorld_h
+#define Magnum_Examples_Bullet_PhysicsWorld_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <btBulletDynamicsCommon.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Quaternion.h>
+
+namespace Magnum { namespace Examples {
+
+/* Bullet dynamics world stepped on its own thread with a fixed time step.
+   Bodies are referred to by IDs handed out by addBody(). Poses come back in
+   snapshots with the last two steps of all bodies as plain arrays, which
+   the render thread interpolates between, so the result moves smoothly
+   independently of the frame rate. Bodies that fall too far away are
+   removed by the physics thread, all at once after a step, and reported
+   back in sync().
+
+   Except for the constructor and destructor, all functions are meant to be
+   called from a single thread, usually the one that renders. */
+class PhysicsWorld {
+    public:
+        /* If the physics thread is behind by more than maxSubsteps steps,
+           the rest of the time is dropped and the simulation slows down */
+        explicit PhysicsWorld(const Vector3& gravity, Float fixedStep = 1.0f/60.0f, UnsignedInt maxSubsteps = 5, Float removalDistance = 100.0f);
+
+        ~PhysicsWorld();
+
+        /* Queues a body for addition on the next step and returns its ID.
+           The shape has to stay alive as long as the body, mass of zero
+           makes it static. */
+        UnsignedInt addBody(btCollisionShape& shape, Float mass, const Matrix4& transformation, const Vector3& linearVelocity = {});
+
+        /* Takes the latest snapshot from the physics thread. IDs of bodies
+           removed since the last call are put into removed, they get reused
+           by addBody() only after that. */
+        void sync(std::vector<UnsignedInt>& removed);
+
+        /* Calls f(id, transformation) for all bodies in the snapshot taken
+           by the last sync(), interpolated for the time of that call */
+        template<class F> void interpolate(F&& f) const;
+
+        /* Draws the world with given drawer. Waits for the current step to
+           finish. */
+        void debugDraw(btIDebugDraw& drawer);
+
+    private:
+        typedef std::chrono::steady_clock Clock;
+
+        struct Command {
+            UnsignedInt id;
+            btCollisionShape* shape;
+            Float mass;
+            Matrix4 transformation;
+            Vector3 linearVelocity;
+        };
+
+        /* Poses of the last two steps, indexed by body ID. Bodies that don't
+           exist or weren't added yet have valid set to 0. */
+        struct Snapshot {
+            std::vector<Vector3> previousPositions, positions;
+            std::vector<Quaternion> previousRotations, rotations;
+            std::vector<UnsignedByte> valid;
+            /* Time for which positions are the current state */
+            Clock::time_point time;
+        };
+
+        void run();
+        void addBodies(const std::vector<Command>& commands);
+        void step();
+        void publish();
+
+        Float _fixedStep, _removalDistanceSquared;
+        UnsignedInt _maxSubsteps;
+        Clock::duration _fixedStepDuration;
+
+        btDbvtBroadphase _bBroadphase;
+        btDefaultCollisionConfiguration _bCollisionConfig;
+        btCollisionDispatcher _bDispatcher{&_bCollisionConfig};
+        btSequentialImpulseConstraintSolver _bSolver;
+        btDiscreteDynamicsWorld _bWorld{&_bDispatcher, &_bBroadphase, &_bSolver, &_bCollisionConfig};
+
+        /* Physics thread only. The current state gets copied to the back
+           snapshot when published. */
+        std::vector<Containers::Pointer<btRigidBody>> _bodies;
+        /* Whether the body was active after the previous step, indexed by
+           body ID */
+        std::vector<UnsignedByte> _wasActive;
+        std::vector<UnsignedInt> _removed;
+        Snapshot _state;
+        Clock::time_point _nextStep;
+
+        /* Render thread only */
+        std::vector<UnsignedInt> _freeIds;
+        UnsignedInt _nextId = 0;
+        Float _alpha = 1.0f;
+
+        /* Triple buffer of snapshots, _latest and everything below it is
+           protected by _mutex */
+        Snapshot _snapshots[3];
+        Snapshot *_back = _snapshots, *_front = _snapshots + 1, *_latest = _snapshots + 2;
+        bool _fresh = false;
+        std::vector<UnsignedInt> _removedShared;
+        std::vector<Command> _commands;
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        bool _quit = false;
+
+        /* Held by the physics thread while it accesses the world */
+        std::mutex _worldMutex;
+        std::thread _thread;
+};
+
+template<class F> void PhysicsWorld::interpolate(F&& f) const {
+    const Snapshot& s = *_front;
+    for(std::size_t id = 0; id != s.valid.size(); ++id) {
+        if(!s.valid[id]) continue;
+
+        /* Normalized lerp along the shorter arc is close enough for steps
+           this small */
+        const Quaternion& a = s.previousRotations[id];
+        const Quaternion& b = s.rotations[id];
+        const Float sign = Math::dot(a, b) < 0.0f ? -1.0f : 1.0f;
+        const Quaternion rotation = (a*(1.0f - _alpha) + b*(sign*_alpha)).normalized();
+        const Vector3 position = Math::lerp(s.previousPositions[id], s.positions[id], _alpha);
+        f(UnsignedInt(id), Matrix4::from(rotation.toMatrix(), position));
+    }
+}
+
+}}
+
+#endif
@@ -0,0 +1,147 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Checkpoint.h"
+
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+constexpr char Magic[8]{'M', 'N', 'F', 'L', 'U', 'I', 'D', '\0'};
+
+std::size_t aligned(std::size_t offset) {
+    return (offset + CheckpointAlignment - 1)/CheckpointAlignment*CheckpointAlignment;
+}
+
+}
+
+CheckpointWriter::CheckpointWriter(const Containers::StringView kind, const UnsignedInt payloadVersion): _payloadVersion{payloadVersion} {
+    CORRADE_INTERNAL_ASSERT(kind.size() < sizeof(_kind));
+    std::memcpy(_kind, kind.data(), kind.size());
+}
+
+CheckpointWriter& CheckpointWriter::add(const UnsignedInt id, const std::size_t elementSize, const std::size_t count, const void* const data) {
+    /* Offsets are relative to the file start, which is header size before
+       the data */
+    _data.resize(aligned(_data.size()));
+    _entries.push_back({id, UnsignedInt(elementSize), count, sizeof(Checkpoint::Header) + _data.size(), 0});
+    const char* const bytes = static_cast<const char*>(data);
+    _data.insert(_data.end(), bytes, bytes + elementSize*count);
+    return *this;
+}
+
+bool CheckpointWriter::write(const Containers::StringView filename) const {
+    /* The table goes after the data, aligned as well */
+    const std::size_t tableOffset = aligned(sizeof(Checkpoint::Header) + _data.size());
+    const std::vector<char> tablePadding(tableOffset - sizeof(Checkpoint::Header) - _data.size());
+
+    Checkpoint::Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = CheckpointVersion;
+    header.arrayCount = UnsignedInt(_entries.size());
+    std::memcpy(header.kind, _kind, sizeof(_kind));
+    header.fileSize = tableOffset + _entries.size()*sizeof(Entry);
+    header.tableOffset = tableOffset;
+    header.payloadVersion = _payloadVersion;
+
+    return Utility::Path::write(filename, Containers::arrayView(&header, 1)) &&
+        Utility::Path::append(filename, Containers::arrayView(_data)) &&
+        Utility::Path::append(filename, Containers::arrayView(tablePadding)) &&
+        Utility::Path::append(filename, Containers::arrayView(_entries));
+}
+
+Containers::Optional<Checkpoint> Checkpoint::open(const Containers::StringView filename, const Containers::StringView kind, const UnsignedInt payloadVersion) {
+    Containers::Optional<Containers::Array<const char, Utility::Path::MapDeleter>> data = Utility::Path::mapRead(filename);
+    if(!data) return {};
+
+    if(data->size() < sizeof(Header)) {
+        Error{} << "Checkpoint:" << filename << "is too short";
+        return {};
+    }
+    const Header& header = *reinterpret_cast<const Header*>(data->data());
+    if(std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+        Error{} << "Checkpoint:" << filename << "is not a checkpoint";
+        return {};
+    }
+    if(header.version != CheckpointVersion) {
+        Error{} << "Checkpoint: unsupported version" << header.version << "of" << filename;
+        return {};
+    }
+    if(header.fileSize != data->size()) {
+        Error{} << "Checkpoint: expected" << header.fileSize << "bytes in" << filename << "but got" << data->size();
+        return {};
+    }
+    if(header.kind[sizeof(header.kind) - 1] != '\0' || Containers::StringView{header.kind} != kind) {
+        Error{} << "Checkpoint:" << filename << "is not a checkpoint of" << kind;
+        return {};
+    }
+    if(header.payloadVersion != payloadVersion) {
+        Error{} << "Checkpoint: unsupported" << kind << "version" << header.payloadVersion << "of" << filename;
+        return {};
+    }
+
+    /* Check that everything is in bounds, so the accessors don't need to */
+    if(header.tableOffset % CheckpointAlignment || header.tableOffset > data->size() ||
+       header.arrayCount > (data->size() - header.tableOffset)/sizeof(Entry)) {
+        Error{} << "Checkpoint: array table out of bounds in" << filename;
+        return {};
+    }
+    const Entry* entries = reinterpret_cast<const Entry*>(data->data() + header.tableOffset);
+    for(std::size_t i = 0; i != header.arrayCount; ++i) {
+        const Entry& entry = entries[i];
+        if(entry.offset % CheckpointAlignment || entry.offset > data->size() ||
+           (entry.elementSize && entry.count > (data->size() - entry.offset)/entry.elementSize)) {
+            Error{} << "Checkpoint: array" << entry.id << "out of bounds in" << filename;
+            return {};
+        }
+    }
+
+    return Checkpoint{std::move(*data)};
+}
+
+const Checkpoint::Entry* Checkpoint::find(const UnsignedInt id, const std::size_t elementSize) const {
+    const Header& header = *reinterpret_cast<const Header*>(_data.data());
+    const Entry* entries = reinterpret_cast<const Entry*>(_data.data() + header.tableOffset);
+    for(std::size_t i = 0; i != header.arrayCount; ++i) {
+        if(entries[i].id != id) continue;
+        if(entries[i].elementSize != elementSize) {
+            Error{} << "Checkpoint: expected" << elementSize << "byte elements in array" << id << "but got" << entries[i].elementSize;
+            return nullptr;
+        }
+        return &entries[i];
+    }
+    return nullptr;
+}
+
+}}
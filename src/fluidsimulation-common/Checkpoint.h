@@ -0,0 +1,154 @@
+#ifndef Magnum_Examples_FluidSimulation_Checkpoint_h
+#define Magnum_Examples_FluidSimulation_Checkpoint_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <vector>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/StringView.h>
+#include <Corrade/Utility/Path.h>
+#include <Magnum/Magnum.h>
+
+namespace Magnum { namespace Examples {
+
+/* Checkpoint of a solver state. The file consists of a header, the array
+   data and a table of the arrays, each array starting at a 64-byte aligned
+   offset. Nothing is parsed on load -- the file is mapped into memory and
+   the arrays are either viewed in place or copied out with a single
+   memcpy(). The data are stored with native byte order and type layout, so
+   a checkpoint is meant to be read on the platform it was written on.
+
+   Used by both fluid simulation examples. What the arrays contain is up to
+   each solver, which versions it separately from the container. */
+/* Incremented on any change in the container layout. Version 3 added the
+   payload version to the header. */
+enum: UnsignedInt { CheckpointVersion = 3 };
+enum: std::size_t { CheckpointAlignment = 64 };
+
+class CheckpointWriter {
+    public:
+        /* Kind identifies the solver, at most 15 characters. Payload
+           version is incremented by the solver on any change in what it
+           stores, checkpoints with a different one are rejected. */
+        explicit CheckpointWriter(Containers::StringView kind, UnsignedInt payloadVersion);
+
+        /* The data are copied, so they don't need to stay alive */
+        CheckpointWriter& add(UnsignedInt id, std::size_t elementSize, std::size_t count, const void* data);
+
+        template<class T> CheckpointWriter& add(UnsignedInt id, const std::vector<T>& data) {
+            return add(id, sizeof(T), data.size(), data.data());
+        }
+
+        template<class T> CheckpointWriter& addValue(UnsignedInt id, const T& value) {
+            return add(id, sizeof(T), 1, &value);
+        }
+
+        bool write(Containers::StringView filename) const;
+
+    private:
+        friend class Checkpoint;
+
+        struct Entry {
+            UnsignedInt id;
+            UnsignedInt elementSize;
+            UnsignedLong count;
+            UnsignedLong offset;
+            UnsignedLong padding;
+        };
+
+        char _kind[16]{};
+        UnsignedInt _payloadVersion;
+        /* Array data, placed right after the header in the file */
+        std::vector<char> _data;
+        std::vector<Entry> _entries;
+};
+
+class Checkpoint {
+    public:
+        /* Map the file and check that it's a checkpoint of given kind and
+           payload version with all arrays in bounds. Prints a message and
+           returns an empty optional on failure. */
+        static Containers::Optional<Checkpoint> open(Containers::StringView filename, Containers::StringView kind, UnsignedInt payloadVersion);
+
+        /* View on an array directly in the mapped file, empty if the array
+           isn't there or its type doesn't match */
+        template<class T> Containers::ArrayView<const T> view(UnsignedInt id) const {
+            const Entry* entry = find(id, sizeof(T));
+            if(!entry) return {};
+            return {reinterpret_cast<const T*>(_data.data() + entry->offset), std::size_t(entry->count)};
+        }
+
+        /* Copy an array out of the file, returns false if it isn't there or
+           its type doesn't match */
+        template<class T> bool read(UnsignedInt id, std::vector<T>& out) const {
+            const Entry* entry = find(id, sizeof(T));
+            if(!entry) return false;
+            out.resize(std::size_t(entry->count));
+            if(entry->count)
+                std::memcpy(out.data(), _data.data() + entry->offset, std::size_t(entry->count)*sizeof(T));
+            return true;
+        }
+
+        template<class T> bool readValue(UnsignedInt id, T& out) const {
+            const Entry* entry = find(id, sizeof(T));
+            if(!entry || entry->count != 1) return false;
+            std::memcpy(&out, _data.data() + entry->offset, sizeof(T));
+            return true;
+        }
+
+    private:
+        friend class CheckpointWriter;
+
+        struct Header {
+            char magic[8];
+            UnsignedInt version;
+            UnsignedInt arrayCount;
+            char kind[16];
+            UnsignedLong fileSize;
+            UnsignedLong tableOffset;
+            UnsignedInt payloadVersion;
+            char padding[12];
+        };
+
+        using Entry = CheckpointWriter::Entry;
+
+        explicit Checkpoint(Containers::Array<const char, Utility::Path::MapDeleter>&& data): _data{std::move(data)} {}
+
+        const Entry* find(UnsignedInt id, std::size_t elementSize) const;
+
+        Containers::Array<const char, Utility::Path::MapDeleter> _data;
+};
+
+}}
+
+#endif
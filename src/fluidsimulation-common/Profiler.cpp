@@ -0,0 +1,183 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "Profiler.h"
+
+#include <algorithm>
+#include <sstream>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Utility/Path.h>
+
+/* Not next to this file, the example compiling it has to provide it */
+#include "TaskScheduler.h"
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+bool writeString(const Containers::StringView filename, const std::string& string) {
+    return Utility::Path::write(filename, Containers::arrayView(string.data(), string.size()));
+}
+
+}
+
+Profiler::Profiler(const std::size_t capacity): _start{std::chrono::steady_clock::now()}, _events(capacity) {}
+
+Double Profiler::now() const {
+    return std::chrono::duration<Double, std::micro>(std::chrono::steady_clock::now() - _start).count();
+}
+
+void Profiler::beginFrame() {
+    if(_tracking != _enabled) {
+        _tracking = _enabled;
+        TaskScheduler::setBusyTimeTracking(_tracking);
+    }
+    ++_frame;
+}
+
+void Profiler::addCounter(const char* const name, const Double value) {
+    if(!_tracking) return;
+    Event event{EventType::Counter, name, _frame, now(), 0.0, value, {}};
+    record(event);
+}
+
+void Profiler::record(Event& event) {
+    std::lock_guard<std::mutex> lock{_mutex};
+    Event& slot = _events[_eventCount++ % _events.size()];
+    slot.type = event.type;
+    slot.name = event.name;
+    slot.frame = event.frame;
+    slot.time = event.time;
+    slot.duration = event.duration;
+    slot.value = event.value;
+    /* Stages swap the busy time vectors with the slot to avoid allocations
+       once the buffer wraps around, counters keep the slot capacity */
+    if(event.type == EventType::Stage)
+        slot.threadBusyTime.swap(event.threadBusyTime);
+    else slot.threadBusyTime.clear();
+}
+
+std::vector<Profiler::Event> Profiler::events() const {
+    std::lock_guard<std::mutex> lock{_mutex};
+    std::vector<Event> out;
+    const std::size_t count = std::min(_eventCount, _events.size());
+    out.reserve(count);
+    for(std::size_t i = _eventCount - count; i != _eventCount; ++i)
+        out.push_back(_events[i % _events.size()]);
+    return out;
+}
+
+void Profiler::clear() {
+    std::lock_guard<std::mutex> lock{_mutex};
+    _eventCount = 0;
+}
+
+bool Profiler::exportChromeTrace(const Containers::StringView filename) const {
+    /* The trace event format expects microseconds, stages go to a single
+       track, busy time of each thread and counters are shown as graphs */
+    std::ostringstream out;
+    out.precision(3);
+    out << std::fixed << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+    for(const Event& event: events()) {
+        if(!first) out << ",\n";
+        first = false;
+
+        if(event.type == EventType::Counter) {
+            out << "{\"name\":\"" << event.name << "\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":"
+                << event.time << ",\"args\":{\"value\":" << event.value << "}}";
+            continue;
+        }
+
+        out << "{\"name\":\"" << event.name << "\",\"cat\":\"stage\",\"ph\":\"X\",\"pid\":1,\"tid\":1,\"ts\":"
+            << event.time << ",\"dur\":" << event.duration
+            << ",\"args\":{\"frame\":" << event.frame << "}}";
+        if(event.threadBusyTime.empty()) continue;
+        out << ",\n{\"name\":\"" << event.name << " busy us\",\"ph\":\"C\",\"pid\":1,\"tid\":1,\"ts\":"
+            << event.time << ",\"args\":{";
+        for(std::size_t i = 0; i != event.threadBusyTime.size(); ++i)
+            out << (i ? ",\"thread " : "\"thread ") << i << "\":" << event.threadBusyTime[i];
+        out << "}}";
+    }
+    out << "\n]}\n";
+    return writeString(filename, out.str());
+}
+
+bool Profiler::exportCsv(const Containers::StringView filename) const {
+    const std::vector<Event> recorded = events();
+    std::size_t threadCount = 0;
+    for(const Event& event: recorded)
+        threadCount = std::max(threadCount, event.threadBusyTime.size());
+
+    std::ostringstream out;
+    out.precision(3);
+    out << std::fixed << "frame,type,name,time_us,duration_us,value";
+    for(std::size_t i = 0; i != threadCount; ++i)
+        out << ",thread" << i << "_busy_us";
+    out << '\n';
+
+    for(const Event& event: recorded) {
+        out << event.frame << ',' << (event.type == EventType::Stage ? "stage" : "counter")
+            << ',' << event.name << ',' << event.time << ',' << event.duration
+            << ',' << event.value;
+        for(std::size_t i = 0; i != threadCount; ++i) {
+            out << ',';
+            if(i < event.threadBusyTime.size()) out << event.threadBusyTime[i];
+        }
+        out << '\n';
+    }
+    return writeString(filename, out.str());
+}
+
+void Profiler::Stage::begin() {
+    std::vector<std::vector<Double>>& stack = _profiler->_busyTimeStack;
+    if(stack.size() == _profiler->_stageDepth) stack.emplace_back();
+    TaskScheduler::busyTime(stack[_profiler->_stageDepth++]);
+    _begin = _profiler->now();
+}
+
+void Profiler::Stage::end() {
+    const Double end = _profiler->now();
+    const std::vector<Double>& busyTimeBegin = _profiler->_busyTimeStack[--_profiler->_stageDepth];
+    std::vector<Double>& busyTimeEnd = _profiler->_busyTimeEnd;
+    TaskScheduler::busyTime(busyTimeEnd);
+
+    for(std::size_t i = 0; i != busyTimeEnd.size(); ++i)
+        busyTimeEnd[i] = (busyTimeEnd[i] - (i < busyTimeBegin.size() ? busyTimeBegin[i] : 0.0))*1.0e6;
+
+    /* The vector gets swapped with the one in the ring buffer slot, so
+       keeping what comes back to reuse its storage next time */
+    Event event{EventType::Stage, _name, _profiler->_frame, _begin, end - _begin, 0.0, {}};
+    event.threadBusyTime.swap(busyTimeEnd);
+    _profiler->record(event);
+    busyTimeEnd.swap(event.threadBusyTime);
+}
+
+}}
@@ -0,0 +1,144 @@
+#ifndef Magnum_Examples_FluidSimulation_Profiler_h
+#define Magnum_Examples_FluidSimulation_Profiler_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <vector>
+#include <Corrade/Containers/StringView.h>
+#include <Magnum/Magnum.h>
+
+namespace Magnum { namespace Examples {
+
+/* Records wall time of solver stages, time each thread spent in parallel
+   loops during them, and counters such as particle counts into a ring buffer
+   of fixed capacity, so it can stay enabled indefinitely. The content can be
+   exported as a Chrome trace (for chrome://tracing or https://ui.perfetto.dev)
+   or as CSV.
+
+   Stages and counters are recorded from the thread running the solver,
+   while enabling, querying and exporting can be done from any thread. When
+   disabled, a stage costs just a branch.
+
+   Used by both fluid simulation examples, each compiles it with its own
+   TaskScheduler.h, which has to be in the include path. */
+class Profiler {
+    public:
+        enum class EventType: UnsignedByte { Stage, Counter };
+
+        struct Event {
+            EventType type;
+            /* Expected to be a string literal, it's not copied */
+            const char* name;
+            UnsignedLong frame;
+            /* Begin of a stage or time of a counter sample, in microseconds
+               since the profiler was created */
+            Double time;
+            /* Wall time of a stage in microseconds, zero for counters */
+            Double duration;
+            /* Counter value, zero for stages */
+            Double value;
+            /* Time each thread spent in parallel loops of a stage, in
+               microseconds. Empty for counters. */
+            std::vector<Double> threadBusyTime;
+        };
+
+        class Stage;
+
+        explicit Profiler(std::size_t capacity = 16384);
+
+        bool isEnabled() const { return _enabled; }
+        void setEnabled(bool enabled) { _enabled = enabled; }
+
+        /* To be called by the solver at the start of each frame, applies
+           the enabled state and advances the frame index the events are
+           attributed to */
+        void beginFrame();
+
+        void addCounter(const char* name, Double value);
+
+        /* Recorded events, oldest first */
+        std::vector<Event> events() const;
+        void clear();
+
+        bool exportChromeTrace(Containers::StringView filename) const;
+        bool exportCsv(Containers::StringView filename) const;
+
+    private:
+        Double now() const;
+        void record(Event& event);
+
+        const std::chrono::steady_clock::time_point _start;
+        std::atomic<bool> _enabled{false};
+
+        /* Owned by the thread running the solver */
+        bool _tracking = false;
+        UnsignedLong _frame = 0;
+        /* Busy time at the begin of each nested stage, and at the end of the
+           innermost one */
+        std::vector<std::vector<Double>> _busyTimeStack;
+        std::size_t _stageDepth = 0;
+        std::vector<Double> _busyTimeEnd;
+
+        /* Guards the ring buffer, which is read from other threads */
+        mutable std::mutex _mutex;
+        std::vector<Event> _events;
+        std::size_t _eventCount = 0;
+};
+
+/* Measures a stage from construction to destruction. Stages can be nested,
+   the nested ones are shown inside the outer ones in the Chrome trace. */
+class Profiler::Stage {
+    public:
+        explicit Stage(Profiler& profiler, const char* name): _profiler{profiler._tracking ? &profiler : nullptr}, _name{name} {
+            if(_profiler) begin();
+        }
+
+        ~Stage() {
+            if(_profiler) end();
+        }
+
+        Stage(const Stage&) = delete;
+        Stage& operator=(const Stage&) = delete;
+
+    private:
+        void begin();
+        void end();
+
+        Profiler* _profiler;
+        const char* _name;
+        Double _begin;
+};
+
+}}
+
+#endif
@@ -82,6 +82,19 @@ template<class T> inline Math::Vector2<T> bilerpGradient(const T& v00,
     return f00 * v00 + f10 * v10 + f01 * v01 + f11 * v11;
 }
 
+/* Interleave bits of two 16-bit coordinates into a Z-order (Morton) code */
+inline UnsignedInt mortonCode2D(UnsignedInt x, UnsignedInt y) {
+    const auto spread = [](UnsignedInt v) {
+        v &= 0x0000ffffu;
+        v = (v | (v << 8)) & 0x00ff00ffu;
+        v = (v | (v << 4)) & 0x0f0f0f0fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
 template<class T> inline T smoothKernel(T r2, T h2) {
     const T t = T(1) - r2/h2;
     const T tExp3 = t*t*t;
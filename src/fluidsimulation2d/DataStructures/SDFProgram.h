@@ -0,0 +1,167 @@
+#ifndef Magnum_Examples_FluidSimulation2D_SDFProgram_h
+#define Magnum_Examples_FluidSimulation2D_SDFProgram_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Vector2.h>
+
+#include "SDFObject.h"
+
+namespace Magnum { namespace Examples {
+
+/* SDFObject tree compiled into a flat postfix program. Primitives push their
+   distance onto a value stack, boolean operations pop two values and push
+   the result. Points are evaluated in batches, with every instruction
+   executed for the whole batch at once, so the inner loops have no branches
+   or pointer chasing and can be vectorized by the compiler. */
+class SDFProgram {
+    public:
+        /* Number of points evaluated together */
+        enum: std::size_t { BatchSize = 16 };
+        /* Maximal depth of the value stack, i.e. nesting of the tree */
+        enum: std::size_t { MaxStackDepth = 16 };
+
+        explicit SDFProgram() = default;
+        explicit SDFProgram(const SDFObject& object) { compile(object); }
+
+        void compile(const SDFObject& object) {
+            _instructions.clear();
+            std::size_t depth = 0;
+            compileNode(object, depth);
+            CORRADE_INTERNAL_ASSERT(depth == 1);
+        }
+
+        bool isEmpty() const { return _instructions.empty(); }
+
+        Float signedDistance(const Vector2& pos) const {
+            Float distance;
+            signedDistances(&pos, &distance, 1);
+            return distance;
+        }
+
+        /* Evaluate signed distance of count points into distances */
+        void signedDistances(const Vector2* points, Float* distances, std::size_t count) const {
+            Float x[BatchSize], y[BatchSize];
+            Float stack[MaxStackDepth][BatchSize];
+
+            for(std::size_t offset = 0; offset < count; offset += BatchSize) {
+                const std::size_t lanes = Math::min(std::size_t(BatchSize), count - offset);
+                for(std::size_t l = 0; l < lanes; ++l) {
+                    x[l] = points[offset + l].x();
+                    y[l] = points[offset + l].y();
+                }
+
+                std::size_t top = 0;
+                for(const Instruction& instruction: _instructions) {
+                    switch(instruction.op) {
+                        case SDFObject::ObjectType::Circle: {
+                            Float* out = stack[top++];
+                            for(std::size_t l = 0; l < lanes; ++l) {
+                                const Float dx = x[l] - instruction.center.x();
+                                const Float dy = y[l] - instruction.center.y();
+                                out[l] = instruction.sign*(Math::sqrt(dx*dx + dy*dy) - instruction.radii.x());
+                            }
+                        } break;
+                        case SDFObject::ObjectType::Box: {
+                            Float* out = stack[top++];
+                            for(std::size_t l = 0; l < lanes; ++l) {
+                                const Float dx = Math::abs(x[l] - instruction.center.x()) - instruction.radii.x();
+                                const Float dy = Math::abs(y[l] - instruction.center.y()) - instruction.radii.y();
+                                const Float dax = Math::max(dx, 0.0f);
+                                const Float day = Math::max(dy, 0.0f);
+                                /* Same as SDFObject::signedDistance(), just
+                                   without branching on inside/outside */
+                                out[l] = instruction.sign*(Math::min(Math::max(dx, dy), 0.0f) + Math::sqrt(dax*dax + day*day));
+                            }
+                        } break;
+                        case SDFObject::ObjectType::Intersection: {
+                            const Float* b = stack[--top];
+                            Float* a = stack[top - 1];
+                            for(std::size_t l = 0; l < lanes; ++l)
+                                a[l] = Math::max(a[l], b[l]);
+                        } break;
+                        case SDFObject::ObjectType::Subtraction: {
+                            const Float* b = stack[--top];
+                            Float* a = stack[top - 1];
+                            for(std::size_t l = 0; l < lanes; ++l)
+                                a[l] = Math::max(a[l], -b[l]);
+                        } break;
+                        case SDFObject::ObjectType::Union: {
+                            const Float* b = stack[--top];
+                            Float* a = stack[top - 1];
+                            for(std::size_t l = 0; l < lanes; ++l)
+                                a[l] = Math::min(a[l], b[l]);
+                        } break;
+                    }
+                }
+
+                for(std::size_t l = 0; l < lanes; ++l)
+                    distances[offset + l] = stack[0][l];
+            }
+        }
+
+    private:
+        struct Instruction {
+            SDFObject::ObjectType op;
+            Float sign; /* -1 if the primitive has positive inside */
+            Vector2 center;
+            Vector2 radii;
+        };
+
+        void compileNode(const SDFObject& object, std::size_t& depth) {
+            Instruction instruction{object.type, 1.0f, {}, {}};
+            if(object.type == SDFObject::ObjectType::Circle ||
+               object.type == SDFObject::ObjectType::Box) {
+                instruction.sign = object.negativeInside ? 1.0f : -1.0f;
+                instruction.center = object.center;
+                instruction.radii = object.radii;
+                if(++depth > MaxStackDepth) {
+                    Fatal{} << "SDF object tree is too deep";
+                }
+            } else {
+                compileNode(*object.obj1, depth);
+                compileNode(*object.obj2, depth);
+                --depth;
+            }
+
+            _instructions.push_back(instruction);
+        }
+
+        std::vector<Instruction> _instructions;
+};
+
+}}
+
+#endif
@@ -0,0 +1,248 @@
+#ifndef Magnum_Examples_FluidSimulation2D_TiledArray2X_h
+#define Magnum_Examples_FluidSimulation2D_TiledArray2X_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Math/Vector2.h>
+
+#include "MathHelpers.h"
+
+namespace Magnum { namespace Examples {
+
+/* Size of a square tile of a TiledArray2X, in cells */
+constexpr Int GridTileSize = 8;
+
+/* Sparse counterpart of Array2X. The domain is split into tiles of
+   GridTileSize*GridTileSize cells and storage is allocated only for tiles
+   that were activated through setActiveTiles(). Reading a cell of an inactive
+   tile returns the background value, writing to it is not allowed. */
+template<class T> class TiledArray2X {
+    public:
+        /*implicit*/ TiledArray2X() = default;
+
+        TiledArray2X<T>& operator=(const TiledArray2X<T>& other) {
+            if(other.sizeX() != sizeX() || other.sizeY() != sizeY()) {
+                Fatal{} << "Copy array with different size!";
+            }
+            /* Only the content is copied, both arrays are expected to have
+               the same tiles active */
+            for(const Vector2i& tile: _activeTiles) {
+                const std::size_t tileIdx = flatTileIndex(tile.x(), tile.y());
+                CORRADE_INTERNAL_ASSERT(!other._tiles[tileIdx].empty());
+                _tiles[tileIdx] = other._tiles[tileIdx];
+            }
+            return *this;
+        }
+
+        /* Accessors */
+
+        template<class IntType> const T& operator()(IntType i, IntType j) const {
+            CORRADE_INTERNAL_ASSERT(i >= 0 && j >= 0 &&
+                std::size_t(i) < _size[0] && std::size_t(j) < _size[1]);
+            const std::vector<T>& tile = _tiles[flatTileIndex(Int(i)/GridTileSize, Int(j)/GridTileSize)];
+            if(tile.empty()) return _background;
+            return tile[Int(i)%GridTileSize + GridTileSize*(Int(j)%GridTileSize)];
+        }
+
+        template<class IntType> T& operator()(IntType i, IntType j) {
+            CORRADE_INTERNAL_ASSERT(i >= 0 && j >= 0 &&
+                std::size_t(i) < _size[0] && std::size_t(j) < _size[1]);
+            std::vector<T>& tile = _tiles[flatTileIndex(Int(i)/GridTileSize, Int(j)/GridTileSize)];
+            CORRADE_INTERNAL_ASSERT(!tile.empty());
+            return tile[Int(i)%GridTileSize + GridTileSize*(Int(j)%GridTileSize)];
+        }
+
+        template<class IntType> const T& operator()(const Math::Vector2<IntType>& coord) const {
+            return operator()(coord[0], coord[1]);
+        }
+
+        template<class IntType> T& operator()(const Math::Vector2<IntType>& coord) {
+            return operator()(coord[0], coord[1]);
+        }
+
+        std::size_t sizeX() const { return _size[0]; }
+        std::size_t sizeY() const { return _size[1]; }
+
+        const T& background() const { return _background; }
+        const std::vector<Vector2i>& activeTiles() const { return _activeTiles; }
+        std::size_t activeTileCount() const { return _activeTiles.size(); }
+
+        bool isActiveTile(Int ti, Int tj) const {
+            return ti >= 0 && tj >= 0 && ti < _numTiles[0] && tj < _numTiles[1] &&
+                !_tiles[flatTileIndex(ti, tj)].empty();
+        }
+
+        /* Number of cells that have storage allocated, including the spare
+           tiles kept around for reuse */
+        std::size_t allocatedCount() const {
+            return (_activeTiles.size() + _spareTiles.size())*GridTileSize*GridTileSize;
+        }
+
+        /* Modifiers */
+
+        template<class IntType> void resize(IntType nx, IntType ny, const T& background = T{}) {
+            _size[0] = std::size_t(nx);
+            _size[1] = std::size_t(ny);
+            _numTiles[0] = (Int(nx) + GridTileSize - 1)/GridTileSize;
+            _numTiles[1] = (Int(ny) + GridTileSize - 1)/GridTileSize;
+            _background = background;
+            _tiles.clear();
+            _tiles.resize(std::size_t(_numTiles[0]*_numTiles[1]));
+            _spareTiles.clear();
+            _activeTiles.clear();
+        }
+
+        /* Activate given tiles and deactivate all others. Tiles that stay
+           active keep their content, newly activated tiles are filled with
+           the background value. Tiles outside of the array are ignored. */
+        void setActiveTiles(const std::vector<Vector2i>& tiles) {
+            _tileMask.assign(_tiles.size(), 0);
+            for(const Vector2i& tile: tiles) {
+                if(tile.x() < 0 || tile.y() < 0 ||
+                   tile.x() >= _numTiles[0] || tile.y() >= _numTiles[1]) continue;
+                _tileMask[flatTileIndex(tile.x(), tile.y())] = 1;
+            }
+
+            /* Recycle storage of tiles that are no longer needed */
+            for(const Vector2i& tile: _activeTiles) {
+                std::vector<T>& storage = _tiles[flatTileIndex(tile.x(), tile.y())];
+                if(_tileMask[flatTileIndex(tile.x(), tile.y())]) continue;
+                _spareTiles.emplace_back();
+                _spareTiles.back().swap(storage);
+            }
+
+            /* Allocate the new ones */
+            _activeTiles.clear();
+            for(const Vector2i& tile: tiles) {
+                if(tile.x() < 0 || tile.y() < 0 ||
+                   tile.x() >= _numTiles[0] || tile.y() >= _numTiles[1]) continue;
+                const std::size_t tileIdx = flatTileIndex(tile.x(), tile.y());
+                /* Skip duplicates */
+                if(_tileMask[tileIdx] != 1) continue;
+                _tileMask[tileIdx] = 2;
+                _activeTiles.push_back(tile);
+
+                std::vector<T>& storage = _tiles[tileIdx];
+                if(!storage.empty()) continue;
+                if(!_spareTiles.empty()) {
+                    storage.swap(_spareTiles.back());
+                    _spareTiles.pop_back();
+                    storage.assign(storage.size(), _background);
+                } else storage.assign(GridTileSize*GridTileSize, _background);
+            }
+        }
+
+        /* Only active tiles are affected, the background value stays */
+        void assign(const T& value) {
+            for(const Vector2i& tile: _activeTiles) {
+                std::vector<T>& storage = _tiles[flatTileIndex(tile.x(), tile.y())];
+                storage.assign(storage.size(), value);
+            }
+        }
+        void setZero() { assign(T(0)); }
+
+        void swapContent(TiledArray2X<T>& other) {
+            /* Only allow to swap content of array having the same sizes */
+            if(other.sizeX() != sizeX() || other.sizeY() != sizeY()) {
+                Fatal{} << "Swap content of arrays having different sizes!";
+            }
+            _tiles.swap(other._tiles);
+            _spareTiles.swap(other._spareTiles);
+            _activeTiles.swap(other._activeTiles);
+        }
+
+        /* Data manipulation */
+
+        /* Call func(i, j) for every cell of active tiles, tile by tile */
+        template<class Function> void loopActive2D(Function&& func) const {
+            for(const Vector2i& tile: _activeTiles) {
+                loopTile2D(tile, func);
+            }
+        }
+
+        template<class Function> void loopTile2D(const Vector2i& tile, Function&& func) const {
+            const std::size_t iBegin = std::size_t(tile.x()*GridTileSize);
+            const std::size_t jBegin = std::size_t(tile.y()*GridTileSize);
+            const std::size_t iEnd = Math::min(iBegin + GridTileSize, _size[0]);
+            const std::size_t jEnd = Math::min(jBegin + GridTileSize, _size[1]);
+            for(std::size_t j = jBegin; j < jEnd; ++j) {
+                for(std::size_t i = iBegin; i < iEnd; ++i) {
+                    func(i, j);
+                }
+            }
+        }
+
+        T interpolateValue(const Math::Vector2<T>& point) const {
+            Int i, j;
+            T   fx, fy;
+            barycentric(point[0], i, fx, 0, Int(sizeX()));
+            barycentric(point[1], j, fy, 0, Int(sizeY()));
+            T v00 = (*this)(i, j);
+            T v10 = (*this)(i + 1, j);
+            T v01 = (*this)(i, j + 1);
+            T v11 = (*this)(i + 1, j + 1);
+            return bilerp(v00, v10, v01, v11, fx, fy);
+        }
+
+        Math::Vector2<T> affineInterpolateValue(const Math::Vector2<T>& point) const {
+            Int i, j;
+            T fx, fy;
+            barycentric(point[0], i, fx, 0, Int(sizeX()));
+            barycentric(point[1], j, fy, 0, Int(sizeY()));
+            T v00 = (*this)(i, j);
+            T v10 = (*this)(i + 1, j);
+            T v01 = (*this)(i, j + 1);
+            T v11 = (*this)(i + 1, j + 1);
+            return bilerpGradient(v00, v10, v01, v11, fx, fy);
+        }
+
+    private:
+        std::size_t flatTileIndex(Int ti, Int tj) const {
+            return std::size_t(ti + tj*_numTiles[0]);
+        }
+
+        std::size_t _size[2]{};
+        Int _numTiles[2]{};
+        T _background{};
+
+        /* Storage of each tile, empty if the tile is inactive */
+        std::vector<std::vector<T>> _tiles;
+        /* Storage of deactivated tiles, reused on next activation */
+        std::vector<std::vector<T>> _spareTiles;
+        std::vector<Vector2i> _activeTiles;
+        std::vector<char> _tileMask;
+};
+
+}}
+
+#endif
@@ -30,6 +30,7 @@
 
 #include "DrawableObjects/ParticleGroup2D.h"
 
+#include <algorithm>
 #include <Corrade/Utility/Assert.h>
 #include <Corrade/Containers/ArrayView.h>
 #include <Magnum/GL/Renderer.h>
@@ -42,14 +43,16 @@ namespace Magnum { namespace Examples {
 
 using namespace Math::Literals;
 
-ParticleGroup2D::ParticleGroup2D(const std::vector<Vector2>& points, Float particleRadius):
+ParticleGroup2D::ParticleGroup2D(const std::vector<Vector2>& points, const std::vector<UnsignedInt>& ids, Float particleRadius):
     /* With {}, GCC 4.8 warns that "a temporary bound to '_points' only
        persists until the constructor exits" (?!) */
     _points(points),
+    _ids(ids),
     _particleRadius{particleRadius},
     _meshParticles{GL::MeshPrimitive::Points}
 {
-    _meshParticles.addVertexBuffer(_bufferParticles, 0, Shaders::GenericGL2D::Position{});
+    _meshParticles.addVertexBuffer(_bufferParticles, 0, Shaders::GenericGL2D::Position{})
+        .addVertexBuffer(_bufferIds, 0, ParticleSphereShader2D::ParticleId{});
     _particleShader.reset(new ParticleSphereShader2D);
 }
 
@@ -59,13 +62,19 @@ ParticleGroup2D& ParticleGroup2D::draw(Containers::Pointer<SceneGraph::Camera2D>
     if(_dirty) {
         Containers::ArrayView<const float> data(reinterpret_cast<const float*>(&_points[0]), _points.size() * 2);
         _bufferParticles.setData(data);
+        CORRADE_INTERNAL_ASSERT(_ids.size() == _points.size());
+        _bufferIds.setData(Containers::arrayView(_ids.data(), _ids.size()));
         _meshParticles.setCount(Int(_points.size()));
+        /* IDs of removed particles get reused, so they aren't necessarily
+           less than the particle count. Spread the color ramp over all of
+           them. */
+        _idBound = *std::max_element(_ids.begin(), _ids.end()) + 1;
         _dirty = false;
     }
 
     (*_particleShader)
         /* particle data */
-        .setNumParticles(Int(_points.size()))
+        .setNumParticles(Int(_idBound))
         .setParticleRadius(_particleRadius)
         /* sphere render data */
         .setColorMode(_colorMode)
@@ -43,7 +43,9 @@ namespace Magnum { namespace Examples {
 
 class ParticleGroup2D {
     public:
-        explicit ParticleGroup2D(const std::vector<Vector2>& points, Float particleRadius);
+        /* The ids are used for coloring, so particles keep their color when
+           they get reordered */
+        explicit ParticleGroup2D(const std::vector<Vector2>& points, const std::vector<UnsignedInt>& ids, Float particleRadius);
 
         ParticleGroup2D& draw(Containers::Pointer<SceneGraph::Camera2D>& camera, Int screenHeight, Int projectionHeight);
 
@@ -77,6 +79,8 @@ class ParticleGroup2D {
 
     private:
         const std::vector<Vector2>& _points;
+        const std::vector<UnsignedInt>& _ids;
+        UnsignedInt _idBound = 0;
         bool _dirty = false;
 
         Float _particleRadius = 1.0f;
@@ -84,6 +88,7 @@ class ParticleGroup2D {
         Color3 _color{0.1f};
 
         GL::Buffer _bufferParticles;
+        GL::Buffer _bufferIds;
         GL::Mesh   _meshParticles;
         Containers::Pointer<ParticleSphereShader2D> _particleShader;
 };
@@ -97,6 +97,8 @@ class FluidSimulation2DExample: public Platform::Application {
         Float _evolvedTime = 0.0f;
         Int _numEmission = 0.0f;
         bool _bAutoEmitParticles = true;
+        bool _continuousEmitter = false;
+        bool _drain = false;
         bool _pausedSimulation = false;
 
         /* Mouse-Fluid interaction */
@@ -114,11 +116,23 @@ constexpr Float GridCellLength = 1.0f;      /* length of 1 grid cell */
 constexpr Vector2i NumGridCells{100, 100};   /* number of cells */
 constexpr Vector2 GridStart{-50.0f, -50.0f}; /* lower corner of the grid */
 constexpr Int RadiusCircleBoundary = 45; /* radius of the boundary circle */
+/* Continuous emitter and drain toggled from the menu, relative to grid
+   center */
+constexpr Vector2 ContinuousEmitterOffset{-25.0f, 25.0f};
+constexpr Float ContinuousEmitterRadius = 4.0f;
+constexpr Vector2 ContinuousEmitterVelocity{8.0f, 0.0f};
+constexpr Vector2 DrainOffset{0.0f, -40.0f};
+constexpr Float DrainRadius = 6.0f;
 
 /* Viewport will display this window */
 constexpr Float ProjectionScale = 1.05f;
 const Vector2i DomainDisplaySize = NumGridCells*GridCellLength*ProjectionScale;
 
+/* Saved and restored from the menu, in the current working directory */
+constexpr const char CheckpointFile[] = "fluidsimulation2d.checkpoint";
+constexpr const char ProfileTraceFile[] = "fluidsimulation2d-profile.json";
+constexpr const char ProfileCsvFile[] = "fluidsimulation2d-profile.csv";
+
 Vector2 gridCenter() {
     return Vector2{NumGridCells}*GridCellLength*0.5f + GridStart;
 }
@@ -189,9 +203,13 @@ FluidSimulation2DExample::FluidSimulation2DExample(const Arguments& arguments):
         sceneObjs->emitter = SDFObject{gridCenter() + Vector2(15.0f, 20.0f), 15.0f, SDFObject::ObjectType::Circle};
         sceneObjs->boundary = SDFObject{gridCenter(), Float(RadiusCircleBoundary), SDFObject::ObjectType::Circle, false};
         _fluidSolver.emplace(GridStart, GridCellLength, NumGridCells.x(), NumGridCells.y(), sceneObjs);
+        /* Two particles per cell at most, so the continuous emitter can't
+           grow the storage indefinitely */
+        _fluidSolver->setMaxParticles(2*NumGridCells.product());
 
         /* Drawable particles */
         _drawableParticles.emplace(_fluidSolver->particlePositions(),
+                                   _fluidSolver->particleIds(),
                                    _fluidSolver->particleRadius());
         _drawableParticles->setColor(0x55c8f5_rgbf);
 
@@ -402,6 +420,7 @@ void FluidSimulation2DExample::showMenu() {
     /* General information */
     ImGui::Text("Hide/show menu: H");
     ImGui::Text("Num. particles: %d",   Int(_fluidSolver->numParticles()));
+    ImGui::Text("Active grid tiles: %d/%d", Int(_fluidSolver->numActiveGridTiles()), Int(_fluidSolver->numGridTiles()));
     ImGui::Text("Rendering: %3.2f FPS", Double(ImGui::GetIO().Framerate));
     ImGui::Spacing();
 
@@ -434,7 +453,21 @@ void FluidSimulation2DExample::showMenu() {
         ImGui::PushID("Simulation");
         ImGui::PushItemWidth(ImGui::GetWindowWidth()*0.3f);
         ImGui::InputFloat("Speed", &_speed);
+        Int extrapolationLayers = _fluidSolver->extrapolationLayers();
+        if(ImGui::SliderInt("Extrapolation layers", &extrapolationLayers, 1, GridTileSize))
+            _fluidSolver->setExtrapolationLayers(extrapolationLayers);
         ImGui::Checkbox("Auto emit particles 5 times", &_bAutoEmitParticles);
+        if(ImGui::Checkbox("Continuous emitter", &_continuousEmitter)) {
+            if(_continuousEmitter) _fluidSolver->addEmitter(
+                SDFObject{gridCenter() + ContinuousEmitterOffset, ContinuousEmitterRadius, SDFObject::ObjectType::Circle},
+                ContinuousEmitterVelocity);
+            else _fluidSolver->clearEmitters();
+        }
+        if(ImGui::Checkbox("Drain", &_drain)) {
+            if(_drain) _fluidSolver->addSink(
+                SDFObject{gridCenter() + DrainOffset, DrainRadius, SDFObject::ObjectType::Circle});
+            else _fluidSolver->clearSinks();
+        }
         ImGui::PopItemWidth();
         ImGui::BeginGroup();
         ImGui::Checkbox("Mouse interaction", &_bMouseInteraction);
@@ -464,6 +497,24 @@ void FluidSimulation2DExample::showMenu() {
     if(ImGui::Button("Reset Sim")) {
         resetSimulation();
     }
+    if(ImGui::Button("Save State") && _fluidSolver->saveCheckpoint(CheckpointFile)) {
+        Debug{} << "Saved simulation state to" << CheckpointFile;
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Load State")) {
+        _fluidSolver->loadCheckpoint(CheckpointFile);
+    }
+    Profiler& profiler = _fluidSolver->profiler();
+    bool profiling = profiler.isEnabled();
+    if(ImGui::Checkbox("Profile", &profiling)) {
+        profiler.setEnabled(profiling);
+    }
+    ImGui::SameLine();
+    if(ImGui::Button("Export Profile") &&
+       profiler.exportChromeTrace(ProfileTraceFile) &&
+       profiler.exportCsv(ProfileCsvFile)) {
+        Debug{} << "Saved the profile to" << ProfileTraceFile << "and" << ProfileCsvFile;
+    }
     ImGui::End();
 }
 
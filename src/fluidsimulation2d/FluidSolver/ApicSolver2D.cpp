@@ -30,10 +30,76 @@
 
 #include "FluidSolver/ApicSolver2D.h"
 
-#include <random>
+#include <algorithm>
+#include <type_traits>
+#include <Corrade/Utility/Debug.h>
+
+#include "TaskScheduler.h"
 
 namespace Magnum { namespace Examples {
 
+using namespace Containers::Literals;
+
+namespace {
+
+enum: UnsignedInt {
+    CheckpointGrid,
+    CheckpointPositionsT0,
+    CheckpointPositions,
+    CheckpointVelocities,
+    CheckpointAffineMatrices,
+    CheckpointIds,
+    CheckpointActiveTiles,
+    /* Grid velocities in active tiles, in the order of loopActive2D() */
+    CheckpointGridU,
+    CheckpointGridV,
+    /* Substeps since the last sort and extrapolation layer count */
+    CheckpointCounters,
+    CheckpointRandom,
+    /* Pool bookkeeping, see ParticleData::removeParticle() */
+    CheckpointNextId,
+    CheckpointFreeIds
+};
+
+/* Grid the checkpoint was made on, has to match when loading */
+struct GridInfo {
+    Vector2 origin;
+    Float cellSize;
+    Vector2i size;
+};
+
+/* The generator is saved as-is, which it is on all major standard library
+   implementations */
+static_assert(std::is_trivially_copyable<std::mt19937>::value,
+    "std::mt19937 has to be trivially copyable");
+
+template<class T> UnsignedLong fnv1a(UnsignedLong hash, const std::vector<T>& data) {
+    const auto* bytes = reinterpret_cast<const UnsignedByte*>(data.data());
+    for(std::size_t i = 0, size = data.size()*sizeof(T); i != size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+/* Cells with centers inside given shape, evaluated one grid row at a time */
+std::vector<Vector2i> cellsInside(const GridData& grid, const SDFObject& shape) {
+    const SDFProgram sdf{shape};
+    std::vector<Vector2> centers(grid.nI);
+    std::vector<Float> distances(grid.nI);
+    std::vector<Vector2i> cells;
+    for(Int j = 0; j < grid.nJ; ++j) {
+        for(Int i = 0; i < grid.nI; ++i)
+            centers[i] = grid.getWorldPos({i + 0.5f, j + 0.5f});
+        sdf.signedDistances(centers.data(), distances.data(), centers.size());
+        for(Int i = 0; i < grid.nI; ++i)
+            if(distances[i] < 0) cells.emplace_back(i, j);
+    }
+    return cells;
+}
+
+}
+
 ApicSolver2D::ApicSolver2D(const Vector2& origin, Float cellSize, Int nI, Int nJ, SceneObjects* sceneObjs):
     _objects{sceneObjs},
     _particles{cellSize},
@@ -46,16 +112,31 @@ ApicSolver2D::ApicSolver2D(const Vector2& origin, Float cellSize, Int nI, Int nJ
         Fatal{} << "Invalid scene object";
     }
 
+    /* Compile the scene objects */
+    _emitterT0.compile(_objects->emitterT0);
+    _emitter.compile(_objects->emitter);
+    _boundary.compile(_objects->boundary);
+
     /* Initialize data */
     initBoundary();
-    generateParticles(_objects->emitterT0, 0);
+    generateParticles(_emitterT0, 0);
 }
 
 /* This function should be called again every time the boundary changes */
 void ApicSolver2D::initBoundary() {
-    _grid.boundarySDF.loop2D([&](std::size_t i, std::size_t j) {
-        _grid.boundarySDF(i, j) = _objects->boundary.signedDistance(_grid.getWorldPos({Float(i), Float(j)}));
-    });
+    /* Bake the boundary SDF at grid nodes and cell centers, evaluating one
+       row at a time */
+    std::vector<Vector2> rowPositions(_grid.nI + 1);
+    for(std::size_t j = 0; j < _grid.boundarySDF.sizeY(); ++j) {
+        for(std::size_t i = 0; i < _grid.boundarySDF.sizeX(); ++i)
+            rowPositions[i] = _grid.getWorldPos({Float(i), Float(j)});
+        _boundary.signedDistances(rowPositions.data(), &_grid.boundarySDF(std::size_t(0), j), _grid.boundarySDF.sizeX());
+    }
+    for(std::size_t j = 0; j < _grid.boundaryCellSDF.sizeY(); ++j) {
+        for(std::size_t i = 0; i < _grid.boundaryCellSDF.sizeX(); ++i)
+            rowPositions[i] = _grid.getWorldPos({i + 0.5f, j + 0.5f});
+        _boundary.signedDistances(rowPositions.data(), &_grid.boundaryCellSDF(std::size_t(0), j), _grid.boundaryCellSDF.sizeX());
+    }
 
     /* Initialize the fluid cell weights from boundary signed distance field */
     _grid.uWeights.loop2D([&](std::size_t i, std::size_t j) {
@@ -68,24 +149,31 @@ void ApicSolver2D::initBoundary() {
     });
 }
 
-void ApicSolver2D::generateParticles(const SDFObject& sdfObj, Float initialVelocity_y) {
+void ApicSolver2D::generateParticles(const SDFProgram& sdf, Float initialVelocity_y) {
     using Distribution = std::uniform_real_distribution<Float>;
     const Float rndScale = _particles.particleRadius*0.5f;
-    std::mt19937 gen(std::random_device{}());
     Distribution distr(-rndScale, rndScale);
 
-    /* Generate new particles */
+    /* Generate new particles, two candidates per cell, one grid row at a
+       time */
     std::vector<Vector2> newParticles;
-    _grid.fluidSDF.loop2D(
-        [&](std::size_t i, std::size_t j) {
+    std::vector<Vector2> candidates(2*_grid.nI);
+    std::vector<Float> distances(candidates.size());
+    for(Int j = 0; j < _grid.nJ; ++j) {
+        for(Int i = 0; i < _grid.nI; ++i) {
             const Vector2 cellCenter = _grid.getWorldPos({i + 0.5f, j + 0.5f});
             for(Int k = 0; k < 2; ++k) {
-                const Vector2 ppos = cellCenter + Vector2(distr(gen), distr(gen));
-                if(sdfObj.signedDistance(ppos) < 0) {
-                    newParticles.push_back(ppos);
-                }
+                candidates[2*i + k] = cellCenter + Vector2(distr(_random), distr(_random));
             }
-        });
+        }
+
+        sdf.signedDistances(candidates.data(), distances.data(), candidates.size());
+        for(std::size_t c = 0; c < candidates.size(); ++c) {
+            if(distances[c] < 0) {
+                newParticles.push_back(candidates[c]);
+            }
+        }
+    }
 
     /* Insert into the system */
     _particles.addParticles(newParticles, initialVelocity_y);
@@ -111,6 +199,9 @@ void ApicSolver2D::addRepulsiveVelocity(const Vector2& p0, const Vector2& p1, Fl
     const Vector2 p01 = p1 - p0;
     const Float p01DistSqr = p01.dot();
 
+    /* Cells outside of active grid tiles have no particles, access them
+       through a const reference to get an empty list instead of an assert */
+    const GridData& grid = _grid;
     const auto distToSegment = [&](const Vector2& pos) -> Float {
         const Float t = Math::max(0.0f, Math::min(1.0f, Math::dot(pos - p0, p01)/p01DistSqr));
         const Vector2 prj = p0 + t * p01;
@@ -119,9 +210,9 @@ void ApicSolver2D::addRepulsiveVelocity(const Vector2& p0, const Vector2& p1, Fl
 
     for(Int j = fromCell.y(); j <= toCell.y(); ++j) {
         for(Int i = fromCell.x(); i <= toCell.x(); ++i) {
-            if(!_grid.isValidCellIdx(i, j)) continue;
+            if(!grid.isValidCellIdx(i, j)) continue;
 
-            const std::vector<UnsignedInt>& particleIdxs = _grid.cellParticles(i, j);
+            const std::vector<UnsignedInt>& particleIdxs = grid.cellParticles(i, j);
             for(UnsignedInt p: particleIdxs) {
                 const Float dist = distToSegment(_particles.positions[p]);
                 const Float t = dist/radius;
@@ -134,10 +225,230 @@ void ApicSolver2D::addRepulsiveVelocity(const Vector2& p0, const Vector2& p1, Fl
     }
 }
 
+void ApicSolver2D::addEmitter(const SDFObject& shape, const Vector2& velocity) {
+    if(!_cellFlags.count()) _cellFlags.resize(_grid.nI, _grid.nJ, UnsignedByte(0));
+    if(!_cellParticleCounts.count()) _cellParticleCounts.resize(_grid.nI, _grid.nJ, UnsignedByte(0));
+
+    Emitter emitter{cellsInside(_grid, shape), velocity};
+    for(const Vector2i& cell: emitter.cells) _cellFlags(cell) |= EmitterCell;
+    _emitters.push_back(std::move(emitter));
+}
+
+void ApicSolver2D::addSink(const SDFObject& shape) {
+    if(!_cellFlags.count()) _cellFlags.resize(_grid.nI, _grid.nJ, UnsignedByte(0));
+
+    for(const Vector2i& cell: cellsInside(_grid, shape)) _cellFlags(cell) |= SinkCell;
+    ++_sinkCount;
+}
+
+void ApicSolver2D::clearEmitters() {
+    for(const Emitter& emitter: _emitters)
+        for(const Vector2i& cell: emitter.cells) _cellFlags(cell) &= ~EmitterCell;
+    _emitters.clear();
+}
+
+void ApicSolver2D::clearSinks() {
+    if(!_sinkCount) return;
+    _cellFlags.loop2D([&](std::size_t i, std::size_t j) {
+        _cellFlags(i, j) &= ~SinkCell;
+    });
+    _sinkCount = 0;
+}
+
+void ApicSolver2D::applyEmittersAndSinks() {
+    if(_emitters.empty() && !_sinkCount) return;
+
+    /* Remove particles in sink cells and count particles in emitter cells,
+       in a single pass. Counts above two don't matter. */
+    for(const Emitter& emitter: _emitters)
+        for(const Vector2i& cell: emitter.cells) _cellParticleCounts(cell) = 0;
+    _particles.loopAll([&](UnsignedInt p) {
+        const Vector2i cell = _grid.getValidCellIdx(_particles.positions[p]);
+        const UnsignedByte flags = _cellFlags(cell);
+        if(flags & SinkCell)
+            _particles.removeParticle(p);
+        else if((flags & EmitterCell) && _cellParticleCounts(cell) < 2)
+            ++_cellParticleCounts(cell);
+    });
+
+    /* Top up emitter cells to two particles, jittered the same way as in
+       generateParticles(). The new particles go into slots of the removed
+       ones first. */
+    const Float rndScale = _particles.particleRadius*0.5f;
+    std::uniform_real_distribution<Float> distr(-rndScale, rndScale);
+    for(const Emitter& emitter: _emitters) {
+        _emittedParticles.clear();
+        for(const Vector2i& cell: emitter.cells) {
+            if(_cellFlags(cell) & SinkCell) continue;
+
+            const Vector2 cellCenter = _grid.getWorldPos({cell.x() + 0.5f, cell.y() + 0.5f});
+            for(UnsignedByte k = _cellParticleCounts(cell); k < 2; ++k) {
+                /* Braces to have the random numbers drawn in a defined order */
+                _emittedParticles.push_back(cellCenter + Vector2{distr(_random), distr(_random)});
+            }
+
+            /* Don't fill the cell again from an overlapping emitter */
+            _cellParticleCounts(cell) = 2;
+        }
+        _particles.addParticles(_emittedParticles, emitter.velocity);
+    }
+
+    /* Close the holes that weren't refilled, the rest of the frame expects
+       none */
+    _particles.compact();
+}
+
+UnsignedLong ApicSolver2D::stateChecksum() const {
+    UnsignedLong hash = 14695981039346656037ull;
+    hash = fnv1a(hash, _particles.positions);
+    hash = fnv1a(hash, _particles.velocities);
+    hash = fnv1a(hash, _particles.affineMat);
+    return hash;
+}
+
+Containers::StringView ApicSolver2D::checkpointKind() {
+    return "ApicSolver2D"_s;
+}
+
+UnsignedInt ApicSolver2D::checkpointVersion() {
+    /* Version 2 added the particle pool bookkeeping */
+    return 2;
+}
+
+bool ApicSolver2D::saveCheckpoint(const Containers::StringView filename) const {
+    const GridInfo grid{_grid.origin, _grid.cellSize, {_grid.nI, _grid.nJ}};
+    const Int counters[]{_substepsSinceSort, _extrapolationLayers};
+    std::vector<Float> u, v;
+    _grid.u.loopActive2D([&](std::size_t i, std::size_t j) { u.push_back(_grid.u(i, j)); });
+    _grid.v.loopActive2D([&](std::size_t i, std::size_t j) { v.push_back(_grid.v(i, j)); });
+
+    CheckpointWriter writer{checkpointKind(), checkpointVersion()};
+    writer.addValue(CheckpointGrid, grid)
+        .add(CheckpointPositionsT0, _particles.positionsT0)
+        .add(CheckpointPositions, _particles.positions)
+        .add(CheckpointVelocities, _particles.velocities)
+        .add(CheckpointAffineMatrices, _particles.affineMat)
+        .add(CheckpointIds, _particles.ids)
+        .add(CheckpointActiveTiles, _grid.activeTiles)
+        .add(CheckpointGridU, u)
+        .add(CheckpointGridV, v)
+        .add(CheckpointCounters, sizeof(Int), 2, counters)
+        .addValue(CheckpointRandom, _random)
+        .addValue(CheckpointNextId, _particles.nextId)
+        .add(CheckpointFreeIds, _particles.freeIds);
+    return writer.write(filename);
+}
+
+bool ApicSolver2D::loadCheckpoint(const Checkpoint& checkpoint) {
+    GridInfo grid;
+    if(!checkpoint.readValue(CheckpointGrid, grid) ||
+       grid.origin != _grid.origin || grid.cellSize != _grid.cellSize ||
+       grid.size != Vector2i{_grid.nI, _grid.nJ}) {
+        Error{} << "ApicSolver2D: checkpoint grid doesn't match";
+        return false;
+    }
+
+    /* The tiles are views into the mapped file, everything else is copied
+       to temporaries first */
+    std::vector<Vector2> positionsT0, positions, velocities;
+    std::vector<Matrix2x2> affineMat;
+    std::vector<UnsignedInt> ids, freeIds;
+    UnsignedInt nextId;
+    std::mt19937 random;
+    const Containers::ArrayView<const Vector2i> activeTiles = checkpoint.view<Vector2i>(CheckpointActiveTiles);
+    const Containers::ArrayView<const Float> u = checkpoint.view<Float>(CheckpointGridU);
+    const Containers::ArrayView<const Float> v = checkpoint.view<Float>(CheckpointGridV);
+    const Containers::ArrayView<const Int> counters = checkpoint.view<Int>(CheckpointCounters);
+    if(!checkpoint.read(CheckpointPositionsT0, positionsT0) ||
+       !checkpoint.read(CheckpointPositions, positions) ||
+       !checkpoint.read(CheckpointVelocities, velocities) ||
+       !checkpoint.read(CheckpointAffineMatrices, affineMat) ||
+       !checkpoint.read(CheckpointIds, ids) ||
+       !checkpoint.readValue(CheckpointRandom, random) ||
+       !checkpoint.readValue(CheckpointNextId, nextId) ||
+       !checkpoint.read(CheckpointFreeIds, freeIds) ||
+       counters.size() != 2) {
+        Error{} << "ApicSolver2D: incomplete checkpoint";
+        return false;
+    }
+    if(velocities.size() != positions.size() ||
+       affineMat.size() != positions.size() ||
+       ids.size() != positions.size()) {
+        Error{} << "ApicSolver2D: inconsistent particle count in checkpoint";
+        return false;
+    }
+
+    for(const UnsignedInt id: ids) {
+        if(id >= nextId) {
+            Error{} << "ApicSolver2D: particle ID out of bounds in checkpoint";
+            return false;
+        }
+    }
+    for(const Vector2i& tile: activeTiles) {
+        if(tile.x() < 0 || tile.y() < 0 ||
+           tile.x() >= _grid.numTiles.x() || tile.y() >= _grid.numTiles.y()) {
+            Error{} << "ApicSolver2D: checkpoint grid tile out of bounds";
+            return false;
+        }
+    }
+
+    /* Check the velocity counts before touching the grid. Tiles on the
+       upper edge are partially outside of the array, so count the cells
+       the same way loopActive2D() does. */
+    const auto cellCount = [](Int begin, Int size) {
+        return std::size_t(Math::clamp(size - begin, 0, GridTileSize));
+    };
+    std::size_t uCount = 0, vCount = 0;
+    for(const Vector2i& tile: activeTiles) {
+        const Vector2i begin = tile*GridTileSize;
+        uCount += cellCount(begin.x(), _grid.nI + 1)*cellCount(begin.y(), _grid.nJ);
+        vCount += cellCount(begin.x(), _grid.nI)*cellCount(begin.y(), _grid.nJ + 1);
+    }
+    if(u.size() != uCount || v.size() != vCount) {
+        Error{} << "ApicSolver2D: inconsistent grid velocities in checkpoint";
+        return false;
+    }
+
+    _particles.positionsT0 = std::move(positionsT0);
+    _particles.positions = std::move(positions);
+    _particles.velocities = std::move(velocities);
+    _particles.affineMat = std::move(affineMat);
+    _particles.ids = std::move(ids);
+    _particles.tmp.resize(_particles.positions.size());
+    _particles.nextId = nextId;
+    _particles.freeIds = std::move(freeIds);
+    _particles.freeSlots.clear();
+    /* The arrays got replaced, allocate the storage for the bound again */
+    _particles.setMaxCount(_particles.maxCount);
+    _random = random;
+    _substepsSinceSort = counters[0];
+    setExtrapolationLayers(counters[1]);
+
+    _grid.setActiveTiles({activeTiles.begin(), activeTiles.end()});
+    std::size_t uIndex = 0, vIndex = 0;
+    _grid.u.loopActive2D([&](std::size_t i, std::size_t j) { _grid.u(i, j) = u[uIndex++]; });
+    _grid.v.loopActive2D([&](std::size_t i, std::size_t j) { _grid.v(i, j) = v[vIndex++]; });
+    return true;
+}
+
+bool ApicSolver2D::loadCheckpoint(const Containers::StringView filename) {
+    const Containers::Optional<Checkpoint> checkpoint = Checkpoint::open(filename, checkpointKind(), checkpointVersion());
+    return checkpoint && loadCheckpoint(*checkpoint);
+}
+
 void ApicSolver2D::advanceFrame(Float frameDuration) {
-    Float frameTime = 0;
+    _profiler.beginFrame();
+    Profiler::Stage frame{_profiler, "advanceFrame"};
+    {
+        Profiler::Stage stage{_profiler, "emittersAndSinks"};
+        applyEmittersAndSinks();
+    }
+    _profiler.addCounter("particles", _particles.size());
 
+    Float frameTime = 0;
+    Int substeps = 0;
     while(frameTime < frameDuration) {
+        Profiler::Stage substepStage{_profiler, "substep"};
         Float substep = timestepCFL();
         const Float remainingTime = frameDuration - frameTime;
         if(frameTime + substep > frameDuration)
@@ -145,37 +456,70 @@ void ApicSolver2D::advanceFrame(Float frameDuration) {
         else if(frameTime + Float(1.5) * substep > frameDuration)
             substep = remainingTime * Float(0.5);
         frameTime += substep;
-
-        /* Advect particles */
-        moveParticles(substep);
+        ++substeps;
+
+        /* Advect particles, then allocate grid tiles around them */
+        {
+            Profiler::Stage stage{_profiler, "moveParticles"};
+            moveParticles(substep);
+            if(++_substepsSinceSort >= SortInterval) {
+                sortParticles();
+                _substepsSinceSort = 0;
+            }
+            _grid.updateActiveTiles(_particles.positions);
+        }
+        _profiler.addCounter("activeTiles", _grid.activeTiles.size());
 
         /* Particles => grid */
-        collectParticlesToCells();
-        particleVelocity2Grid();
+        {
+            Profiler::Stage stage{_profiler, "particleVelocity2Grid"};
+            collectParticlesToCells();
+            particleVelocity2Grid();
+        }
 
         /* Update grid velocity */
-        extrapolate(_grid.u, _grid.uTmp, _grid.uValid, _grid.uOldValid);
-        extrapolate(_grid.v, _grid.vTmp, _grid.vValid, _grid.vOldValid);
+        {
+            Profiler::Stage stage{_profiler, "extrapolate"};
+            extrapolate(_grid.u, _grid.uTmp, _grid.uValid, _grid.uOldValid);
+            extrapolate(_grid.v, _grid.vTmp, _grid.vValid, _grid.vOldValid);
+        }
         addGravity(substep);
-        computeFluidSDF();
-        solvePressures(substep);
+        {
+            Profiler::Stage stage{_profiler, "computeFluidSDF"};
+            computeFluidSDF();
+        }
+        {
+            Profiler::Stage stage{_profiler, "solvePressures"};
+            solvePressures(substep);
+        }
+        _profiler.addCounter("pcgIterations", _pressureSolver.pcgSolver.lastIterationCount());
 
         /* Enforce boundary condition */
-        constrainVelocity();
+        {
+            Profiler::Stage stage{_profiler, "constrainVelocity"};
+            constrainVelocity();
+        }
 
         /* Grid => particles */
-        relaxParticlePositions(substep);
-        gridVelocity2Particle();
+        {
+            Profiler::Stage stage{_profiler, "relaxParticlePositions"};
+            relaxParticlePositions(substep);
+        }
+        {
+            Profiler::Stage stage{_profiler, "gridVelocity2Particle"};
+            gridVelocity2Particle();
+        }
     }
+    _profiler.addCounter("substeps", substeps);
 }
 
 Float ApicSolver2D::timestepCFL() const {
     Float maxVel = 0;
-    _grid.u.loop1D([&](std::size_t i) {
-        maxVel = Math::max(maxVel, Math::abs(_grid.u.data()[i]));
+    _grid.u.loopActive2D([&](std::size_t i, std::size_t j) {
+        maxVel = Math::max(maxVel, Math::abs(_grid.u(i, j)));
     });
-    _grid.v.loop1D([&](std::size_t i) {
-        maxVel = Math::max(maxVel, Math::abs(_grid.v.data()[i]));
+    _grid.v.loopActive2D([&](std::size_t i, std::size_t j) {
+        maxVel = Math::max(maxVel, Math::abs(_grid.v(i, j)));
     });
     return maxVel > 0 ? _grid.cellSize/maxVel*3.0f : 1.0f;
 }
@@ -187,9 +531,40 @@ void ApicSolver2D::moveParticles(Float dt) {
     });
 }
 
+void ApicSolver2D::sortParticles() {
+    /* Order particles along a Morton curve over grid cells, so particles
+       close in space are close in memory as well and the grid transfers
+       access them mostly sequentially. Particles in the same cell keep their
+       relative order, thus the result doesn't depend on the thread count. */
+    std::vector<UnsignedLong>& keys = _particles.sortKeys;
+    keys.resize(_particles.size());
+    TaskScheduler::forEach(_particles.size(), [&](UnsignedInt p) {
+        const Vector2i cellIdx = _grid.getValidCellIdx(_particles.positions[p]);
+        keys[p] = UnsignedLong(mortonCode2D(UnsignedInt(cellIdx.x()), UnsignedInt(cellIdx.y()))) << 32 | p;
+    });
+    std::sort(keys.begin(), keys.end());
+
+    /* Permute all attributes together, in a single parallel pass */
+    _particles.tmp.resize(_particles.size());
+    _particles.velocitiesTmp.resize(_particles.size());
+    _particles.affineMatTmp.resize(_particles.size());
+    _particles.idsTmp.resize(_particles.size());
+    TaskScheduler::forEach(_particles.size(), [&](UnsignedInt p) {
+        const UnsignedInt from = UnsignedInt(keys[p] & 0xffffffffu);
+        _particles.tmp[p] = _particles.positions[from];
+        _particles.velocitiesTmp[p] = _particles.velocities[from];
+        _particles.affineMatTmp[p] = _particles.affineMat[from];
+        _particles.idsTmp[p] = _particles.ids[from];
+    });
+    _particles.positions.swap(_particles.tmp);
+    _particles.velocities.swap(_particles.velocitiesTmp);
+    _particles.affineMat.swap(_particles.affineMatTmp);
+    _particles.ids.swap(_particles.idsTmp);
+}
+
 void ApicSolver2D::collectParticlesToCells() {
-    _grid.cellParticles.loop1D([&](std::size_t i) {
-        _grid.cellParticles.data()[i].resize(0);
+    _grid.cellParticles.loopActive2D([&](std::size_t i, std::size_t j) {
+        _grid.cellParticles(i, j).resize(0);
     });
     _particles.loopAll([&](UnsignedInt p) {
         const Vector2 ppos = _particles.positions[p];
@@ -199,7 +574,7 @@ void ApicSolver2D::collectParticlesToCells() {
 }
 
 void ApicSolver2D::particleVelocity2Grid() {
-    _grid.u.loop2D([&](std::size_t i, std::size_t j) {
+    _grid.u.loopActive2D([&](std::size_t i, std::size_t j) {
         Float sumW = 0.0f;
         Float sumU = 0.0f;
         const Vector2 nodePos = _grid.getWorldPos({Float(i), j + 0.5f});
@@ -215,7 +590,7 @@ void ApicSolver2D::particleVelocity2Grid() {
         _grid.uValid(i, j) = sumW > 0 ? 1 : 0;
     });
 
-    _grid.v.loop2D([&](std::size_t i, std::size_t j) {
+    _grid.v.loopActive2D([&](std::size_t i, std::size_t j) {
         Float sumW = 0.0;
         Float sumV = 0.0;
         const Vector2 nodePos = _grid.getWorldPos({i + 0.5f, Float(j)});
@@ -232,31 +607,34 @@ void ApicSolver2D::particleVelocity2Grid() {
     });
 }
 
-void ApicSolver2D::extrapolate(Array2X<Float>& grid, Array2X<Float>& tmp_grid, Array2X<char>& valid, Array2X<char>& old_valid) const {
-    tmp_grid  = grid;
-    old_valid = valid;
+void ApicSolver2D::extrapolate(TiledArray2X<Float>& grid, TiledArray2X<Float>& tmp_grid, TiledArray2X<char>& valid, TiledArray2X<char>& old_valid) const {
+    const std::vector<Vector2i>& activeTiles = grid.activeTiles();
+
+    /* Each layer extends the valid region by one cell. Every cell of the
+       target is written, either copied from the source or averaged from its
+       valid neighbors, so the arrays can be just swapped after each layer.
+       Tiles are processed in parallel, each of them writes only its own
+       cells. */
+    for(Int layer = 0; layer < _extrapolationLayers; ++layer) {
+        /* Sources are read also outside of active tiles, access them
+           through a const reference to get the background value */
+        const TiledArray2X<Float>& gridSrc = grid;
+        const TiledArray2X<char>& validSrc = valid;
+
+        TaskScheduler::forEach(activeTiles.size(), [&](std::size_t tileIdx) {
+            grid.loopTile2D(activeTiles[tileIdx], [&](std::size_t i, std::size_t j) {
+                tmp_grid(i, j) = gridSrc(i, j);
+                old_valid(i, j) = validSrc(i, j);
+
+                if(validSrc(i, j) ||
+                   i == 0 || i == grid.sizeX() - 1 ||
+                   j == 0 || j == grid.sizeY() - 1) return;
 
-    Array2X<Float>* pgrids[] = {&grid, &tmp_grid};
-    Array2X<char>* pvalids[] = {&valid, &old_valid};
-
-    for(int layers = 0; layers < 1; ++layers) {
-        auto& gridSrc = *pgrids[layers & 1];
-        auto& gridTgt = *pgrids[!(layers & 1)];
-
-        auto& validSrc = *pvalids[layers & 1];
-        auto& validTgt = *pvalids[!(layers & 1)];
-
-        grid.loop2D([&](std::size_t i, std::size_t j) {
-            if(i == 0 || i == grid.sizeX() - 1 ||
-               j == 0 || j == grid.sizeY() - 1) return;
-
-            Float sum = 0;
-            Int count = 0;
-
-            if(!validSrc(i, j)) {
                 const std::size_t rows[] = { i + 1, i - 1, i, i };
                 const std::size_t cols[] = { j, j, j + 1, j - 1 };
 
+                Float sum = 0;
+                Int count = 0;
                 for(std::size_t cell = 0; cell < 4; ++cell) {
                     if(validSrc(rows[cell], cols[cell])) {
                         sum += gridSrc(rows[cell], cols[cell]);
@@ -265,19 +643,19 @@ void ApicSolver2D::extrapolate(Array2X<Float>& grid, Array2X<Float>& tmp_grid, A
                 }
 
                 if(count > 0) {
-                    gridTgt(i, j) = sum/Float(count);
-                    validTgt(i, j) = 1;
+                    tmp_grid(i, j) = sum/Float(count);
+                    old_valid(i, j) = 1;
                 }
-            }
+            });
         });
 
-        gridSrc.swapContent(gridTgt);
-        validSrc.swapContent(validTgt);
+        grid.swapContent(tmp_grid);
+        valid.swapContent(old_valid);
     }
 }
 
 void ApicSolver2D::addGravity(Float dt) {
-    _grid.v.loop2D([&](std::size_t i, std::size_t j) {
+    _grid.v.loopActive2D([&](std::size_t i, std::size_t j) {
         if(_grid.vValid(i, j)) {
             _grid.v(i, j) -= 9.81f*dt; /* gravity */
         }
@@ -285,133 +663,141 @@ void ApicSolver2D::addGravity(Float dt) {
 }
 
 void ApicSolver2D::computeFluidSDF() {
-    _grid.fluidSDF.assign(3 * _grid.cellSize);
-
-    _particles.loopAll([&](UnsignedInt p) {
-        const Vector2 ppos = _particles.positions[p];
-        const Vector2i gridPos = Vector2i(_grid.getGridPos(ppos) - Vector2(0.5));
-
-        for(Int j = gridPos.y() - 2; j <= gridPos.y() + 2; ++j) {
-            for(Int i = gridPos.x() - 2; i <= gridPos.x() + 2; ++i) {
-                if(!_grid.isValidCellIdx(i, j)) continue;
-
-                const Vector2 cellCenter = _grid.getWorldPos({i + 0.5f, j + 0.5f});
-                const Float sdfVal = (cellCenter - ppos).length() - _particles.particleRadius;
-                if(_grid.fluidSDF(i, j) > sdfVal)
-                    _grid.fluidSDF(i, j) = sdfVal;
-            }
-        }
-    });
-
-    _grid.fluidSDF.loop2D([&](std::size_t i, std::size_t j) {
-        const Vector2 cellCenter = _grid.getWorldPos({i + 0.5f, j + 0.5f});
-        const Float sdfVal = _objects->boundary.signedDistance(cellCenter);
-        if(_grid.fluidSDF(i, j) > sdfVal)
-            _grid.fluidSDF(i, j) = sdfVal;
+    const std::vector<Vector2i>& activeTiles = _grid.activeTiles;
+    const GridData& grid = _grid;
+    const Float maxDist = 3*_grid.cellSize + _particles.particleRadius;
+
+    /* Each cell gathers distance from particles in the surrounding 5x5 cells
+       instead of particles splatting into their neighborhood, so the cells
+       can be computed in parallel, one tile per task */
+    TaskScheduler::forEach(activeTiles.size(), [&](std::size_t tileIdx) {
+        _grid.fluidSDF.loopTile2D(activeTiles[tileIdx], [&](std::size_t i, std::size_t j) {
+            const Vector2 cellCenter = grid.getWorldPos({i + 0.5f, j + 0.5f});
+            Float minDistSqr = maxDist*maxDist;
+            grid.loopNeigborParticles(Int(i), Int(j), -2, 2, -2, 2, [&](UnsignedInt p) {
+                minDistSqr = Math::min(minDistSqr, (cellCenter - _particles.positions[p]).dot());
+            });
+
+            const Float sdfVal = Math::sqrt(minDistSqr) - _particles.particleRadius;
+            _grid.fluidSDF(i, j) = Math::min(sdfVal, grid.boundaryCellSDF(i, j));
+        });
     });
 }
 
 void ApicSolver2D::solvePressures(Float dt) {
     const std::size_t nI = std::size_t(_grid.nI);
     const std::size_t nJ = std::size_t(_grid.nJ);
-    const std::size_t numCells = nI * nJ;
-
-    _pressureSolver.resize(numCells);
-    _pressureSolver.clear();
 
-    for(std::size_t j = 1; j < nJ - 1; ++j) {
-        for(std::size_t i = 1; i < nI - 1; ++i) {
-            const std::size_t row = i + nI * j;
-            Double rhsVal = 0.0;
-            const Float centerSDF = _grid.fluidSDF(i, j);
+    /* Neighbor cells may lie in inactive tiles, read them through a const
+       reference to get the background value */
+    const GridData& grid = _grid;
+
+    /* Only fluid cells get a row in the linear system, so its size scales
+       with the fluid volume instead of the domain area */
+    Int numRows = 0;
+    _grid.pressureRows.assign(-1);
+    _grid.pressureRows.loopActive2D([&](std::size_t i, std::size_t j) {
+        if(i == 0 || i == nI - 1 || j == 0 || j == nJ - 1) return;
+        if(grid.fluidSDF(i, j) < 0) _grid.pressureRows(i, j) = numRows++;
+    });
+    if(!numRows) return;
 
-            if(centerSDF >= 0) {
-                _pressureSolver.rhs[row] = rhsVal;
-                continue;
-            }
+    _pressureSolver.resize(std::size_t(numRows));
+    _pressureSolver.clear();
 
-            const Float cellsWeights[] = {
-                _grid.uWeights(i + 1, j),
-                _grid.uWeights(i, j),
-                _grid.vWeights(i, j + 1),
-                _grid.vWeights(i, j)
-            };
-            const Float cellsSDF[] = {
-                _grid.fluidSDF(i + 1, j),
-                _grid.fluidSDF(i - 1, j),
-                _grid.fluidSDF(i, j + 1),
-                _grid.fluidSDF(i, j - 1)
-            };
-            const Float cellsVel[] = {
-                -_grid.u(i + 1, j), /* minus velocity */
-                 _grid.u(i, j),
-                -_grid.v(i, j + 1), /* minus velocity */
-                 _grid.v(i, j)
-            };
-            const std::size_t cols[] = {
-                row + 1,
-                row - 1,
-                row + nI,
-                row - nI
-            };
-
-            /* Fill-in matrix */
-            for(std::size_t cell = 0; cell < 4; ++cell) {
-                rhsVal += Double(cellsWeights[cell]*cellsVel[cell]);
-                const Float term = cellsWeights[cell] * dt;
-                if(cellsSDF[cell] < 0.0f) {
-                    _pressureSolver.matrix.addToElement(row, row, term);
+    const TiledArray2X<Int>& pressureRows = grid.pressureRows;
+    pressureRows.loopActive2D([&](std::size_t i, std::size_t j) {
+        const Int row = pressureRows(i, j);
+        if(row < 0) return;
+
+        Double rhsVal = 0.0;
+        const Float centerSDF = grid.fluidSDF(i, j);
+        const Float cellsWeights[] = {
+            grid.uWeights(i + 1, j),
+            grid.uWeights(i, j),
+            grid.vWeights(i, j + 1),
+            grid.vWeights(i, j)
+        };
+        const Float cellsSDF[] = {
+            grid.fluidSDF(i + 1, j),
+            grid.fluidSDF(i - 1, j),
+            grid.fluidSDF(i, j + 1),
+            grid.fluidSDF(i, j - 1)
+        };
+        const Float cellsVel[] = {
+            -grid.u(i + 1, j), /* minus velocity */
+             grid.u(i, j),
+            -grid.v(i, j + 1), /* minus velocity */
+             grid.v(i, j)
+        };
+        const Int cols[] = {
+            pressureRows(i + 1, j),
+            pressureRows(i - 1, j),
+            pressureRows(i, j + 1),
+            pressureRows(i, j - 1)
+        };
+
+        /* Fill-in matrix */
+        for(std::size_t cell = 0; cell < 4; ++cell) {
+            rhsVal += Double(cellsWeights[cell]*cellsVel[cell]);
+            const Float term = cellsWeights[cell] * dt;
+            if(cellsSDF[cell] < 0.0f) {
+                _pressureSolver.matrix.addToElement(row, row, term);
+                /* Fluid cells on the domain edge have zero pressure */
+                if(cols[cell] >= 0)
                     _pressureSolver.matrix.addToElement(row, cols[cell], -term);
-                } else {
-                    const Float theta = Math::max(0.01f, fractionInside(centerSDF, cellsSDF[cell]));
-                    _pressureSolver.matrix.addToElement(row, row, term / theta);
-                }
+            } else {
+                const Float theta = Math::max(0.01f, fractionInside(centerSDF, cellsSDF[cell]));
+                _pressureSolver.matrix.addToElement(row, row, term / theta);
             }
-
-            /* Write rhs */
-            _pressureSolver.rhs[row] = rhsVal;
         }
-    }
+
+        /* Write rhs */
+        _pressureSolver.rhs[std::size_t(row)] = rhsVal;
+    });
 
     _pressureSolver.solve(); /* now solve the linear system for cells' pressure */
 
-    _grid.u.loop2D([&](std::size_t i, std::size_t j) {
+    const auto pressure = [&](std::size_t i, std::size_t j) {
+        const Int row = pressureRows(i, j);
+        return row < 0 ? 0.0 : _pressureSolver.solution[std::size_t(row)];
+    };
+
+    _grid.u.loopActive2D([&](std::size_t i, std::size_t j) {
         /* Edges of the domain, or entirely in solid */
         if(i == 0 || i == _grid.u.sizeX() - 1 || !(_grid.uWeights(i, j) > 0)) {
             _grid.u(i, j) = 0;
             return;
         }
 
-        const Float centerSDF = _grid.fluidSDF(i, j);
-        const Float leftSDF   = _grid.fluidSDF(i - 1, j);
+        const Float centerSDF = grid.fluidSDF(i, j);
+        const Float leftSDF   = grid.fluidSDF(i - 1, j);
         if(centerSDF < 0 || leftSDF < 0) {
             Float theta = 1;
-            if(_grid.fluidSDF(i, j) >= 0 || leftSDF >= 0) {
+            if(centerSDF >= 0 || leftSDF >= 0) {
                 theta = Math::max(0.01f, fractionInside(leftSDF, centerSDF));
             }
-            const std::size_t row = i + j*nI;
-            const Float pressure = Float(_pressureSolver.solution[row] - _pressureSolver.solution[row - 1]);
-            _grid.u(i, j) -= pressure*(dt/theta);
+            const Float pressureDiff = Float(pressure(i, j) - pressure(i - 1, j));
+            _grid.u(i, j) -= pressureDiff*(dt/theta);
         }
     });
 
-    _grid.v.loop2D([&](std::size_t i, std::size_t j) {
+    _grid.v.loopActive2D([&](std::size_t i, std::size_t j) {
         /* Edges of the domain, or entirely in solid */
         if(j == 0 || j == _grid.v.sizeY() - 1 || !(_grid.vWeights(i, j) > 0)) {
             _grid.v(i, j) = 0;
             return;
         }
 
-        const Float centerSDF = _grid.fluidSDF(i, j);
-        const Float bottomSDF = _grid.fluidSDF(i, j - 1);
+        const Float centerSDF = grid.fluidSDF(i, j);
+        const Float bottomSDF = grid.fluidSDF(i, j - 1);
         if(centerSDF < 0 || bottomSDF < 0) {
             Float theta = 1;
             if(centerSDF >= 0 || bottomSDF >= 0) {
                 theta = Math::max(0.01f, fractionInside(bottomSDF, centerSDF));
             }
-            const std::size_t row = i + j*nI;
-            const Float pressure = Float(_pressureSolver.solution[row] - _pressureSolver.solution[row - nI]);
-            _grid.v(i, j) -= pressure*(dt/theta);
+            const Float pressureDiff = Float(pressure(i, j) - pressure(i, j - 1));
+            _grid.v(i, j) -= pressureDiff*(dt/theta);
         }
     });
 }
@@ -420,7 +806,7 @@ void ApicSolver2D::constrainVelocity() {
     _grid.uTmp = _grid.u;
     _grid.vTmp = _grid.v;
 
-    _grid.u.loop2D([&](std::size_t i, std::size_t j) {
+    _grid.u.loopActive2D([&](std::size_t i, std::size_t j) {
         if(_grid.uWeights(i, j) > 0) /* not entirely in solid */
             return;
 
@@ -432,7 +818,7 @@ void ApicSolver2D::constrainVelocity() {
         _grid.uTmp(i, j) = vel[0];
     });
 
-    _grid.v.loop2D([&](std::size_t i, std::size_t j) {
+    _grid.v.loopActive2D([&](std::size_t i, std::size_t j) {
         if(_grid.vWeights(i, j) > 0) /* not entirely in solid */
             return;
 
@@ -470,8 +856,8 @@ void ApicSolver2D::relaxParticlePositions(Float dt) {
             if(distSqr > overlappedSqr) {
                 spring += xpq * (w / Math::sqrt(distSqr)*restDist);
             } else {
-                spring.x() += ((rand() & 255) - 128)*jitterMag;
-                spring.y() += ((rand() & 255) - 128)*jitterMag;
+                spring.x() += (Int(_random() & 255) - 128)*jitterMag;
+                spring.y() += (Int(_random() & 255) - 128)*jitterMag;
             }
         });
 
@@ -483,8 +869,8 @@ void ApicSolver2D::relaxParticlePositions(Float dt) {
 }
 
 void ApicSolver2D::gridVelocity2Particle() {
-    Array2X<Float>& u = _grid.u;
-    Array2X<Float>& v = _grid.v;
+    const TiledArray2X<Float>& u = _grid.u;
+    const TiledArray2X<Float>& v = _grid.v;
     const auto dxInv = _grid.invCellSize;
 
     _particles.loopAll([&](UnsignedInt p) {
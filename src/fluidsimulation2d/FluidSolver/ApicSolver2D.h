@@ -30,8 +30,11 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <random>
 #include <Corrade/Containers/Pointer.h>
 
+#include "Checkpoint.h"
+#include "Profiler.h"
 #include "FluidSolver/SolverData.h"
 
 namespace Magnum { namespace Examples {
@@ -47,7 +50,24 @@ public:
         _particles.addParticles(_particles.positionsT0, 0);
     }
 
-    void emitParticles() { generateParticles(_objects->emitter, 10); }
+    void emitParticles() { generateParticles(_emitter, 10); }
+
+    /* Continuous emitters and sinks, applied at the beginning of every
+       frame. An emitter keeps the cells with centers inside its shape filled
+       with particles, the new ones moving with given velocity. Particles in
+       cells with centers inside a sink are removed. Neither is saved in a
+       checkpoint, same as the scene objects. */
+    void addEmitter(const SDFObject& shape, const Vector2& velocity);
+    void addSink(const SDFObject& shape);
+    void clearEmitters();
+    void clearSinks();
+    std::size_t emitterCount() const { return _emitters.size(); }
+    std::size_t sinkCount() const { return _sinkCount; }
+
+    /* Upper bound on the particle count, zero by default for no bound.
+       Emitters stop adding particles when it's reached. */
+    UnsignedInt maxParticles() const { return _particles.maxCount; }
+    void setMaxParticles(UnsignedInt count) { _particles.setMaxCount(count); }
 
     void addRepulsiveVelocity(const Vector2& p0, const Vector2& p1, Float dt, Float radius, Float magnitude);
 
@@ -55,6 +75,18 @@ public:
 
     /* Properties */
     UnsignedInt numParticles() const { return _particles.size(); }
+    /* All particle IDs are less than this value */
+    UnsignedInt particleIdBound() const { return _particles.nextId; }
+
+    std::size_t numActiveGridTiles() const { return _grid.activeTiles.size(); }
+
+    /* Number of cell layers the fluid velocity is extrapolated into the air,
+       at most GridTileSize, as the active grid band is one tile wide */
+    Int extrapolationLayers() const { return _extrapolationLayers; }
+    void setExtrapolationLayers(Int layers) {
+        _extrapolationLayers = Math::clamp(layers, 1, GridTileSize);
+    }
+    std::size_t numGridTiles() const { return _grid.tileFlags.size(); }
 
     Float particleRadius() const { return _particles.particleRadius; }
 
@@ -62,17 +94,43 @@ public:
         return _particles.positions;
     }
 
+    /* 64-bit FNV-1a hash of particle positions, velocities and affine
+       matrices. Same setup gives the same sequence of checksums regardless
+       of the thread count, see TaskScheduler::setThreadCount(). */
+    UnsignedLong stateChecksum() const;
+
+    /* Per-stage timing of advanceFrame(), disabled by default */
+    Profiler& profiler() { return _profiler; }
+
+    /* Particles together with the grid velocities the next time step is
+       derived from. The scene objects aren't saved, the checkpoint has to
+       be loaded into a solver set up with the same scene. Loading doesn't
+       touch the solver if it fails. */
+    bool saveCheckpoint(Containers::StringView filename) const;
+    bool loadCheckpoint(const Checkpoint& checkpoint);
+    bool loadCheckpoint(Containers::StringView filename);
+    static Containers::StringView checkpointKind();
+    static UnsignedInt checkpointVersion();
+
+    /* Particles get reordered during the simulation, the ID of a particle
+       stays the same */
+    const std::vector<UnsignedInt>& particleIds() const {
+        return _particles.ids;
+    }
+
 private:
     /* Initialization */
     void initBoundary();
-    void generateParticles(const SDFObject& sdfObj, Float initialVelocity_y);
+    void generateParticles(const SDFProgram& sdf, Float initialVelocity_y);
 
     /* Simulation */
+    void applyEmittersAndSinks();
     Float timestepCFL() const;
     void moveParticles(Float dt);
+    void sortParticles();
     void collectParticlesToCells();
     void particleVelocity2Grid();
-    void extrapolate(Array2X<Float>& grid, Array2X<Float>& tmp_grid, Array2X<char>& valid, Array2X<char>& old_valid) const;
+    void extrapolate(TiledArray2X<Float>& grid, TiledArray2X<Float>& tmp_grid, TiledArray2X<char>& valid, TiledArray2X<char>& old_valid) const;
     void addGravity(Float dt);
     void computeFluidSDF();
     void solvePressures(Float dt);
@@ -81,9 +139,36 @@ private:
     void gridVelocity2Particle();
 
     Containers::Pointer<SceneObjects> _objects;
+    /* Scene objects compiled for fast evaluation */
+    SDFProgram _emitterT0, _emitter, _boundary;
     ParticleData _particles;
     GridData _grid;
     LinearSystemSolver _pressureSolver;
+    Int _extrapolationLayers = 1;
+
+    /* Cells of each emitter and a flag for each cell marking the emitter
+       and sink cells. Both arrays are allocated only once there's an
+       emitter or a sink. */
+    struct Emitter {
+        std::vector<Vector2i> cells;
+        Vector2 velocity;
+    };
+    enum: UnsignedByte { EmitterCell = 1 << 0, SinkCell = 1 << 1 };
+    std::vector<Emitter> _emitters;
+    std::size_t _sinkCount = 0;
+    Array2X<UnsignedByte> _cellFlags;
+    Array2X<UnsignedByte> _cellParticleCounts;
+    std::vector<Vector2> _emittedParticles;
+
+    /* Particles are sorted spatially every SortInterval substeps */
+    enum: Int { SortInterval = 16 };
+    Int _substepsSinceSort = SortInterval;
+
+    /* Jitter of generated and overlapping particles. The seed is fixed, so
+       the same setup always gives the same results. */
+    std::mt19937 _random{5489u};
+
+    Profiler _profiler;
 };
 
 }}
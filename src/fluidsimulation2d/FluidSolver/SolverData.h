@@ -30,12 +30,15 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <algorithm>
 #include <vector>
 #include <Magnum/Math/Matrix.h>
 
 #include "DataStructures/Array2X.h"
 #include "DataStructures/SDFObject.h"
+#include "DataStructures/SDFProgram.h"
 #include "DataStructures/PCGSolver.h"
+#include "DataStructures/TiledArray2X.h"
 
 namespace Magnum { namespace Examples {
 struct SceneObjects {
@@ -49,21 +52,114 @@ struct ParticleData {
 
     UnsignedInt size() const { return static_cast<UnsignedInt>(positions.size()); }
 
-    void addParticles(const std::vector<Vector2>& newParticles, Float initialVelocity_y) {
+    /* Upper bound on the particle count, zero for no bound. Storage for all
+       of them is allocated right away, including the scratch space for
+       sorting, so adding, removing and sorting particles never reallocates.
+       Particles over the bound are not added. */
+    void setMaxCount(UnsignedInt count) {
+        maxCount = count;
+        positions.reserve(count);
+        velocities.reserve(count);
+        affineMat.reserve(count);
+        ids.reserve(count);
+        tmp.reserve(count);
+        freeSlots.reserve(count);
+        freeIds.reserve(count);
+        sortKeys.reserve(count);
+        velocitiesTmp.reserve(count);
+        affineMatTmp.reserve(count);
+        idsTmp.reserve(count);
+    }
+
+    /* Fills the slots of removed particles first. Returns the count of
+       particles actually added. */
+    UnsignedInt addParticles(const std::vector<Vector2>& newParticles, const Vector2& velocity) {
         if(positionsT0.size() == 0) {
             positionsT0 = newParticles;
         }
-        positions.insert(positions.end(), newParticles.begin(), newParticles.end());
-        velocities.resize(size(), Vector2(0, -initialVelocity_y));
-        affineMat.resize(size(), Matrix2x2(0));
+
+        std::size_t count = newParticles.size();
+        if(maxCount) {
+            const std::size_t alive = positions.size() - freeSlots.size();
+            count = Math::min(count, alive < maxCount ? maxCount - alive : 0);
+        }
+
+        for(std::size_t i = 0; i < count; ++i) {
+            UnsignedInt id;
+            if(freeIds.empty()) id = nextId++;
+            else {
+                id = freeIds.back();
+                freeIds.pop_back();
+            }
+
+            if(freeSlots.empty()) {
+                positions.push_back(newParticles[i]);
+                velocities.push_back(velocity);
+                affineMat.push_back(Matrix2x2(0));
+                ids.push_back(id);
+                continue;
+            }
+
+            const UnsignedInt p = freeSlots.back();
+            freeSlots.pop_back();
+            positions[p] = newParticles[i];
+            velocities[p] = velocity;
+            affineMat[p] = Matrix2x2(0);
+            ids[p] = id;
+        }
         tmp.resize(size(), Vector2(0));
+        return UnsignedInt(count);
+    }
+
+    UnsignedInt addParticles(const std::vector<Vector2>& newParticles, Float initialVelocity_y) {
+        return addParticles(newParticles, Vector2(0, -initialVelocity_y));
+    }
+
+    /* Leaves a hole that's filled by the next added particle or closed by
+       compact(), whichever comes first. The simulation can't run with holes
+       in the arrays. Each particle can be removed only once. */
+    void removeParticle(UnsignedInt p) {
+        freeSlots.push_back(p);
+        freeIds.push_back(ids[p]);
+    }
+
+    /* Close the holes left by removed particles, keeping the order of the
+       remaining ones */
+    void compact() {
+        if(freeSlots.empty()) return;
+
+        std::sort(freeSlots.begin(), freeSlots.end());
+        UnsignedInt to = freeSlots.front();
+        std::size_t hole = 0;
+        for(UnsignedInt from = to, end = size(); from < end; ++from) {
+            if(hole < freeSlots.size() && freeSlots[hole] == from) {
+                ++hole;
+                continue;
+            }
+            positions[to] = positions[from];
+            velocities[to] = velocities[from];
+            affineMat[to] = affineMat[from];
+            ids[to] = ids[from];
+            ++to;
+        }
+
+        positions.resize(to);
+        velocities.resize(to);
+        affineMat.resize(to);
+        ids.resize(to);
+        tmp.resize(to);
+        freeSlots.clear();
     }
 
     void reset() {
         positions.resize(0);
         velocities.resize(0);
         affineMat.resize(0);
+        ids.resize(0);
         tmp.resize(0);
+        freeSlots.resize(0);
+        freeIds.resize(0);
+        nextId = 0;
     }
 
     template<class Function>
@@ -78,7 +174,25 @@ struct ParticleData {
     std::vector<Vector2>   positions;
     std::vector<Vector2>   velocities;
     std::vector<Matrix2x2> affineMat;
+    /* ID of each particle, which stays the same when the particles get
+       reordered. IDs of removed particles get reused, so they're always
+       less than nextId. */
+    std::vector<UnsignedInt> ids;
     std::vector<Vector2>   tmp;
+
+    /* Pool bookkeeping, see removeParticle() */
+    UnsignedInt maxCount = 0;
+    UnsignedInt nextId = 0;
+    std::vector<UnsignedInt> freeSlots;
+    std::vector<UnsignedInt> freeIds;
+
+    /* Scratch space for spatial sorting. Each sort key has the Morton code
+       of the particle cell in upper 32 bits and the particle index in lower
+       32 bits. */
+    std::vector<UnsignedLong> sortKeys;
+    std::vector<Vector2>     velocitiesTmp;
+    std::vector<Matrix2x2>   affineMatTmp;
+    std::vector<UnsignedInt> idsTmp;
 };
 
 struct GridData {
@@ -87,20 +201,75 @@ struct GridData {
         cellSize{cellSize_},
         invCellSize{1.0f/cellSize}
     {
+        numTiles = Vector2i{(nI + GridTileSize)/GridTileSize,
+                            (nJ + GridTileSize)/GridTileSize};
+        tileFlags.resize(std::size_t(numTiles.product()));
+
+        /* Velocities and other per-substep data are stored only in tiles
+           around the fluid */
         u.resize(nI + 1, nJ);
         v.resize(nI, nJ + 1);
         uTmp.resize(nI + 1, nJ);
         vTmp.resize(nI, nJ + 1);
-        uWeights.resize(nI + 1, nJ);
-        vWeights.resize(nI, nJ + 1);
         uValid.resize(nI + 1, nJ);
         vValid.resize(nI, nJ + 1);
         uOldValid.resize(nI + 1, nJ);
         vOldValid.resize(nI, nJ + 1);
+        fluidSDF.resize(nI, nJ, 3*cellSize);
+        pressureRows.resize(nI, nJ, -1);
+        cellParticles.resize(nI, nJ);
 
-        fluidSDF.resize(nI, nJ);
+        /* Boundary data don't change during the simulation, they are computed
+           once for the whole domain */
+        uWeights.resize(nI + 1, nJ);
+        vWeights.resize(nI, nJ + 1);
         boundarySDF.resize(nI + 1, nJ + 1);
-        cellParticles.resize(nI, nJ);
+        boundaryCellSDF.resize(nI, nJ);
+    }
+
+    /* Activate grid tiles that contain particles, together with one ring of
+       tiles around them. The ring is wide enough to contain the velocity
+       stencils, the fluid SDF band and extrapolated velocities of all fluid
+       cells, so no stage ever needs to write into an inactive tile. */
+    void updateActiveTiles(const std::vector<Vector2>& positions) {
+        tileFlags.assign(tileFlags.size(), 0);
+        for(const Vector2& ppos: positions) {
+            const Vector2i cellIdx = getValidCellIdx(ppos);
+            tileFlags[cellIdx.x()/GridTileSize + cellIdx.y()/GridTileSize*numTiles.x()] = 1;
+        }
+
+        activeTiles.clear();
+        for(Int tj = 0; tj < numTiles.y(); ++tj) {
+            for(Int ti = 0; ti < numTiles.x(); ++ti) {
+                bool active = false;
+                for(Int sj = Math::max(tj - 1, 0); sj <= Math::min(tj + 1, numTiles.y() - 1) && !active; ++sj)
+                    for(Int si = Math::max(ti - 1, 0); si <= Math::min(ti + 1, numTiles.x() - 1) && !active; ++si)
+                        active = tileFlags[si + sj*numTiles.x()];
+                if(active) activeTiles.push_back({ti, tj});
+            }
+        }
+
+        allocateActiveTiles();
+    }
+
+    /* Activate exactly given tiles, used when restoring a checkpoint */
+    void setActiveTiles(const std::vector<Vector2i>& tiles) {
+        activeTiles = tiles;
+        allocateActiveTiles();
+    }
+
+    void allocateActiveTiles() {
+        u.setActiveTiles(activeTiles);
+        v.setActiveTiles(activeTiles);
+        uTmp.setActiveTiles(activeTiles);
+        vTmp.setActiveTiles(activeTiles);
+        uValid.setActiveTiles(activeTiles);
+        vValid.setActiveTiles(activeTiles);
+        uOldValid.setActiveTiles(activeTiles);
+        vOldValid.setActiveTiles(activeTiles);
+        fluidSDF.setActiveTiles(activeTiles);
+        pressureRows.setActiveTiles(activeTiles);
+        cellParticles.setActiveTiles(activeTiles);
     }
 
     Vector2 getGridPos(const Vector2& worldPos) const {
@@ -161,14 +330,25 @@ struct GridData {
     const Float cellSize;
     const Float invCellSize;
 
-    /* Nodes and cells' data */
-    Array2X<Float> u, uTmp, uWeights;
-    Array2X<Float> v, vTmp, vWeights;
-    Array2X<char> uValid, vValid, uOldValid, vOldValid;
+    /* Grid tiles */
+    Vector2i numTiles;
+    std::vector<char> tileFlags;
+    std::vector<Vector2i> activeTiles;
+
+    /* Nodes and cells' data, allocated only in active tiles */
+    TiledArray2X<Float> u, uTmp;
+    TiledArray2X<Float> v, vTmp;
+    TiledArray2X<char> uValid, vValid, uOldValid, vOldValid;
+    TiledArray2X<Float> fluidSDF;
+    /* Row of each fluid cell in the pressure linear system, -1 for others */
+    TiledArray2X<Int> pressureRows;
+    TiledArray2X<std::vector<UnsignedInt>> cellParticles;
+
+    /* Static boundary data, allocated for the whole domain. The boundary
+       SDF is sampled both at grid nodes and cell centers. */
+    Array2X<Float> uWeights, vWeights;
     Array2X<Float> boundarySDF;
-    Array2X<Float> fluidSDF;
-
-    Array2X<std::vector<UnsignedInt>> cellParticles;
+    Array2X<Float> boundaryCellSDF;
 };
 
 struct LinearSystemSolver {
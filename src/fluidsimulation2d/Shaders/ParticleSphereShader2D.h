@@ -36,6 +36,9 @@ namespace Magnum { namespace Examples {
 
 class ParticleSphereShader2D: public GL::AbstractShaderProgram {
     public:
+        /* ID of the particle, used for coloring */
+        typedef GL::Attribute<1, UnsignedInt> ParticleId;
+
         enum ColorMode {
             UniformDiffuseColor = 0,
             RampColorById
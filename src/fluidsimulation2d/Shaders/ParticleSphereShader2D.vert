@@ -38,6 +38,7 @@ uniform vec3 uniformColor;
 
 
 layout(location = 0) in highp vec2 position;
+layout(location = 1) in highp uint particleId;
 flat out vec3 color;
 
 const vec3 colorRamp[] = vec3[] (
@@ -53,8 +54,8 @@ const vec3 colorRamp[] = vec3[] (
 vec3 generateVertexColor() {
     if(colorMode == 1 ) { /* ramp color by particle id */
         float segmentSize = float(numParticles)/6.0f;
-        float segment = floor(float(gl_VertexID)/segmentSize);
-        float t = (float(gl_VertexID) - segmentSize*segment)/segmentSize;
+        float segment = floor(float(particleId)/segmentSize);
+        float t = (float(particleId) - segmentSize*segment)/segmentSize;
         vec3 startVal = colorRamp[int(segment)];
         vec3 endVal = colorRamp[int(segment) + 1];
         return mix(startVal, endVal, t);
@@ -0,0 +1,157 @@
+#ifndef Magnum_Examples_FluidSimulation2D_TaskScheduler_h
+#define Magnum_Examples_FluidSimulation2D_TaskScheduler_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <vector>
+#include <Magnum/Magnum.h>
+
+#include "configure.h"
+
+#ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_MULTITHREADING
+    #ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_TBB
+    #include <Corrade/Containers/Pointer.h>
+    #include <tbb/global_control.h>
+    #include <tbb/parallel_for.h>
+    #include <tbb/task_arena.h>
+    #else
+    #include "ThreadPool.h"
+    #endif
+#endif
+
+namespace Magnum { namespace Examples { namespace TaskScheduler {
+
+namespace Implementation {
+    inline bool& busyTimeTracking() {
+        static bool enabled = false;
+        return enabled;
+    }
+
+    #if !defined(MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_MULTITHREADING) || defined(MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_TBB)
+    /* One entry per thread, with TBB indexed by the thread slot. Each is
+       written only by its own thread. */
+    inline std::vector<Double>& busyTime() {
+        static std::vector<Double> time;
+        return time;
+    }
+
+    inline Double secondsSince(const std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    #endif
+}
+
+/* Parallel loops don't depend on the thread count in any way --- every
+   iteration writes only its own outputs and the few reductions that there
+   are are summed over fixed chunks in a fixed order. The results are thus
+   bit-identical whether they're computed on one thread or on sixty-four,
+   which allows to limit the count for reproducing or measuring things.
+
+   Zero means all hardware threads. Must not be called from inside
+   forEach(). */
+inline void setThreadCount(std::size_t count) {
+    #ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_MULTITHREADING
+    #ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_TBB
+    static Containers::Pointer<tbb::global_control> control;
+    control.reset();
+    if(count) control.reset(new tbb::global_control{
+        tbb::global_control::max_allowed_parallelism, count});
+    #else
+    ThreadPool::setUniqueInstanceThreadCount(count);
+    ThreadPool::getUniqueInstance().setBusyTimeTracking(Implementation::busyTimeTracking());
+    #endif
+    #else
+    static_cast<void>(count);
+    #endif
+}
+
+/* If enabled, forEach() measures how long each thread spent running its part
+   of the loop, otherwise it costs just a branch. Used by Profiler to see how
+   well the work is balanced across threads. Enabling resets the counters.
+   Must not be called from inside forEach(). */
+inline void setBusyTimeTracking(bool enabled) {
+    Implementation::busyTimeTracking() = enabled;
+    #ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_MULTITHREADING
+    #ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_TBB
+    Implementation::busyTime().assign(std::size_t(tbb::this_task_arena::max_concurrency()), 0.0);
+    #else
+    ThreadPool::getUniqueInstance().resetBusyTime();
+    ThreadPool::getUniqueInstance().setBusyTimeTracking(enabled);
+    #endif
+    #else
+    Implementation::busyTime().assign(1, 0.0);
+    #endif
+}
+
+inline bool isBusyTimeTracking() {
+    return Implementation::busyTimeTracking();
+}
+
+/* Busy time accumulated by each thread since the tracking was enabled, in
+   seconds */
+inline void busyTime(std::vector<Double>& out) {
+    #if defined(MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_MULTITHREADING) && !defined(MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_TBB)
+    const std::vector<Double>& time = ThreadPool::getUniqueInstance().busyTime();
+    #else
+    const std::vector<Double>& time = Implementation::busyTime();
+    #endif
+    out.assign(time.begin(), time.end());
+}
+
+template<class IndexType, class Function> void forEach(IndexType endIdx, Function&& func) {
+    #ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_MULTITHREADING
+    #ifdef MAGNUM_FLUIDSIMULATION2D_EXAMPLE_USE_TBB
+    const bool trackBusyTime = Implementation::busyTimeTracking();
+    tbb::parallel_for(tbb::blocked_range<IndexType>(IndexType(0), endIdx),
+        [&](const tbb::blocked_range<IndexType>& r) {
+            const auto begin = trackBusyTime ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+            for(IndexType i = r.begin(), iEnd = r.end(); i < iEnd; ++i) {
+                func(i);
+            }
+            if(trackBusyTime)
+                Implementation::busyTime()[std::size_t(tbb::this_task_arena::current_thread_index())] += Implementation::secondsSince(begin);
+        });
+    #else
+    ThreadPool::getUniqueInstance().parallel_for(endIdx, std::forward<Function>(func));
+    #endif
+    #else
+    const auto begin = Implementation::busyTimeTracking() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+    for(IndexType idx = 0; idx < endIdx; ++idx) {
+        func(idx);
+    }
+    if(Implementation::busyTimeTracking())
+        Implementation::busyTime()[0] += Implementation::secondsSince(begin);
+    #endif
+}
+
+}}}
+
+#endif
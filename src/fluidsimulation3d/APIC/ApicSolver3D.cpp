@@ -0,0 +1,488 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "APIC/ApicSolver3D.h"
+
+#include "TaskScheduler.h"
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Grid stages are processed in parallel over cubic blocks of cells. With X
+   being the fastest changing index, a block of 8^3 cells of a Float array
+   spans just 64 short rows, so the data a block reads from its neighborhood
+   stay in the cache while it's being processed. */
+constexpr Int GridBlockSize = 8;
+
+template<class T, class Function> void parallelLoop3D(const Array3X<T>& array, Function&& func) {
+    const Vector3i size = array.size();
+    const Vector3i numBlocks = (size + Vector3i{GridBlockSize - 1})/GridBlockSize;
+    TaskScheduler::forEach(std::size_t(numBlocks.product()), [&](std::size_t blockIdx) {
+        const Int bi = Int(blockIdx%std::size_t(numBlocks.x()));
+        const Int bj = Int(blockIdx/std::size_t(numBlocks.x())%std::size_t(numBlocks.y()));
+        const Int bk = Int(blockIdx/std::size_t(numBlocks.x()*numBlocks.y()));
+        const std::size_t iEnd = std::size_t(Math::min((bi + 1)*GridBlockSize, size.x()));
+        const std::size_t jEnd = std::size_t(Math::min((bj + 1)*GridBlockSize, size.y()));
+        const std::size_t kEnd = std::size_t(Math::min((bk + 1)*GridBlockSize, size.z()));
+        for(std::size_t k = std::size_t(bk*GridBlockSize); k < kEnd; ++k) {
+            for(std::size_t j = std::size_t(bj*GridBlockSize); j < jEnd; ++j) {
+                for(std::size_t i = std::size_t(bi*GridBlockSize); i < iEnd; ++i) {
+                    func(i, j, k);
+                }
+            }
+        }
+    });
+}
+
+template<class T> UnsignedLong fnv1a(UnsignedLong hash, const std::vector<T>& data) {
+    const auto* bytes = reinterpret_cast<const UnsignedByte*>(data.data());
+    for(std::size_t i = 0, size = data.size()*sizeof(T); i != size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+}
+
+ApicSolver3D::ApicSolver3D(const Vector3& origin, Float cellSize, Int nI, Int nJ, Int nK, SceneObjects3D* sceneObjs):
+    _objects{sceneObjs},
+    _particles{cellSize},
+    _grid{origin, cellSize, nI, nJ, nK}
+{
+    if(nI < 1 || nJ < 1 || nK < 1) {
+        Fatal{} << "Invalid grid resolution";
+    }
+    if(!sceneObjs) {
+        Fatal{} << "Invalid scene object";
+    }
+
+    /* Initialize data */
+    initBoundary();
+    generateParticles(_objects->emitterT0, 0);
+}
+
+/* This function should be called again every time the boundary changes */
+void ApicSolver3D::initBoundary() {
+    /* Bake the boundary SDF at grid nodes and cell centers */
+    const SDFObject3D& boundary = _objects->boundary;
+    parallelLoop3D(_grid.boundarySDF, [&](std::size_t i, std::size_t j, std::size_t k) {
+        _grid.boundarySDF(i, j, k) = boundary.signedDistance(_grid.getWorldPos({Float(i), Float(j), Float(k)}));
+    });
+    parallelLoop3D(_grid.boundaryCellSDF, [&](std::size_t i, std::size_t j, std::size_t k) {
+        _grid.boundaryCellSDF(i, j, k) = boundary.signedDistance(_grid.getWorldPos({i + 0.5f, j + 0.5f, k + 0.5f}));
+    });
+
+    /* Initialize the fluid face weights from the boundary signed distance
+       field at the face corners */
+    const Array3X<Float>& phi = _grid.boundarySDF;
+    parallelLoop3D(_grid.uWeights, [&](std::size_t i, std::size_t j, std::size_t k) {
+        _grid.uWeights(i, j, k) = Math::clamp(Float(1) - fractionInside(
+            phi(i, j, k), phi(i, j + 1, k), phi(i, j + 1, k + 1), phi(i, j, k + 1)),
+            Float(0), Float(1));
+    });
+    parallelLoop3D(_grid.vWeights, [&](std::size_t i, std::size_t j, std::size_t k) {
+        _grid.vWeights(i, j, k) = Math::clamp(Float(1) - fractionInside(
+            phi(i, j, k), phi(i + 1, j, k), phi(i + 1, j, k + 1), phi(i, j, k + 1)),
+            Float(0), Float(1));
+    });
+    parallelLoop3D(_grid.wWeights, [&](std::size_t i, std::size_t j, std::size_t k) {
+        _grid.wWeights(i, j, k) = Math::clamp(Float(1) - fractionInside(
+            phi(i, j, k), phi(i + 1, j, k), phi(i + 1, j + 1, k), phi(i, j + 1, k)),
+            Float(0), Float(1));
+    });
+}
+
+void ApicSolver3D::generateParticles(const SDFObject3D& sdf, Float initialVelocity_y) {
+    using Distribution = std::uniform_real_distribution<Float>;
+    const Float rndScale = _particles.particleRadius*0.5f;
+    Distribution distr(-rndScale, rndScale);
+
+    /* Generate new particles, eight candidates per cell, one at the center of
+       each octant */
+    std::vector<Vector3> newParticles;
+    const Float offset = 0.25f*_grid.cellSize;
+    for(Int k = 0; k < _grid.nK; ++k) {
+        for(Int j = 0; j < _grid.nJ; ++j) {
+            for(Int i = 0; i < _grid.nI; ++i) {
+                const Vector3 cellCenter = _grid.getWorldPos({i + 0.5f, j + 0.5f, k + 0.5f});
+                for(Int c = 0; c < 8; ++c) {
+                    const Vector3 octant{c & 1 ? offset : -offset,
+                                         c & 2 ? offset : -offset,
+                                         c & 4 ? offset : -offset};
+                    const Vector3 candidate = cellCenter + octant + Vector3(distr(_random), distr(_random), distr(_random));
+                    if(sdf.signedDistance(candidate) < 0 &&
+                       _objects->boundary.signedDistance(candidate) > 0) {
+                        newParticles.push_back(candidate);
+                    }
+                }
+            }
+        }
+    }
+
+    /* Insert into the system */
+    _particles.addParticles(newParticles, initialVelocity_y);
+}
+
+UnsignedLong ApicSolver3D::stateChecksum() const {
+    UnsignedLong hash = 14695981039346656037ull;
+    hash = fnv1a(hash, _particles.positions);
+    hash = fnv1a(hash, _particles.velocities);
+    hash = fnv1a(hash, _particles.affineMat);
+    return hash;
+}
+
+void ApicSolver3D::advanceFrame(Float frameDuration) {
+    Float frameTime = 0;
+
+    while(frameTime < frameDuration) {
+        Float substep = timestepCFL();
+        const Float remainingTime = frameDuration - frameTime;
+        if(frameTime + substep > frameDuration)
+            substep = remainingTime;
+        else if(frameTime + Float(1.5) * substep > frameDuration)
+            substep = remainingTime * Float(0.5);
+        frameTime += substep;
+
+        /* Advect particles */
+        moveParticles(substep);
+
+        /* Particles => grid */
+        collectParticlesToCells();
+        particleVelocity2Grid();
+
+        /* Update grid velocity */
+        extrapolate(_grid.u, _grid.uTmp, _grid.uValid, _grid.uOldValid);
+        extrapolate(_grid.v, _grid.vTmp, _grid.vValid, _grid.vOldValid);
+        extrapolate(_grid.w, _grid.wTmp, _grid.wValid, _grid.wOldValid);
+        addGravity(substep);
+        computeFluidSDF();
+        solvePressures(substep);
+
+        /* Enforce boundary condition */
+        constrainVelocity();
+
+        /* Grid => particles */
+        gridVelocity2Particle();
+    }
+}
+
+Float ApicSolver3D::timestepCFL() const {
+    /* Particle velocities are interpolated from the grid, so the particle
+       maximum is a cheap estimate of the grid maximum */
+    Float maxVelSqr = 0;
+    for(const Vector3& vel: _particles.velocities) {
+        maxVelSqr = Math::max(maxVelSqr, vel.dot());
+    }
+    return maxVelSqr > 0 ? _grid.cellSize/Math::sqrt(maxVelSqr)*3.0f : 1.0f;
+}
+
+void ApicSolver3D::moveParticles(Float dt) {
+    TaskScheduler::forEach(_particles.size(), [&](UnsignedInt p) {
+        const Vector3 newPos = _particles.positions[p] + _particles.velocities[p]*dt;
+        _particles.positions[p] = _grid.constrainBoundary(newPos);
+    });
+}
+
+void ApicSolver3D::collectParticlesToCells() {
+    TaskScheduler::forEach(_particles.size(), [&](UnsignedInt p) {
+        const Vector3i cellIdx = _grid.getValidCellIdx(_particles.positions[p]);
+        _particles.cells[p] = UnsignedInt(_grid.flatCellIdx(cellIdx.x(), cellIdx.y(), cellIdx.z()));
+    });
+    _grid.sortParticlesToCells(_particles.cells);
+}
+
+void ApicSolver3D::particleVelocity2Grid() {
+    /* Each face gathers from particles in the cells its kernel overlaps, so
+       faces can be computed in parallel without any atomics */
+    const auto gather = [&](Array3X<Float>& grid, Array3X<char>& valid, std::size_t axis, const Vector3i& low, const Vector3i& high) {
+        Vector3 nodeOffset{0.5f};
+        nodeOffset[axis] = 0.0f;
+        parallelLoop3D(grid, [&](std::size_t i, std::size_t j, std::size_t k) {
+            Float sumW = 0.0f;
+            Float sumU = 0.0f;
+            const Vector3 nodePos = _grid.getWorldPos(Vector3{Float(i), Float(j), Float(k)} + nodeOffset);
+            _grid.loopNeigborParticles(Int(i), Int(j), Int(k), low.x(), high.x(), low.y(), high.y(), low.z(), high.z(), [&](UnsignedInt p) {
+                const Vector3 xpg = nodePos - _particles.positions[p];
+                const Float w = linearKernel(xpg, _grid.invCellSize);
+                if(w > 0) {
+                    sumW += w;
+                    sumU += w*(_particles.velocities[p][axis] + Math::dot(_particles.affineMat[p][axis], xpg));
+                }
+            });
+            grid(i, j, k) = sumW > 0 ? sumU/sumW : 0.0f;
+            valid(i, j, k) = sumW > 0 ? 1 : 0;
+        });
+    };
+
+    gather(_grid.u, _grid.uValid, 0, {-1, -1, -1}, {0, 1, 1});
+    gather(_grid.v, _grid.vValid, 1, {-1, -1, -1}, {1, 0, 1});
+    gather(_grid.w, _grid.wValid, 2, {-1, -1, -1}, {1, 1, 0});
+}
+
+void ApicSolver3D::extrapolate(Array3X<Float>& grid, Array3X<Float>& tmp_grid, Array3X<char>& valid, Array3X<char>& old_valid) const {
+    const Array3X<Float>& gridSrc = grid;
+    const Array3X<char>& validSrc = valid;
+
+    /* Every cell of the target is written, either copied from the source or
+       averaged from its valid neighbors, so the arrays can be just swapped
+       afterwards */
+    parallelLoop3D(grid, [&](std::size_t i, std::size_t j, std::size_t k) {
+        tmp_grid(i, j, k) = gridSrc(i, j, k);
+        old_valid(i, j, k) = validSrc(i, j, k);
+
+        if(validSrc(i, j, k) ||
+           i == 0 || i == grid.sizeX() - 1 ||
+           j == 0 || j == grid.sizeY() - 1 ||
+           k == 0 || k == grid.sizeZ() - 1) return;
+
+        const std::size_t is[] = { i + 1, i - 1, i, i, i, i };
+        const std::size_t js[] = { j, j, j + 1, j - 1, j, j };
+        const std::size_t ks[] = { k, k, k, k, k + 1, k - 1 };
+
+        Float sum = 0;
+        Int count = 0;
+        for(std::size_t cell = 0; cell < 6; ++cell) {
+            if(validSrc(is[cell], js[cell], ks[cell])) {
+                sum += gridSrc(is[cell], js[cell], ks[cell]);
+                ++count;
+            }
+        }
+
+        if(count > 0) {
+            tmp_grid(i, j, k) = sum/Float(count);
+            old_valid(i, j, k) = 1;
+        }
+    });
+
+    grid.swapContent(tmp_grid);
+    valid.swapContent(old_valid);
+}
+
+void ApicSolver3D::addGravity(Float dt) {
+    parallelLoop3D(_grid.v, [&](std::size_t i, std::size_t j, std::size_t k) {
+        if(_grid.vValid(i, j, k)) {
+            _grid.v(i, j, k) -= 9.81f*dt; /* gravity */
+        }
+    });
+}
+
+void ApicSolver3D::computeFluidSDF() {
+    /* Cells farther than one cell from the center are at least 1.5 cells
+       away, so gathering from the 3x3x3 neighborhood gives exact distance
+       up to that */
+    const Float maxDist = 1.5f*_grid.cellSize;
+
+    parallelLoop3D(_grid.fluidSDF, [&](std::size_t i, std::size_t j, std::size_t k) {
+        const Vector3 cellCenter = _grid.getWorldPos({i + 0.5f, j + 0.5f, k + 0.5f});
+        Float minDistSqr = maxDist*maxDist;
+        _grid.loopNeigborParticles(Int(i), Int(j), Int(k), -1, 1, -1, 1, -1, 1, [&](UnsignedInt p) {
+            minDistSqr = Math::min(minDistSqr, (cellCenter - _particles.positions[p]).dot());
+        });
+
+        const Float sdfVal = Math::sqrt(minDistSqr) - _particles.particleRadius;
+        _grid.fluidSDF(i, j, k) = Math::min(sdfVal, _grid.boundaryCellSDF(i, j, k));
+    });
+}
+
+void ApicSolver3D::solvePressures(Float dt) {
+    const std::size_t nI = std::size_t(_grid.nI);
+    const std::size_t nJ = std::size_t(_grid.nJ);
+    const std::size_t nK = std::size_t(_grid.nK);
+
+    /* Only fluid cells that aren't entirely in solid get a row in the linear
+       system. The rows are assigned in memory order, which the MIC(0)
+       preconditioner relies on. */
+    Int numRows = 0;
+    _grid.pressureRows.loop3D([&](std::size_t i, std::size_t j, std::size_t k) {
+        _grid.pressureRows(i, j, k) = -1;
+        if(i == 0 || i == nI - 1 || j == 0 || j == nJ - 1 || k == 0 || k == nK - 1 ||
+           !(_grid.fluidSDF(i, j, k) < 0)) return;
+        if(_grid.uWeights(i, j, k) > 0 || _grid.uWeights(i + 1, j, k) > 0 ||
+           _grid.vWeights(i, j, k) > 0 || _grid.vWeights(i, j + 1, k) > 0 ||
+           _grid.wWeights(i, j, k) > 0 || _grid.wWeights(i, j, k + 1) > 0)
+            _grid.pressureRows(i, j, k) = numRows++;
+    });
+
+    _pressureSolver.resize(std::size_t(numRows));
+    if(!numRows) return;
+
+    const GridData3D& grid = _grid;
+    SevenPointMatrix<Double>& matrix = _pressureSolver.matrix;
+    parallelLoop3D(grid.pressureRows, [&](std::size_t i, std::size_t j, std::size_t k) {
+        const Int row = grid.pressureRows(i, j, k);
+        if(row < 0) return;
+
+        /* Faces in the SevenPointMatrix direction order */
+        const Float centerSDF = grid.fluidSDF(i, j, k);
+        const Float facesWeights[] = {
+            grid.uWeights(i, j, k),
+            grid.uWeights(i + 1, j, k),
+            grid.vWeights(i, j, k),
+            grid.vWeights(i, j + 1, k),
+            grid.wWeights(i, j, k),
+            grid.wWeights(i, j, k + 1)
+        };
+        const Float facesVel[] = {
+             grid.u(i, j, k),
+            -grid.u(i + 1, j, k), /* minus velocity */
+             grid.v(i, j, k),
+            -grid.v(i, j + 1, k), /* minus velocity */
+             grid.w(i, j, k),
+            -grid.w(i, j, k + 1)  /* minus velocity */
+        };
+        const std::size_t is[] = { i - 1, i + 1, i, i, i, i };
+        const std::size_t js[] = { j, j, j - 1, j + 1, j, j };
+        const std::size_t ks[] = { k, k, k, k, k - 1, k + 1 };
+        Double* const plus[] = {
+            nullptr, &matrix.plusX[std::size_t(row)],
+            nullptr, &matrix.plusY[std::size_t(row)],
+            nullptr, &matrix.plusZ[std::size_t(row)]
+        };
+
+        /* Fill-in matrix */
+        Double diag = 0.0;
+        Double rhsVal = 0.0;
+        for(std::size_t face = 0; face < 6; ++face) {
+            rhsVal += Double(facesWeights[face]*facesVel[face]);
+            const Float term = facesWeights[face]*dt;
+            const Float neighborSDF = grid.fluidSDF(is[face], js[face], ks[face]);
+            const Int neighborRow = grid.pressureRows(is[face], js[face], ks[face]);
+            matrix.neighbors[std::size_t(row)*6 + face] = -1;
+            if(neighborSDF < 0.0f) {
+                diag += term;
+                /* Fluid cells on the domain edge have zero pressure */
+                if(neighborRow >= 0) {
+                    matrix.neighbors[std::size_t(row)*6 + face] = neighborRow;
+                    if(plus[face]) *plus[face] = -term;
+                }
+            } else {
+                const Float theta = Math::max(0.01f, fractionInside(centerSDF, neighborSDF));
+                diag += term/theta;
+            }
+        }
+
+        matrix.diag[std::size_t(row)] = diag;
+        _pressureSolver.rhs[std::size_t(row)] = rhsVal;
+    });
+
+    _pressureSolver.solve(); /* now solve the linear system for cells' pressure */
+
+    const auto pressure = [&](std::size_t i, std::size_t j, std::size_t k) {
+        const Int row = grid.pressureRows(i, j, k);
+        return row < 0 ? 0.0 : _pressureSolver.solution[std::size_t(row)];
+    };
+
+    /* Subtract the pressure gradient from velocity of given component */
+    const auto project = [&](Array3X<Float>& vel, const Array3X<Float>& weights, std::size_t axis) {
+        parallelLoop3D(vel, [&](std::size_t i, std::size_t j, std::size_t k) {
+            const std::size_t idx[] = { i, j, k };
+            /* Edges of the domain, or entirely in solid */
+            if(idx[axis] == 0 || idx[axis] == std::size_t(vel.size()[axis] - 1) || !(weights(i, j, k) > 0)) {
+                vel(i, j, k) = 0;
+                return;
+            }
+
+            const std::size_t pi = axis == 0 ? i - 1 : i;
+            const std::size_t pj = axis == 1 ? j - 1 : j;
+            const std::size_t pk = axis == 2 ? k - 1 : k;
+            const Float centerSDF = grid.fluidSDF(i, j, k);
+            const Float prevSDF = grid.fluidSDF(pi, pj, pk);
+            if(centerSDF < 0 || prevSDF < 0) {
+                Float theta = 1;
+                if(centerSDF >= 0 || prevSDF >= 0) {
+                    theta = Math::max(0.01f, fractionInside(prevSDF, centerSDF));
+                }
+                const Float pressureDiff = Float(pressure(i, j, k) - pressure(pi, pj, pk));
+                vel(i, j, k) -= pressureDiff*(dt/theta);
+            }
+        });
+    };
+
+    project(_grid.u, _grid.uWeights, 0);
+    project(_grid.v, _grid.vWeights, 1);
+    project(_grid.w, _grid.wWeights, 2);
+}
+
+void ApicSolver3D::constrainVelocity() {
+    _grid.uTmp = _grid.u;
+    _grid.vTmp = _grid.v;
+    _grid.wTmp = _grid.w;
+
+    /* Remove the normal component of velocity of faces entirely in solid.
+       Reads are from the original arrays, so all three components are
+       constrained consistently. */
+    const auto constrain = [&](const Array3X<Float>& weights, Array3X<Float>& tmp, std::size_t axis) {
+        Vector3 faceOffset{0.5f};
+        faceOffset[axis] = 0.0f;
+        parallelLoop3D(weights, [&](std::size_t i, std::size_t j, std::size_t k) {
+            if(weights(i, j, k) > 0) /* not entirely in solid */
+                return;
+
+            const Vector3 gridPos = Vector3{Float(i), Float(j), Float(k)} + faceOffset;
+            const Vector3 normal = _grid.boundarySDF.interpolateGradient(gridPos);
+            Vector3 vel = _grid.velocityFromGridPos(gridPos);
+            vel -= Math::dot(vel, normal)*normal;
+            tmp(i, j, k) = vel[axis];
+        });
+    };
+
+    constrain(_grid.uWeights, _grid.uTmp, 0);
+    constrain(_grid.vWeights, _grid.vTmp, 1);
+    constrain(_grid.wWeights, _grid.wTmp, 2);
+
+    /* Only swap after constraining all components */
+    _grid.u.swapContent(_grid.uTmp);
+    _grid.v.swapContent(_grid.vTmp);
+    _grid.w.swapContent(_grid.wTmp);
+}
+
+void ApicSolver3D::gridVelocity2Particle() {
+    const Array3X<Float>& u = _grid.u;
+    const Array3X<Float>& v = _grid.v;
+    const Array3X<Float>& w = _grid.w;
+    const auto dxInv = _grid.invCellSize;
+
+    TaskScheduler::forEach(_particles.size(), [&](UnsignedInt p) {
+        const Vector3 gridPos = _grid.getGridPos(_particles.positions[p]);
+        const Vector3 px = gridPos - Vector3(0, 0.5f, 0.5f);
+        const Vector3 py = gridPos - Vector3(0.5f, 0, 0.5f);
+        const Vector3 pz = gridPos - Vector3(0.5f, 0.5f, 0);
+
+        _particles.velocities[p] = Vector3(u.interpolateValue(px),
+                                           v.interpolateValue(py),
+                                           w.interpolateValue(pz));
+        _particles.affineMat[p] = Matrix3x3(u.affineInterpolateValue(px)*dxInv,
+                                            v.affineInterpolateValue(py)*dxInv,
+                                            w.affineInterpolateValue(pz)*dxInv);
+    });
+}
+
+}}
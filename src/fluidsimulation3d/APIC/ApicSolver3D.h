@@ -0,0 +1,104 @@
+#ifndef Magnum_Examples_FluidSimulation3D_ApicSolver3D_h
+#define Magnum_Examples_FluidSimulation3D_ApicSolver3D_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <random>
+#include <Corrade/Containers/Pointer.h>
+
+#include "APIC/SolverData3D.h"
+
+namespace Magnum { namespace Examples {
+
+/* 3D Affine Particle-in-Cell fluid solver, counterpart of ApicSolver2D from
+   the 2D fluid simulation example. It doesn't depend on any GL functionality
+   and runs headless only. */
+class ApicSolver3D {
+public:
+    explicit ApicSolver3D(const Vector3& origin, Float cellSize, Int nI, Int nJ, Int nK, SceneObjects3D* sceneObjs);
+
+    /* Manipulation */
+    void reset() {
+        _particles.reset();
+        _particles.addParticles(_particles.positionsT0, 0);
+    }
+
+    void emitParticles() { generateParticles(_objects->emitter, 10); }
+
+    void advanceFrame(Float frameDuration);
+
+    /* Properties */
+    UnsignedInt numParticles() const { return _particles.size(); }
+
+    Float particleRadius() const { return _particles.particleRadius; }
+
+    const std::vector<Vector3>& particlePositions() const {
+        return _particles.positions;
+    }
+
+    /* 64-bit FNV-1a hash of particle positions, velocities and affine
+       matrices. Same setup gives the same sequence of checksums regardless
+       of the thread count, see TaskScheduler::setThreadCount(). */
+    UnsignedLong stateChecksum() const;
+
+    /* Statistics of the last substep */
+    UnsignedInt numPressureRows() const { return UnsignedInt(_pressureSolver.matrix.size()); }
+    UnsignedInt numPressureIterations() const { return _pressureSolver.pcgSolver.lastIterationCount(); }
+
+private:
+    /* Initialization */
+    void initBoundary();
+    void generateParticles(const SDFObject3D& sdf, Float initialVelocity_y);
+
+    /* Simulation */
+    Float timestepCFL() const;
+    void moveParticles(Float dt);
+    void collectParticlesToCells();
+    void particleVelocity2Grid();
+    void extrapolate(Array3X<Float>& grid, Array3X<Float>& tmp_grid, Array3X<char>& valid, Array3X<char>& old_valid) const;
+    void addGravity(Float dt);
+    void computeFluidSDF();
+    void solvePressures(Float dt);
+    void constrainVelocity();
+    void gridVelocity2Particle();
+
+    Containers::Pointer<SceneObjects3D> _objects;
+    ParticleData3D _particles;
+    GridData3D _grid;
+    LinearSystemSolver3D _pressureSolver;
+
+    /* Jitter of generated particles. The seed is fixed, so the same setup
+       always gives the same results. */
+    std::mt19937 _random{5489u};
+};
+
+}}
+
+#endif
@@ -0,0 +1,176 @@
+#ifndef Magnum_Examples_FluidSimulation3D_Array3X_h
+#define Magnum_Examples_FluidSimulation3D_Array3X_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <cstring>
+#include <vector>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "APIC/MathHelpers.h"
+
+namespace Magnum { namespace Examples {
+
+/* Dense 3D array, stored with x as the fastest changing index */
+template<class T> class Array3X {
+    public:
+        /*implicit*/ Array3X() = default;
+        /*implicit*/ Array3X(std::size_t nx, std::size_t ny, std::size_t nz): _size{nx, ny, nz}, _data(nx*ny*nz) {}
+        /*implicit*/ Array3X(std::size_t nx, std::size_t ny, std::size_t nz, const T& value) : _size{nx, ny, nz}, _data(nx*ny*nz, value) {}
+
+        Array3X<T>& operator=(const Array3X<T>& other) {
+            if(other.sizeX() != sizeX() || other.sizeY() != sizeY() || other.sizeZ() != sizeZ()) {
+                Fatal{} << "Copy array with different size!";
+            }
+            std::memcpy(data(), other.data(), count() * sizeof(T));
+            return *this;
+        }
+
+        /* Accessors */
+
+        template<class IntType> const T& operator()(IntType i, IntType j, IntType k) const {
+            CORRADE_INTERNAL_ASSERT(i >= 0 && j >= 0 && k >= 0 &&
+                std::size_t(i) < _size[0] && std::size_t(j) < _size[1] && std::size_t(k) < _size[2]);
+            return _data[flatIndex(i, j, k)];
+        }
+
+        template<class IntType> T& operator()(IntType i, IntType j, IntType k) {
+            CORRADE_INTERNAL_ASSERT(i >= 0 && j >= 0 && k >= 0 &&
+                std::size_t(i) < _size[0] && std::size_t(j) < _size[1] && std::size_t(k) < _size[2]);
+            return _data[flatIndex(i, j, k)];
+        }
+
+        template<class IntType> const T& operator()(const Math::Vector3<IntType>& coord) const {
+            return operator()(coord[0], coord[1], coord[2]);
+        }
+
+        template<class IntType> T& operator()(const Math::Vector3<IntType>& coord) {
+            return operator()(coord[0], coord[1], coord[2]);
+        }
+
+        template<class IntType> std::size_t flatIndex(IntType i, IntType j, IntType k) const {
+            return std::size_t(i) + _size[0]*(std::size_t(j) + _size[1]*std::size_t(k));
+        }
+
+        const T* data() const { return _data.data(); }
+        T* data() { return _data.data(); }
+
+        std::size_t sizeX() const { return _size[0]; }
+        std::size_t sizeY() const { return _size[1]; }
+        std::size_t sizeZ() const { return _size[2]; }
+        Vector3i size() const { return {Int(_size[0]), Int(_size[1]), Int(_size[2])}; }
+        std::size_t count() const { return _data.size(); }
+
+        /* Modifiers */
+
+        void assign(const T& value) { _data.assign(_data.size(), value); }
+        void setZero() { _data.assign(_data.size(), T(0)); }
+
+        template<class IntType> void resize(IntType nx, IntType ny, IntType nz) {
+            _size[0] = std::size_t(nx);
+            _size[1] = std::size_t(ny);
+            _size[2] = std::size_t(nz);
+            _data.resize(_size[0] * _size[1] * _size[2]);
+        }
+
+        template<class IntType> void resize(IntType nx, IntType ny, IntType nz, const T& value) {
+            _size[0] = std::size_t(nx);
+            _size[1] = std::size_t(ny);
+            _size[2] = std::size_t(nz);
+            _data.resize(_size[0] * _size[1] * _size[2], value);
+        }
+
+        void swapContent(Array3X<T>& other) {
+            /* Only allow to swap content of array having the same sizes */
+            if(other.sizeX() != sizeX() || other.sizeY() != sizeY() || other.sizeZ() != sizeZ()) {
+                Fatal{} << "Swap content of arrays having different sizes!";
+            }
+            _data.swap(other._data);
+        }
+
+        /* Data manipulation */
+
+        template<class Function> void loop3D(Function&& func) const {
+            for(std::size_t k = 0; k < sizeZ(); ++k) {
+                for(std::size_t j = 0; j < sizeY(); ++j) {
+                    for(std::size_t i = 0; i < sizeX(); ++i) {
+                        func(i, j, k);
+                    }
+                }
+            }
+        }
+
+        T interpolateValue(const Math::Vector3<T>& point) const {
+            Int i, j, k;
+            T fx, fy, fz;
+            barycentric(point[0], i, fx, 0, Int(sizeX()));
+            barycentric(point[1], j, fy, 0, Int(sizeY()));
+            barycentric(point[2], k, fz, 0, Int(sizeZ()));
+            return trilerp(
+                (*this)(i, j, k),         (*this)(i + 1, j, k),
+                (*this)(i, j + 1, k),     (*this)(i + 1, j + 1, k),
+                (*this)(i, j, k + 1),     (*this)(i + 1, j, k + 1),
+                (*this)(i, j + 1, k + 1), (*this)(i + 1, j + 1, k + 1),
+                fx, fy, fz);
+        }
+
+        Math::Vector3<T> affineInterpolateValue(const Math::Vector3<T>& point) const {
+            Int i, j, k;
+            T fx, fy, fz;
+            barycentric(point[0], i, fx, 0, Int(sizeX()));
+            barycentric(point[1], j, fy, 0, Int(sizeY()));
+            barycentric(point[2], k, fz, 0, Int(sizeZ()));
+            return trilerpGradient(
+                (*this)(i, j, k),         (*this)(i + 1, j, k),
+                (*this)(i, j + 1, k),     (*this)(i + 1, j + 1, k),
+                (*this)(i, j, k + 1),     (*this)(i + 1, j, k + 1),
+                (*this)(i, j + 1, k + 1), (*this)(i + 1, j + 1, k + 1),
+                fx, fy, fz);
+        }
+
+        Math::Vector3<T> interpolateGradient(const Math::Vector3<T>& point) const {
+            Math::Vector3<T> grad = affineInterpolateValue(point);
+            const T magSqr = grad.dot();
+            if(magSqr > T(1e-20)) {
+                grad /= Math::sqrt(magSqr);
+            }
+            return grad;
+        }
+
+    private:
+        std::size_t _size[3]{};
+        std::vector<T> _data;
+};
+
+}}
+
+#endif
@@ -0,0 +1,161 @@
+#ifndef Magnum_Examples_FluidSimulation3D_MathHelpers_h
+#define Magnum_Examples_FluidSimulation3D_MathHelpers_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Vector3.h>
+
+namespace Magnum { namespace Examples {
+
+/* Interpolation and fraction helpers of the 3D APIC solver, extending the
+   ones in the 2D fluid simulation example to the third dimension */
+
+template<class T> inline T fractionInside(T phiLeft, T phiRight) {
+    if(phiLeft < 0 && phiRight < 0)
+        return T(1);
+
+    if(phiLeft < 0 && phiRight >= 0)
+        return phiLeft/(phiLeft - phiRight);
+
+    if(phiLeft >= 0 && phiRight < 0)
+        return phiRight/(phiRight - phiLeft);
+    else
+        return T(0);
+}
+
+template<class T> inline void barycentric(T x, Int& i, T& f, Int iLow, Int iHigh) {
+    T s = Math::floor(x);
+    i = static_cast<int>(s);
+    if(i < iLow) {
+        i = iLow;
+        f = 0;
+    } else if(i > iHigh - 2) {
+        i = iHigh - 2;
+        f = 1;
+    } else {
+        f = T(x - s);
+    }
+}
+
+template<class T> inline T bilerp(const T& v00, const T& v10, const T& v01,
+    const T& v11, T fx, T fy)
+{
+    return Math::lerp(Math::lerp(v00, v10, fx),
+                      Math::lerp(v01, v11, fx),
+                      fy);
+}
+
+template<class T> inline T trilerp(const T& v000, const T& v100,
+    const T& v010, const T& v110, const T& v001, const T& v101,
+    const T& v011, const T& v111, T fx, T fy, T fz)
+{
+    return Math::lerp(bilerp(v000, v100, v010, v110, fx, fy),
+                      bilerp(v001, v101, v011, v111, fx, fy),
+                      fz);
+}
+
+/* Gradient of trilerp() with respect to the interpolation factors */
+template<class T> inline Math::Vector3<T> trilerpGradient(const T& v000,
+    const T& v100, const T& v010, const T& v110, const T& v001,
+    const T& v101, const T& v011, const T& v111, T fx, T fy, T fz)
+{
+    return {bilerp(v100 - v000, v110 - v010, v101 - v001, v111 - v011, fy, fz),
+            bilerp(v010 - v000, v110 - v100, v011 - v001, v111 - v101, fx, fz),
+            bilerp(v001 - v000, v101 - v100, v011 - v010, v111 - v110, fx, fy)};
+}
+
+/* Fraction of a square face that is inside, from signed distance values at
+   its corners given in counter-clockwise order */
+template<class T> inline T fractionInside(T phi00, T phi10, T phi11, T phi01) {
+    T phi[] = { phi00, phi10, phi11, phi01 };
+    const Int insideCount = (phi00 < 0) + (phi10 < 0) + (phi11 < 0) + (phi01 < 0);
+    const auto rotate = [&phi]() {
+        const T first = phi[0];
+        phi[0] = phi[1];
+        phi[1] = phi[2];
+        phi[2] = phi[3];
+        phi[3] = first;
+    };
+
+    if(insideCount == 4)
+        return T(1);
+
+    if(insideCount == 3) {
+        /* Subtract area of the single outside corner triangle */
+        while(phi[0] < 0) rotate();
+        const T side0 = T(1) - fractionInside(phi[0], phi[3]);
+        const T side1 = T(1) - fractionInside(phi[0], phi[1]);
+        return T(1) - T(0.5)*side0*side1;
+    }
+
+    if(insideCount == 2) {
+        /* Rotate so the first corner is inside and the second inside corner
+           is either the next or the opposite one */
+        while(phi[0] >= 0 || !(phi[1] < 0 || phi[2] < 0)) rotate();
+
+        /* Adjacent inside corners, the area is a trapezoid */
+        if(phi[1] < 0) {
+            const T sideLeft = fractionInside(phi[0], phi[3]);
+            const T sideRight = fractionInside(phi[1], phi[2]);
+            return T(0.5)*(sideLeft + sideRight);
+        }
+
+        /* Diagonally opposite corners, disambiguate by the center value */
+        if(phi[0] + phi[1] + phi[2] + phi[3] < 0) {
+            const T area =
+                T(0.5)*(T(1) - fractionInside(phi[0], phi[3]))*(T(1) - fractionInside(phi[2], phi[3])) +
+                T(0.5)*(T(1) - fractionInside(phi[0], phi[1]))*(T(1) - fractionInside(phi[2], phi[1]));
+            return T(1) - area;
+        }
+        return T(0.5)*fractionInside(phi[0], phi[1])*fractionInside(phi[0], phi[3]) +
+               T(0.5)*fractionInside(phi[2], phi[1])*fractionInside(phi[2], phi[3]);
+    }
+
+    if(insideCount == 1) {
+        /* Area of the single inside corner triangle */
+        while(phi[0] >= 0) rotate();
+        return T(0.5)*fractionInside(phi[0], phi[3])*fractionInside(phi[0], phi[1]);
+    }
+
+    return T(0);
+}
+
+template<class T> inline T linearKernel(const Math::Vector3<T>& d, T hInv) {
+    const T tx = T(1) - Math::abs(d.x() * hInv);
+    const T ty = T(1) - Math::abs(d.y() * hInv);
+    const T tz = T(1) - Math::abs(d.z() * hInv);
+    return Math::max(tx, T(0))*Math::max(ty, T(0))*Math::max(tz, T(0));
+}
+
+}}
+
+#endif
@@ -0,0 +1,269 @@
+#ifndef Magnum_Examples_FluidSimulation3D_PCGSolver3D_h
+#define Magnum_Examples_FluidSimulation3D_PCGSolver3D_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <Corrade/Utility/StlMath.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+
+#include "TaskScheduler.h"
+
+namespace Magnum { namespace Examples {
+
+/* Symmetric matrix of the 7-point Laplacian over the fluid cells of a 3D
+   grid. Instead of general sparse rows, each row stores its diagonal, the
+   coefficients towards its +X, +Y and +Z neighbors, and row indices of all
+   six neighbors. The coefficient towards a -X neighbor is the +X coefficient
+   of that neighbor. Rows are expected to be ordered with X as the fastest
+   changing cell index, so all -X, -Y and -Z neighbors of a row come before
+   it. */
+template<class T> struct SevenPointMatrix {
+    enum: std::size_t {
+        MinusX = 0, PlusX, MinusY, PlusY, MinusZ, PlusZ
+    };
+
+    std::size_t size() const { return diag.size(); }
+
+    void resize(std::size_t newSize) {
+        diag.assign(newSize, T(0));
+        plusX.assign(newSize, T(0));
+        plusY.assign(newSize, T(0));
+        plusZ.assign(newSize, T(0));
+        neighbors.resize(newSize*6);
+    }
+
+    /* Row of the neighbor in given direction, -1 if it has no row */
+    Int neighbor(std::size_t row, std::size_t direction) const {
+        return neighbors[row*6 + direction];
+    }
+
+    std::vector<T> diag, plusX, plusY, plusZ;
+    std::vector<Int> neighbors;
+};
+
+/* Conjugate gradient solver for SevenPointMatrix, preconditioned with
+   modified incomplete Cholesky, MIC(0). The matrix-vector product and the
+   vector operations run in parallel over fixed chunks of rows, so the
+   reductions are summed in the same order no matter how many threads there
+   are. The triangular solves of the preconditioner are inherently
+   sequential. */
+template<class T> class PCGSolver3D {
+    public:
+        /* Number of rows processed by a single parallel task */
+        enum: std::size_t { ChunkSize = 4096 };
+
+        explicit PCGSolver3D(T toleranceFactor_ = T(1e-8), UnsignedInt maxIterations_ = 1000): _maxIterations{maxIterations_}, _toleranceFactor{toleranceFactor_} {}
+
+        bool solve(const SevenPointMatrix<T>& matrix, const std::vector<T>& rhs, std::vector<T>& result) {
+            const std::size_t rows = matrix.size();
+            result.assign(rows, T(0));
+            if(rows == 0) return false;
+
+            _s.resize(rows);
+            _z.resize(rows);
+            _r = rhs;
+            _lastResidual = maxAbs(_r);
+            if(!(_lastResidual > 0)) {
+                _lastIterationCount = 0;
+                return true;
+            }
+
+            formPreconditioner(matrix);
+            applyPreconditioner(matrix, _r, _z);
+            T rho = dotProduct(_z, _r);
+            if(!(rho > 0) || rho != rho) {
+                _lastIterationCount = 0;
+                return false;
+            }
+
+            _s = _z;
+
+            const T tolerance = _toleranceFactor*_lastResidual;
+            for(UnsignedInt iter = 0; iter < _maxIterations; ++iter) {
+                multiply(matrix, _s, _z);
+                const T alpha = rho/dotProduct(_s, _z);
+                addScaled(alpha, _s, result);
+                addScaled(-alpha, _z, _r);
+                _lastResidual = maxAbs(_r);
+                if(_lastResidual < tolerance) {
+                    _lastIterationCount = iter + 1;
+                    return true;
+                }
+                applyPreconditioner(matrix, _r, _z);
+                const T rhoNew = dotProduct(_z, _r);
+                const T beta = rhoNew/rho;
+                addScaled(beta, _s, _z);
+                _s.swap(_z);
+                rho = rhoNew;
+            }
+
+            /* Failed to converge */
+            _lastIterationCount = _maxIterations;
+            return false;
+        }
+
+        /* API to query last solve */
+        UnsignedInt lastIterationCount() const { return _lastIterationCount; }
+        T lastResidual() const { return _lastResidual; }
+
+    private:
+        using MatrixType = SevenPointMatrix<T>;
+
+        /* Call func(begin, end) for chunks of [0, count) in parallel */
+        template<class Function> static void forEachChunk(std::size_t count, Function&& func) {
+            const std::size_t numChunks = (count + ChunkSize - 1)/ChunkSize;
+            TaskScheduler::forEach(numChunks, [&](std::size_t chunk) {
+                func(chunk*ChunkSize, Math::min(count, (chunk + 1)*ChunkSize));
+            });
+        }
+
+        void multiply(const SevenPointMatrix<T>& matrix, const std::vector<T>& x, std::vector<T>& result) const {
+            forEachChunk(x.size(), [&](std::size_t begin, std::size_t end) {
+                for(std::size_t row = begin; row < end; ++row) {
+                    T sum = matrix.diag[row]*x[row];
+                    const Int* const n = &matrix.neighbors[row*6];
+                    if(n[MatrixType::MinusX] >= 0) sum += matrix.plusX[n[MatrixType::MinusX]]*x[n[MatrixType::MinusX]];
+                    if(n[MatrixType::PlusX] >= 0) sum += matrix.plusX[row]*x[n[MatrixType::PlusX]];
+                    if(n[MatrixType::MinusY] >= 0) sum += matrix.plusY[n[MatrixType::MinusY]]*x[n[MatrixType::MinusY]];
+                    if(n[MatrixType::PlusY] >= 0) sum += matrix.plusY[row]*x[n[MatrixType::PlusY]];
+                    if(n[MatrixType::MinusZ] >= 0) sum += matrix.plusZ[n[MatrixType::MinusZ]]*x[n[MatrixType::MinusZ]];
+                    if(n[MatrixType::PlusZ] >= 0) sum += matrix.plusZ[row]*x[n[MatrixType::PlusZ]];
+                    result[row] = sum;
+                }
+            });
+        }
+
+        void formPreconditioner(const SevenPointMatrix<T>& matrix) {
+            constexpr T tau = T(0.97);
+            constexpr T sigma = T(0.25);
+            _precond.resize(matrix.size());
+
+            for(std::size_t row = 0; row < matrix.size(); ++row) {
+                T e = matrix.diag[row];
+                if(e == T(0)) {
+                    _precond[row] = T(0); /* null row/column */
+                    continue;
+                }
+
+                const Int mx = matrix.neighbor(row, MatrixType::MinusX);
+                if(mx >= 0) {
+                    const T a = matrix.plusX[mx]*_precond[mx];
+                    e -= a*a + tau*matrix.plusX[mx]*(matrix.plusY[mx] + matrix.plusZ[mx])*_precond[mx]*_precond[mx];
+                }
+                const Int my = matrix.neighbor(row, MatrixType::MinusY);
+                if(my >= 0) {
+                    const T a = matrix.plusY[my]*_precond[my];
+                    e -= a*a + tau*matrix.plusY[my]*(matrix.plusX[my] + matrix.plusZ[my])*_precond[my]*_precond[my];
+                }
+                const Int mz = matrix.neighbor(row, MatrixType::MinusZ);
+                if(mz >= 0) {
+                    const T a = matrix.plusZ[mz]*_precond[mz];
+                    e -= a*a + tau*matrix.plusZ[mz]*(matrix.plusX[mz] + matrix.plusY[mz])*_precond[mz]*_precond[mz];
+                }
+
+                if(e < sigma*matrix.diag[row]) e = matrix.diag[row];
+                _precond[row] = T(1)/std::sqrt(e);
+            }
+        }
+
+        void applyPreconditioner(const SevenPointMatrix<T>& matrix, const std::vector<T>& x, std::vector<T>& result) const {
+            /* Solve L*q = x */
+            for(std::size_t row = 0; row < matrix.size(); ++row) {
+                T t = x[row];
+                const Int mx = matrix.neighbor(row, MatrixType::MinusX);
+                if(mx >= 0) t -= matrix.plusX[mx]*_precond[mx]*result[mx];
+                const Int my = matrix.neighbor(row, MatrixType::MinusY);
+                if(my >= 0) t -= matrix.plusY[my]*_precond[my]*result[my];
+                const Int mz = matrix.neighbor(row, MatrixType::MinusZ);
+                if(mz >= 0) t -= matrix.plusZ[mz]*_precond[mz]*result[mz];
+                result[row] = t*_precond[row];
+            }
+
+            /* Solve L^T*result = q */
+            for(std::size_t row = matrix.size(); row-- > 0; ) {
+                T t = result[row];
+                const Int px = matrix.neighbor(row, MatrixType::PlusX);
+                if(px >= 0) t -= matrix.plusX[row]*_precond[row]*result[px];
+                const Int py = matrix.neighbor(row, MatrixType::PlusY);
+                if(py >= 0) t -= matrix.plusY[row]*_precond[row]*result[py];
+                const Int pz = matrix.neighbor(row, MatrixType::PlusZ);
+                if(pz >= 0) t -= matrix.plusZ[row]*_precond[row]*result[pz];
+                result[row] = t*_precond[row];
+            }
+        }
+
+        T dotProduct(const std::vector<T>& x, const std::vector<T>& y) {
+            _partialSums.assign((x.size() + ChunkSize - 1)/ChunkSize, T(0));
+            forEachChunk(x.size(), [&](std::size_t begin, std::size_t end) {
+                T sum = 0;
+                for(std::size_t i = begin; i < end; ++i) sum += x[i]*y[i];
+                _partialSums[begin/ChunkSize] = sum;
+            });
+
+            T sum = 0;
+            for(const T partial: _partialSums) sum += partial;
+            return sum;
+        }
+
+        T maxAbs(const std::vector<T>& x) {
+            _partialSums.assign((x.size() + ChunkSize - 1)/ChunkSize, T(0));
+            forEachChunk(x.size(), [&](std::size_t begin, std::size_t end) {
+                T result = 0;
+                for(std::size_t i = begin; i < end; ++i) result = Math::max(result, std::abs(x[i]));
+                _partialSums[begin/ChunkSize] = result;
+            });
+
+            T result = 0;
+            for(const T partial: _partialSums) result = Math::max(result, partial);
+            return result;
+        }
+
+        /* result += alpha*x */
+        static void addScaled(T alpha, const std::vector<T>& x, std::vector<T>& result) {
+            forEachChunk(x.size(), [&](std::size_t begin, std::size_t end) {
+                for(std::size_t i = begin; i < end; ++i) result[i] += alpha*x[i];
+            });
+        }
+
+        std::vector<T> _precond;
+        std::vector<T> _partialSums;
+        std::vector<T> _r, _s, _z;
+
+        UnsignedInt _maxIterations;
+        T _toleranceFactor;
+        UnsignedInt _lastIterationCount{0};
+        T _lastResidual{0};
+};
+
+}}
+
+#endif
@@ -0,0 +1,119 @@
+#ifndef Magnum_Examples_FluidSimulation3D_SDFObject3D_h
+#define Magnum_Examples_FluidSimulation3D_SDFObject3D_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Vector3.h>
+
+namespace Magnum { namespace Examples {
+
+/* 3D counterpart of SDFObject */
+struct SDFObject3D {
+    enum class ObjectType {
+        /* Basic primitives */
+        Sphere = 0,
+        Box,
+
+        /* Boolean operations */
+        Intersection,
+        Subtraction,
+        Union
+    };
+
+    explicit SDFObject3D(): center{0, 0, 0}, radii{1}, type{ObjectType::Sphere}, negativeInside{true} {}
+
+    explicit SDFObject3D(const Vector3& center_, Float radius_, ObjectType type_, bool negativeInside_ = true):
+        SDFObject3D(center_, Vector3{radius_, 0, 0}, type_, negativeInside_) {}
+
+    explicit SDFObject3D(const Vector3& center_, const Vector3& radii_, ObjectType type_, bool negativeInside_ = true):
+        center{center_}, radii{radii_}, type{type_},
+        negativeInside{negativeInside_}
+    {
+        if(type != ObjectType::Sphere
+           && type != ObjectType::Box) {
+            Fatal{} << "Invalid object type";
+        }
+    }
+
+    explicit SDFObject3D(SDFObject3D* obj1_, SDFObject3D* obj2_, ObjectType type_):
+        type{type_}, obj1{obj1_}, obj2{obj2_}
+    {
+        if(type != ObjectType::Intersection &&
+           type != ObjectType::Subtraction &&
+           type != ObjectType::Union) {
+            Fatal{} << "Invalid boolean operation";
+        }
+    }
+
+    Float signedDistance(const Vector3& pos) const {
+        switch(type) {
+            case ObjectType::Sphere: {
+                const Float dist = (pos - center).length() - radii[0];
+                return negativeInside ? dist : -dist;
+            }
+            case ObjectType::Box: {
+                const Float dx = Math::abs(pos[0] - center[0]) - radii[0];
+                const Float dy = Math::abs(pos[1] - center[1]) - radii[1];
+                const Float dz = Math::abs(pos[2] - center[2]) - radii[2];
+                const Float dax = Math::max(dx, 0.0f);
+                const Float day = Math::max(dy, 0.0f);
+                const Float daz = Math::max(dz, 0.0f);
+                const Float dist = Math::min(Math::max(dx, Math::max(dy, dz)), 0.0f) +
+                    Math::sqrt(dax*dax + day*day + daz*daz);
+                return negativeInside ? dist : -dist;
+            }
+
+            case ObjectType::Intersection:
+                return Math::max(obj1->signedDistance(pos), obj2->signedDistance(pos));
+            case ObjectType::Subtraction:
+                return Math::max(obj1->signedDistance(pos), -obj2->signedDistance(pos));
+            case ObjectType::Union:
+                return Math::min(obj1->signedDistance(pos), obj2->signedDistance(pos));
+        }
+
+        return 0;
+    }
+
+    Vector3 center;
+    Vector3 radii;
+    ObjectType type;
+    bool negativeInside { true };
+
+    Containers::Pointer<SDFObject3D> obj1;
+    Containers::Pointer<SDFObject3D> obj2;
+};
+
+}}
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef Magnum_Examples_FluidSimulation3D_SolverData3D_h
+#define Magnum_Examples_FluidSimulation3D_SolverData3D_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <Magnum/Math/Matrix.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "APIC/Array3X.h"
+#include "APIC/PCGSolver3D.h"
+#include "APIC/SDFObject3D.h"
+
+namespace Magnum { namespace Examples {
+
+struct SceneObjects3D {
+    SDFObject3D emitterT0; /* emitter that is called once upon initialization */
+    SDFObject3D emitter;   /* emitter that is called by user when requested */
+    SDFObject3D boundary;  /* solid boundary */
+};
+
+struct ParticleData3D {
+    explicit ParticleData3D(Float cellSize) : particleRadius{cellSize*0.5f} {}
+
+    UnsignedInt size() const { return static_cast<UnsignedInt>(positions.size()); }
+
+    void addParticles(const std::vector<Vector3>& newParticles, Float initialVelocity_y) {
+        if(positionsT0.size() == 0) {
+            positionsT0 = newParticles;
+        }
+        positions.insert(positions.end(), newParticles.begin(), newParticles.end());
+        velocities.resize(size(), Vector3(0, -initialVelocity_y, 0));
+        affineMat.resize(size(), Matrix3x3(0));
+        cells.resize(size());
+    }
+
+    void reset() {
+        positions.resize(0);
+        velocities.resize(0);
+        affineMat.resize(0);
+        cells.resize(0);
+    }
+
+    template<class Function>
+    void loopAll(Function&& func) const {
+        for(UnsignedInt p = 0, pend = size(); p < pend; ++p) {
+            func(p);
+        }
+    }
+
+    const Float            particleRadius;
+    std::vector<Vector3>   positionsT0;
+    std::vector<Vector3>   positions;
+    std::vector<Vector3>   velocities;
+    std::vector<Matrix3x3> affineMat;
+    /* Flat index of the cell each particle is in */
+    std::vector<UnsignedInt> cells;
+};
+
+struct GridData3D {
+    GridData3D(const Vector3& origin_, Float cellSize_, Int nI_, Int nJ_, Int nK_) :
+        origin{origin_}, nI{nI_}, nJ{nJ_}, nK{nK_},
+        cellSize{cellSize_},
+        invCellSize{1.0f/cellSize}
+    {
+        u.resize(nI + 1, nJ, nK);
+        v.resize(nI, nJ + 1, nK);
+        w.resize(nI, nJ, nK + 1);
+        uTmp.resize(nI + 1, nJ, nK);
+        vTmp.resize(nI, nJ + 1, nK);
+        wTmp.resize(nI, nJ, nK + 1);
+        uValid.resize(nI + 1, nJ, nK);
+        vValid.resize(nI, nJ + 1, nK);
+        wValid.resize(nI, nJ, nK + 1);
+        uOldValid.resize(nI + 1, nJ, nK);
+        vOldValid.resize(nI, nJ + 1, nK);
+        wOldValid.resize(nI, nJ, nK + 1);
+        uWeights.resize(nI + 1, nJ, nK);
+        vWeights.resize(nI, nJ + 1, nK);
+        wWeights.resize(nI, nJ, nK + 1);
+        fluidSDF.resize(nI, nJ, nK);
+        pressureRows.resize(nI, nJ, nK);
+        boundarySDF.resize(nI + 1, nJ + 1, nK + 1);
+        boundaryCellSDF.resize(nI, nJ, nK);
+        cellStart.resize(std::size_t(nI)*nJ*nK + 1);
+    }
+
+    Vector3 getGridPos(const Vector3& worldPos) const {
+        return (worldPos - origin)*invCellSize;
+    }
+    Vector3 getWorldPos(const Vector3& gridPos) const {
+        return gridPos*cellSize + origin;
+    }
+
+    bool isValidCellIdx(Int x, Int y, Int z) const {
+        return x >= 0 && x < nI && y >= 0 && y < nJ && z >= 0 && z < nK;
+    }
+    Vector3i getCellIdx(const Vector3& worldPos) const {
+        return Vector3i(getGridPos(worldPos));
+    }
+    Vector3i getValidCellIdx(const Vector3& worldPos) const {
+        Vector3i tmp = getCellIdx(worldPos);
+        tmp.x() = Math::max(0, Math::min(nI - 1, tmp.x()));
+        tmp.y() = Math::max(0, Math::min(nJ - 1, tmp.y()));
+        tmp.z() = Math::max(0, Math::min(nK - 1, tmp.z()));
+        return tmp;
+    }
+    std::size_t flatCellIdx(Int x, Int y, Int z) const {
+        return std::size_t(x) + std::size_t(nI)*(std::size_t(y) + std::size_t(nJ)*std::size_t(z));
+    }
+
+    Vector3 velocityFromGridPos(const Vector3& gridPos) const {
+        const Vector3 px = Vector3(gridPos[0], gridPos[1] - 0.5f, gridPos[2] - 0.5f);
+        const Vector3 py = Vector3(gridPos[0] - 0.5f, gridPos[1], gridPos[2] - 0.5f);
+        const Vector3 pz = Vector3(gridPos[0] - 0.5f, gridPos[1] - 0.5f, gridPos[2]);
+        return Vector3(u.interpolateValue(px),
+                       v.interpolateValue(py),
+                       w.interpolateValue(pz));
+    }
+
+    Vector3 constrainBoundary(const Vector3& worldPos) const {
+        const Vector3 gridPos = getGridPos(worldPos);
+        const Float sdfVal = boundarySDF.interpolateValue(gridPos);
+        if(sdfVal < 0) {
+            const Vector3 normal = boundarySDF.interpolateGradient(gridPos);
+            return worldPos - sdfVal*normal;
+        } else {
+            return worldPos;
+        }
+    }
+
+    /* Bucket particles by cell with a counting sort. Particles of a cell are
+       then a contiguous range of cellParticles, which is much more compact
+       than a list per cell at 256^3 cells. */
+    void sortParticlesToCells(const std::vector<UnsignedInt>& particleCells) {
+        cellStart.assign(cellStart.size(), 0);
+        for(const UnsignedInt cell: particleCells) ++cellStart[cell];
+
+        /* Exclusive prefix sum, cellStart[c] is then the first slot of cell
+           c */
+        UnsignedInt sum = 0;
+        for(UnsignedInt& start: cellStart) {
+            const UnsignedInt count = start;
+            start = sum;
+            sum += count;
+        }
+
+        /* Scatter, which advances cellStart[c] to the first slot of c + 1,
+           then shift everything back by one cell */
+        cellParticles.resize(particleCells.size());
+        for(UnsignedInt p = 0; p < particleCells.size(); ++p) {
+            cellParticles[cellStart[particleCells[p]]++] = p;
+        }
+        for(std::size_t c = cellStart.size() - 1; c > 0; --c) {
+            cellStart[c] = cellStart[c - 1];
+        }
+        cellStart[0] = 0;
+    }
+
+    template<class Function> void loopNeigborParticles(Int i, Int j, Int k, Int il, Int ih, Int jl, Int jh, Int kl, Int kh, Function&& func) const {
+        for(Int sk = Math::max(k + kl, 0); sk <= Math::min(k + kh, nK - 1); ++sk) {
+            for(Int sj = Math::max(j + jl, 0); sj <= Math::min(j + jh, nJ - 1); ++sj) {
+                /* Cells of the same row are contiguous in cellParticles */
+                const Int siBegin = Math::max(i + il, 0);
+                const Int siEnd = Math::min(i + ih, nI - 1);
+                if(siBegin > siEnd) continue;
+                for(UnsignedInt idx = cellStart[flatCellIdx(siBegin, sj, sk)],
+                    idxEnd = cellStart[flatCellIdx(siEnd, sj, sk) + 1]; idx < idxEnd; ++idx) {
+                    func(cellParticles[idx]);
+                }
+            }
+        }
+    }
+
+    /* Grid spatial information */
+    const Vector3 origin;
+    const Int nI, nJ, nK;
+    const Float cellSize;
+    const Float invCellSize;
+
+    /* Face and cells' data */
+    Array3X<Float> u, uTmp;
+    Array3X<Float> v, vTmp;
+    Array3X<Float> w, wTmp;
+    Array3X<char> uValid, vValid, wValid;
+    Array3X<char> uOldValid, vOldValid, wOldValid;
+    Array3X<Float> fluidSDF;
+    /* Row of each fluid cell in the pressure linear system, -1 for others */
+    Array3X<Int> pressureRows;
+
+    /* Particles sorted by cell, particles of cell c are at
+       cellParticles[cellStart[c]] to cellParticles[cellStart[c + 1]] */
+    std::vector<UnsignedInt> cellStart;
+    std::vector<UnsignedInt> cellParticles;
+
+    /* Static boundary data. The boundary SDF is sampled both at grid nodes
+       and cell centers. */
+    Array3X<Float> uWeights, vWeights, wWeights;
+    Array3X<Float> boundarySDF;
+    Array3X<Float> boundaryCellSDF;
+};
+
+struct LinearSystemSolver3D {
+    void resize(std::size_t newSize) {
+        rhs.resize(newSize);
+        matrix.resize(newSize);
+    }
+
+    void solve() {
+        if(!pcgSolver.solve(matrix, rhs, solution)) {
+            Error{} << "Pressure solve failed!";
+        }
+    }
+
+    /* Use double for linear system (the solver converges slower if using float
+       numbers) */
+    using pcg_real = Double;
+    PCGSolver3D<pcg_real> pcgSolver;
+    SevenPointMatrix<pcg_real> matrix;
+    std::vector<pcg_real> rhs;
+    std::vector<pcg_real> solution;
+};
+
+}}
+
+#endif
@@ -0,0 +1,116 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <chrono>
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Format.h>
+
+#include "TaskScheduler.h"
+#include "APIC/ApicSolver3D.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* Dam break in a unit cube, with a water column in one corner */
+void runBenchmark(Int resolution, Int frames, bool checksums) {
+    const Float cellSize = 1.0f/Float(resolution);
+
+    auto sceneObjs = new SceneObjects3D;
+    sceneObjs->emitterT0 = SDFObject3D{Vector3{0.15f, 0.25f, 0.15f}, Vector3{0.15f, 0.25f, 0.15f}, SDFObject3D::ObjectType::Box};
+    sceneObjs->emitter = SDFObject3D{Vector3{0.75f, 0.75f, 0.5f}, 0.1f, SDFObject3D::ObjectType::Sphere};
+    /* Solid everywhere except the box, a bit over two cells thick at domain edges */
+    sceneObjs->boundary = SDFObject3D{Vector3{0.5f}, Vector3{0.5f - 2.25f*cellSize}, SDFObject3D::ObjectType::Box, false};
+
+    const auto initBegin = std::chrono::steady_clock::now();
+    ApicSolver3D solver{Vector3{0.0f}, cellSize, resolution, resolution, resolution, sceneObjs};
+    const std::chrono::duration<Double> initDuration = std::chrono::steady_clock::now() - initBegin;
+
+    /* Timings differ from run to run, in the checksum mode print just the
+       state to make the output comparable */
+    if(checksums) Debug{} << "Grid" << resolution << Debug::nospace << "^3 with"
+        << solver.numParticles() << "particles";
+    else Debug{} << "Grid" << resolution << Debug::nospace << "^3 with"
+        << solver.numParticles() << "particles, initialized in"
+        << initDuration.count() << "s";
+
+    Double totalDuration = 0.0;
+    for(Int frame = 0; frame < frames; ++frame) {
+        const auto begin = std::chrono::steady_clock::now();
+        solver.advanceFrame(1.0f/60.0f);
+        const std::chrono::duration<Double> duration = std::chrono::steady_clock::now() - begin;
+        totalDuration += duration.count();
+
+        if(checksums) {
+            Utility::print("  frame {}: {:.16x}\n", frame, solver.stateChecksum());
+            continue;
+        }
+
+        Debug{} << "  frame" << frame << Debug::nospace << ":" << duration.count()*1000.0
+            << "ms," << solver.numPressureRows() << "pressure rows,"
+            << solver.numPressureIterations() << "PCG iterations";
+    }
+    if(checksums) return;
+
+    Debug{} << "Grid" << resolution << Debug::nospace << "^3:"
+        << totalDuration/Double(frames)*1000.0 << "ms per frame on average";
+}
+
+}
+
+int main(int argc, char** argv) {
+    Utility::Arguments args;
+    args.addArrayOption("resolution")
+            .setHelp("resolution", "grid resolution along each axis, can be specified multiple times (default: 128 and 256)", "N")
+        .addOption("frames", "10")
+            .setHelp("frames", "number of frames to simulate", "N")
+        .addOption("threads", "0")
+            .setHelp("threads", "number of threads to use, 0 for all hardware threads", "N")
+        .addBooleanOption("checksums")
+            .setHelp("checksums", "print checksums of the solver state instead of timings, which don't depend on the thread count")
+        .setGlobalHelp("Runs the 3D APIC fluid solver headless and reports time spent per frame.")
+        .parse(argc, argv);
+
+    std::vector<Int> resolutions;
+    for(std::size_t i = 0; i != args.arrayValueCount("resolution"); ++i)
+        resolutions.push_back(args.arrayValue<Int>("resolution", i));
+    if(resolutions.empty()) resolutions = {128, 256};
+
+    const Int frames = args.value<Int>("frames");
+    TaskScheduler::setThreadCount(args.value<std::size_t>("threads"));
+    for(const Int resolution: resolutions) {
+        if(resolution < 8) {
+            Error{} << "Resolution" << resolution << "is too small";
+            return 1;
+        }
+        runBenchmark(resolution, frames, args.isSet("checksums"));
+    }
+}
@@ -0,0 +1,75 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "FluidSurface.h"
+
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Trade/MeshData.h>
+
+namespace Magnum { namespace Examples {
+
+FluidSurface::FluidSurface() {
+    /* Interleaved positions and normals, as SurfaceReconstruction::mesh()
+       makes them */
+    _mesh.addVertexBuffer(_vertices, 0,
+            Shaders::PhongGL::Position{},
+            Shaders::PhongGL::Normal{})
+        .setIndexBuffer(_indices, 0, MeshIndexType::UnsignedInt)
+        .setCount(0);
+}
+
+FluidSurface& FluidSurface::setMesh(const Trade::MeshData& mesh) {
+    _vertices.setData(mesh.vertexData(), GL::BufferUsage::StreamDraw);
+    _indices.setData(mesh.indexData(), GL::BufferUsage::StreamDraw);
+    _mesh.setCount(Int(mesh.indexCount()));
+    return *this;
+}
+
+FluidSurface& FluidSurface::draw(Containers::Pointer<SceneGraph::Camera3D>& camera) {
+    if(!_mesh.count()) return *this;
+
+    const Matrix4 viewMatrix = camera->cameraMatrix();
+    _shader
+        .setAmbientColor(_diffuseColor*0.2f)
+        .setDiffuseColor(_diffuseColor)
+        .setSpecularColor(Color3{0.5f})
+        .setShininess(80.0f)
+        /* Directional light, given in world space */
+        .setLightPositions({Vector4{viewMatrix.transformVector(_lightDir), 0.0f}})
+        .setTransformationMatrix(viewMatrix)
+        .setNormalMatrix(viewMatrix.normalMatrix())
+        .setProjectionMatrix(camera->projectionMatrix())
+        .draw(_mesh);
+
+    return *this;
+}
+
+}}
@@ -0,0 +1,78 @@
+#ifndef Magnum_Examples_FluidSimulation3D_DrawableObjects_FluidSurface_h
+#define Magnum_Examples_FluidSimulation3D_DrawableObjects_FluidSurface_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <Corrade/Containers/Pointer.h>
+#include <Magnum/GL/Buffer.h>
+#include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/SceneGraph/Camera.h>
+#include <Magnum/Shaders/PhongGL.h>
+#include <Magnum/Trade/Trade.h>
+
+namespace Magnum { namespace Examples {
+
+/* Draws a mesh produced by SurfaceReconstruction. The mesh is uploaded as a
+   whole every time it changes. */
+class FluidSurface {
+    public:
+        explicit FluidSurface();
+
+        FluidSurface& setMesh(const Trade::MeshData& mesh);
+
+        FluidSurface& draw(Containers::Pointer<SceneGraph::Camera3D>& camera);
+
+        Color3 diffuseColor() const { return _diffuseColor; }
+
+        FluidSurface& setDiffuseColor(const Color3& color) {
+            _diffuseColor = color;
+            return *this;
+        }
+
+        Vector3 lightDirection() const { return _lightDir; }
+
+        FluidSurface& setLightDirection(const Vector3& lightDir) {
+            _lightDir = lightDir;
+            return *this;
+        }
+
+    private:
+        Color3 _diffuseColor{0.0f, 0.5f, 0.9f};
+        Vector3 _lightDir{1.0f, 1.0f, 2.0f};
+
+        GL::Buffer _vertices, _indices;
+        GL::Mesh _mesh;
+        Shaders::PhongGL _shader;
+};
+
+}}
+
+#endif
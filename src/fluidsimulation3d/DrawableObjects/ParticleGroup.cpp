@@ -43,27 +43,59 @@ namespace Magnum { namespace Examples {
 using namespace Math::Literals;
 
 ParticleGroup::ParticleGroup(const std::vector<Vector3>& points, float particleRadius):
-    _points(points),
+    _points(&points),
     _particleRadius(particleRadius),
     _meshParticles(GL::MeshPrimitive::Points) {
-    _meshParticles.addVertexBuffer(_bufferParticles, 0, Shaders::GenericGL3D::Position{});
+    setupMesh();
     _particleShader.reset(new ParticleSphereShader);
 }
 
+ParticleGroup& ParticleGroup::setPositionQuantized(bool quantized, const Range3D& bounds) {
+    _packer.setFormat(quantized ? ParticlePacker::Format::Quantized16 : ParticlePacker::Format::Float, bounds);
+    setupMesh();
+    _dirty = true;
+    return *this;
+}
+
+void ParticleGroup::setupMesh() {
+    _meshParticles = GL::Mesh{GL::MeshPrimitive::Points};
+    if(_packer.format() == ParticlePacker::Format::Quantized16) {
+        /* Two bytes of padding after each position */
+        _meshParticles.addVertexBuffer(_bufferParticles, 0,
+            Shaders::GenericGL3D::Position{
+                Shaders::GenericGL3D::Position::DataType::UnsignedShort,
+                Shaders::GenericGL3D::Position::DataOption::Normalized}, 2);
+    } else {
+        _meshParticles.addVertexBuffer(_bufferParticles, 0, Shaders::GenericGL3D::Position{});
+    }
+}
+
 ParticleGroup& ParticleGroup::draw(Containers::Pointer<SceneGraph::Camera3D>& camera, const Vector2i& viewportSize) {
-    if(_points.empty()) return *this;
+    if(_points->empty()) return *this;
 
+    /* Upload only what changed since the last time. Whole-buffer uploads
+       reallocate the storage, so the driver can hand out a fresh one while
+       the GPU still draws from the previous. */
+    _uploadedBytes = 0;
     if(_dirty) {
-        Containers::ArrayView<const float> data(reinterpret_cast<const float*>(&_points[0]), _points.size() * 3);
-        _bufferParticles.setData(data);
-        _meshParticles.setCount(static_cast<int>(_points.size()));
+        _packer.pack(*_points);
+        const Containers::ArrayView<const UnsignedByte> data{_packer.data().data(), _packer.data().size()};
+        if(_packer.needsFullUpload()) {
+            _bufferParticles.setData(data, GL::BufferUsage::StreamDraw);
+        } else for(const ParticlePacker::Range& range: _packer.dirtyRanges()) {
+            _bufferParticles.setSubData(range.offset, data.slice(range.offset, range.offset + range.size));
+        }
+        _uploadedBytes = _packer.dirtyBytes();
+        _meshParticles.setCount(static_cast<int>(_packer.particleCount()));
         _dirty = false;
     }
 
     (*_particleShader)
         /* particle data */
-        .setNumParticles(static_cast<int>(_points.size()))
+        .setNumParticles(static_cast<int>(_points->size()))
         .setParticleRadius(_particleRadius)
+        .setPositionScale(_packer.dequantizationScale())
+        .setPositionOffset(_packer.dequantizationOffset())
         /* sphere render data */
         .setPointSizeScale(static_cast<float>(viewportSize.y())/
             Math::tan(22.5_degf)) /* tan(half field-of-view angle (45_deg)*/
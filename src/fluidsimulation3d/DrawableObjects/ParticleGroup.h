@@ -37,6 +37,7 @@
 #include <Magnum/Math/Color.h>
 #include <Magnum/SceneGraph/Camera.h>
 
+#include "DrawableObjects/ParticlePacker.h"
 #include "Shaders/ParticleSphereShader.h"
 
 namespace Magnum { namespace Examples {
@@ -47,8 +48,26 @@ class ParticleGroup {
 
         ParticleGroup& draw(Containers::Pointer<SceneGraph::Camera3D>& camera, const Vector2i& viewportSize);
 
+        /* Point the group to a different particle array, which is then
+           uploaded on next draw */
+        ParticleGroup& setPoints(const std::vector<Vector3>& points) {
+            _points = &points;
+            _dirty = true;
+            return *this;
+        }
+
         bool isDirty() const { return _dirty; }
 
+        /* Store positions as 16-bit integers relative to given bounds
+           instead of floats. Positions outside of the bounds get clamped. */
+        bool isPositionQuantized() const {
+            return _packer.format() == ParticlePacker::Format::Quantized16;
+        }
+        ParticleGroup& setPositionQuantized(bool quantized, const Range3D& bounds = {});
+
+        /* Bytes uploaded to the GPU in the last draw() */
+        std::size_t uploadedBytes() const { return _uploadedBytes; }
+
         ParticleGroup& setDirty() {
             _dirty = true;
             return *this;
@@ -104,9 +123,14 @@ class ParticleGroup {
         }
 
     private:
-        const std::vector<Vector3>& _points;
+        void setupMesh();
+
+        const std::vector<Vector3>* _points;
         bool _dirty = false;
 
+        ParticlePacker _packer;
+        std::size_t _uploadedBytes = 0;
+
         Float _particleRadius = 1.0f;
         ParticleSphereShader::ColorMode _colorMode = ParticleSphereShader::ColorMode::RampColorById;
         Color3 _ambientColor{0.1f};
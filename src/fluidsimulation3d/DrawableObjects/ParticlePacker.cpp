@@ -0,0 +1,135 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "ParticlePacker.h"
+
+#include <cstring>
+#include <Magnum/Math/Functions.h>
+
+namespace Magnum { namespace Examples {
+
+ParticlePacker::ParticlePacker(const Format format, const Range3D& bounds): _format{format}, _bounds{bounds} {}
+
+void ParticlePacker::setFormat(const Format format, const Range3D& bounds) {
+    _format = format;
+    _bounds = bounds;
+    invalidate();
+}
+
+Vector3 ParticlePacker::dequantizationScale() const {
+    return _format == Format::Float ? Vector3{1.0f} : _bounds.size();
+}
+
+Vector3 ParticlePacker::dequantizationOffset() const {
+    return _format == Format::Float ? Vector3{0.0f} : _bounds.min();
+}
+
+void ParticlePacker::invalidate() {
+    _data.clear();
+}
+
+void ParticlePacker::packInto(const std::vector<Vector3>& positions, std::vector<UnsignedByte>& out) const {
+    out.resize(positions.size()*stride());
+
+    if(_format == Format::Float) {
+        if(!positions.empty())
+            std::memcpy(out.data(), positions.data(), out.size());
+        return;
+    }
+
+    const Vector3 offset = _bounds.min();
+    const Vector3 scale = 65535.0f/_bounds.size();
+    UnsignedShort* packed = reinterpret_cast<UnsignedShort*>(out.data());
+    for(std::size_t i = 0; i != positions.size(); ++i) {
+        for(std::size_t j = 0; j != 3; ++j) {
+            const Float normalized = Math::clamp((positions[i][j] - offset[j])*scale[j], 0.0f, 65535.0f);
+            packed[4*i + j] = UnsignedShort(normalized + 0.5f);
+        }
+        packed[4*i + 3] = 0;
+    }
+}
+
+void ParticlePacker::pack(const std::vector<Vector3>& positions) {
+    _dirtyRanges.clear();
+
+    /* Everything is new if the count changed or there's nothing to compare
+       to */
+    _fullUpload = _data.size() != positions.size()*stride();
+
+    /* The previous data are kept around to compare against, swapping
+       instead of copying */
+    _previous.swap(_data);
+    packInto(positions, _data);
+
+    if(_fullUpload) {
+        _dirtyBytes = _data.size();
+        return;
+    }
+
+    /* Find runs of changed particles. With quantization, particles that
+       moved less than one quantization step don't count as changed. */
+    const std::size_t stride = this->stride();
+    const std::size_t count = positions.size();
+    _dirtyBytes = 0;
+    std::size_t rangeBegin = 0, rangeEnd = 0;
+    bool inRange = false;
+    for(std::size_t i = 0; i != count; ++i) {
+        if(!std::memcmp(_data.data() + i*stride, _previous.data() + i*stride, stride))
+            continue;
+
+        if(inRange && i - rangeEnd <= MergeDistance) {
+            rangeEnd = i + 1;
+            continue;
+        }
+
+        if(inRange) {
+            _dirtyRanges.push_back({rangeBegin*stride, (rangeEnd - rangeBegin)*stride});
+            _dirtyBytes += _dirtyRanges.back().size;
+        }
+        rangeBegin = i;
+        rangeEnd = i + 1;
+        inRange = true;
+    }
+    if(inRange) {
+        _dirtyRanges.push_back({rangeBegin*stride, (rangeEnd - rangeBegin)*stride});
+        _dirtyBytes += _dirtyRanges.back().size;
+    }
+
+    /* If most of the data changed anyway, upload everything at once.
+       Respecifying the whole buffer lets the driver orphan the old storage
+       instead of waiting until the GPU is done reading from it. */
+    if(2*_dirtyBytes > _data.size()) {
+        _dirtyRanges.clear();
+        _dirtyBytes = _data.size();
+        _fullUpload = true;
+    }
+}
+
+}}
@@ -0,0 +1,114 @@
+#ifndef Magnum_Examples_FluidSimulation3D_DrawableObjects_ParticlePacker_h
+#define Magnum_Examples_FluidSimulation3D_DrawableObjects_ParticlePacker_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Math/Vector3.h>
+
+namespace Magnum { namespace Examples {
+
+/* CPU side of the particle upload. Packs particle positions into the vertex
+   buffer layout and compares them to what was packed last time, so only the
+   ranges that actually changed need to be uploaded. Doesn't touch GL at all
+   and thus can be used without a GPU. */
+class ParticlePacker {
+    public:
+        enum class Format {
+            /* Three floats per particle */
+            Float,
+            /* Three normalized unsigned shorts relative to given bounds and
+               two bytes of padding to keep four-byte alignment */
+            Quantized16
+        };
+
+        /* Byte range of the packed data */
+        struct Range {
+            std::size_t offset;
+            std::size_t size;
+        };
+
+        /* Changed particles closer than this to each other are merged into a
+           single range, as a few unchanged bytes are cheaper to upload than
+           a separate call */
+        enum: std::size_t { MergeDistance = 64 };
+
+        explicit ParticlePacker(Format format = Format::Float, const Range3D& bounds = {});
+
+        Format format() const { return _format; }
+        const Range3D& bounds() const { return _bounds; }
+
+        /* Change the packed format, the next pack() then requires a full
+           upload */
+        void setFormat(Format format, const Range3D& bounds = {});
+
+        /* Size of a single packed particle in bytes */
+        std::size_t stride() const { return _format == Format::Float ? 12 : 8; }
+
+        /* Values the packed positions are multiplied by and offset with to
+           get back positions in the original space */
+        Vector3 dequantizationScale() const;
+        Vector3 dequantizationOffset() const;
+
+        /* Pack the positions and update the dirty ranges */
+        void pack(const std::vector<Vector3>& positions);
+
+        /* Forget the previously packed data, so the next pack() requires a
+           full upload */
+        void invalidate();
+
+        const std::vector<UnsignedByte>& data() const { return _data; }
+        std::size_t particleCount() const { return _data.size()/stride(); }
+
+        /* Whether the whole buffer has to be (re)uploaded after the last
+           pack(), for example because the particle count changed. If not,
+           only dirtyRanges() have to be. */
+        bool needsFullUpload() const { return _fullUpload; }
+        const std::vector<Range>& dirtyRanges() const { return _dirtyRanges; }
+
+        /* Bytes that need to be uploaded after the last pack() */
+        std::size_t dirtyBytes() const { return _dirtyBytes; }
+
+    private:
+        void packInto(const std::vector<Vector3>& positions, std::vector<UnsignedByte>& out) const;
+
+        Format _format;
+        Range3D _bounds;
+        bool _fullUpload = true;
+        std::size_t _dirtyBytes = 0;
+        std::vector<UnsignedByte> _data, _previous;
+        std::vector<Range> _dirtyRanges;
+};
+
+}}
+
+#endif
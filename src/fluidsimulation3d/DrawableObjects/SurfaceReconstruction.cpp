@@ -0,0 +1,625 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "SurfaceReconstruction.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include "TaskScheduler.h"
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Corner c of a cube is at (c & 1, (c >> 1) & 1, (c >> 2) & 1). Edge
+   4*a + o goes along axis a, o selects one of the four edges parallel to
+   it. */
+Vector3i cornerOffset(const UnsignedInt corner) {
+    return {Int(corner & 1), Int((corner >> 1) & 1), Int((corner >> 2) & 1)};
+}
+
+UnsignedInt edgeAxis(const UnsignedInt edge) { return edge/4; }
+
+UnsignedInt edgeOriginCorner(const UnsignedInt edge) {
+    const UnsignedInt axis = edgeAxis(edge);
+    return (edge & 1) << ((axis + 1) % 3) | ((edge >> 1) & 1) << ((axis + 2) % 3);
+}
+
+UnsignedInt edgeBetween(const UnsignedInt a, const UnsignedInt b) {
+    for(UnsignedInt edge = 0; edge != 12; ++edge) {
+        const UnsignedInt origin = edgeOriginCorner(edge);
+        const UnsignedInt end = origin | 1 << edgeAxis(edge);
+        if((origin == a && end == b) || (origin == b && end == a))
+            return edge;
+    }
+    CORRADE_INTERNAL_ASSERT_UNREACHABLE();
+}
+
+/* Whether two edges lie on the same cube face */
+bool shareFace(const UnsignedInt a, const UnsignedInt b) {
+    /* Each edge lies on two faces, perpendicular to the other two axes */
+    const UnsignedInt originA = edgeOriginCorner(a), originB = edgeOriginCorner(b);
+    for(UnsignedInt axis = 0; axis != 3; ++axis) {
+        if(axis == edgeAxis(a) || axis == edgeAxis(b)) continue;
+        if(((originA >> axis) & 1) == ((originB >> axis) & 1)) return true;
+    }
+    return false;
+}
+
+/* Triangles for each of the 256 inside/outside corner configurations, as
+   triplets of edges. Instead of the usual hardcoded table it's built from
+   the cube faces: on each face, edges with a sign change are connected so
+   the inside corners stay on one side, the segments are chained into loops
+   around the cube and each loop is triangulated as a fan. If a face has two
+   diagonally opposite inside corners, each gets its own segment. The choice
+   depends only on the face itself, so two cubes sharing a face always agree
+   on it and there are no holes in the surface. */
+struct CaseTable {
+    /* Triangles of case c are edges[offsets[c]] to edges[offsets[c + 1]] */
+    UnsignedShort offsets[257];
+    std::vector<UnsignedByte> edges;
+};
+
+const CaseTable& caseTable() {
+    static const CaseTable table = [] {
+        CaseTable out;
+        for(UnsignedInt config = 0; config != 256; ++config) {
+            out.offsets[config] = UnsignedShort(out.edges.size());
+            const auto inside = [config](UnsignedInt corner) {
+                return (config >> corner) & 1;
+            };
+
+            /* Segments on the faces, oriented so the inside is on their
+               right when looking at the face from outside of the cube.
+               Positions are doubled to stay integer. */
+            Int next[12];
+            for(Int& i: next) i = -1;
+            const auto midpoint = [](UnsignedInt edge) {
+                const UnsignedInt origin = edgeOriginCorner(edge);
+                return Vector3{cornerOffset(origin) + cornerOffset(origin | 1 << edgeAxis(edge))};
+            };
+            const auto addSegment = [&](const Vector3& normal, UnsignedInt from, UnsignedInt to, const Vector3& insidePoint) {
+                const Vector3 a = midpoint(from);
+                const Vector3 b = midpoint(to);
+                if(Math::dot(Math::cross(normal, b - a), insidePoint - a) > 0.0f)
+                    std::swap(from, to);
+                CORRADE_INTERNAL_ASSERT(next[from] == -1);
+                next[from] = Int(to);
+            };
+            for(UnsignedInt axis = 0; axis != 3; ++axis) {
+                const UnsignedInt u = (axis + 1) % 3, v = (axis + 2) % 3;
+                for(UnsignedInt side = 0; side != 2; ++side) {
+                    Vector3 normal;
+                    normal[axis] = side ? 1.0f : -1.0f;
+
+                    /* Corners around the face */
+                    const UnsignedInt corners[]{
+                        side << axis,
+                        side << axis | 1 << u,
+                        side << axis | 1 << u | 1 << v,
+                        side << axis | 1 << v
+                    };
+                    UnsignedInt crossing[4];
+                    UnsignedInt crossingCount = 0;
+                    Vector3 insidePoint;
+                    UnsignedInt insideCount = 0;
+                    for(UnsignedInt i = 0; i != 4; ++i) {
+                        const UnsignedInt a = corners[i], b = corners[(i + 1) % 4];
+                        if(inside(a) != inside(b))
+                            crossing[crossingCount++] = edgeBetween(a, b);
+                        if(inside(a)) {
+                            insidePoint += 2.0f*Vector3{cornerOffset(a)};
+                            ++insideCount;
+                        }
+                    }
+
+                    if(crossingCount == 2) {
+                        addSegment(normal, crossing[0], crossing[1], insidePoint/Float(insideCount));
+                    } else if(crossingCount == 4) {
+                        for(UnsignedInt i = 0; i != 4; ++i) {
+                            if(!inside(corners[i])) continue;
+                            addSegment(normal,
+                                edgeBetween(corners[(i + 3) % 4], corners[i]),
+                                edgeBetween(corners[i], corners[(i + 1) % 4]),
+                                2.0f*Vector3{cornerOffset(corners[i])});
+                        }
+                    }
+                }
+            }
+
+            /* Chain the segments into loops and triangulate those */
+            bool visited[12]{};
+            for(UnsignedInt start = 0; start != 12; ++start) {
+                if(next[start] == -1 || visited[start]) continue;
+                UnsignedInt loop[12];
+                UnsignedInt loopSize = 0;
+                for(UnsignedInt edge = start; !visited[edge]; edge = UnsignedInt(next[edge])) {
+                    CORRADE_INTERNAL_ASSERT(next[edge] != -1);
+                    visited[edge] = true;
+                    loop[loopSize++] = edge;
+                }
+                CORRADE_INTERNAL_ASSERT(loopSize >= 3);
+
+                /* Start the fan so that no diagonal lies on a cube face.
+                   The cube on the other side of the face could have the
+                   same diagonal, making the edge shared by four
+                   triangles. */
+                UnsignedInt first = 0;
+                for(; first != loopSize; ++first) {
+                    bool onFace = false;
+                    for(UnsignedInt i = 2; i + 1 < loopSize; ++i)
+                        onFace = onFace || shareFace(loop[first], loop[(first + i) % loopSize]);
+                    if(!onFace) break;
+                }
+                CORRADE_INTERNAL_ASSERT(first != loopSize);
+                for(UnsignedInt i = 1; i + 1 < loopSize; ++i) {
+                    out.edges.push_back(UnsignedByte(loop[first]));
+                    out.edges.push_back(UnsignedByte(loop[(first + i) % loopSize]));
+                    out.edges.push_back(UnsignedByte(loop[(first + i + 1) % loopSize]));
+                }
+            }
+        }
+        out.offsets[256] = UnsignedShort(out.edges.size());
+        return out;
+    }();
+    return table;
+}
+
+/* Sum of kernel weights (1 - d^2/R^2)^3 over a lattice of particles with
+   given spacing, approximated by an integral. Both in cell units. */
+Float restDensity(const Float kernelRadius, const Float spacing) {
+    return 4.0f*Constants::pi()*kernelRadius*kernelRadius*kernelRadius*(16.0f/315.0f)/(spacing*spacing*spacing);
+}
+
+/* Key of an edge going from a node in a block along given axis */
+UnsignedInt edgeKey(const Vector3i& node, const UnsignedInt axis) {
+    constexpr Int B = SurfaceReconstruction::BlockSize;
+    return UnsignedInt((node.z()*B + node.y())*B + node.x())*3 + axis;
+}
+
+struct Vertex {
+    Vector3 position;
+    Vector3 normal;
+};
+
+}
+
+SurfaceReconstruction::SurfaceReconstruction(const Float particleRadius, const Range3D& bounds): _particleRadius{particleRadius}, _bounds{bounds}, _cellSize{particleRadius}, _kernelRadius{3.0f*particleRadius} {
+    if(!(particleRadius > 0.0f) || !(bounds.size() > Vector3{0.0f}).all()) {
+        Fatal{} << "SurfaceReconstruction: invalid particle radius or bounds";
+    }
+    setupGrid();
+}
+
+void SurfaceReconstruction::setCellSize(const Float size) {
+    _cellSize = size;
+    setupGrid();
+}
+
+void SurfaceReconstruction::setKernelRadius(const Float radius) {
+    _kernelRadius = radius;
+    setupGrid();
+}
+
+void SurfaceReconstruction::setIsoValue(const Float value) {
+    _isoValue = value;
+    setupGrid();
+}
+
+void SurfaceReconstruction::setupGrid() {
+    if(!(_cellSize > 0.0f) || !(_kernelRadius > 0.0f) ||
+       _kernelRadius > (BlockSize - 1)*_cellSize) {
+        Fatal{} << "SurfaceReconstruction: kernel radius" << _kernelRadius
+            << "has to be positive and at most" << BlockSize - 1
+            << "cell sizes of" << _cellSize;
+    }
+
+    /* Pad the bounds so the outermost nodes are never reached by any
+       particle and the surface is closed */
+    const Vector3 padding{_kernelRadius + _cellSize};
+    _origin = _bounds.min() - padding;
+    _blockCount = Vector3i{Math::ceil((_bounds.size() + 2.0f*padding)/(_cellSize*BlockSize))};
+    _nodeCount = _blockCount*BlockSize;
+    _isoDensity = _isoValue*restDensity(_kernelRadius/_cellSize, 2.0f*_particleRadius/_cellSize);
+
+    const std::size_t blockCount = std::size_t(_blockCount.product());
+    _slots.assign(blockCount, NoSlot);
+    _flags.assign(blockCount, 0);
+    _pool.clear();
+    _freeSlots.clear();
+    _activeBlocks.clear();
+    _splattedBlocks.clear();
+    _polygonizedBlocks.clear();
+    _rebuild = true;
+}
+
+template<class Function> void SurfaceReconstruction::forEach(const std::size_t count, Function&& func) const {
+    if(_parallel) TaskScheduler::forEach(count, func);
+    else for(std::size_t i = 0; i != count; ++i) func(i);
+}
+
+Vector3i SurfaceReconstruction::blockCoordinates(const UnsignedInt block) const {
+    return {Int(block)%_blockCount.x(),
+            Int(block)/_blockCount.x()%_blockCount.y(),
+            Int(block)/(_blockCount.x()*_blockCount.y())};
+}
+
+UnsignedInt SurfaceReconstruction::blockIndex(const Vector3i& coordinates) const {
+    return UnsignedInt(coordinates.x() + (coordinates.y() + coordinates.z()*_blockCount.y())*_blockCount.x());
+}
+
+void SurfaceReconstruction::markChanged(const Vector3& position) {
+    if(!_bounds.contains(position)) return;
+
+    /* Blocks containing nodes within kernel radius */
+    const Vector3 relative = (position - _origin)/_cellSize;
+    const Float radius = _kernelRadius/_cellSize;
+    const Vector3i from = Math::max(Vector3i{Math::ceil(relative - Vector3{radius})}, Vector3i{0})/BlockSize;
+    const Vector3i to = Math::min(Vector3i{Math::floor(relative + Vector3{radius})}, _nodeCount - Vector3i{1})/BlockSize;
+    for(Int z = from.z(); z <= to.z(); ++z)
+        for(Int y = from.y(); y <= to.y(); ++y)
+            for(Int x = from.x(); x <= to.x(); ++x)
+                _flags[blockIndex({x, y, z})] |= BlockChanged;
+}
+
+Float SurfaceReconstruction::densityAt(const Vector3i& node) const {
+    if((node < Vector3i{0}).any() || (node >= _nodeCount).any()) return 0.0f;
+    const UnsignedInt slot = _slots[blockIndex(node/BlockSize)];
+    if(slot == NoSlot) return 0.0f;
+    const Vector3i local = node - node/BlockSize*BlockSize;
+    return _pool[slot].densities[(local.z()*BlockSize + local.y())*BlockSize + local.x()];
+}
+
+Vector3 SurfaceReconstruction::gradientAt(const Vector3i& node) const {
+    Vector3 gradient;
+    for(std::size_t i = 0; i != 3; ++i) {
+        Vector3i offset;
+        offset[i] = 1;
+        gradient[i] = densityAt(node + offset) - densityAt(node - offset);
+    }
+    return gradient;
+}
+
+bool SurfaceReconstruction::update(const std::vector<Vector3>& positions) {
+    const std::size_t blockCount = _slots.size();
+    for(UnsignedByte& flags: _flags) flags = 0;
+
+    /* Find blocks affected by particles that moved, both at their old and
+       new position. If the particle count changed, everything is
+       rebuilt. */
+    const bool rebuild = _rebuild || positions.size() != _previousPositions.size();
+    if(!rebuild) {
+        bool changed = false;
+        for(std::size_t i = 0; i != positions.size(); ++i) {
+            if(positions[i] == _previousPositions[i]) continue;
+            markChanged(_previousPositions[i]);
+            markChanged(positions[i]);
+            changed = true;
+        }
+        if(!changed) {
+            _splattedBlocks.clear();
+            _polygonizedBlocks.clear();
+            return false;
+        }
+    }
+
+    /* Sort particles into blocks */
+    _binOffsets.assign(blockCount + 1, 0);
+    _binParticles.resize(positions.size());
+    const auto binOf = [&](const Vector3& position) {
+        const Vector3i block = Vector3i{(position - _origin)/(_cellSize*BlockSize)};
+        return blockIndex(Math::clamp(block, Vector3i{0}, _blockCount - Vector3i{1}));
+    };
+    for(const Vector3& position: positions)
+        if(_bounds.contains(position)) ++_binOffsets[binOf(position) + 1];
+    for(std::size_t i = 0; i != blockCount; ++i)
+        _binOffsets[i + 1] += _binOffsets[i];
+    {
+        std::vector<UnsignedInt> fill{_binOffsets.begin(), _binOffsets.end() - 1};
+        for(std::size_t i = 0; i != positions.size(); ++i)
+            if(_bounds.contains(positions[i]))
+                _binParticles[fill[binOf(positions[i])]++] = UnsignedInt(i);
+    }
+
+    /* Blocks within one block of a particle need storage, as the kernel
+       radius is less than block size */
+    for(UnsignedInt block = 0; block != blockCount; ++block) {
+        if(_binOffsets[block] == _binOffsets[block + 1]) continue;
+        const Vector3i coordinates = blockCoordinates(block);
+        const Vector3i from = Math::max(coordinates - Vector3i{1}, Vector3i{0});
+        const Vector3i to = Math::min(coordinates + Vector3i{1}, _blockCount - Vector3i{1});
+        for(Int z = from.z(); z <= to.z(); ++z)
+            for(Int y = from.y(); y <= to.y(); ++y)
+                for(Int x = from.x(); x <= to.x(); ++x)
+                    _flags[blockIndex({x, y, z})] |= BlockNeeded;
+    }
+
+    /* Allocate newly needed blocks and recycle the rest. Both count as
+       changed, as their densities went from or to zero. */
+    _activeBlocks.clear();
+    for(UnsignedInt block = 0; block != blockCount; ++block) {
+        const bool needed = _flags[block] & BlockNeeded;
+        UnsignedInt& slot = _slots[block];
+        if(needed && slot == NoSlot) {
+            if(_freeSlots.empty()) {
+                slot = UnsignedInt(_pool.size());
+                _pool.emplace_back();
+            } else {
+                slot = _freeSlots.back();
+                _freeSlots.pop_back();
+            }
+            _flags[block] |= BlockChanged;
+        } else if(!needed && slot != NoSlot) {
+            Block& storage = _pool[slot];
+            storage.positions.clear();
+            storage.normals.clear();
+            storage.edgeKeys.clear();
+            storage.indices.clear();
+            storage.foreignVertices.clear();
+            _freeSlots.push_back(slot);
+            slot = NoSlot;
+            _flags[block] |= BlockChanged;
+        }
+
+        if(needed) {
+            if(rebuild) _flags[block] |= BlockChanged;
+            _activeBlocks.push_back(block);
+        }
+    }
+
+    /* Splat the changed blocks */
+    _splattedBlocks.clear();
+    for(const UnsignedInt block: _activeBlocks)
+        if(_flags[block] & BlockChanged) _splattedBlocks.push_back(block);
+    forEach(_splattedBlocks.size(), [&](std::size_t i) {
+        splat(_splattedBlocks[i], positions);
+    });
+
+    /* Polygonizing a block reads densities of nodes up to one block away,
+       for vertices on its upper edges and for normals */
+    for(UnsignedInt block = 0; block != blockCount; ++block) {
+        if(!(_flags[block] & BlockChanged)) continue;
+        const Vector3i coordinates = blockCoordinates(block);
+        const Vector3i from = Math::max(coordinates - Vector3i{1}, Vector3i{0});
+        const Vector3i to = Math::min(coordinates + Vector3i{1}, _blockCount - Vector3i{1});
+        for(Int z = from.z(); z <= to.z(); ++z)
+            for(Int y = from.y(); y <= to.y(); ++y)
+                for(Int x = from.x(); x <= to.x(); ++x)
+                    _flags[blockIndex({x, y, z})] |= BlockAffected;
+    }
+    _polygonizedBlocks.clear();
+    for(const UnsignedInt block: _activeBlocks)
+        if(_flags[block] & BlockAffected) _polygonizedBlocks.push_back(block);
+    forEach(_polygonizedBlocks.size(), [&](std::size_t i) {
+        polygonize(_polygonizedBlocks[i]);
+    });
+
+    _previousPositions = positions;
+    _rebuild = false;
+    return true;
+}
+
+void SurfaceReconstruction::splat(const UnsignedInt block, const std::vector<Vector3>& positions) {
+    std::vector<Float>& densities = _pool[_slots[block]].densities;
+    densities.assign(BlockSize*BlockSize*BlockSize, 0.0f);
+
+    const Vector3i coordinates = blockCoordinates(block);
+    const Vector3i firstNode = coordinates*BlockSize;
+    const Vector3i lastNode = firstNode + Vector3i{BlockSize - 1};
+    const Float radius = _kernelRadius/_cellSize;
+    const Float radiusSqr = radius*radius;
+
+    /* Neighboring bins in a fixed order, so the sums are the same every
+       time */
+    const Vector3i from = Math::max(coordinates - Vector3i{1}, Vector3i{0});
+    const Vector3i to = Math::min(coordinates + Vector3i{1}, _blockCount - Vector3i{1});
+    for(Int bz = from.z(); bz <= to.z(); ++bz) for(Int by = from.y(); by <= to.y(); ++by) for(Int bx = from.x(); bx <= to.x(); ++bx) {
+        const UnsignedInt bin = blockIndex({bx, by, bz});
+        for(UnsignedInt i = _binOffsets[bin]; i != _binOffsets[bin + 1]; ++i) {
+            const Vector3 relative = (positions[_binParticles[i]] - _origin)/_cellSize;
+            const Vector3i nodeFrom = Math::max(Vector3i{Math::ceil(relative - Vector3{radius})}, firstNode);
+            const Vector3i nodeTo = Math::min(Vector3i{Math::floor(relative + Vector3{radius})}, lastNode);
+            for(Int z = nodeFrom.z(); z <= nodeTo.z(); ++z) {
+                const Float dz = Float(z) - relative.z();
+                for(Int y = nodeFrom.y(); y <= nodeTo.y(); ++y) {
+                    const Float dy = Float(y) - relative.y();
+                    Float* row = densities.data() + ((z - firstNode.z())*BlockSize + y - firstNode.y())*BlockSize - firstNode.x();
+                    for(Int x = nodeFrom.x(); x <= nodeTo.x(); ++x) {
+                        const Float dx = Float(x) - relative.x();
+                        const Float q = 1.0f - (dx*dx + dy*dy + dz*dz)/radiusSqr;
+                        if(q > 0.0f) row[x] += q*q*q;
+                    }
+                }
+            }
+        }
+    }
+}
+
+void SurfaceReconstruction::polygonize(const UnsignedInt block) {
+    Block& storage = _pool[_slots[block]];
+    storage.positions.clear();
+    storage.normals.clear();
+    storage.edgeKeys.clear();
+    storage.indices.clear();
+    storage.foreignVertices.clear();
+
+    const Vector3i firstNode = blockCoordinates(block)*BlockSize;
+
+    /* Vertex on every edge with a sign change that goes from a node of this
+       block, in edge key order. Edges reaching past the last node don't
+       exist, but there's nothing there anyway due to the padding. */
+    constexpr Int E = BlockSize + 1;
+    UnsignedInt edgeVertices[E*E*E*3];
+    std::fill_n(edgeVertices, E*E*E*3, NoSlot);
+    for(Int z = 0; z != BlockSize; ++z) for(Int y = 0; y != BlockSize; ++y) for(Int x = 0; x != BlockSize; ++x) {
+        const Vector3i node = firstNode + Vector3i{x, y, z};
+        const Float density = storage.densities[(z*BlockSize + y)*BlockSize + x];
+        for(UnsignedInt axis = 0; axis != 3; ++axis) {
+            Vector3i end = node;
+            ++end[axis];
+            if(end[axis] >= _nodeCount[axis]) continue;
+            const Float endDensity = densityAt(end);
+            if((density > _isoDensity) == (endDensity > _isoDensity)) continue;
+
+            const Float t = (_isoDensity - density)/(endDensity - density);
+            Vector3 position{node};
+            position[axis] += t;
+            const Vector3 gradient = Math::lerp(gradientAt(node), gradientAt(end), t);
+            const Float length = gradient.length();
+
+            edgeVertices[((z*E + y)*E + x)*3 + axis] = UnsignedInt(storage.positions.size());
+            storage.positions.push_back(_origin + position*_cellSize);
+            storage.normals.push_back(length > 0.0f ? -gradient/length : Vector3::yAxis());
+            storage.edgeKeys.push_back(edgeKey({x, y, z}, axis));
+        }
+    }
+
+    /* Triangles of cells in this block */
+    const CaseTable& table = caseTable();
+    for(Int z = 0; z != BlockSize; ++z) for(Int y = 0; y != BlockSize; ++y) for(Int x = 0; x != BlockSize; ++x) {
+        const Vector3i cell{x, y, z};
+        if((firstNode + cell + Vector3i{1} >= _nodeCount).any()) continue;
+
+        UnsignedInt config = 0;
+        for(UnsignedInt corner = 0; corner != 8; ++corner) {
+            const Vector3i local = cell + cornerOffset(corner);
+            const Float density = (local < Vector3i{BlockSize}).all() ?
+                storage.densities[(local.z()*BlockSize + local.y())*BlockSize + local.x()] :
+                densityAt(firstNode + local);
+            if(density > _isoDensity) config |= 1 << corner;
+        }
+
+        for(UnsignedInt i = table.offsets[config]; i != table.offsets[config + 1]; ++i) {
+            const UnsignedInt edge = table.edges[i];
+            const UnsignedInt axis = edgeAxis(edge);
+            const Vector3i origin = cell + cornerOffset(edgeOriginCorner(edge));
+            UnsignedInt& vertex = edgeVertices[((origin.z()*E + origin.y())*E + origin.x())*3 + axis];
+
+            /* Edges from nodes of the upper neighbors have their vertex
+               there, remember the neighbor and the key to find it in
+               mesh() */
+            if(vertex == NoSlot) {
+                const Vector3i neighbor = origin/BlockSize;
+                CORRADE_INTERNAL_ASSERT(neighbor != Vector3i{0});
+                vertex = ForeignVertex|UnsignedInt(storage.foreignVertices.size());
+                storage.foreignVertices.push_back(
+                    UnsignedInt(neighbor.x() | neighbor.y() << 1 | neighbor.z() << 2) << 16 |
+                    edgeKey(origin - neighbor*BlockSize, axis));
+            }
+            storage.indices.push_back(vertex);
+        }
+    }
+}
+
+std::size_t SurfaceReconstruction::vertexCount() const {
+    std::size_t count = 0;
+    for(const UnsignedInt block: _activeBlocks)
+        count += _pool[_slots[block]].positions.size();
+    return count;
+}
+
+std::size_t SurfaceReconstruction::triangleCount() const {
+    std::size_t count = 0;
+    for(const UnsignedInt block: _activeBlocks)
+        count += _pool[_slots[block]].indices.size()/3;
+    return count;
+}
+
+Trade::MeshData SurfaceReconstruction::mesh() const {
+    /* Vertices and indices of all blocks one after another */
+    std::vector<UnsignedInt> vertexOffsets(_pool.size()), indexOffsets(_pool.size());
+    std::size_t vertexCount = 0, indexCount = 0;
+    for(const UnsignedInt block: _activeBlocks) {
+        const UnsignedInt slot = _slots[block];
+        vertexOffsets[slot] = UnsignedInt(vertexCount);
+        indexOffsets[slot] = UnsignedInt(indexCount);
+        vertexCount += _pool[slot].positions.size();
+        indexCount += _pool[slot].indices.size();
+    }
+
+    Containers::Array<char> vertexData{NoInit, vertexCount*sizeof(Vertex)};
+    Containers::Array<char> indexData{NoInit, indexCount*sizeof(UnsignedInt)};
+    const Containers::ArrayView<Vertex> vertices = Containers::arrayCast<Vertex>(vertexData);
+    const Containers::ArrayView<UnsignedInt> indices = Containers::arrayCast<UnsignedInt>(indexData);
+
+    forEach(_activeBlocks.size(), [&](std::size_t i) {
+        const UnsignedInt block = _activeBlocks[i];
+        const UnsignedInt slot = _slots[block];
+        const Block& storage = _pool[slot];
+
+        Vertex* outVertices = vertices.data() + vertexOffsets[slot];
+        for(std::size_t v = 0; v != storage.positions.size(); ++v)
+            outVertices[v] = {storage.positions[v], storage.normals[v]};
+
+        UnsignedInt* outIndices = indices.data() + indexOffsets[slot];
+        const Vector3i coordinates = blockCoordinates(block);
+        for(std::size_t j = 0; j != storage.indices.size(); ++j) {
+            const UnsignedInt index = storage.indices[j];
+            if(!(index & ForeignVertex)) {
+                outIndices[j] = vertexOffsets[slot] + index;
+                continue;
+            }
+
+            /* The neighbor has the vertex if there's a sign change on the
+               edge, it got polygonized whenever this block did */
+            const UnsignedInt foreign = storage.foreignVertices[index & ~ForeignVertex];
+            const UnsignedInt key = foreign & 0xffff;
+            const UnsignedInt neighborSlot = _slots[blockIndex(coordinates + cornerOffset(foreign >> 16))];
+            CORRADE_INTERNAL_ASSERT(neighborSlot != NoSlot);
+            const std::vector<UnsignedInt>& keys = _pool[neighborSlot].edgeKeys;
+            const auto found = std::lower_bound(keys.begin(), keys.end(), key);
+            CORRADE_INTERNAL_ASSERT(found != keys.end() && *found == key);
+            outIndices[j] = vertexOffsets[neighborSlot] + UnsignedInt(found - keys.begin());
+        }
+    });
+
+    const Trade::MeshIndexData meshIndices{indices};
+    const Trade::MeshAttributeData positions{Trade::MeshAttribute::Position,
+        Containers::StridedArrayView1D<const Vector3>{vertexData,
+            reinterpret_cast<const Vector3*>(vertexData.data() + offsetof(Vertex, position)),
+            vertexCount, sizeof(Vertex)}};
+    const Trade::MeshAttributeData normals{Trade::MeshAttribute::Normal,
+        Containers::StridedArrayView1D<const Vector3>{vertexData,
+            reinterpret_cast<const Vector3*>(vertexData.data() + offsetof(Vertex, normal)),
+            vertexCount, sizeof(Vertex)}};
+    return Trade::MeshData{MeshPrimitive::Triangles,
+        std::move(indexData), meshIndices,
+        std::move(vertexData), {positions, normals}};
+}
+
+}}
@@ -0,0 +1,179 @@
+#ifndef Magnum_Examples_FluidSimulation3D_DrawableObjects_SurfaceReconstruction_h
+#define Magnum_Examples_FluidSimulation3D_DrawableObjects_SurfaceReconstruction_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Math/Vector3.h>
+#include <Magnum/Trade/Trade.h>
+
+namespace Magnum { namespace Examples {
+
+/* Fluid surface reconstructed from particle positions on the CPU. Particles
+   are splatted onto a grid of densities, which is then polygonized with
+   marching cubes. The grid is split into blocks of BlockSize^3 nodes and
+   storage is allocated only for blocks near particles. Only blocks affected
+   by particles that moved since the last update() are splatted and
+   polygonized again, so a mostly settled fluid is cheap to update.
+
+   Vertices are shared by all triangles using them, including triangles in
+   neighboring blocks, and ambiguous cube faces are always split the same way
+   from both sides, so the surface has no cracks. Doesn't touch GL at all and
+   thus can be used without a GPU. */
+class SurfaceReconstruction {
+    public:
+        enum: Int { BlockSize = 8 };
+
+        /* Particles outside of bounds are ignored */
+        explicit SurfaceReconstruction(Float particleRadius, const Range3D& bounds);
+
+        Float particleRadius() const { return _particleRadius; }
+        const Range3D& bounds() const { return _bounds; }
+
+        /* Distance of grid nodes, particle radius by default. Smaller cells
+           give a smoother surface with more triangles. */
+        Float cellSize() const { return _cellSize; }
+        void setCellSize(Float size);
+
+        /* Radius of the splatting kernel, three particle radii by default.
+           Has to be at most BlockSize - 1 cell sizes. */
+        Float kernelRadius() const { return _kernelRadius; }
+        void setKernelRadius(Float radius);
+
+        /* Density at which the surface is extracted, relative to density of
+           fluid at rest, 0.4 by default. With the default kernel radius,
+           lone particles disappear above about 0.46. */
+        Float isoValue() const { return _isoValue; }
+        void setIsoValue(Float value);
+
+        /* Whether update() and mesh() run in parallel through
+           TaskScheduler::forEach(). The builtin thread pool can't be entered
+           from two threads at once, so this has to be disabled when the
+           solver is being advanced on another thread. Enabled by default. */
+        bool isParallel() const { return _parallel; }
+        void setParallel(bool parallel) { _parallel = parallel; }
+
+        /* Update the surface for given particle positions. Returns false if
+           no particle moved since the last update. */
+        bool update(const std::vector<Vector3>& positions);
+
+        /* Forget the previous positions, so the next update() rebuilds
+           everything */
+        void invalidate() { _rebuild = true; }
+
+        /* Indexed triangle mesh with positions and normals pointing out of
+           the fluid */
+        Trade::MeshData mesh() const;
+
+        std::size_t vertexCount() const;
+        std::size_t triangleCount() const;
+
+        /* Blocks that have storage allocated, blocks that were splatted and
+           blocks that were polygonized in the last update() */
+        std::size_t activeBlockCount() const { return _activeBlocks.size(); }
+        std::size_t splattedBlockCount() const { return _splattedBlocks.size(); }
+        std::size_t polygonizedBlockCount() const { return _polygonizedBlocks.size(); }
+
+    private:
+        struct Block {
+            /* Densities of the BlockSize^3 nodes */
+            std::vector<Float> densities;
+            /* Vertices on edges going from nodes of this block in the
+               positive direction, ordered by the edge key */
+            std::vector<Vector3> positions, normals;
+            std::vector<UnsignedInt> edgeKeys;
+            /* Three per triangle. Vertices of neighboring blocks have the
+               ForeignVertex bit set and index foreignVertices, which contain
+               the neighbor offset and the edge key. */
+            std::vector<UnsignedInt> indices;
+            std::vector<UnsignedInt> foreignVertices;
+        };
+
+        enum: UnsignedInt {
+            NoSlot = ~UnsignedInt{},
+            ForeignVertex = 1u << 31
+        };
+
+        enum: UnsignedByte {
+            BlockNeeded = 1 << 0,
+            BlockChanged = 1 << 1,
+            BlockAffected = 1 << 2
+        };
+
+        void setupGrid();
+        template<class Function> void forEach(std::size_t count, Function&& func) const;
+        void markChanged(const Vector3& position);
+        Vector3i blockCoordinates(UnsignedInt block) const;
+        UnsignedInt blockIndex(const Vector3i& coordinates) const;
+        Float densityAt(const Vector3i& node) const;
+        Vector3 gradientAt(const Vector3i& node) const;
+        void splat(UnsignedInt block, const std::vector<Vector3>& positions);
+        void polygonize(UnsignedInt block);
+
+        Float _particleRadius;
+        Range3D _bounds;
+        Float _cellSize;
+        Float _kernelRadius;
+        Float _isoValue = 0.4f;
+        bool _parallel = true;
+        bool _rebuild = true;
+
+        /* Derived from the above in setupGrid() */
+        Vector3 _origin;
+        Vector3i _blockCount;
+        Vector3i _nodeCount;
+        Float _isoDensity;
+
+        std::vector<Vector3> _previousPositions;
+
+        /* Index into _pool for each block, NoSlot if the block has no
+           storage. Storage of blocks that are no longer needed is recycled
+           through _freeSlots. */
+        std::vector<UnsignedInt> _slots;
+        std::vector<Block> _pool;
+        std::vector<UnsignedInt> _freeSlots;
+        std::vector<UnsignedByte> _flags;
+
+        /* Sorted block indices */
+        std::vector<UnsignedInt> _activeBlocks;
+        std::vector<UnsignedInt> _splattedBlocks;
+        std::vector<UnsignedInt> _polygonizedBlocks;
+
+        /* Particles sorted by the block they're in, particles of block b
+           are _binParticles[_binOffsets[b]] to _binParticles[_binOffsets[b + 1]] */
+        std::vector<UnsignedInt> _binOffsets;
+        std::vector<UnsignedInt> _binParticles;
+};
+
+}}
+
+#endif
@@ -35,6 +35,7 @@
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/Primitives/Cube.h>
 #include <Magnum/Primitives/Grid.h>
+#include <Magnum/Primitives/UVSphere.h>
 #include <Magnum/Shaders/FlatGL.h>
 #include <Magnum/SceneGraph/Scene.h>
 #include <Magnum/SceneGraph/MatrixTransformation3D.h>
@@ -82,6 +83,13 @@ class WireframeBox: public WireframeObject {
         }
 };
 
+class WireframeSphere: public WireframeObject {
+    public:
+        explicit WireframeSphere(Scene3D* const scene, SceneGraph::DrawableGroup3D* const drawableGroup): WireframeObject{scene, drawableGroup} {
+            _mesh = MeshTools::compile(Primitives::uvSphereWireframe(16, 32));
+        }
+};
+
 class WireframeGrid: public WireframeObject {
     public:
         explicit WireframeGrid(Scene3D* const scene, SceneGraph::DrawableGroup3D* const drawableGroup): WireframeObject{scene, drawableGroup} {
@@ -32,8 +32,6 @@
 #include <Corrade/Containers/StringView.h>
 #include <Corrade/Utility/StlMath.h>
 #include <Magnum/Image.h>
-#include <Magnum/Timeline.h>
-#include <Magnum/Animation/Easing.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/PixelFormat.h>
@@ -44,14 +42,19 @@
 #include <Magnum/ImGuiIntegration/Context.hpp>
 #include <Magnum/Platform/Sdl2Application.h>
 #include <Magnum/Primitives/Cube.h>
+#include <Magnum/Primitives/Icosphere.h>
 #include <Magnum/SceneGraph/Camera.h>
 #include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/MatrixTransformation3D.h>
 #include <Magnum/SceneGraph/Scene.h>
+#include <Magnum/Trade/MeshData.h>
 
+#include "DrawableObjects/FluidSurface.h"
 #include "DrawableObjects/ParticleGroup.h"
+#include "DrawableObjects/SurfaceReconstruction.h"
 #include "DrawableObjects/WireframeObjects.h"
 #include "SPH/SPHSolver.h"
+#include "SPH/SimulationThread.h"
 
 #include "configure.h"
 
@@ -83,7 +86,12 @@ class FluidSimulation3DExample: public Platform::Application {
         /* Fluid simulation helper functions */
         void showMenu();
         void initializeScene();
-        void simulationStep();
+        void setPaused(bool paused);
+        void setSphereObstacle(bool enabled);
+        void updateSphereObstacle();
+        void saveState();
+        void loadState();
+        void updateSurface();
 
         /* Window control */
         bool _showMenu = true;
@@ -103,29 +111,44 @@ class FluidSimulation3DExample: public Platform::Application {
         Containers::Pointer<Object3D> _objCamera;
         Containers::Pointer<SceneGraph::Camera3D> _camera;
 
-        /* Fluid simulation system */
+        /* Fluid simulation system. The solver is advanced by the simulation
+           thread, which has to be destroyed first. */
         Containers::Pointer<SPHSolver> _fluidSolver;
+        Containers::Pointer<SimulationThread> _simulation;
         Containers::Pointer<WireframeBox> _drawableBox;
-        Int _substeps = 1;
+        Containers::Pointer<WireframeSphere> _drawableSphere;
+        SPHParams _simulationParameters;
+        UnsignedLong _lastSimulationStep = 0;
+        Int _substeps = 0; /* Simulation steps done since last frame */
         bool _pausedSimulation = false;
-        bool _mousePressed = false;
-        bool _dynamicBoundary = true;
-        Float _boundaryOffset = 0.0f; /* For boundary animation */
+        bool _dynamicBoundary = false;
 
         /* Drawable particles */
         Containers::Pointer<ParticleGroup> _drawableParticles;
 
+        /* Fluid surface, reconstructed from the particles on the main thread
+           when enabled */
+        Containers::Pointer<SurfaceReconstruction> _surfaceReconstruction;
+        Containers::Pointer<FluidSurface> _drawableSurface;
+        bool _drawSurface = false;
+
         /* Ground grid */
         Containers::Pointer<WireframeGrid> _grid;
-
-        /* Timeline to adjust number of simulation steps per frame */
-        Timeline _timeline;
 };
 
 using namespace Math::Literals;
 
 namespace {
     constexpr Float ParticleRadius = 0.02f;
+
+    /* Static obstacle in the middle of the domain, off by default */
+    constexpr Float SphereRadius = 0.3f;
+    const Vector3 SphereCenter{1.5f, 0.45f, 0.5f};
+
+    /* Saved and restored from the menu, in the current working directory */
+    constexpr const char CheckpointFile[] = "fluidsimulation3d.checkpoint";
+    constexpr const char ProfileTraceFile[] = "fluidsimulation3d-profile.json";
+    constexpr const char ProfileCsvFile[] = "fluidsimulation3d-profile.csv";
 }
 
 FluidSimulation3DExample::FluidSimulation3DExample(const Arguments& arguments): Platform::Application{arguments, NoCreate} {
@@ -207,21 +230,46 @@ FluidSimulation3DExample::FluidSimulation3DExample(const Arguments& arguments):
         _drawableBox->transform(Matrix4::scaling(Vector3{ 1.5, 1.5, 0.5 }) * Matrix4::translation(Vector3(1)));
         _drawableBox->setColor(Color3(1, 1, 0));
 
-        /* Drawable particles */
-        _drawableParticles.reset(new ParticleGroup{_fluidSolver->particlePositions(), ParticleRadius});
+        /* Static obstacle. Converting the mesh to a boundary volume is done
+           just once, the checkbox in the UI only enables or disables it. */
+        {
+            Trade::MeshData sphere = Primitives::icosphereSolid(3);
+            std::vector<Vector3> vertices;
+            for(const Vector3& position: sphere.positions3DAsArray())
+                vertices.push_back(SphereCenter + position*SphereRadius);
+            const Containers::Array<UnsignedInt> indices = sphere.indicesAsArray();
+            _fluidSolver->setStaticBoundary(Containers::pointer<BoundaryVolume>(
+                vertices, std::vector<UnsignedInt>{indices.begin(), indices.end()},
+                BoundaryVolume::FluidSide::Outside, ParticleRadius));
+        }
 
         /* Initialize scene particles */
         initializeScene();
+
+        /* Simulation thread, which publishes the initial state right away */
+        _fluidSolver->simulationParameters().staticBoundary = false;
+        _simulationParameters = _fluidSolver->simulationParameters();
+        _simulation.reset(new SimulationThread{*_fluidSolver, ParticleRadius});
+        _simulation->snapshots().update();
+
+        /* Drawable particles */
+        _drawableParticles.reset(new ParticleGroup{_simulation->snapshots().readBuffer().positions, ParticleRadius});
+
+        /* Fluid surface, covering the whole domain */
+        _surfaceReconstruction.reset(new SurfaceReconstruction{ParticleRadius, Range3D{{}, {3.0f, 3.0f, 1.0f}}});
+        _drawableSurface.reset(new FluidSurface);
     }
 
     /* Enable depth test, render particles as sprites */
     GL::Renderer::enable(GL::Renderer::Feature::DepthTest);
     GL::Renderer::enable(GL::Renderer::Feature::ProgramPointSize);
 
-    /* Start the timer, loop at 60 Hz max */
+    /* Loop at 60 Hz max */
     setSwapInterval(1);
     setMinimalLoopPeriod(16);
-    _timeline.start();
+
+    /* Run the simulation independently of rendering from now on */
+    _simulation->start();
 }
 
 void FluidSimulation3DExample::drawEvent() {
@@ -235,23 +283,30 @@ void FluidSimulation3DExample::drawEvent() {
         stopTextInput();
     }
 
-    /* Pause simulation if the mouse was pressed (camera is moving around).
-       This avoid freezing GUI while running the simulation */
-    if(!_pausedSimulation && !_mousePressed) {
-        /* Adjust the substep number to maximize CPU usage each frame */
-        const Float lastAvgStepTime = _timeline.previousFrameDuration()/Float(_substeps);
-        const Int newSubsteps = lastAvgStepTime > 0 ? Int(1.0f/60.0f/lastAvgStepTime) + 1 : 1;
-        if(Math::abs(newSubsteps - _substeps) > 1) _substeps = newSubsteps;
-
-        for(Int i = 0; i < _substeps; ++i) simulationStep();
-    }
+    /* Without a simulation thread, simulate for the duration of a frame
+       here */
+    if(!_simulation->isRunning()) _simulation->runFor(1.0/60.0);
+
+    /* Pick up the latest simulation state. If the simulation didn't finish
+       a step since the last frame, the previous state is drawn again. */
+    if(_simulation->snapshots().update()) {
+        const SimulationSnapshot& snapshot = _simulation->snapshots().readBuffer();
+        _substeps = Int(snapshot.step - _lastSimulationStep);
+        _lastSimulationStep = snapshot.step;
+
+        _drawableBox->setTransformation(
+            Matrix4::scaling(Vector3{1.5f - snapshot.boundaryOffset, 1.5f, 0.5f})*
+            Matrix4::translation(Vector3{1.0f}));
+        /* Trigger drawable object to upload the particles to the GPU */
+        _drawableParticles->setPoints(snapshot.positions);
+        if(_drawSurface) updateSurface();
+    } else _substeps = 0;
 
     /* Draw objects */
     {
-        /* Trigger drawable object to update the particles to the GPU */
-        _drawableParticles->setDirty();
-        /* Draw particles */
-        _drawableParticles->draw(_camera, framebufferSize());
+        /* Draw either the particles or the surface */
+        if(_drawSurface) _drawableSurface->draw(_camera);
+        else _drawableParticles->draw(_camera, framebufferSize());
 
         /* Draw other objects (ground grid) */
         _camera->draw(*_drawableGroup);
@@ -279,7 +334,6 @@ void FluidSimulation3DExample::drawEvent() {
     }
 
     swapBuffers();
-    _timeline.nextFrame();
 
     /* Run next frame immediately */
     redraw();
@@ -307,7 +361,7 @@ void FluidSimulation3DExample::keyPressEvent(KeyEvent& event) {
             event.setAccepted(true);
             break;
         case KeyEvent::Key::Space:
-            _pausedSimulation ^= true;
+            setPaused(!_pausedSimulation);
             event.setAccepted(true);
             break;
         default:
@@ -344,13 +398,9 @@ void FluidSimulation3DExample::mousePressEvent(MouseEvent& event) {
             _lastDepth = depth;
         }
     }
-
-    _mousePressed = true;
 }
 
 void FluidSimulation3DExample::mouseReleaseEvent(MouseEvent& event) {
-    _mousePressed = false;
-
     if(_imGuiContext.handleMouseReleaseEvent(event)) {
         event.setAccepted(true);
     }
@@ -450,7 +500,9 @@ void FluidSimulation3DExample::showMenu() {
 
     /* General information */
     ImGui::Text("Hide/show menu: H");
-    ImGui::Text("Num. particles: %d", Int(_fluidSolver->numParticles()));
+    ImGui::Text("Num. particles: %d (%d active)",
+        Int(_simulation->snapshots().readBuffer().positions.size()),
+        Int(_simulation->snapshots().readBuffer().activeParticles));
     ImGui::Text("Simulation steps/frame: %d", _substeps);
     #ifndef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
     ImGui::Text("Rendering: %3.2f FPS (1 thread)", Double(ImGui::GetIO().Framerate));
@@ -482,6 +534,27 @@ void FluidSimulation3DExample::showMenu() {
         if(ImGui::InputFloat3("Light Direction", lightDir.data())) {
             _drawableParticles->setLightDirection(lightDir);
         }
+        bool quantized = _drawableParticles->isPositionQuantized();
+        if(ImGui::Checkbox("16-bit Positions", &quantized)) {
+            /* Quantize relative to the simulation domain */
+            _drawableParticles->setPositionQuantized(quantized, Range3D{{}, {3.0f, 3.0f, 1.0f}});
+        }
+        ImGui::Text("Uploaded: %.1f kB/frame", Double(_drawableParticles->uploadedBytes())/1024.0);
+        if(ImGui::Checkbox("Draw Surface", &_drawSurface) && _drawSurface) {
+            /* Blocks weren't kept up to date while the surface was hidden */
+            _surfaceReconstruction->invalidate();
+            updateSurface();
+        }
+        if(_drawSurface) {
+            static Color3 surfaceColor = _drawableSurface->diffuseColor();
+            if(ImGui::ColorEdit3("Surface Color", surfaceColor.data()))
+                _drawableSurface->setDiffuseColor(surfaceColor);
+            _drawableSurface->setLightDirection(lightDir);
+            ImGui::Text("Surface: %d triangles, %d/%d blocks remeshed",
+                Int(_surfaceReconstruction->triangleCount()),
+                Int(_surfaceReconstruction->polygonizedBlockCount()),
+                Int(_surfaceReconstruction->activeBlockCount()));
+        }
         ImGui::PopID();
         ImGui::TreePop();
     }
@@ -492,10 +565,20 @@ void FluidSimulation3DExample::showMenu() {
     /* Simulation parameters */
     if(ImGui::TreeNodeEx("Simulation", ImGuiTreeNodeFlags_DefaultOpen)) {
         ImGui::PushID("Simulation");
-        ImGui::InputFloat("Stiffness", &_fluidSolver->simulationParameters().stiffness);
-        ImGui::SliderFloat("Viscosity",   &_fluidSolver->simulationParameters().viscosity,           0.0f, 1.0f);
-        ImGui::SliderFloat("Restitution", &_fluidSolver->simulationParameters().boundaryRestitution, 0.0f, 1.0f);
-        ImGui::Checkbox("Dynamic Boundary", &_dynamicBoundary);
+        /* The solver is owned by the simulation thread, edit a copy of the
+           parameters and pass it over */
+        bool parametersChanged = false;
+        parametersChanged |= ImGui::InputFloat("Stiffness", &_simulationParameters.stiffness);
+        parametersChanged |= ImGui::SliderFloat("Viscosity",   &_simulationParameters.viscosity,           0.0f, 1.0f);
+        parametersChanged |= ImGui::SliderFloat("Restitution", &_simulationParameters.boundaryRestitution, 0.0f, 1.0f);
+        parametersChanged |= ImGui::Checkbox("Sleeping", &_simulationParameters.sleeping);
+        if(parametersChanged)
+            _simulation->setParameters(_simulationParameters);
+        if(ImGui::Checkbox("Dynamic Boundary", &_dynamicBoundary))
+            _simulation->setDynamicBoundary(_dynamicBoundary);
+        bool sphereObstacle = _simulationParameters.staticBoundary;
+        if(ImGui::Checkbox("Sphere Obstacle", &sphereObstacle))
+            setSphereObstacle(sphereObstacle);
         ImGui::PopID();
         ImGui::TreePop();
     }
@@ -505,71 +588,103 @@ void FluidSimulation3DExample::showMenu() {
     /* Reset */
     ImGui::Spacing();
     if(ImGui::Button(_pausedSimulation ? "Play Sim" : "Pause Sim"))
-        _pausedSimulation ^= true;
+        setPaused(!_pausedSimulation);
     ImGui::SameLine();
     if(ImGui::Button("Reset Sim")) {
-        _pausedSimulation = false;
+        setPaused(false);
         initializeScene();
     }
     ImGui::SameLine();
     if(ImGui::Button("Reset Camera")) {
         _objCamera->setTransformation(Matrix4::lookAt(_defaultCamPosition, _defaultCamTarget, Vector3(0, 1, 0)));
     }
+    if(ImGui::Button("Save State")) saveState();
+    ImGui::SameLine();
+    if(ImGui::Button("Load State")) loadState();
+
+    /* The profiler can be queried while the simulation is running */
+    Profiler& profiler = _fluidSolver->profiler();
+    bool profiling = profiler.isEnabled();
+    if(ImGui::Checkbox("Profile", &profiling))
+        profiler.setEnabled(profiling);
+    ImGui::SameLine();
+    if(ImGui::Button("Export Profile") &&
+       profiler.exportChromeTrace(ProfileTraceFile) &&
+       profiler.exportCsv(ProfileCsvFile))
+        Debug{} << "Saved the profile to" << ProfileTraceFile << "and" << ProfileCsvFile;
     ImGui::PopItemWidth();
     ImGui::End();
 }
 
 void FluidSimulation3DExample::initializeScene() {
-    if(_fluidSolver->numParticles() > 0) {
-        _fluidSolver->reset();
+    /* Once the simulation is running, the solver can be reset only from the
+       simulation thread */
+    if(_simulation) {
+        _simulation->requestReset();
     } else {
-        const Vector3 lowerCorner = Vector3{ParticleRadius*2.0f};
-        const Vector3 upperCorner = Vector3{0.5f, 2.0f, 1.0f} - Vector3{ParticleRadius*2.0f};
-        const Float spacing = ParticleRadius * 2.0f;
-        const Vector3 resolution = (upperCorner - lowerCorner)/spacing;
-
-        std::vector<Vector3> tmp;
-        tmp.reserve(std::size_t(resolution.product()));
-        for(Int i = 0; i < resolution[0]; ++i) {
-            for(Int j = 0; j < resolution[1]; ++j) {
-                for(Int k = 0; k < resolution[2]; ++k) {
-                    tmp.push_back(Vector3{Vector3i{i, j, k}}*spacing + lowerCorner);
-                }
-            }
-        }
-
-        _fluidSolver->setPositions(tmp);
+        _fluidSolver->setPositions(initialParticlePositions(ParticleRadius));
     }
 
     /* Reset domain */
-    if(_dynamicBoundary) _boundaryOffset = 0.0f;
     _drawableBox->setTransformation(
         Matrix4::scaling(Vector3{1.5f, 1.5f, 0.5f})*
         Matrix4::translation(Vector3(1)));
-    _fluidSolver->domainBox().upperDomainBound().x() = 3.0f - ParticleRadius;
+}
 
-    /* Trigger drawable object to upload particles to the GPU */
-    _drawableParticles->setDirty();
+void FluidSimulation3DExample::setPaused(bool paused) {
+    _pausedSimulation = paused;
+    _simulation->setPaused(paused);
 }
 
-void FluidSimulation3DExample::simulationStep() {
-    static Float offset = 0.0f;
-    if(_dynamicBoundary) {
-        /* Change fluid boundary */
-        static Float step = 2.0e-3f;
-        if(_boundaryOffset > 1.0f || _boundaryOffset < 0.0f) {
-            step *= -1.0f;
-        }
-        _boundaryOffset += step;
-        offset = Math::lerp(0.0f, 0.5f, Animation::Easing::quadraticInOut(_boundaryOffset));
-    }
+void FluidSimulation3DExample::setSphereObstacle(bool enabled) {
+    _simulationParameters.staticBoundary = enabled;
+    _simulation->setParameters(_simulationParameters);
 
-    _drawableBox->setTransformation(
-        Matrix4::scaling(Vector3{1.5f - offset, 1.5f, 0.5f})* Matrix4::translation(Vector3{1.0f}));
-    _fluidSolver->domainBox().upperDomainBound().x() = 2.0f*(1.5f - offset) - ParticleRadius;
+    /* Particles could be inside the sphere when it appears, start over */
+    setPaused(false);
+    initializeScene();
+    updateSphereObstacle();
+}
 
-    /* Run simulation one time step */
-    _fluidSolver->advance();
+void FluidSimulation3DExample::updateSphereObstacle() {
+    if(_simulationParameters.staticBoundary) {
+        _drawableSphere.reset(new WireframeSphere(_scene.get(), _drawableGroup.get()));
+        _drawableSphere->setTransformation(
+            Matrix4::translation(SphereCenter)*
+            Matrix4::scaling(Vector3{SphereRadius}));
+        _drawableSphere->setColor(Color3(1, 1, 0));
+    } else _drawableSphere = nullptr;
+}
+
+void FluidSimulation3DExample::saveState() {
+    /* The solver can be accessed only while the thread isn't running */
+    const bool running = _simulation->isRunning();
+    _simulation->stop();
+    if(_simulation->saveCheckpoint(CheckpointFile))
+        Debug{} << "Saved simulation state to" << CheckpointFile;
+    if(running) _simulation->start();
+}
+
+void FluidSimulation3DExample::updateSurface() {
+    /* The builtin thread pool is busy with the simulation thread, if it
+       runs */
+    _surfaceReconstruction->setParallel(!_simulation->isRunning());
+    if(_surfaceReconstruction->update(_simulation->snapshots().readBuffer().positions))
+        _drawableSurface->setMesh(_surfaceReconstruction->mesh());
+}
+
+void FluidSimulation3DExample::loadState() {
+    const bool running = _simulation->isRunning();
+    _simulation->stop();
+    if(_simulation->loadCheckpoint(CheckpointFile)) {
+        /* The checkpoint brings its own parameters, show them in the UI and
+           don't let an older pending request override them */
+        _simulationParameters = _fluidSolver->simulationParameters();
+        _simulation->setParameters(_simulationParameters);
+        _lastSimulationStep = _simulation->stepCount();
+        updateSphereObstacle();
+    }
+    if(running) _simulation->start();
 }
 
 }}
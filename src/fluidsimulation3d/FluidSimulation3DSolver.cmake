@@ -0,0 +1,88 @@
+#
+#   This file is part of Magnum.
+#
+#   Original authors — credit is appreciated but not required:
+#
+#       2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+#       2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+#       2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+#
+#   This is free and unencumbered software released into the public domain.
+#
+#   Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+#   this software, either in source code form or as a compiled binary, for any
+#   purpose, commercial or non-commercial, and by any means.
+#
+#   In jurisdictions that recognize copyright laws, the author or authors of
+#   this software dedicate any and all copyright interest in the software to
+#   the public domain. We make this dedication for the benefit of the public
+#   at large and to the detriment of our heirs and successors. We intend this
+#   dedication to be an overt act of relinquishment in perpetuity of all
+#   present and future rights to this software under copyright law.
+#
+#   THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#   IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+#   FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+#   THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+#   IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+#   CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+#
+
+# The SPH solver together with the simulation thread, built once and linked
+# into the example, its headless executables and the benchmarks. Those are
+# separate projects that can be a part of one build, so whichever includes
+# this file first defines the library and the others just link to it. Uses
+# the MAGNUM_FLUIDSIMULATION3D_EXAMPLE_* options, which have to be defined
+# before.
+
+# Imported targets are visible only in the directory that found them, so
+# these are needed by every includer
+if(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING)
+    find_package(Threads REQUIRED)
+endif()
+if(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB)
+    find_package(TBB CONFIG REQUIRED)
+endif()
+
+if(TARGET FluidSimulation3DSolver)
+    return()
+endif()
+
+configure_file(${CMAKE_CURRENT_LIST_DIR}/configure.h.cmake
+               ${CMAKE_CURRENT_BINARY_DIR}/FluidSimulation3DSolver/configure.h)
+
+add_library(FluidSimulation3DSolver STATIC
+    ${CMAKE_CURRENT_LIST_DIR}/TaskScheduler.h
+    ${CMAKE_CURRENT_LIST_DIR}/ThreadPool.h
+    ${CMAKE_CURRENT_LIST_DIR}/TripleBuffer.h
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/BoundaryVolume.h
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/BoundaryVolume.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/DomainBox.h
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/DomainBox.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/SPHKernels.h
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/SPHSolver.h
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/SPHSolver.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/SimulationThread.h
+    ${CMAKE_CURRENT_LIST_DIR}/SPH/SimulationThread.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/../fluidsimulation-common/Checkpoint.h
+    ${CMAKE_CURRENT_LIST_DIR}/../fluidsimulation-common/Checkpoint.cpp
+    ${CMAKE_CURRENT_LIST_DIR}/../fluidsimulation-common/Profiler.h
+    ${CMAKE_CURRENT_LIST_DIR}/../fluidsimulation-common/Profiler.cpp)
+target_link_libraries(FluidSimulation3DSolver PUBLIC Magnum::Magnum)
+target_include_directories(FluidSimulation3DSolver PUBLIC
+    ${CMAKE_CURRENT_LIST_DIR}
+    ${CMAKE_CURRENT_LIST_DIR}/../fluidsimulation-common
+    ${CMAKE_CURRENT_BINARY_DIR}/FluidSimulation3DSolver)
+if(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING)
+    target_link_libraries(FluidSimulation3DSolver PUBLIC Threads::Threads)
+endif()
+if(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB)
+    # TBBConfig.cmake adds -isystem /usr/lib/cmake/TBB/../../../include, which
+    # breaks compilation. Temporary workaround by not including that dir as
+    # system, see https://github.com/intel/tbb/issues/195 and
+    # https://github.com/intel/tbb/pull/196. Targets linking to this library
+    # need the same property.
+    set_target_properties(FluidSimulation3DSolver PROPERTIES
+        NO_SYSTEM_FROM_IMPORTED ON)
+    target_link_libraries(FluidSimulation3DSolver PUBLIC TBB::tbb)
+endif()
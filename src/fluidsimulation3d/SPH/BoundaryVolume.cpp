@@ -0,0 +1,341 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include "BoundaryVolume.h"
+
+#include <algorithm>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Functions.h>
+
+#include "SPH/SPHKernels.h"
+#include "TaskScheduler.h"
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+/* Closest point to p on triangle abc, from Christer Ericson's Real-Time
+   Collision Detection */
+Vector3 closestPointOnTriangle(const Vector3& p, const Vector3& a, const Vector3& b, const Vector3& c) {
+    const Vector3 ab = b - a;
+    const Vector3 ac = c - a;
+    const Vector3 ap = p - a;
+    const Float d1 = Math::dot(ab, ap);
+    const Float d2 = Math::dot(ac, ap);
+    if(d1 <= 0.0f && d2 <= 0.0f) return a;
+
+    const Vector3 bp = p - b;
+    const Float d3 = Math::dot(ab, bp);
+    const Float d4 = Math::dot(ac, bp);
+    if(d3 >= 0.0f && d4 <= d3) return b;
+
+    const Float vc = d1*d4 - d3*d2;
+    if(vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab*(d1/(d1 - d3));
+
+    const Vector3 cp = p - c;
+    const Float d5 = Math::dot(ab, cp);
+    const Float d6 = Math::dot(ac, cp);
+    if(d6 >= 0.0f && d5 <= d6) return c;
+
+    const Float vb = d5*d2 - d1*d6;
+    if(vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac*(d2/(d2 - d6));
+
+    const Float va = d3*d6 - d5*d4;
+    if(va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f)
+        return b + (c - b)*((d4 - d3)/((d4 - d3) + (d5 - d6)));
+
+    const Float denom = 1.0f/(va + vb + vc);
+    return a + ab*(vb*denom) + ac*(vc*denom);
+}
+
+/* Trilinear interpolation weights of the eight cell corners, in the order
+   used by BoundaryVolume::cellNodes() */
+void trilinearWeights(const Vector3& f, Float (&weights)[8]) {
+    for(Int c = 0; c != 8; ++c)
+        weights[c] =
+            (c & 1 ? f.x() : 1.0f - f.x())*
+            (c & 2 ? f.y() : 1.0f - f.y())*
+            (c & 4 ? f.z() : 1.0f - f.z());
+}
+
+}
+
+BoundaryVolume::BoundaryVolume(const std::vector<Vector3>& vertices, const std::vector<UnsignedInt>& indices, const FluidSide side, const Float particleRadius):
+    _particleRadius{particleRadius},
+    _kernelRadius{particleRadius*4.0f},
+    _spacing{particleRadius},
+    /* Nodes that can be corners of a cell within kernel radius from the
+       surface */
+    _band{_kernelRadius + 2.0f*_spacing},
+    _outsideSolid{side == FluidSide::Inside}
+{
+    CORRADE_INTERNAL_ASSERT(!vertices.empty() && indices.size() % 3 == 0);
+    const std::size_t triangleCount = indices.size()/3;
+
+    /* The grid covers the mesh with the band around, rounded up to whole
+       blocks */
+    Vector3 min = vertices[0];
+    Vector3 max = vertices[0];
+    for(const Vector3& vertex: vertices) {
+        min = Math::min(min, vertex);
+        max = Math::max(max, vertex);
+    }
+    _origin = min - Vector3{_band};
+    _blockGridSize = Vector3i{Math::ceil((max - min + Vector3{2.0f*_band})/(_spacing*BlockSize))} + Vector3i{1};
+    _size = _blockGridSize*BlockSize;
+    const std::size_t nodeCount = std::size_t(_size.product());
+    auto flatIndex = [&](Int i, Int j, Int k) {
+        return std::size_t(i + _size.x()*(j + _size.y()*k));
+    };
+
+    /* Classify nodes as inside or outside of the mesh by casting a ray
+       along X through each row of nodes and counting the crossings. The rays
+       are slightly offset from the nodes to avoid hitting mesh edges
+       exactly. */
+    std::vector<UnsignedByte> solid(nodeCount);
+    TaskScheduler::forEach(std::size_t(_size.y()*_size.z()), [&](const std::size_t row) {
+        const Float y = _origin.y() + (Float(Int(row) % _size.y()) + 0.0013f)*_spacing;
+        const Float z = _origin.z() + (Float(Int(row)/_size.y()) + 0.0017f)*_spacing;
+        std::vector<Float> crossings;
+        for(std::size_t t = 0; t != triangleCount; ++t) {
+            const Vector3& a = vertices[indices[3*t + 0]];
+            const Vector3& b = vertices[indices[3*t + 1]];
+            const Vector3& c = vertices[indices[3*t + 2]];
+
+            /* Barycentric coordinates of the ray in the YZ projection */
+            const Float area = (b.y() - a.y())*(c.z() - a.z()) - (c.y() - a.y())*(b.z() - a.z());
+            if(area == 0.0f) continue;
+            const Float u = ((b.y() - y)*(c.z() - z) - (c.y() - y)*(b.z() - z))/area;
+            const Float v = ((c.y() - y)*(a.z() - z) - (a.y() - y)*(c.z() - z))/area;
+            const Float w = 1.0f - u - v;
+            if(u < 0.0f || v < 0.0f || w < 0.0f) continue;
+            crossings.push_back(u*a.x() + v*b.x() + w*c.x());
+        }
+        std::sort(crossings.begin(), crossings.end());
+
+        std::size_t crossed = 0;
+        for(Int i = 0; i != _size.x(); ++i) {
+            const Float x = _origin.x() + Float(i)*_spacing;
+            while(crossed != crossings.size() && crossings[crossed] < x) ++crossed;
+            const bool inside = crossed % 2;
+            solid[i + _size.x()*row] = inside != _outsideSolid;
+        }
+    });
+
+    /* Distance to the surface, computed just in the band around it. Each
+       thread processes one slice of nodes, so there are no write
+       conflicts. */
+    std::vector<Float> distance(nodeCount, _band);
+    TaskScheduler::forEach(std::size_t(_size.z()), [&](const std::size_t k) {
+        const Float z = _origin.z() + Float(k)*_spacing;
+        for(std::size_t t = 0; t != triangleCount; ++t) {
+            const Vector3& a = vertices[indices[3*t + 0]];
+            const Vector3& b = vertices[indices[3*t + 1]];
+            const Vector3& c = vertices[indices[3*t + 2]];
+            const Vector3 triangleMin = Math::min(a, Math::min(b, c)) - Vector3{_band};
+            const Vector3 triangleMax = Math::max(a, Math::max(b, c)) + Vector3{_band};
+            if(z < triangleMin.z() || z > triangleMax.z()) continue;
+
+            const Int iMin = Math::max(Int(Math::ceil((triangleMin.x() - _origin.x())/_spacing)), 0);
+            const Int jMin = Math::max(Int(Math::ceil((triangleMin.y() - _origin.y())/_spacing)), 0);
+            const Int iMax = Math::min(Int((triangleMax.x() - _origin.x())/_spacing), _size.x() - 1);
+            const Int jMax = Math::min(Int((triangleMax.y() - _origin.y())/_spacing), _size.y() - 1);
+            for(Int j = jMin; j <= jMax; ++j) {
+                for(Int i = iMin; i <= iMax; ++i) {
+                    const Vector3 p = _origin + Vector3{Vector3i{i, j, Int(k)}}*_spacing;
+                    Float& d = distance[flatIndex(i, j, Int(k))];
+                    d = Math::min(d, (p - closestPointOnTriangle(p, a, b, c)).length());
+                }
+            }
+        }
+    });
+
+    /* Allocate blocks that have any node in the band */
+    _blocks.assign(std::size_t(_blockGridSize.product()), -1);
+    _blockSolid.resize(_blocks.size());
+    std::vector<Vector3i> allocated;
+    for(Int bk = 0; bk != _blockGridSize.z(); ++bk) {
+        for(Int bj = 0; bj != _blockGridSize.y(); ++bj) {
+            for(Int bi = 0; bi != _blockGridSize.x(); ++bi) {
+                const std::size_t blockIdx = std::size_t(bi + _blockGridSize.x()*(bj + _blockGridSize.y()*bk));
+                _blockSolid[blockIdx] = solid[flatIndex(bi*BlockSize, bj*BlockSize, bk*BlockSize)];
+
+                bool near = false;
+                for(Int k = 0; k != BlockSize && !near; ++k)
+                    for(Int j = 0; j != BlockSize && !near; ++j)
+                        for(Int i = 0; i != BlockSize && !near; ++i)
+                            near = distance[flatIndex(bi*BlockSize + i, bj*BlockSize + j, bk*BlockSize + k)] < _band;
+                if(!near) continue;
+
+                _blocks[blockIdx] = Int(allocated.size()*BlockSize*BlockSize*BlockSize);
+                allocated.push_back({bi, bj, bk});
+            }
+        }
+    }
+    _nodes.resize(allocated.size()*BlockSize*BlockSize*BlockSize);
+
+    /* Signed distance of a point, interpolated from the dense grid */
+    auto interpolatedDistance = [&](const Vector3& point) {
+        const Vector3 g = (point - _origin)/_spacing;
+        const Vector3i cell{Math::floor(g)};
+        if(cell.x() < 0 || cell.y() < 0 || cell.z() < 0 ||
+           cell.x() >= _size.x() - 1 || cell.y() >= _size.y() - 1 || cell.z() >= _size.z() - 1)
+            return _outsideSolid ? -_band : _band;
+
+        Float weights[8];
+        trilinearWeights(g - Vector3{cell}, weights);
+        Float d = 0.0f;
+        for(Int c = 0; c != 8; ++c) {
+            const std::size_t idx = flatIndex(cell.x() + (c & 1), cell.y() + (c & 2)/2, cell.z() + (c & 4)/4);
+            d += weights[c]*(solid[idx] ? -distance[idx] : distance[idx]);
+        }
+        return d;
+    };
+
+    /* Integrate the solid around each node of the allocated blocks. That's
+       the expensive part, done only once. */
+    const SPHKernels kernels{_kernelRadius};
+    const Float particleVolume = Math::pow(2.0f*_particleRadius, 3.0f);
+    TaskScheduler::forEach(allocated.size(), [&](const std::size_t b) {
+        Node* blockNodes = _nodes.data() + b*BlockSize*BlockSize*BlockSize;
+        for(Int k = 0; k != BlockSize; ++k) {
+            for(Int j = 0; j != BlockSize; ++j) {
+                for(Int i = 0; i != BlockSize; ++i) {
+                    const Vector3i coords = allocated[b]*BlockSize + Vector3i{i, j, k};
+                    const std::size_t idx = flatIndex(coords.x(), coords.y(), coords.z());
+                    Node& node = blockNodes[i + BlockSize*(j + BlockSize*k)];
+                    node.distance = solid[idx] ? -distance[idx] : distance[idx];
+                    node.density = 0.0f;
+                    node.pressureGradient = Vector3{0.0f};
+
+                    /* Particles can't get deep into the solid and nothing is
+                       within reach far from it */
+                    if(Math::abs(node.distance) >= _kernelRadius) continue;
+
+                    kernels.integrateSolid(_origin + Vector3{coords}*_spacing,
+                        4, particleVolume, interpolatedDistance,
+                        node.density, node.pressureGradient);
+                }
+            }
+        }
+    });
+}
+
+const BoundaryVolume::Node* BoundaryVolume::node(const Int i, const Int j, const Int k) const {
+    const Int block = _blocks[std::size_t(i/BlockSize + _blockGridSize.x()*(j/BlockSize + _blockGridSize.y()*(k/BlockSize)))];
+    if(block < 0) return nullptr;
+    return &_nodes[std::size_t(block + i%BlockSize + BlockSize*(j%BlockSize + BlockSize*(k%BlockSize)))];
+}
+
+bool BoundaryVolume::cellNodes(const Vector3& position, const Node* (&nodes)[8], Vector3& factors) const {
+    const Vector3 g = (position - _origin)/_spacing;
+    const Vector3i cell{Math::floor(g)};
+    if(cell.x() < 0 || cell.y() < 0 || cell.z() < 0 ||
+       cell.x() >= _size.x() - 1 || cell.y() >= _size.y() - 1 || cell.z() >= _size.z() - 1)
+        return false;
+
+    for(Int c = 0; c != 8; ++c)
+        if(!(nodes[c] = node(cell.x() + (c & 1), cell.y() + (c & 2)/2, cell.z() + (c & 4)/4)))
+            return false;
+
+    factors = g - Vector3{cell};
+    return true;
+}
+
+Float BoundaryVolume::signedDistance(const Vector3& position) const {
+    const Node* nodes[8];
+    Vector3 factors;
+    if(!cellNodes(position, nodes, factors)) {
+        const Vector3i cell{Math::floor((position - _origin)/_spacing)};
+        if(cell.x() < 0 || cell.y() < 0 || cell.z() < 0 ||
+           cell.x() >= _size.x() || cell.y() >= _size.y() || cell.z() >= _size.z())
+            return _outsideSolid ? -_band : _band;
+        const Vector3i block = cell/BlockSize;
+        return _blockSolid[std::size_t(block.x() + _blockGridSize.x()*(block.y() + _blockGridSize.y()*block.z()))] ? -_band : _band;
+    }
+
+    Float weights[8];
+    trilinearWeights(factors, weights);
+    Float distance = 0.0f;
+    for(Int c = 0; c != 8; ++c)
+        distance += weights[c]*nodes[c]->distance;
+    return distance;
+}
+
+void BoundaryVolume::addBoundaryContribution(const Vector3& ppos, Float& density, Vector3& pressureGradient) const {
+    const Node* nodes[8];
+    Vector3 factors;
+    if(!cellNodes(ppos, nodes, factors)) return;
+
+    Float weights[8];
+    trilinearWeights(factors, weights);
+    for(Int c = 0; c != 8; ++c) {
+        density += weights[c]*nodes[c]->density;
+        pressureGradient += weights[c]*nodes[c]->pressureGradient;
+    }
+}
+
+bool BoundaryVolume::enforceBoundary(Vector3& ppos, Vector3& pvel, const Float restitution) const {
+    const Node* nodes[8];
+    Vector3 factors;
+    if(!cellNodes(ppos, nodes, factors)) return false;
+
+    Float weights[8];
+    trilinearWeights(factors, weights);
+    Float distance = 0.0f;
+    for(Int c = 0; c != 8; ++c)
+        distance += weights[c]*nodes[c]->distance;
+    if(distance >= _particleRadius) return false;
+
+    /* Surface normal from the distance gradient, which is the derivative of
+       the trilinear interpolation */
+    Vector3 normal{0.0f};
+    for(Int c = 0; c != 8; ++c) {
+        const Vector3 sign{c & 1 ? 1.0f : -1.0f, c & 2 ? 1.0f : -1.0f, c & 4 ? 1.0f : -1.0f};
+        const Vector3 other{
+            (c & 2 ? factors.y() : 1.0f - factors.y())*(c & 4 ? factors.z() : 1.0f - factors.z()),
+            (c & 1 ? factors.x() : 1.0f - factors.x())*(c & 4 ? factors.z() : 1.0f - factors.z()),
+            (c & 1 ? factors.x() : 1.0f - factors.x())*(c & 2 ? factors.y() : 1.0f - factors.y())};
+        normal += sign*other*nodes[c]->distance;
+    }
+    const Float length = normal.length();
+    if(length < 1.0e-6f) return false;
+    normal /= length;
+
+    /* Same as reflection on the DomainBox walls, just in normal direction */
+    ppos += normal*(_particleRadius - distance)*(restitution + 1.0f);
+    const Float normalVelocity = Math::dot(pvel, normal);
+    if(normalVelocity < 0.0f) pvel -= normal*normalVelocity*(restitution + 1.0f);
+    return true;
+}
+
+}}
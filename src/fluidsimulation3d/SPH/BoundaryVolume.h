@@ -0,0 +1,99 @@
+#ifndef Magnum_Examples_FluidSimulation3D_SPH_BoundaryVolume_h
+#define Magnum_Examples_FluidSimulation3D_SPH_BoundaryVolume_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <vector>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+namespace Magnum { namespace Examples {
+
+/* Static boundary of arbitrary shape, given by a closed triangle mesh. The
+   mesh is converted to a signed distance field on a grid with particle radius
+   spacing. Grid nodes closer to the surface than the kernel radius also store
+   contribution of the solid to density and pressure force of a particle
+   there, integrated over the kernel support. Looking the boundary up for a
+   particle is then a trilinear interpolation of eight nodes.
+
+   Only blocks of nodes around the surface are stored, the rest of the grid
+   remembers just whether it's solid or fluid. */
+class BoundaryVolume {
+    public:
+        /* Which side of the mesh the fluid is on. Outside for obstacles,
+           inside for containers. */
+        enum class FluidSide { Outside, Inside };
+
+        /* Size of a block of nodes in each dimension */
+        enum: Int { BlockSize = 8 };
+
+        explicit BoundaryVolume(const std::vector<Vector3>& vertices, const std::vector<UnsignedInt>& indices, FluidSide side, Float particleRadius);
+
+        /* Distance to the surface, positive on the fluid side. Far from the
+           surface only the sign is correct. */
+        Float signedDistance(const Vector3& position) const;
+
+        /* Same as DomainBox::addBoundaryContribution() */
+        void addBoundaryContribution(const Vector3& ppos, Float& density, Vector3& pressureGradient) const;
+
+        /* Push a particle that got closer than particle radius to the surface
+           back, reflecting its velocity */
+        bool enforceBoundary(Vector3& ppos, Vector3& pvel, Float restitution) const;
+
+        std::size_t blockCount() const { return _blocks.size(); }
+        std::size_t allocatedBlockCount() const { return _nodes.size()/(BlockSize*BlockSize*BlockSize); }
+
+    private:
+        struct Node {
+            Float distance;
+            Float density;
+            Vector3 pressureGradient;
+        };
+
+        /* Fills nodes of given cell and interpolation factors, returns false
+           if any of them is not stored */
+        bool cellNodes(const Vector3& position, const Node* (&nodes)[8], Vector3& factors) const;
+        const Node* node(Int i, Int j, Int k) const;
+
+        Float _particleRadius, _kernelRadius, _spacing, _band;
+        bool _outsideSolid;
+        Vector3 _origin;
+        Vector3i _size, _blockGridSize;
+
+        /* Offset of block nodes in _nodes or -1 if the block is far from the
+           surface. For those, _blockSolid says if they're solid. */
+        std::vector<Int> _blocks;
+        std::vector<UnsignedByte> _blockSolid;
+        std::vector<Node> _nodes;
+};
+
+}}
+
+#endif
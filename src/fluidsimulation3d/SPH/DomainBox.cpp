@@ -30,8 +30,7 @@
 
 #include "DomainBox.h"
 
-#include <random>
-
+#include "SPH/SPHKernels.h"
 #include "TaskScheduler.h"
 
 namespace Magnum { namespace Examples {
@@ -44,29 +43,19 @@ DomainBox::DomainBox(Float particleRadius, const Vector3& lowerCorner, const Vec
     _particleRadius{particleRadius},
     _overlappedDistSqr{particleRadius*particleRadius*1.0e-8f}
 {
-    generateBoundaryParticles();
+    computeBoundaryTable();
 }
 
 void DomainBox::findNeighbors(const std::vector<Vector3>& positions,
+    const std::vector<UnsignedInt>& particles,
     std::vector<std::vector<uint32_t>>& neighbors,
     std::vector<std::vector<Vector3>>& relativePositions)
 {
     /* Collect particle indices into cells */
     collectIndices(positions);
 
-    /* Only consider ghost boundary particles if the fluid particle is within
-       boundaryDist to the boundary
-        boundaryDist = 2*particleRadius
-       because ghost boundary particles are at
-        2*particleRadius outside the boundary */
-    const Float boundaryDist = 2.0f*_particleRadius;
-    const Float lowerX = _lowerDomainBound[0] + boundaryDist;
-    const Float upperX = _upperDomainBound[0] - boundaryDist;
-    const Float lowerY = _lowerDomainBound[1] + boundaryDist;
-    const Float lowerZ = _lowerDomainBound[2] + boundaryDist;
-    const Float upperZ = _upperDomainBound[2] - boundaryDist;
-
-    TaskScheduler::forEach(positions.size(), [&](UnsignedLong p) {
+    TaskScheduler::forEach(particles.size(), [&](UnsignedLong i) {
+        const UnsignedInt p = particles[i];
         Vector3 ppos = positions[p];
         std::vector<UnsignedInt>& pNeighbors = neighbors[p];
         std::vector<Vector3>& pRelPositions = relativePositions[p];
@@ -91,7 +80,7 @@ void DomainBox::findNeighbors(const std::vector<Vector3>& positions,
                     const std::vector<UnsignedInt>& cell = _cells[getFlatIndex(xIdx, yIdx, zIdx)];
                     for(UnsignedInt q: cell) {
                         /* Exclude particle p from its neighbor list */
-                        if(UnsignedInt(p) == q) continue;
+                        if(p == q) continue;
 
                         const Vector3 qpos = positions[q];
                         const Vector3 r = ppos - qpos;
@@ -104,79 +93,44 @@ void DomainBox::findNeighbors(const std::vector<Vector3>& positions,
                 }
             }
         }
+    });
+}
 
-        /* Check with ghost boundary particles to fix the inherent SPH's
-           problem of density deficiency at boundary. If a particle is closed
-           to the boundary, compute the relative position with the boundary
-           particles. There is no need to collect boundary particle indices. */
-
-        if(ppos[1] < lowerY) { /* Don't need to consider the top face of the domain box */
-            const Vector3 transPos = ppos - Vector3{
-                _cellLength*Math::floor(ppos[0]*_invCellLength),
-                0.0f,
-                _cellLength*Math::floor(ppos[2]*_invCellLength)};
-            const Float y = _lowerDomainBound[1] - 2.0f*_particleRadius;
-            for(const Vector3& bdpos: _boundaryParticles) {
-                const Vector3 r = transPos - Vector3{bdpos[0], y + bdpos[2], bdpos[1]};
-                const Float l2 = r.dot();
-                if(l2 < _maxDistSqr && l2 > _overlappedDistSqr)
-                    pRelPositions.push_back(r);
-            }
-        }
+void DomainBox::computeBoundaryTable() {
+    /* Integrate the kernel over a solid half-space x < 0 for particles at
+       increasing distance from it. All walls, including the moving one, are
+       the same half-space just placed differently, so one table is enough. */
+    const SPHKernels kernels{_cellLength};
+    const Float particleVolume = Math::pow(2.0f*_particleRadius, 3.0f);
+    for(std::size_t i = 0; i <= BoundaryTableSize; ++i) {
+        const Float distance = _cellLength*Float(i)/Float(BoundaryTableSize);
+        Vector3 gradient;
+        kernels.integrateSolid(Vector3::xAxis(distance), 16, particleVolume,
+            [](const Vector3& point) { return point.x(); },
+            _boundaryDensityTable[i], gradient);
+        _boundaryGradientTable[i] = gradient.x();
+    }
+}
 
-        if(ppos[0] < lowerX || ppos[0] > upperX) {
-            const Vector3 transPos = ppos - Vector3{
-                0.0f,
-                _cellLength*Math::floor(ppos[1]*_invCellLength),
-                _cellLength*Math::floor(ppos[2]*_invCellLength)};
-            const Float x = ppos[0] < lowerX ?
-                _lowerDomainBound[0] - 2.0f*_particleRadius :
-                _upperDomainBound[0] + 2.0f*_particleRadius;
-            for(const Vector3& bdpos: _boundaryParticles) {
-                const Vector3 r = transPos - Vector3{x + bdpos[2], bdpos[0], bdpos[1]};
-                const Float l2 = r.dot();
-                if(l2 < _maxDistSqr && l2 > _overlappedDistSqr)
-                    pRelPositions.push_back(r);
-            }
-        }
+void DomainBox::addWallContribution(const Float distance, const Vector3& normal, Float& density, Vector3& pressureGradient) const {
+    if(distance >= _cellLength) return;
 
-        if(ppos[2] < lowerZ || ppos[2] > upperZ) {
-            const Vector3 transPos = ppos - Vector3{
-                _cellLength*Math::floor(ppos[0] * _invCellLength),
-                _cellLength*Math::floor(ppos[1] * _invCellLength),
-                0.0f};
-            const Float z = ppos[2] < lowerZ ?
-                _lowerDomainBound[2] - 2.0f * _particleRadius :
-                _upperDomainBound[2] + 2.0f * _particleRadius;
-            for(const Vector3& bdpos: _boundaryParticles) {
-                const Vector3 r = transPos - Vector3{bdpos[0], bdpos[1], z + bdpos[2]};
-                const Float l2 = r.dot();
-                if(l2 < _maxDistSqr && l2 > _overlappedDistSqr)
-                    pRelPositions.push_back(r);
-            }
-        }
-    });
+    /* Linear interpolation in the table */
+    const Float t = Math::max(distance, 0.0f)*Float(BoundaryTableSize)/_cellLength;
+    const std::size_t i = Math::min(std::size_t(t), std::size_t(BoundaryTableSize) - 1);
+    const Float f = t - Float(i);
+    density += Math::lerp(_boundaryDensityTable[i], _boundaryDensityTable[i + 1], f);
+    pressureGradient += Math::lerp(_boundaryGradientTable[i], _boundaryGradientTable[i + 1], f)*normal;
 }
 
-void DomainBox::generateBoundaryParticles() {
-    /* Generate 1 layer of ghots boundary particles for 3x3 cells */
-    constexpr Int N = 8;
-    const Float spacing = 3.0f*_cellLength/Float(N);
-    const Vector2 corner = Vector2{-_cellLength + spacing*0.5f};
-
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<float> distr(-_particleRadius, _particleRadius);
-
-    for(Int l1 = 0; l1 < N; ++l1) {
-        for(Int l2 = 0; l2 < N; ++l2) {
-            const Vector2 pos2D = corner + Vector2(l1, l2)*spacing;
-            _boundaryParticles.emplace_back(
-                pos2D[0] + distr(gen)*0.2f, /* Store jittered position in 2D */
-                pos2D[1] + distr(gen)*0.2f, /* Store jittered position in 2D */
-                distr(gen) * 0.1f); /* Store just some jittering amount */
-        }
-    }
+void DomainBox::addBoundaryContribution(const Vector3& ppos, Float& density, Vector3& pressureGradient) const {
+    /* The walls are particle radius behind the domain bounds. There's no
+       wall on top. */
+    addWallContribution(ppos.x() - _lowerDomainBound.x() + _particleRadius, Vector3::xAxis(), density, pressureGradient);
+    addWallContribution(_upperDomainBound.x() + _particleRadius - ppos.x(), -Vector3::xAxis(), density, pressureGradient);
+    addWallContribution(ppos.y() - _lowerDomainBound.y() + _particleRadius, Vector3::yAxis(), density, pressureGradient);
+    addWallContribution(ppos.z() - _lowerDomainBound.z() + _particleRadius, Vector3::zAxis(), density, pressureGradient);
+    addWallContribution(_upperDomainBound.z() + _particleRadius - ppos.z(), -Vector3::zAxis(), density, pressureGradient);
 }
 
 void DomainBox::collectIndices(const std::vector<Vector3>& positions) {
@@ -40,22 +40,39 @@ namespace Magnum { namespace Examples {
 
 /* A grid data structure to search for indices of particle neighbors within a
    given distance. Upon searching for neighbors, the relative positions with
-   neighbors are also computed. */
+   neighbors are also computed. The box also acts as the domain boundary,
+   with the walls being solid half-spaces particle radius behind the domain
+   bounds. The top of the box is open. */
 class DomainBox {
     public:
         explicit DomainBox(Float particleRadius, const Vector3& lowerDomainBound, const Vector3& upperDomainBound);
 
         Vector3& lowerDomainBound() { return _lowerDomainBound; }
         Vector3& upperDomainBound() { return _upperDomainBound; }
+        const Vector3& lowerDomainBound() const { return _lowerDomainBound; }
+        const Vector3& upperDomainBound() const { return _upperDomainBound; }
 
+        /* Neighbors are searched among all positions, but only for the
+           particles listed in the particles array */
         void findNeighbors(const std::vector<Vector3>& positions,
+            const std::vector<UnsignedInt>& particles,
             std::vector<std::vector<uint32_t>>& neighbors,
             std::vector<std::vector<Vector3>>& relativePositions);
 
+        /* Add contribution of the walls to density of a particle at ppos and
+           to the sum of kernel gradients used for its pressure force, both in
+           units of the fluid particle mass. Each wall is looked up in a
+           precomputed table. */
+        void addBoundaryContribution(const Vector3& ppos, Float& density, Vector3& pressureGradient) const;
+
         bool enforceBoundary(Vector3& ppos, Vector3& pvel, Float restitution);
 
     private:
-        void generateBoundaryParticles();
+        /* Number of table entries between zero and kernel radius distance */
+        enum: std::size_t { BoundaryTableSize = 64 };
+
+        void computeBoundaryTable();
+        void addWallContribution(Float distance, const Vector3& normal, Float& density, Vector3& pressureGradient) const;
         void collectIndices(const std::vector<Vector3>& positions);
         void tightenGrid(const std::vector<Vector3>& positions);
 
@@ -83,7 +100,11 @@ class DomainBox {
         }
 
         std::vector<std::vector<UnsignedInt>> _cells;
-        std::vector<Vector3> _boundaryParticles;
+
+        /* Contribution of a solid half-space to a particle at given distance
+           from it, the gradient is along the wall normal */
+        Float _boundaryDensityTable[BoundaryTableSize + 1];
+        Float _boundaryGradientTable[BoundaryTableSize + 1];
 
         Vector3 _lowerDomainBound, _upperDomainBound;
         Vector3 _lowerGridBound;
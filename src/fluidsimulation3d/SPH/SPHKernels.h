@@ -93,16 +93,50 @@ class SpikyKernel {
 
 class SPHKernels {
     public:
-        explicit SPHKernels(Float kernelRadius) {
+        explicit SPHKernels(Float kernelRadius): _radius{kernelRadius} {
             _poly6.setRadius(kernelRadius);
             _spiky.setRadius(kernelRadius);
         }
 
+        Float radius() const { return _radius; }
+
         Float W0() const { return _poly6.W0(); }
         Float W(const Vector3& r) const { return _poly6.W(r); }
         Vector3 gradW(const Vector3& r) const { return _spiky.gradW(r); }
 
+        /* Integrate W and gradW over the part of the kernel support around
+           position where signedDistance(point) is negative, i.e. inside a
+           solid. The support is sampled at centers of a regular lattice with
+           given number of cells per kernel radius. Each sample is weighted by
+           the fraction of its cell that is solid, estimated from the distance,
+           which keeps the result smooth even with a coarse lattice. The result
+           is divided by particleVolume, so it's what a sum over particles
+           filling the solid would give. */
+        template<class SignedDistance> void integrateSolid(const Vector3& position, Int samples, Float particleVolume, SignedDistance&& signedDistance, Float& w, Vector3& gradient) const {
+            const Float spacing = _radius/Float(samples);
+            w = 0.0f;
+            gradient = Vector3{0.0f};
+            for(Int k = -samples; k != samples; ++k) {
+                for(Int j = -samples; j != samples; ++j) {
+                    for(Int i = -samples; i != samples; ++i) {
+                        /* Relative position of the particle from the solid
+                           point, same as for neighbor particles */
+                        const Vector3 r = (Vector3{Vector3i{i, j, k}} + Vector3{0.5f})*spacing;
+                        if(r.dot() > _radius*_radius) continue;
+                        const Float fraction = Math::clamp(0.5f - signedDistance(position - r)/spacing, 0.0f, 1.0f);
+                        if(fraction == 0.0f) continue;
+                        w += fraction*W(r);
+                        gradient += fraction*gradW(r);
+                    }
+                }
+            }
+            const Float weight = spacing*spacing*spacing/particleVolume;
+            w *= weight;
+            gradient *= weight;
+        }
+
     private:
+        Float _radius;
         Poly6Kernel _poly6;
         SpikyKernel _spiky;
 };
@@ -30,56 +30,311 @@
 
 #include "SPHSolver.h"
 
+#include <algorithm>
+#include <Corrade/Utility/Debug.h>
+
 #include "TaskScheduler.h"
 
 namespace Magnum { namespace Examples {
 
+using namespace Containers::Literals;
+
+namespace {
+
+template<class T> UnsignedLong fnv1a(UnsignedLong hash, const std::vector<T>& data) {
+    const auto* bytes = reinterpret_cast<const UnsignedByte*>(data.data());
+    for(std::size_t i = 0, size = data.size()*sizeof(T); i != size; ++i) {
+        hash ^= bytes[i];
+        hash *= 1099511628211ull;
+    }
+    return hash;
+}
+
+enum: UnsignedInt {
+    CheckpointParticleRadius,
+    CheckpointParameters,
+    CheckpointPositions,
+    CheckpointPositionsT0,
+    CheckpointVelocities,
+    CheckpointDensities,
+    CheckpointSleepCounters,
+    /* Lower and upper domain bound, then the same from the last step */
+    CheckpointDomainBounds
+};
+
+}
+
 SPHSolver::SPHSolver(Float particleRadius):
     _particleRadius{particleRadius},
     _particleMass{Math::pow(2.0f*particleRadius, 3.0f)*RestDensity*0.9f},
     _kernels{particleRadius*4.0f},
-    _domainBox{particleRadius, Vector3{particleRadius}, Vector3{3.0f, 3.0f, 1.0f} - Vector3{particleRadius}} {}
+    _domainBox{particleRadius, Vector3{particleRadius}, Vector3{3.0f, 3.0f, 1.0f} - Vector3{particleRadius}}
+{
+    /* The activity grid covers the initial domain, which is the largest it
+       can get */
+    _activityCellLength = particleRadius*4.0f;
+    _activityGridOrigin = _domainBox.lowerDomainBound();
+    _activityGridSize = Vector3i{Math::ceil((_domainBox.upperDomainBound() - _activityGridOrigin)/_activityCellLength)};
+    _lastLowerDomainBound = _domainBox.lowerDomainBound();
+    _lastUpperDomainBound = _domainBox.upperDomainBound();
+    _cellsAwake.resize(std::size_t(_activityGridSize.product()));
+    _cellsActive.resize(std::size_t(_activityGridSize.product()));
+}
 
 void SPHSolver::setPositions(const std::vector<Vector3>& positions) {
     _positions = positions;
     _positionsT0 = positions;
 
-    /* Resize other variables */
-    const auto nParticles = positions.size();
+    /* Must initialize zero for all velocities */
+    _velocities.assign(positions.size(), Vector3{0.0f});
+    _sleepCounters.assign(positions.size(), 0);
+    resizeParticleData();
+}
+
+void SPHSolver::resizeParticleData() {
+    const auto nParticles = _positions.size();
     _densities.resize(nParticles);
     _neighbors.resize(nParticles);
     _relPositions.resize(nParticles);
-    /* Must initialize zero for all velocities */
-    _velocities.assign(nParticles, Vector3{0.0f});
     _velocityDiffusions.resize(nParticles);
+    _boundaryGradients.resize(nParticles);
+    _particleCells.resize(nParticles);
 }
 
 void SPHSolver::reset() {
     _positions = _positionsT0;
     /* Must initialize zero for all velocities */
     _velocities.assign(numParticles(), Vector3{0.0f});
+    _sleepCounters.assign(numParticles(), 0);
+}
+
+UnsignedLong SPHSolver::stateChecksum() const {
+    UnsignedLong hash = 14695981039346656037ull;
+    hash = fnv1a(hash, _positions);
+    hash = fnv1a(hash, _velocities);
+    hash = fnv1a(hash, _densities);
+    return hash;
+}
+
+Containers::StringView SPHSolver::checkpointKind() {
+    return "SPHSolver"_s;
+}
+
+UnsignedInt SPHSolver::checkpointVersion() {
+    return 1;
+}
+
+void SPHSolver::addToCheckpoint(CheckpointWriter& writer) const {
+    const Vector3 domainBounds[]{
+        _domainBox.lowerDomainBound(), _domainBox.upperDomainBound(),
+        _lastLowerDomainBound, _lastUpperDomainBound
+    };
+    writer.addValue(CheckpointParticleRadius, _particleRadius)
+        .addValue(CheckpointParameters, _params)
+        .add(CheckpointPositions, _positions)
+        .add(CheckpointPositionsT0, _positionsT0)
+        .add(CheckpointVelocities, _velocities)
+        .add(CheckpointDensities, _densities)
+        .add(CheckpointSleepCounters, _sleepCounters)
+        .add(CheckpointDomainBounds, sizeof(Vector3), 4, domainBounds);
+}
+
+bool SPHSolver::saveCheckpoint(const Containers::StringView filename) const {
+    CheckpointWriter writer{checkpointKind(), checkpointVersion()};
+    addToCheckpoint(writer);
+    return writer.write(filename);
+}
+
+bool SPHSolver::loadCheckpoint(const Checkpoint& checkpoint) {
+    /* The particle mass, kernels and activity grid are derived from the
+       radius, so it has to match */
+    Float particleRadius;
+    if(!checkpoint.readValue(CheckpointParticleRadius, particleRadius) ||
+       particleRadius != _particleRadius) {
+        Error{} << "SPHSolver: checkpoint particle radius doesn't match";
+        return false;
+    }
+
+    /* Read everything to temporaries first so the solver state stays
+       consistent if something is missing */
+    SPHParams params;
+    std::vector<Vector3> positions, positionsT0, velocities;
+    std::vector<uint16_t> densities;
+    std::vector<UnsignedShort> sleepCounters;
+    const Containers::ArrayView<const Vector3> domainBounds = checkpoint.view<Vector3>(CheckpointDomainBounds);
+    if(!checkpoint.readValue(CheckpointParameters, params) ||
+       !checkpoint.read(CheckpointPositions, positions) ||
+       !checkpoint.read(CheckpointPositionsT0, positionsT0) ||
+       !checkpoint.read(CheckpointVelocities, velocities) ||
+       !checkpoint.read(CheckpointDensities, densities) ||
+       !checkpoint.read(CheckpointSleepCounters, sleepCounters) ||
+       domainBounds.size() != 4) {
+        Error{} << "SPHSolver: incomplete checkpoint";
+        return false;
+    }
+    if(positionsT0.size() != positions.size() ||
+       velocities.size() != positions.size() ||
+       densities.size() != positions.size() ||
+       sleepCounters.size() != positions.size()) {
+        Error{} << "SPHSolver: inconsistent particle count in checkpoint";
+        return false;
+    }
+
+    _params = params;
+    _positions = std::move(positions);
+    _positionsT0 = std::move(positionsT0);
+    _velocities = std::move(velocities);
+    _densities = std::move(densities);
+    _sleepCounters = std::move(sleepCounters);
+    resizeParticleData();
+    _domainBox.lowerDomainBound() = domainBounds[0];
+    _domainBox.upperDomainBound() = domainBounds[1];
+    _lastLowerDomainBound = domainBounds[2];
+    _lastUpperDomainBound = domainBounds[3];
+    return true;
+}
+
+bool SPHSolver::loadCheckpoint(const Containers::StringView filename) {
+    const Containers::Optional<Checkpoint> checkpoint = Checkpoint::open(filename, checkpointKind(), checkpointVersion());
+    return checkpoint && loadCheckpoint(*checkpoint);
 }
 
 void SPHSolver::advance() {
+    _profiler.beginFrame();
+    Profiler::Stage frame{_profiler, "advance"};
+
+    /* Decide which particles to simulate in this step */
+    {
+        Profiler::Stage stage{_profiler, "updateActivity"};
+        updateActivity();
+    }
+    _profiler.addCounter("particles", _positions.size());
+    _profiler.addCounter("activeParticles", _activeParticles.size());
+
     /* Find neighbors and compute relative positions with them */
-    _domainBox.findNeighbors(_positions, _neighbors, _relPositions);
+    {
+        Profiler::Stage stage{_profiler, "findNeighbors"};
+        _domainBox.findNeighbors(_positions, _activeParticles, _neighbors, _relPositions);
+    }
 
     /* This is a fixed time step approach! In practice, adaptive time step
        should be used. */
     const Float timestep = 0.05f*_particleRadius;
 
-    computeDensities();
-    velocityIntegration(timestep);
-    computeViscosity();
-    updatePositions(timestep);
+    {
+        Profiler::Stage stage{_profiler, "computeDensities"};
+        computeDensities();
+    }
+    {
+        Profiler::Stage stage{_profiler, "velocityIntegration"};
+        velocityIntegration(timestep);
+    }
+    {
+        Profiler::Stage stage{_profiler, "computeViscosity"};
+        computeViscosity();
+    }
+    {
+        Profiler::Stage stage{_profiler, "updatePositions"};
+        updatePositions(timestep);
+        updateSleepCounters();
+    }
+}
+
+void SPHSolver::updateActivity() {
+    _activeParticles.clear();
+    if(!_params.sleeping) {
+        for(std::size_t p = 0; p != _positions.size(); ++p)
+            _activeParticles.push_back(UnsignedInt(p));
+        return;
+    }
+
+    /* A moving wall can push into sleeping particles or leave them without
+       support. Wake up the particles in the range the wall swept over since
+       the last step, extended by the kernel support, the rest of the fluid
+       learns about it through the neighboring cells below. */
+    const Float supportRadius = _activityCellLength;
+    for(std::size_t axis = 0; axis != 3; ++axis) {
+        const Float lower = _domainBox.lowerDomainBound()[axis];
+        const Float lastLower = _lastLowerDomainBound[axis];
+        if(lower != lastLower) {
+            const Float wakeBelow = Math::max(lower, lastLower) + supportRadius;
+            for(std::size_t p = 0; p != _positions.size(); ++p)
+                if(_positions[p][axis] < wakeBelow) _sleepCounters[p] = 0;
+        }
+
+        const Float upper = _domainBox.upperDomainBound()[axis];
+        const Float lastUpper = _lastUpperDomainBound[axis];
+        if(upper != lastUpper) {
+            const Float wakeAbove = Math::min(upper, lastUpper) - supportRadius;
+            for(std::size_t p = 0; p != _positions.size(); ++p)
+                if(_positions[p][axis] > wakeAbove) _sleepCounters[p] = 0;
+        }
+    }
+    _lastLowerDomainBound = _domainBox.lowerDomainBound();
+    _lastUpperDomainBound = _domainBox.upperDomainBound();
+
+    /* Mark cells that contain a particle that isn't sleepy */
+    std::fill(_cellsAwake.begin(), _cellsAwake.end(), 0);
+    for(std::size_t p = 0; p != _positions.size(); ++p) {
+        const Vector3i cell = Math::clamp(
+            Vector3i{(_positions[p] - _activityGridOrigin)/_activityCellLength},
+            Vector3i{0}, _activityGridSize - Vector3i{1});
+        const UnsignedInt cellIdx = UnsignedInt(cell.x() + _activityGridSize.x()*(cell.y() + _activityGridSize.y()*cell.z()));
+        _particleCells[p] = cellIdx;
+        if(_sleepCounters[p] < _params.sleepSteps) _cellsAwake[cellIdx] = 1;
+    }
+
+    /* Simulate also the cells around them, as their particles are neighbors
+       of the disturbed ones. If the disturbance spreads, their particles
+       stop being sleepy and wake up the next ring of cells. */
+    std::fill(_cellsActive.begin(), _cellsActive.end(), 0);
+    for(Int k = 0; k != _activityGridSize.z(); ++k) {
+        for(Int j = 0; j != _activityGridSize.y(); ++j) {
+            for(Int i = 0; i != _activityGridSize.x(); ++i) {
+                if(!_cellsAwake[i + _activityGridSize.x()*(j + _activityGridSize.y()*k)]) continue;
+                for(Int kk = Math::max(k - 1, 0); kk <= Math::min(k + 1, _activityGridSize.z() - 1); ++kk)
+                    for(Int jj = Math::max(j - 1, 0); jj <= Math::min(j + 1, _activityGridSize.y() - 1); ++jj)
+                        for(Int ii = Math::max(i - 1, 0); ii <= Math::min(i + 1, _activityGridSize.x() - 1); ++ii)
+                            _cellsActive[ii + _activityGridSize.x()*(jj + _activityGridSize.y()*kk)] = 1;
+            }
+        }
+    }
+
+    /* Sleeping particles keep their position and density, which the active
+       ones next to them still read, and have zero velocity */
+    for(std::size_t p = 0; p != _positions.size(); ++p) {
+        if(_cellsActive[_particleCells[p]])
+            _activeParticles.push_back(UnsignedInt(p));
+        else _velocities[p] = Vector3{0.0f};
+    }
+}
+
+void SPHSolver::updateSleepCounters() {
+    const Float sleepVelocitySqr = _params.sleepVelocity*_params.sleepVelocity;
+    TaskScheduler::forEach(_activeParticles.size(), [&](const std::size_t i) {
+        const UnsignedInt p = _activeParticles[i];
+        if(_velocities[p].dot() < sleepVelocitySqr) {
+            if(_sleepCounters[p] < 0xffff) ++_sleepCounters[p];
+        } else _sleepCounters[p] = 0;
+    });
 }
 
 void SPHSolver::computeDensities() {
-    TaskScheduler::forEach(_positions.size(), [&](const std::size_t p) {
+    TaskScheduler::forEach(_activeParticles.size(), [&](const std::size_t i) {
+        const UnsignedInt p = _activeParticles[i];
+
+        /* Boundary contribution, in units of the particle mass as well */
+        Float boundaryDensity = 0.0f;
+        Vector3 boundaryGradient{0.0f};
+        _domainBox.addBoundaryContribution(_positions[p], boundaryDensity, boundaryGradient);
+        if(_staticBoundary && _params.staticBoundary)
+            _staticBoundary->addBoundaryContribution(_positions[p], boundaryDensity, boundaryGradient);
+        _boundaryGradients[p] = boundaryGradient;
+
         const std::vector<Vector3>& relPositions = _relPositions[p];
-        if(relPositions.size() == 0) return;
+        if(relPositions.size() == 0 && boundaryDensity == 0.0f) return;
 
-        auto pdensity = _kernels.W0();
+        auto pdensity = _kernels.W0() + boundaryDensity;
         for(const Vector3& xpq: relPositions)
             pdensity += _kernels.W(xpq);
         pdensity *= _particleMass;
@@ -100,7 +355,8 @@ void SPHSolver::velocityIntegration(float timestep) {
         return ratioExp7 - 1.0f;
     };
 
-    TaskScheduler::forEach(_positions.size(), [&](const std::size_t p) {
+    TaskScheduler::forEach(_activeParticles.size(), [&](const std::size_t i) {
+        const UnsignedInt p = _activeParticles[i];
         const auto& neighbors = _neighbors[p];
         if(neighbors.size() == 0) {
             /* A lonely particle only interacts with gravity */
@@ -126,11 +382,9 @@ void SPHSolver::velocityIntegration(float timestep) {
             accel -= (Kp + Kq)*_kernels.gradW(r);
         }
 
-        /* Compute the pressure acceleration caused by ghost boundary particles */
-        for(std::size_t idx = neighbors.size(); idx < relPositions.size(); ++idx) {
-            const Vector3 r = relPositions[idx];
-            accel -= Kp*_kernels.gradW(r);
-        }
+        /* Pressure acceleration caused by the boundary, which is assumed to
+           have the same pressure as the particle */
+        accel -= Kp*_boundaryGradients[p];
 
         accel *= _params.stiffness*_particleMass;
         accel.y() -= 9.81f; /* add gravity */
@@ -141,7 +395,8 @@ void SPHSolver::velocityIntegration(float timestep) {
 }
 
 void SPHSolver::computeViscosity() {
-    TaskScheduler::forEach(_positions.size(), [&](const std::size_t p) {
+    TaskScheduler::forEach(_activeParticles.size(), [&](const std::size_t i) {
+        const UnsignedInt p = _activeParticles[i];
         const std::vector<UnsignedInt>& neighbors = _neighbors[p];
         if(neighbors.empty()) {
             _velocityDiffusions[p] = Vector3(0);
@@ -166,16 +421,21 @@ void SPHSolver::computeViscosity() {
     });
 
     /* Add diffused velocity back to velocity, causing viscosity */
-    TaskScheduler::forEach(_positions.size(), [&](const std::size_t p) {
+    TaskScheduler::forEach(_activeParticles.size(), [&](const std::size_t i) {
+        const UnsignedInt p = _activeParticles[i];
         _velocities[p] += _velocityDiffusions[p];
     });
 }
 
 void SPHSolver::updatePositions(Float timestep) {
-    TaskScheduler::forEach(_positions.size(), [&](const std::size_t p) {
+    TaskScheduler::forEach(_activeParticles.size(), [&](const std::size_t i) {
+        const UnsignedInt p = _activeParticles[i];
         Vector3 pvel = _velocities[p];
         auto ppos = _positions[p] + pvel * timestep;
-        if(_domainBox.enforceBoundary(ppos, pvel, _params.boundaryRestitution)) {
+        bool velocityChanged = _domainBox.enforceBoundary(ppos, pvel, _params.boundaryRestitution);
+        if(_staticBoundary && _params.staticBoundary)
+            velocityChanged |= _staticBoundary->enforceBoundary(ppos, pvel, _params.boundaryRestitution);
+        if(velocityChanged) {
             _velocities[p] = pvel;
         }
         _positions[p] = ppos;
@@ -31,9 +31,13 @@
  */
 
 #include <vector>
+#include <Corrade/Containers/Pointer.h>
 #include <Magnum/Magnum.h>
 
+#include "Checkpoint.h"
+#include "Profiler.h"
 #include "SPH/SPHKernels.h"
+#include "SPH/BoundaryVolume.h"
 #include "SPH/DomainBox.h"
 
 namespace Magnum { namespace Examples {
@@ -42,6 +46,14 @@ struct SPHParams {
     Float stiffness = 20000.0f;
     Float viscosity = 0.05f;
     Float boundaryRestitution = 0.5f;
+    /* Whether to use the static boundary, if there's any */
+    bool staticBoundary = true;
+
+    /* Parts of the fluid where all particles stayed slower than
+       sleepVelocity for sleepSteps steps are not simulated until disturbed */
+    bool sleeping = true;
+    Float sleepVelocity = 0.1f;
+    UnsignedInt sleepSteps = 200;
 };
 
 /* This is a very basic implementation of SPH (Smoothed Particle Hydrodynamics)
@@ -56,16 +68,49 @@ class SPHSolver {
         void advance();
 
         DomainBox& domainBox() { return _domainBox; }
+
+        /* Boundary in addition to the domain box, for example obstacles */
+        const BoundaryVolume* staticBoundary() const { return _staticBoundary.get(); }
+        void setStaticBoundary(Containers::Pointer<BoundaryVolume>&& boundary) {
+            _staticBoundary = std::move(boundary);
+        }
         SPHParams& simulationParameters() { return _params; }
 
         std::size_t numParticles() const { return _positions.size(); }
+        /* Particles simulated in the last step, the rest is sleeping */
+        std::size_t numActiveParticles() const { return _activeParticles.size(); }
         const std::vector<Vector3>& particlePositions() { return _positions; }
 
+        /* 64-bit FNV-1a hash of positions, velocities and densities. Same
+           setup gives the same sequence of checksums regardless of the
+           thread count, see TaskScheduler::setThreadCount(). */
+        UnsignedLong stateChecksum() const;
+
+        /* Per-stage timing of advance(), disabled by default */
+        Profiler& profiler() { return _profiler; }
+
+        /* Particle state, domain bounds and parameters. The static boundary
+           isn't saved, it's expected to be set up the same way again. Array
+           IDs below 100 are used by the solver, the rest is free for
+           additional state of the caller. */
+        static Containers::StringView checkpointKind();
+        static UnsignedInt checkpointVersion();
+        void addToCheckpoint(CheckpointWriter& writer) const;
+        bool saveCheckpoint(Containers::StringView filename) const;
+
+        /* Restoring doesn't touch the solver if it fails. The same
+           checkpoint can be loaded into any number of solvers. */
+        bool loadCheckpoint(const Checkpoint& checkpoint);
+        bool loadCheckpoint(Containers::StringView filename);
+
     private:
+        void updateActivity();
+        void updateSleepCounters();
         void computeDensities();
         void velocityIntegration(Float timestep);
         void computeViscosity();
         void updatePositions(Float timestep);
+        void resizeParticleData();
 
         /* Rest density of fluid */
         constexpr static Float RestDensity = 1000.0f;
@@ -89,14 +134,35 @@ class SPHSolver {
         std::vector<Vector3> _velocities;
         std::vector<Vector3> _velocityDiffusions;
 
+        /* Contribution of the boundary to pressure force */
+        std::vector<Vector3> _boundaryGradients;
+
+        /* Sleeping. Activity is tracked on a fixed grid over the domain with
+           cells as large as the kernel support, a cell is simulated if it or
+           any of its neighbors contains a particle that isn't sleepy. */
+        std::vector<UnsignedInt> _activeParticles;
+        std::vector<UnsignedShort> _sleepCounters;
+        std::vector<UnsignedInt> _particleCells;
+        std::vector<UnsignedByte> _cellsAwake;
+        std::vector<UnsignedByte> _cellsActive;
+        Vector3 _activityGridOrigin;
+        Vector3i _activityGridSize;
+        Float _activityCellLength;
+        /* Domain bounds in the last step, particles next to a wall that
+           moved since are woken up */
+        Vector3 _lastLowerDomainBound, _lastUpperDomainBound;
+
         /* SPH kernels */
         SPHKernels _kernels;
 
         /* Boundary */
         DomainBox _domainBox;
+        Containers::Pointer<BoundaryVolume> _staticBoundary;
 
         /* Parameters */
         SPHParams _params;
+
+        Profiler _profiler;
 };
 
 }}
@@ -0,0 +1,199 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include "SPH/SimulationThread.h"
+
+#include <chrono>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Animation/Easing.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Magnum { namespace Examples {
+
+std::vector<Vector3> initialParticlePositions(const Float particleRadius) {
+    const Vector3 lowerCorner = Vector3{particleRadius*2.0f};
+    const Vector3 upperCorner = Vector3{0.5f, 2.0f, 1.0f} - Vector3{particleRadius*2.0f};
+    const Float spacing = particleRadius*2.0f;
+    const Vector3 resolution = (upperCorner - lowerCorner)/spacing;
+
+    std::vector<Vector3> positions;
+    positions.reserve(std::size_t(resolution.product()));
+    for(Int i = 0; i < resolution[0]; ++i) {
+        for(Int j = 0; j < resolution[1]; ++j) {
+            for(Int k = 0; k < resolution[2]; ++k) {
+                positions.push_back(Vector3{Vector3i{i, j, k}}*spacing + lowerCorner);
+            }
+        }
+    }
+
+    return positions;
+}
+
+SimulationThread::SimulationThread(SPHSolver& solver, const Float particleRadius): _solver(solver), _particleRadius{particleRadius}, _parameters{solver.simulationParameters()} {
+    /* Publish the initial state, so there's something to draw before the
+       first step finishes */
+    _snapshots.writeBuffer().positions = _solver.particlePositions();
+    _snapshots.writeBuffer().activeParticles = _solver.numParticles();
+    _snapshots.publish();
+}
+
+namespace {
+
+/* IDs of the additional checkpoint arrays, the solver uses IDs below 100 */
+enum: UnsignedInt {
+    CheckpointWall = 100,
+    CheckpointStepCount
+};
+
+}
+
+SimulationThread::~SimulationThread() { stop(); }
+
+void SimulationThread::start() {
+    #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
+    if(_running) return;
+    _running = true;
+    _thread = std::thread{[this]{ loop(); }};
+    #endif
+}
+
+void SimulationThread::stop() {
+    #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
+    if(!_running) return;
+    _running = false;
+    _thread.join();
+    #endif
+}
+
+void SimulationThread::setParameters(const SPHParams& params) {
+    std::lock_guard<std::mutex> lock{_parametersMutex};
+    _parameters = params;
+    _parametersChanged = true;
+}
+
+bool SimulationThread::saveCheckpoint(const Containers::StringView filename) const {
+    CORRADE_INTERNAL_ASSERT(!_running);
+    CheckpointWriter writer{SPHSolver::checkpointKind(), SPHSolver::checkpointVersion()};
+    _solver.addToCheckpoint(writer);
+    const Float wall[]{_boundaryOffset, _boundaryStep, _wallOffset};
+    writer.add(CheckpointWall, sizeof(Float), 3, wall)
+        .addValue(CheckpointStepCount, UnsignedLong(_stepCount));
+    return writer.write(filename);
+}
+
+bool SimulationThread::loadCheckpoint(const Containers::StringView filename) {
+    CORRADE_INTERNAL_ASSERT(!_running);
+    const Containers::Optional<Checkpoint> checkpoint = Checkpoint::open(filename, SPHSolver::checkpointKind(), SPHSolver::checkpointVersion());
+    if(!checkpoint) return false;
+
+    const Containers::ArrayView<const Float> wall = checkpoint->view<Float>(CheckpointWall);
+    UnsignedLong stepCount;
+    if(wall.size() != 3 || !checkpoint->readValue(CheckpointStepCount, stepCount)) {
+        Error{} << "SimulationThread: checkpoint has no wall state in" << filename;
+        return false;
+    }
+    if(!_solver.loadCheckpoint(*checkpoint)) return false;
+
+    _boundaryOffset = wall[0];
+    _boundaryStep = wall[1];
+    _wallOffset = wall[2];
+    _stepCount = stepCount;
+    publish();
+    return true;
+}
+
+void SimulationThread::runFor(const Double seconds) {
+    const auto begin = std::chrono::steady_clock::now();
+    do {
+        applyRequests();
+        if(_paused) return;
+        step();
+    } while(std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count() < seconds);
+}
+
+void SimulationThread::loop() {
+    #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
+    while(_running) {
+        applyRequests();
+
+        /* Don't spin at full speed while paused */
+        if(_paused) {
+            std::this_thread::sleep_for(std::chrono::milliseconds{5});
+            continue;
+        }
+
+        step();
+    }
+    #endif
+}
+
+void SimulationThread::applyRequests() {
+    if(_parametersChanged.exchange(false)) {
+        std::lock_guard<std::mutex> lock{_parametersMutex};
+        _solver.simulationParameters() = _parameters;
+    }
+
+    if(_resetRequested.exchange(false)) {
+        _solver.reset();
+        if(_dynamicBoundary) _boundaryOffset = 0.0f;
+        _solver.domainBox().upperDomainBound().x() = 3.0f - _particleRadius;
+    }
+}
+
+void SimulationThread::step() {
+    if(_dynamicBoundary) {
+        /* Change fluid boundary */
+        if(_boundaryOffset > 1.0f || _boundaryOffset < 0.0f) {
+            _boundaryStep *= -1.0f;
+        }
+        _boundaryOffset += _boundaryStep;
+        _wallOffset = Math::lerp(0.0f, 0.5f, Animation::Easing::quadraticInOut(_boundaryOffset));
+    }
+    _solver.domainBox().upperDomainBound().x() = 2.0f*(1.5f - _wallOffset) - _particleRadius;
+
+    /* Run simulation one time step */
+    _solver.advance();
+
+    ++_stepCount;
+    publish();
+}
+
+void SimulationThread::publish() {
+    /* Buffers are reused, so after the first few steps this is just a copy
+       without any allocation */
+    SimulationSnapshot& snapshot = _snapshots.writeBuffer();
+    snapshot.positions.assign(_solver.particlePositions().begin(), _solver.particlePositions().end());
+    snapshot.boundaryOffset = _wallOffset;
+    snapshot.activeParticles = _solver.numActiveParticles();
+    snapshot.step = _stepCount;
+    _snapshots.publish();
+}
+
+}}
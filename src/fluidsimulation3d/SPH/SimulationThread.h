@@ -0,0 +1,138 @@
+#ifndef Magnum_Examples_FluidSimulation3D_SPH_SimulationThread_h
+#define Magnum_Examples_FluidSimulation3D_SPH_SimulationThread_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <mutex>
+#include <vector>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector3.h>
+
+#include "TripleBuffer.h"
+#include "SPH/SPHSolver.h"
+
+#include "configure.h"
+
+#ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
+#include <thread>
+#endif
+
+namespace Magnum { namespace Examples {
+
+/* Particles filling the initial fluid block in the corner of the domain */
+std::vector<Vector3> initialParticlePositions(Float particleRadius);
+
+/* State of the simulation after a step, as seen by the renderer */
+struct SimulationSnapshot {
+    std::vector<Vector3> positions;
+    /* Offset of the moving domain wall, from 0 to 0.5 */
+    Float boundaryOffset = 0.0f;
+    /* Number of particles that aren't sleeping */
+    std::size_t activeParticles = 0;
+    /* Number of steps simulated so far */
+    UnsignedLong step = 0;
+};
+
+/* Runs SPHSolver independently of the render loop. The solver is owned by
+   the simulation thread, everything else talks to it only through requests
+   that are applied before the next step, and gets its results through
+   snapshots published after each step.
+
+   If the example is built without multithreading, start() does nothing and
+   runFor() has to be called from the render loop instead. */
+class SimulationThread {
+    public:
+        explicit SimulationThread(SPHSolver& solver, Float particleRadius);
+        ~SimulationThread();
+
+        /* Start and stop the simulation thread */
+        void start();
+        void stop();
+        bool isRunning() const { return _running; }
+
+        /* Run steps on the calling thread until given time elapses, at least
+           one step is done if the simulation isn't paused */
+        void runFor(Double seconds);
+
+        /* Requests, applied before the next step */
+        bool isPaused() const { return _paused; }
+        void setPaused(bool paused) { _paused = paused; }
+        bool isDynamicBoundary() const { return _dynamicBoundary; }
+        void setDynamicBoundary(bool dynamic) { _dynamicBoundary = dynamic; }
+        void setParameters(const SPHParams& params);
+        void requestReset() { _resetRequested = true; }
+
+        /* Snapshots, to be consumed by a single reader */
+        TripleBuffer<SimulationSnapshot>& snapshots() { return _snapshots; }
+
+        /* Total number of steps done, can be queried from any thread */
+        UnsignedLong stepCount() const { return _stepCount; }
+
+        /* Save or restore the solver state together with the moving wall
+           and the step count. Only allowed while the thread isn't running,
+           loading publishes a new snapshot. */
+        bool saveCheckpoint(Containers::StringView filename) const;
+        bool loadCheckpoint(Containers::StringView filename);
+
+    private:
+        void applyRequests();
+        void step();
+        void loop();
+        void publish();
+
+        SPHSolver& _solver;
+        const Float _particleRadius;
+
+        /* Owned by the thread running the simulation */
+        Float _boundaryOffset = 0.0f;
+        Float _boundaryStep = 2.0e-3f;
+        Float _wallOffset = 0.0f;
+
+        std::atomic<bool> _paused{false};
+        std::atomic<bool> _dynamicBoundary{false};
+        std::atomic<bool> _resetRequested{false};
+        std::atomic<bool> _parametersChanged{false};
+        std::atomic<bool> _running{false};
+        std::atomic<UnsignedLong> _stepCount{0};
+
+        std::mutex _parametersMutex;
+        SPHParams _parameters;
+
+        TripleBuffer<SimulationSnapshot> _snapshots;
+
+        #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
+        std::thread _thread;
+        #endif
+};
+
+}}
+
+#endif
@@ -55,6 +55,8 @@ ParticleSphereShader::ParticleSphereShader() {
 
     _uNumParticles = uniformLocation("numParticles");
     _uParticleRadius = uniformLocation("particleRadius");
+    _uPositionScale = uniformLocation("positionScale");
+    _uPositionOffset = uniformLocation("positionOffset");
 
     _uPointSizeScale = uniformLocation("pointSizeScale");
     _uColorMode = uniformLocation("colorMode");
@@ -78,6 +80,16 @@ ParticleSphereShader& ParticleSphereShader::setParticleRadius(Float radius) {
     return *this;
 }
 
+ParticleSphereShader& ParticleSphereShader::setPositionScale(const Vector3& scale) {
+    setUniform(_uPositionScale, scale);
+    return *this;
+}
+
+ParticleSphereShader& ParticleSphereShader::setPositionOffset(const Vector3& offset) {
+    setUniform(_uPositionOffset, offset);
+    return *this;
+}
+
 ParticleSphereShader& ParticleSphereShader::setPointSizeScale(Float scale) {
     setUniform(_uPointSizeScale, scale);
     return *this;
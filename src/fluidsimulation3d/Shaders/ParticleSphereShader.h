@@ -46,6 +46,10 @@ class ParticleSphereShader: public GL::AbstractShaderProgram {
 
         ParticleSphereShader& setNumParticles(Int numParticles);
         ParticleSphereShader& setParticleRadius(Float radius);
+        /* Transformation of the position attribute to world space, for
+           quantized positions */
+        ParticleSphereShader& setPositionScale(const Vector3& scale);
+        ParticleSphereShader& setPositionOffset(const Vector3& offset);
 
         ParticleSphereShader& setPointSizeScale(Float scale);
         ParticleSphereShader& setColorMode(Int colorMode);
@@ -62,6 +66,8 @@ class ParticleSphereShader: public GL::AbstractShaderProgram {
     private:
         Int _uNumParticles,
             _uParticleRadius,
+            _uPositionScale,
+            _uPositionOffset,
             _uPointSizeScale,
             _uColorMode,
             _uAmbientColor,
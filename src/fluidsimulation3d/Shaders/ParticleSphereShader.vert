@@ -34,6 +34,8 @@ uniform highp mat4 projectionMatrix;
 uniform int numParticles;
 uniform int colorMode;
 uniform float particleRadius;
+uniform highp vec3 positionScale;
+uniform highp vec3 positionOffset;
 uniform float pointSizeScale;
 
 uniform vec3 diffuseColor;
@@ -80,7 +82,7 @@ vec3 generateVertexColor() {
 }
 
 void main() {
-    vec4 eyeCoord = viewMatrix*vec4(position, 1.0);
+    vec4 eyeCoord = viewMatrix*vec4(positionOffset + position*positionScale, 1.0);
     vec3 posEye = vec3(eyeCoord);
 
     /* output */
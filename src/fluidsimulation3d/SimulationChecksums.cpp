@@ -0,0 +1,108 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <Corrade/Containers/StringView.h>
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Format.h>
+
+#include "TaskScheduler.h"
+#include "SPH/SPHSolver.h"
+#include "SPH/SimulationThread.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+/* Runs the same scene as the example for a fixed number of steps and prints
+   a checksum of the solver state and the count of particles simulated in each
+   of them, the rest is sleeping. The wall can start moving after the fluid
+   settled, to check that it wakes the fluid up again. The output doesn't
+   depend on the thread count, so runs can be cached and compared with a plain
+   diff. */
+int main(int argc, char** argv) {
+    Utility::Arguments args;
+    args.addOption("steps", "1000")
+            .setHelp("steps", "number of steps to simulate", "N")
+        .addOption("every", "1")
+            .setHelp("every", "print a checksum every N steps", "N")
+        .addOption("threads", "0")
+            .setHelp("threads", "number of threads to use, 0 for all hardware threads", "N")
+        .addOption("radius", "0.02")
+            .setHelp("radius", "particle radius", "RADIUS")
+        .addBooleanOption("no-sleeping")
+            .setHelp("no-sleeping", "simulate all particles in every step")
+        .addOption("move-wall-at")
+            .setHelp("move-wall-at", "start moving the wall after given step, if not set it stays in place", "N")
+        .addOption("save-at", "0")
+            .setHelp("save-at", "save a checkpoint after given step", "N")
+        .addOption("checkpoint", "checkpoint.bin")
+            .setHelp("checkpoint", "file to save the checkpoint to", "FILE")
+        .addOption("load")
+            .setHelp("load", "resume from a checkpoint instead of the initial state", "FILE")
+        .setGlobalHelp("Prints per-step checksums of the 3D fluid simulation state, headless.")
+        .parse(argc, argv);
+
+    const UnsignedLong steps = args.value<UnsignedLong>("steps");
+    const UnsignedLong every = args.value<UnsignedLong>("every");
+    const Float particleRadius = args.value<Float>("radius");
+    if(!every || !(particleRadius > 0.0f)) {
+        Error{} << "Invalid --every or --radius";
+        return 1;
+    }
+
+    TaskScheduler::setThreadCount(args.value<std::size_t>("threads"));
+
+    SPHSolver solver{particleRadius};
+    solver.setPositions(initialParticlePositions(particleRadius));
+    solver.simulationParameters().sleeping = !args.isSet("no-sleeping");
+
+    /* Stepping through the simulation thread on the calling thread, so the
+       wall moves the same way as in the example */
+    SimulationThread simulation{solver, particleRadius};
+
+    /* A resumed run continues with the step numbering of the checkpoint, so
+       its output can be compared with the tail of an uninterrupted run */
+    const Containers::StringView load = args.value("load");
+    if(!load.isEmpty() && !simulation.loadCheckpoint(load))
+        return 2;
+    const UnsignedLong saveAt = args.value<UnsignedLong>("save-at");
+    const bool moveWall = !Containers::StringView{args.value("move-wall-at")}.isEmpty();
+    const UnsignedLong moveWallAt = moveWall ? args.value<UnsignedLong>("move-wall-at") : 0;
+
+    Utility::print("particles {}\n", solver.numParticles());
+    Utility::print("step {} {:.16x}\n", simulation.stepCount(), solver.stateChecksum());
+    for(UnsignedLong step = simulation.stepCount() + 1; step <= steps; ++step) {
+        simulation.setDynamicBoundary(moveWall && step > moveWallAt);
+        simulation.runFor(0.0);
+        if(step % every == 0 || step == steps)
+            Utility::print("step {} {:.16x} active {}\n", step, solver.stateChecksum(), solver.numActiveParticles());
+        if(step == saveAt && !simulation.saveCheckpoint(args.value("checkpoint")))
+            return 3;
+    }
+}
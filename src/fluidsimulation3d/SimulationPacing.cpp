@@ -0,0 +1,213 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <Corrade/Containers/String.h>
+#include <Corrade/Containers/StringView.h>
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Format.h>
+
+#include "SPH/SPHSolver.h"
+#include "SPH/SimulationThread.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+constexpr Float ParticleRadius = 0.02f;
+
+using Clock = std::chrono::steady_clock;
+
+Double secondsSince(Clock::time_point begin) {
+    return std::chrono::duration<Double>(Clock::now() - begin).count();
+}
+
+}
+
+/* Runs the simulation thread together with a fake render loop and measures
+   both sides independently -- how regularly the render loop gets its frames
+   and how many steps the simulation does meanwhile, compared to running the
+   simulation alone */
+int main(int argc, char** argv) {
+    Utility::Arguments args;
+    args.addOption("duration", "5")
+            .setHelp("duration", "duration of each measurement in seconds", "SECONDS")
+        .addOption("render-time", "8")
+            .setHelp("render-time", "time the fake render loop spends on each frame", "MILLISECONDS")
+        .addOption("frame-period", "16.667")
+            .setHelp("frame-period", "period of the fake render loop", "MILLISECONDS")
+        .addOption("max-p99-interval", "25")
+            .setHelp("max-p99-interval", "fail if the 99th percentile of the render loop frame interval is above this", "MILLISECONDS")
+        .addOption("min-throughput", "50")
+            .setHelp("min-throughput", "fail if the simulation does fewer steps while rendering than this percentage of the steps it does alone", "PERCENT")
+        .addOption("min-steps-per-second", "0")
+            .setHelp("min-steps-per-second", "fail if the simulation does fewer steps per second while rendering", "STEPS")
+        .addOption("profile")
+            .setHelp("profile", "profile the solver stages while rendering and save the result to PREFIX.json and PREFIX.csv", "PREFIX")
+        .setGlobalHelp("Measures frame pacing and throughput of the 3D fluid simulation thread, headless. Returns non-zero if the pacing or the throughput is worse than the given limits.")
+        .parse(argc, argv);
+
+    const Double duration = args.value<Double>("duration");
+    const auto renderTime = std::chrono::duration<Double, std::milli>{args.value<Double>("render-time")};
+    const auto framePeriod = std::chrono::duration_cast<Clock::duration>(
+        std::chrono::duration<Double, std::milli>{args.value<Double>("frame-period")});
+
+    SPHSolver solver{ParticleRadius};
+    solver.setPositions(initialParticlePositions(ParticleRadius));
+    Debug{} << "Simulating" << solver.numParticles() << "particles";
+
+    /* Simulation alone */
+    Double standaloneStepsPerSecond;
+    {
+        SimulationThread simulation{solver, ParticleRadius};
+        const Clock::time_point begin = Clock::now();
+        simulation.start();
+        std::this_thread::sleep_for(std::chrono::duration<Double>{duration});
+        simulation.stop();
+        standaloneStepsPerSecond = Double(simulation.stepCount())/secondsSince(begin);
+    }
+    Debug{} << "Simulation alone:" << standaloneStepsPerSecond << "steps/s";
+    if(!standaloneStepsPerSecond) {
+        Error{} << "The simulation didn't finish any step, increase --duration";
+        return 1;
+    }
+
+    /* Simulation with a render loop consuming the snapshots, optionally
+       profiled */
+    const Containers::StringView profile = args.value("profile");
+    solver.reset();
+    solver.profiler().setEnabled(!profile.isEmpty());
+    SimulationThread simulation{solver, ParticleRadius};
+    std::vector<Double> frameIntervals;
+    std::size_t framesWithNewData = 0;
+    std::size_t particleCount = 0;
+    UnsignedLong stepsDone;
+    Double elapsed;
+    {
+        const Clock::time_point begin = Clock::now();
+        simulation.start();
+
+        Clock::time_point nextFrame = begin;
+        Clock::time_point lastFrame = begin;
+        while(secondsSince(begin) < duration) {
+            nextFrame += framePeriod;
+            std::this_thread::sleep_until(nextFrame);
+
+            const Clock::time_point frameBegin = Clock::now();
+            frameIntervals.push_back(std::chrono::duration<Double, std::milli>(frameBegin - lastFrame).count());
+            lastFrame = frameBegin;
+
+            if(simulation.snapshots().update()) ++framesWithNewData;
+            /* Touch the data like an upload would, then pretend to render */
+            particleCount = simulation.snapshots().readBuffer().positions.size();
+            while(Clock::now() - frameBegin < renderTime) {}
+        }
+
+        simulation.stop();
+        stepsDone = simulation.stepCount();
+        elapsed = secondsSince(begin);
+    }
+
+    const std::size_t frameCount = frameIntervals.size();
+    if(!frameCount) {
+        Error{} << "The render loop didn't finish any frame, increase --duration";
+        return 1;
+    }
+
+    std::sort(frameIntervals.begin(), frameIntervals.end());
+    Double sum = 0.0;
+    for(const Double interval: frameIntervals) sum += interval;
+    const Double p99Interval = frameIntervals[frameCount*99/100];
+    const Double stepsPerSecond = Double(stepsDone)/elapsed;
+    const Double throughput = stepsPerSecond/standaloneStepsPerSecond*100.0;
+
+    Debug{} << "Render loop:" << frameCount << "frames of" << particleCount << "particles, interval"
+        << sum/Double(frameCount) << "ms on average," << frameIntervals[frameCount/2] << "ms median,"
+        << p99Interval << "ms at 99th percentile," << frameIntervals.back() << "ms max";
+    Debug{} << "Frames with a new simulation state:" << framesWithNewData << "of" << frameCount;
+    Debug{} << "Simulation while rendering:" << stepsPerSecond << "steps/s,"
+        << throughput << "% of standalone";
+
+    /* Check the limits only after everything is printed, so a failed run
+       still shows all numbers */
+    bool passed = true;
+    if(p99Interval > args.value<Double>("max-p99-interval")) {
+        Error{} << "FAIL: 99th percentile frame interval" << p99Interval
+            << "ms is above" << args.value<Double>("max-p99-interval") << "ms";
+        passed = false;
+    }
+    if(throughput < args.value<Double>("min-throughput")) {
+        Error{} << "FAIL: simulation throughput while rendering" << throughput
+            << "% is below" << args.value<Double>("min-throughput") << "%";
+        passed = false;
+    }
+    if(stepsPerSecond < args.value<Double>("min-steps-per-second")) {
+        Error{} << "FAIL: simulation while rendering did" << stepsPerSecond
+            << "steps/s, less than" << args.value<Double>("min-steps-per-second");
+        passed = false;
+    }
+
+    if(profile.isEmpty()) return passed ? 0 : 1;
+
+    /* Average time of each stage over the recorded steps, in the order the
+       stages first appear. With the busy time summed over all threads, a
+       ratio below the thread count means the threads wait on each other. */
+    const std::vector<Profiler::Event> events = solver.profiler().events();
+    std::vector<const char*> names;
+    std::vector<Double> durations, busyTimes;
+    std::vector<std::size_t> counts;
+    for(const Profiler::Event& event: events) {
+        if(event.type != Profiler::EventType::Stage) continue;
+        std::size_t i = 0;
+        while(i != names.size() && Containers::StringView{names[i]} != Containers::StringView{event.name}) ++i;
+        if(i == names.size()) {
+            names.push_back(event.name);
+            durations.push_back(0.0);
+            busyTimes.push_back(0.0);
+            counts.push_back(0);
+        }
+        durations[i] += event.duration;
+        for(const Double busyTime: event.threadBusyTime) busyTimes[i] += busyTime;
+        ++counts[i];
+    }
+    for(std::size_t i = 0; i != names.size(); ++i)
+        Debug{} << "  " << names[i] << Debug::nospace << ":" << durations[i]/Double(counts[i])
+            << "us on average, busy threads" << busyTimes[i]/durations[i];
+
+    if(!solver.profiler().exportChromeTrace(Utility::format("{}.json", profile)) ||
+       !solver.profiler().exportCsv(Utility::format("{}.csv", profile)))
+        return 1;
+    Debug{} << "Saved" << events.size() << "profiler events to" << profile << Debug::nospace << ".json and .csv";
+    return passed ? 0 : 1;
+}
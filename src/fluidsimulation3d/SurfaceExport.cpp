@@ -0,0 +1,131 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <chrono>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/Containers/String.h>
+#include <Corrade/Containers/StringView.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Format.h>
+#include <Magnum/Trade/AbstractSceneConverter.h>
+#include <Magnum/Trade/MeshData.h>
+
+#include "TaskScheduler.h"
+#include "DrawableObjects/SurfaceReconstruction.h"
+#include "SPH/SPHSolver.h"
+#include "SPH/SimulationThread.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+/* Runs the same scene as the example and saves the reconstructed fluid
+   surface after every frame, without any GPU. The surface is updated
+   incrementally from frame to frame, so mostly settled fluid gets exported
+   fast even with a million particles (--radius 0.005). */
+int main(int argc, char** argv) {
+    Utility::Arguments args;
+    args.addOption("frames", "100")
+            .setHelp("frames", "number of frames to export", "N")
+        .addOption("steps-per-frame", "10")
+            .setHelp("steps-per-frame", "simulation steps between exported frames", "N")
+        .addOption("threads", "0")
+            .setHelp("threads", "number of threads to use, 0 for all hardware threads", "N")
+        .addOption("radius", "0.02")
+            .setHelp("radius", "particle radius", "RADIUS")
+        .addOption("load")
+            .setHelp("load", "resume from a checkpoint instead of the initial state", "FILE")
+        .addOption("cell-size", "1")
+            .setHelp("cell-size", "grid cell size, relative to the particle radius", "SIZE")
+        .addOption("kernel-radius", "3")
+            .setHelp("kernel-radius", "splatting kernel radius, relative to the particle radius", "RADIUS")
+        .addOption("iso", "0.4")
+            .setHelp("iso", "iso value, relative to the rest density", "VALUE")
+        .addOption("output", "surface-{}.ply")
+            .setHelp("output", "output file, {} gets replaced with the frame number", "FILE")
+        .addOption("converter", "AnySceneConverter")
+            .setHelp("converter", "scene converter plugin to use")
+        .addBooleanOption("no-output")
+            .setHelp("no-output", "only reconstruct the surface, don't save anything")
+        .setGlobalHelp("Exports the surface of the 3D fluid simulation, headless.")
+        .parse(argc, argv);
+
+    const UnsignedLong frames = args.value<UnsignedLong>("frames");
+    const UnsignedLong stepsPerFrame = args.value<UnsignedLong>("steps-per-frame");
+    const Float particleRadius = args.value<Float>("radius");
+    if(!(particleRadius > 0.0f)) {
+        Error{} << "Invalid --radius";
+        return 1;
+    }
+
+    TaskScheduler::setThreadCount(args.value<std::size_t>("threads"));
+
+    SPHSolver solver{particleRadius};
+    solver.setPositions(initialParticlePositions(particleRadius));
+    SimulationThread simulation{solver, particleRadius};
+    const Containers::StringView load = args.value("load");
+    if(!load.isEmpty() && !simulation.loadCheckpoint(load))
+        return 2;
+
+    /* Same domain as in the example */
+    SurfaceReconstruction surface{particleRadius, Range3D{{}, {3.0f, 3.0f, 1.0f}}};
+    surface.setCellSize(args.value<Float>("cell-size")*particleRadius);
+    surface.setKernelRadius(args.value<Float>("kernel-radius")*particleRadius);
+    surface.setIsoValue(args.value<Float>("iso"));
+
+    Containers::Pointer<Trade::AbstractSceneConverter> converter;
+    PluginManager::Manager<Trade::AbstractSceneConverter> manager;
+    if(!args.isSet("no-output") && !(converter = manager.loadAndInstantiate(args.value("converter"))))
+        return 3;
+
+    Utility::print("particles {}\n", solver.numParticles());
+    for(UnsignedLong frame = 0; frame != frames; ++frame) {
+        if(frame) for(UnsignedLong i = 0; i != stepsPerFrame; ++i)
+            simulation.runFor(0.0);
+
+        /* Simulation is stepped on this thread, so the surface can use all
+           threads while it isn't */
+        const auto begin = std::chrono::steady_clock::now();
+        surface.update(solver.particlePositions());
+        const Trade::MeshData mesh = surface.mesh();
+        const Double seconds = std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count();
+
+        Utility::print("frame {}: {} triangles, {} of {} blocks remeshed in {} ms\n",
+            frame, surface.triangleCount(), surface.polygonizedBlockCount(),
+            surface.activeBlockCount(), seconds*1000.0);
+
+        if(converter) {
+            const Containers::String filename = Utility::format(args.value("output").data(), frame);
+            if(!converter->convertToFile(mesh, filename))
+                return 4;
+        }
+    }
+}
@@ -30,11 +30,18 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <chrono>
+#include <vector>
+#include <Magnum/Magnum.h>
+
 #include "configure.h"
 
 #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
     #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB
+    #include <Corrade/Containers/Pointer.h>
+    #include <tbb/global_control.h>
     #include <tbb/parallel_for.h>
+    #include <tbb/task_arena.h>
     #else
     #include "ThreadPool.h"
     #endif
@@ -42,22 +49,106 @@
 
 namespace Magnum { namespace Examples { namespace TaskScheduler {
 
+namespace Implementation {
+    inline bool& busyTimeTracking() {
+        static bool enabled = false;
+        return enabled;
+    }
+
+    #if !defined(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING) || defined(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB)
+    /* One entry per thread, with TBB indexed by the thread slot. Each is
+       written only by its own thread. */
+    inline std::vector<Double>& busyTime() {
+        static std::vector<Double> time;
+        return time;
+    }
+
+    inline Double secondsSince(const std::chrono::steady_clock::time_point begin) {
+        return std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count();
+    }
+    #endif
+}
+
+/* Parallel loops don't depend on the thread count in any way --- every
+   iteration writes only its own outputs and the few reductions that there
+   are are summed over fixed chunks in a fixed order. The results are thus
+   bit-identical whether they're computed on one thread or on sixty-four,
+   which allows to limit the count for reproducing or measuring things.
+
+   Zero means all hardware threads. Must not be called from inside
+   forEach(). */
+inline void setThreadCount(std::size_t count) {
+    #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
+    #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB
+    static Containers::Pointer<tbb::global_control> control;
+    control.reset();
+    if(count) control.reset(new tbb::global_control{
+        tbb::global_control::max_allowed_parallelism, count});
+    #else
+    ThreadPool::setUniqueInstanceThreadCount(count);
+    ThreadPool::getUniqueInstance().setBusyTimeTracking(Implementation::busyTimeTracking());
+    #endif
+    #else
+    static_cast<void>(count);
+    #endif
+}
+
+/* If enabled, forEach() measures how long each thread spent running its part
+   of the loop, otherwise it costs just a branch. Used by Profiler to see how
+   well the work is balanced across threads. Enabling resets the counters.
+   Must not be called from inside forEach(). */
+inline void setBusyTimeTracking(bool enabled) {
+    Implementation::busyTimeTracking() = enabled;
+    #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
+    #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB
+    Implementation::busyTime().assign(std::size_t(tbb::this_task_arena::max_concurrency()), 0.0);
+    #else
+    ThreadPool::getUniqueInstance().resetBusyTime();
+    ThreadPool::getUniqueInstance().setBusyTimeTracking(enabled);
+    #endif
+    #else
+    Implementation::busyTime().assign(1, 0.0);
+    #endif
+}
+
+inline bool isBusyTimeTracking() {
+    return Implementation::busyTimeTracking();
+}
+
+/* Busy time accumulated by each thread since the tracking was enabled, in
+   seconds */
+inline void busyTime(std::vector<Double>& out) {
+    #if defined(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING) && !defined(MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB)
+    const std::vector<Double>& time = ThreadPool::getUniqueInstance().busyTime();
+    #else
+    const std::vector<Double>& time = Implementation::busyTime();
+    #endif
+    out.assign(time.begin(), time.end());
+}
+
 template<class IndexType, class Function> void forEach(IndexType endIdx, Function&& func) {
     #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_MULTITHREADING
     #ifdef MAGNUM_FLUIDSIMULATION3D_EXAMPLE_USE_TBB
+    const bool trackBusyTime = Implementation::busyTimeTracking();
     tbb::parallel_for(tbb::blocked_range<IndexType>(IndexType(0), endIdx),
         [&](const tbb::blocked_range<IndexType>& r) {
+            const auto begin = trackBusyTime ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
             for(IndexType i = r.begin(), iEnd = r.end(); i < iEnd; ++i) {
                 func(i);
             }
+            if(trackBusyTime)
+                Implementation::busyTime()[std::size_t(tbb::this_task_arena::current_thread_index())] += Implementation::secondsSince(begin);
         });
     #else
     ThreadPool::getUniqueInstance().parallel_for(endIdx, std::forward<Function>(func));
     #endif
     #else
+    const auto begin = Implementation::busyTimeTracking() ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
     for(IndexType idx = 0; idx < endIdx; ++idx) {
         func(idx);
     }
+    if(Implementation::busyTimeTracking())
+        Implementation::busyTime()[0] += Implementation::secondsSince(begin);
     #endif
 }
 
@@ -30,12 +30,14 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
  */
 
+#include <chrono>
 #include <vector>
 #include <thread>
 #include <mutex>
 #include <condition_variable>
 #include <functional>
 #include <atomic>
+#include <Corrade/Containers/Pointer.h>
 #include <Magnum/Math/Functions.h>
 
 namespace Magnum { namespace Examples {
@@ -45,12 +47,15 @@ namespace Magnum { namespace Examples {
    see TaskScheduler.h. */
 class ThreadPool {
     public:
-        ThreadPool() {
-            const Int maxNumThreads = Int(std::thread::hardware_concurrency());
+        /* Zero thread count means all hardware threads. The calling thread
+           counts as one, so there's one worker less. */
+        explicit ThreadPool(std::size_t numThreads = 0) {
+            const Int maxNumThreads = numThreads ? Int(numThreads) : Int(std::thread::hardware_concurrency());
             std::size_t nWorkers = std::size_t(maxNumThreads > 1 ? maxNumThreads - 1 : 0);
 
             _threadTaskReady.resize(nWorkers, 0);
             _tasks.resize(nWorkers + 1);
+            _busyTime.resize(nWorkers + 1, 0.0);
 
             for(std::size_t threadIdx = 0; threadIdx < nWorkers; ++threadIdx) {
                 _workerThreads.emplace_back([threadIdx, this] {
@@ -97,10 +102,13 @@ class ThreadPool {
                     const std::size_t chunkEnd = Math::min(chunkStart + chunkSize, size);
 
                     /* Must copy func into local lambda's variable */
-                    _tasks[threadIdx] = [chunkStart, chunkEnd, func] {
+                    _tasks[threadIdx] = [this, threadIdx, chunkStart, chunkEnd, func] {
+                        const auto begin = _trackBusyTime ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
                         for(uint64_t idx = chunkStart; idx < chunkEnd; ++idx) {
                             func(idx);
                         }
+                        if(_trackBusyTime)
+                            _busyTime[threadIdx] += std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count();
                     };
                 }
 
@@ -118,16 +126,42 @@ class ThreadPool {
                 /* Wait until all worker threads finish */
                 while(_numBusyThreads.load() > 0) {}
 
-            } else for(std::size_t idx = 0; idx < size; ++idx)
-                func(idx);
+            } else {
+                const auto begin = _trackBusyTime ? std::chrono::steady_clock::now() : std::chrono::steady_clock::time_point{};
+                for(std::size_t idx = 0; idx < size; ++idx)
+                    func(idx);
+                if(_trackBusyTime)
+                    _busyTime[0] += std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count();
+            }
         }
 
+        /* If enabled, parallel_for() measures how long each thread spent
+           running its chunk. Must not be toggled while parallel_for() is
+           running. */
+        bool isBusyTimeTracking() const { return _trackBusyTime; }
+        void setBusyTimeTracking(bool enabled) { _trackBusyTime = enabled; }
+        void resetBusyTime() { _busyTime.assign(_busyTime.size(), 0.0); }
+
+        /* Accumulated busy time of each thread in seconds, the calling
+           thread is the last */
+        const std::vector<Double>& busyTime() const { return _busyTime; }
+
         static ThreadPool& getUniqueInstance() {
-            static ThreadPool threadPool;
-            return threadPool;
+            return *uniqueInstance();
+        }
+
+        /* Replace the unique instance with one using given number of
+           threads. Must not be called while parallel_for() is running. */
+        static void setUniqueInstanceThreadCount(std::size_t numThreads) {
+            uniqueInstance().reset(new ThreadPool{numThreads});
         }
 
     private:
+        static Containers::Pointer<ThreadPool>& uniqueInstance() {
+            static Containers::Pointer<ThreadPool> threadPool{new ThreadPool};
+            return threadPool;
+        }
+
         std::atomic<int> _numBusyThreads{0};
         /* Do not use std::vector<bool>: it's not threadsafe */
         std::vector<int> _threadTaskReady;
@@ -137,6 +171,10 @@ class ThreadPool {
         std::mutex _taskMutex;
         std::condition_variable _condition;
         bool _bStop = false;
+
+        bool _trackBusyTime = false;
+        /* Each written only by its own thread */
+        std::vector<Double> _busyTime;
 };
 
 }}
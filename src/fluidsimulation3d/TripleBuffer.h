@@ -0,0 +1,87 @@
+#ifndef Magnum_Examples_FluidSimulation3D_TripleBuffer_h
+#define Magnum_Examples_FluidSimulation3D_TripleBuffer_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2019 — Nghia Truong <nghiatruong.vn@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+#include <atomic>
+#include <Magnum/Magnum.h>
+
+namespace Magnum { namespace Examples {
+
+/* Lock-free single-producer single-consumer triple buffer. The producer
+   fills writeBuffer() and publishes it, the consumer picks up the latest
+   published buffer with update() and reads it through readBuffer(). Neither
+   side ever waits for the other, a buffer that was published but not picked
+   up before the next publish() is simply dropped. */
+template<class T> class TripleBuffer {
+    public:
+        /* Producer side */
+
+        T& writeBuffer() { return _buffers[_writeIdx]; }
+
+        /* Make the write buffer the latest published buffer, getting the
+           previous middle buffer for writing */
+        void publish() {
+            _writeIdx = _middle.exchange(_writeIdx | FreshBit, std::memory_order_acq_rel) & IndexMask;
+        }
+
+        /* Consumer side */
+
+        /* Acquire the latest published buffer, if there's any newer than
+           the current read buffer. Returns true if the read buffer
+           changed. */
+        bool update() {
+            if(!(_middle.load(std::memory_order_relaxed) & FreshBit))
+                return false;
+            _readIdx = _middle.exchange(_readIdx, std::memory_order_acq_rel) & IndexMask;
+            return true;
+        }
+
+        const T& readBuffer() const { return _buffers[_readIdx]; }
+
+    private:
+        enum: UnsignedInt {
+            IndexMask = 3,
+            /* Set on the middle index if it wasn't picked up by the consumer
+               yet */
+            FreshBit = 4
+        };
+
+        T _buffers[3];
+        /* Each index is touched only by one side, the middle one is
+           exchanged between them */
+        UnsignedInt _writeIdx = 0;
+        UnsignedInt _readIdx = 1;
+        std::atomic<UnsignedInt> _middle{2};
+};
+
+}}
+
+#endif
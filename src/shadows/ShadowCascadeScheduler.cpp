@@ -0,0 +1,87 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ShadowCascadeScheduler.h"
+
+#include <algorithm>
+
+namespace Magnum { namespace Examples {
+
+void ShadowCascadeScheduler::setLayerCount(const std::size_t count) {
+    _layers.assign(count, Layer{});
+}
+
+void ShadowCascadeScheduler::invalidateAll() {
+    for(Layer& layer: _layers) layer.cacheValid = false;
+}
+
+void ShadowCascadeScheduler::schedule() {
+    ++_frame;
+
+    /* Near layers and layers with an invalid cache are updated right away,
+       as with a changed projection the old content is useless */
+    _candidates.clear();
+    for(std::size_t i = 0; i != _layers.size(); ++i) {
+        Layer& layer = _layers[i];
+        layer.update = Update::None;
+        if(!layer.cacheValid)
+            layer.update = Update::Full;
+        else if(layer.dynamicCasters || layer.dynamicCastersDrawn) {
+            if(i < _fullRateLayerCount) layer.update = Update::Dynamic;
+            else _candidates.push_back(i);
+        }
+    }
+
+    /* From the far layers pick the ones that waited the longest */
+    const std::size_t count = std::min(_candidates.size(), _farUpdatesPerFrame);
+    std::partial_sort(_candidates.begin(), _candidates.begin() + count, _candidates.end(),
+        [this](std::size_t a, std::size_t b) {
+            return _layers[a].lastUpdateFrame < _layers[b].lastUpdateFrame ||
+                (_layers[a].lastUpdateFrame == _layers[b].lastUpdateFrame && a < b);
+        });
+    for(std::size_t i = 0; i != count; ++i)
+        _layers[_candidates[i]].update = Update::Dynamic;
+
+    for(Layer& layer: _layers) {
+        if(layer.update == Update::None) continue;
+        layer.cacheValid = true;
+        layer.dynamicCastersDrawn = layer.dynamicCasters;
+        layer.lastUpdateFrame = _frame;
+    }
+}
+
+std::size_t ShadowCascadeScheduler::updateCount(const Update update) const {
+    std::size_t count = 0;
+    for(const Layer& layer: _layers)
+        if(layer.update == update) ++count;
+    return count;
+}
+
+}}
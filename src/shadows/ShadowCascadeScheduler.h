@@ -0,0 +1,108 @@
+#ifndef Magnum_Examples_Shadows_ShadowCascadeScheduler_h
+#define Magnum_Examples_Shadows_ShadowCascadeScheduler_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Magnum/Magnum.h>
+
+namespace Magnum { namespace Examples {
+
+/* Decides which shadow map layers need to be drawn again in a frame. Each
+   layer has a cache with just the static casters, which is valid until the
+   layer projection changes or a static caster in it moves. Dynamic casters
+   are drawn on top of a copy of the cache. Near layers get that every frame
+   they contain dynamic casters, far layers take turns, at most a given
+   count of them per frame, so dynamic shadows far away lag a few frames
+   behind. Has no GL dependency, the caller does the actual drawing. */
+class ShadowCascadeScheduler {
+    public:
+        enum class Update: UnsignedByte {
+            /* Layer is up to date or can wait */
+            None,
+            /* Copy the static cache to the layer and draw dynamic casters on
+               top */
+            Dynamic,
+            /* Draw static casters into the cache first, then the same as
+               Dynamic */
+            Full
+        };
+
+        /* Layers below fullRateLayerCount are updated every frame they need
+           to */
+        explicit ShadowCascadeScheduler(std::size_t fullRateLayerCount = 1, std::size_t farUpdatesPerFrame = 1): _fullRateLayerCount{fullRateLayerCount}, _farUpdatesPerFrame{farUpdatesPerFrame} {}
+
+        std::size_t layerCount() const { return _layers.size(); }
+
+        /* Resets the state, all layers need a full update */
+        void setLayerCount(std::size_t count);
+
+        /* The layer projection changed or a static caster in it moved, the
+           cache has to be drawn again */
+        void invalidate(std::size_t layer) { _layers[layer].cacheValid = false; }
+        void invalidateAll();
+        bool isCacheValid(std::size_t layer) const { return _layers[layer].cacheValid; }
+
+        /* Whether there are dynamic casters in the layer this frame */
+        void setDynamicCasters(std::size_t layer, bool present) {
+            _layers[layer].dynamicCasters = present;
+        }
+
+        /* Decides updates of all layers for the next frame and assumes the
+           caller does them */
+        void schedule();
+
+        std::size_t frame() const { return _frame; }
+        Update update(std::size_t layer) const { return _layers[layer].update; }
+        std::size_t lastUpdateFrame(std::size_t layer) const { return _layers[layer].lastUpdateFrame; }
+
+        /* Count of layers with given update in the last schedule() */
+        std::size_t updateCount(Update update) const;
+
+    private:
+        struct Layer {
+            bool cacheValid = false;
+            bool dynamicCasters = false;
+            /* The layer has dynamic casters drawn in it, which means it
+               needs an update even if they all left */
+            bool dynamicCastersDrawn = false;
+            Update update = Update::None;
+            std::size_t lastUpdateFrame = 0;
+        };
+
+        std::size_t _fullRateLayerCount, _farUpdatesPerFrame;
+        std::size_t _frame = 0;
+        std::vector<Layer> _layers;
+        std::vector<std::size_t> _candidates;
+};
+
+}}
+
+#endif
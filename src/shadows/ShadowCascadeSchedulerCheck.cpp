@@ -0,0 +1,114 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <Corrade/Utility/Debug.h>
+
+#include "ShadowCascadeScheduler.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+constexpr std::size_t LayerCount = 4;
+
+bool check(const bool condition, const char* message, const std::size_t frame) {
+    if(!condition) Error{} << message << "in frame" << frame;
+    return condition;
+}
+
+}
+
+/* Checks which shadow map layers get updated when dynamic casters move
+   through them, without a window or GPU. The first layer is updated every
+   frame, the far ones take turns, one per frame. Exits with a non-zero code
+   on a mismatch. */
+int main() {
+    ShadowCascadeScheduler scheduler{1, 1};
+    scheduler.setLayerCount(LayerCount);
+
+    bool passed = true;
+
+    /* Everything has to be drawn first */
+    scheduler.schedule();
+    passed = check(scheduler.updateCount(ShadowCascadeScheduler::Update::Full) == LayerCount,
+        "Not all layers got a full update", scheduler.frame()) && passed;
+
+    /* Nothing moves, nothing gets drawn */
+    scheduler.schedule();
+    passed = check(scheduler.updateCount(ShadowCascadeScheduler::Update::None) == LayerCount,
+        "A layer with no dynamic casters got updated", scheduler.frame()) && passed;
+
+    /* Dynamic casters in all layers. The near layer is updated every frame
+       and each far layer waits at most as many frames as there are far
+       layers. */
+    for(std::size_t layer = 0; layer != LayerCount; ++layer)
+        scheduler.setDynamicCasters(layer, true);
+    for(std::size_t i = 0; i != 3*(LayerCount - 1); ++i) {
+        scheduler.schedule();
+        const std::size_t frame = scheduler.frame();
+        passed = check(scheduler.update(0) == ShadowCascadeScheduler::Update::Dynamic,
+            "The near layer didn't get a dynamic update", frame) && passed;
+        passed = check(scheduler.updateCount(ShadowCascadeScheduler::Update::Dynamic) == 2,
+            "Not exactly one far layer got a dynamic update", frame) && passed;
+        passed = check(scheduler.updateCount(ShadowCascadeScheduler::Update::Full) == 0,
+            "A layer with a valid cache got a full update", frame) && passed;
+        for(std::size_t layer = 1; layer != LayerCount; ++layer)
+            passed = check(frame - scheduler.lastUpdateFrame(layer) <= LayerCount - 1,
+                "A far layer waited too long", frame) && passed;
+    }
+
+    /* The casters leave the last layer, it still has to be drawn once more
+       to remove them and then it's left alone. Run enough frames for it to
+       get its turn. */
+    scheduler.setDynamicCasters(LayerCount - 1, false);
+    std::size_t lastLayerUpdates = 0;
+    for(std::size_t i = 0; i != 2*(LayerCount - 1); ++i) {
+        scheduler.schedule();
+        if(scheduler.update(LayerCount - 1) != ShadowCascadeScheduler::Update::None)
+            ++lastLayerUpdates;
+    }
+    passed = check(lastLayerUpdates == 1,
+        "A layer the dynamic casters left didn't get exactly one update", scheduler.frame()) && passed;
+
+    /* A static caster moved in a far layer, its cache has to be drawn again
+       right away even though it's not its turn */
+    scheduler.invalidate(1);
+    scheduler.schedule();
+    passed = check(scheduler.update(1) == ShadowCascadeScheduler::Update::Full,
+        "An invalidated far layer didn't get a full update", scheduler.frame()) && passed;
+    passed = check(scheduler.isCacheValid(1),
+        "The cache isn't valid after a full update", scheduler.frame()) && passed;
+
+    if(!passed) return 1;
+
+    Debug{} << "Shadow layer updates follow the schedule";
+    return 0;
+}
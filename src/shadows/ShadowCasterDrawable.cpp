@@ -36,7 +36,14 @@
 
 namespace Magnum { namespace Examples {
 
-ShadowCasterDrawable::ShadowCasterDrawable(SceneGraph::AbstractObject3D& parent, SceneGraph::DrawableGroup3D* drawables): Magnum::SceneGraph::Drawable3D{parent, drawables} {}
+ShadowCasterDrawable::ShadowCasterDrawable(SceneGraph::AbstractObject3D& parent, SceneGraph::DrawableGroup3D* drawables): Magnum::SceneGraph::Drawable3D{parent, drawables} {
+    setCachedTransformations(SceneGraph::CachedTransformation::Absolute);
+}
+
+void ShadowCasterDrawable::clean(const Matrix4& absoluteTransformationMatrix) {
+    _absoluteTransformation = absoluteTransformationMatrix;
+    _moved = true;
+}
 
 void ShadowCasterDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& shadowCamera) {
     (*_shader)
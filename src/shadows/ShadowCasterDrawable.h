@@ -31,6 +31,7 @@
 */
 
 #include <Magnum/GL/Mesh.h>
+#include <Magnum/Math/Matrix4.h>
 #include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/Object.h>
 
@@ -46,6 +47,7 @@ class ShadowCasterDrawable: public SceneGraph::Drawable3D {
         void setMesh(GL::Mesh& mesh, Float radius) {
             _mesh = &mesh;
             _radius = radius;
+            _moved = true;
         }
 
         void setShader(ShadowCasterShader& shader) {
@@ -54,12 +56,46 @@ class ShadowCasterDrawable: public SceneGraph::Drawable3D {
 
         Float radius() const { return _radius; }
 
+        /**
+         * @brief Mark the caster as static
+         *
+         * Static casters are cached by @ref ShadowLight and moving them
+         * means the layers they're in have to be drawn again, so it should
+         * be used for objects that move rarely or never. Default is
+         * @cpp false @ce.
+         */
+        void setStatic(bool isStatic) {
+            _static = isStatic;
+            _moved = true;
+        }
+
+        bool isStatic() const { return _static; }
+
+        /**
+         * @brief Absolute transformation
+         *
+         * Updated every time the object gets cleaned, which is done by
+         * @ref ShadowLight::render().
+         */
+        const Matrix4& absoluteTransformation() const {
+            return _absoluteTransformation;
+        }
+
+        /** @brief Whether the object moved or the mesh changed since last reset */
+        bool hasMoved() const { return _moved; }
+        void resetMoved() { _moved = false; }
+
         void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& shadowCamera) override;
 
     private:
+        void clean(const Matrix4& absoluteTransformationMatrix) override;
+
         GL::Mesh* _mesh{};
         ShadowCasterShader* _shader{};
         Float _radius;
+        Matrix4 _absoluteTransformation;
+        bool _moved = true;
+        bool _static = false;
 };
 
 }}
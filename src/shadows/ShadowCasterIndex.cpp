@@ -0,0 +1,198 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "ShadowCasterIndex.h"
+
+#include <algorithm>
+#include <numeric>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Constants.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Magnum { namespace Examples {
+
+void ShadowCasterIndex::setSphereCount(const std::size_t count) {
+    _centers.resize(count);
+    _radii.resize(count);
+    _dirty.clear();
+    _dirtyFlags.assign(count, 0);
+    _needsRebuild = true;
+}
+
+void ShadowCasterIndex::setSphere(const std::size_t id, const Vector3& center, const Float radius) {
+    _centers[id] = center;
+    _radii[id] = radius;
+    if(_dirtyFlags[id]) return;
+    _dirtyFlags[id] = 1;
+    _dirty.push_back(UnsignedInt(id));
+}
+
+void ShadowCasterIndex::update() {
+    _lastUpdateCount = _dirty.size();
+    _lastUpdateRebuilt = false;
+
+    /* Refitting keeps the original split, which gets worse the more the
+       spheres move around. Build from scratch once half of them moved since
+       the last build. */
+    _refittedCount += _dirty.size();
+    if(_needsRebuild || _refittedCount > _radii.size()/2) {
+        _ids.resize(_radii.size());
+        std::iota(_ids.begin(), _ids.end(), 0);
+        _leaves.resize(_radii.size());
+        _nodes.clear();
+        _parents.clear();
+        if(!_ids.empty()) build(0, UnsignedInt(_ids.size()), ~UnsignedInt{});
+        _needsRebuild = false;
+        _lastUpdateRebuilt = true;
+        _refittedCount = 0;
+    } else for(const UnsignedInt id: _dirty) refit(id);
+
+    for(const UnsignedInt id: _dirty) _dirtyFlags[id] = 0;
+    _dirty.clear();
+}
+
+void ShadowCasterIndex::leafBounds(Node& node) const {
+    node.min = Vector3{Constants::inf()};
+    node.max = Vector3{-Constants::inf()};
+    for(UnsignedInt i = node.first; i != node.first + node.count; ++i) {
+        const UnsignedInt id = _ids[i];
+        node.min = Math::min(node.min, _centers[id] - Vector3{_radii[id]});
+        node.max = Math::max(node.max, _centers[id] + Vector3{_radii[id]});
+    }
+}
+
+UnsignedInt ShadowCasterIndex::build(const UnsignedInt begin, const UnsignedInt end, const UnsignedInt parent) {
+    const UnsignedInt index = UnsignedInt(_nodes.size());
+    _nodes.push_back(Node{{}, {}, begin, end - begin});
+    _parents.push_back(parent);
+
+    if(end - begin <= LeafSize) {
+        leafBounds(_nodes[index]);
+        for(UnsignedInt i = begin; i != end; ++i) _leaves[_ids[i]] = index;
+        return index;
+    }
+
+    /* Split at the median along the axis where the centers are spread the
+       most, which keeps the tree balanced */
+    Vector3 min{Constants::inf()}, max{-Constants::inf()};
+    for(UnsignedInt i = begin; i != end; ++i) {
+        min = Math::min(min, _centers[_ids[i]]);
+        max = Math::max(max, _centers[_ids[i]]);
+    }
+    const Vector3 extent = max - min;
+    const std::size_t axis = extent.x() >= extent.y() && extent.x() >= extent.z() ? 0 :
+        extent.y() >= extent.z() ? 1 : 2;
+    const UnsignedInt middle = begin + (end - begin)/2;
+    std::nth_element(_ids.begin() + begin, _ids.begin() + middle, _ids.begin() + end,
+        [this, axis](UnsignedInt a, UnsignedInt b) {
+            return _centers[a][axis] < _centers[b][axis];
+        });
+
+    /* The left child is right after this node, so only the right one needs
+       to be remembered. The vector may get reallocated in the meantime, so
+       no references are kept. */
+    build(begin, middle, index);
+    const UnsignedInt right = build(middle, end, index);
+    Node& node = _nodes[index];
+    node.first = right;
+    node.count = 0;
+    node.min = Math::min(_nodes[index + 1].min, _nodes[right].min);
+    node.max = Math::max(_nodes[index + 1].max, _nodes[right].max);
+    return index;
+}
+
+void ShadowCasterIndex::refit(const UnsignedInt id) {
+    UnsignedInt index = _leaves[id];
+    leafBounds(_nodes[index]);
+
+    /* Propagate up until the root or until a box stays the same */
+    while((index = _parents[index]) != ~UnsignedInt{}) {
+        Node& node = _nodes[index];
+        const Vector3 min = Math::min(_nodes[index + 1].min, _nodes[node.first].min);
+        const Vector3 max = Math::max(_nodes[index + 1].max, _nodes[node.first].max);
+        if(min == node.min && max == node.max) break;
+        node.min = min;
+        node.max = max;
+    }
+}
+
+void ShadowCasterIndex::query(const Containers::ArrayView<const Vector4> planes, std::vector<UnsignedInt>& ids) const {
+    CORRADE_INTERNAL_ASSERT(planes.size() <= 32);
+    if(_nodes.empty()) return;
+
+    /* Each entry has a mask of planes that still need to be tested, planes
+       that contain the whole node are not tested for its children anymore.
+       The tree is balanced, so the depth is at most log2 of the node
+       count. */
+    struct Entry {
+        UnsignedInt node, planes;
+    } stack[64];
+    std::size_t top = 0;
+    stack[top++] = Entry{0, planes.size() == 32 ? ~UnsignedInt{} : (1u << planes.size()) - 1};
+
+    while(top) {
+        const Entry entry = stack[--top];
+        const Node& node = _nodes[entry.node];
+
+        const Vector3 center = (node.min + node.max)*0.5f;
+        const Vector3 halfSize = (node.max - node.min)*0.5f;
+        UnsignedInt mask = entry.planes;
+        bool outside = false;
+        for(std::size_t i = 0; i != planes.size(); ++i) {
+            if(!(mask & (1u << i))) continue;
+            const Float distance = Math::dot(planes[i].xyz(), center) + planes[i].w();
+            const Float reach = Math::dot(Math::abs(planes[i].xyz()), halfSize);
+            if(distance < -reach) {
+                outside = true;
+                break;
+            }
+            if(distance >= reach) mask &= ~(1u << i);
+        }
+        if(outside) continue;
+
+        if(!node.count) {
+            CORRADE_INTERNAL_ASSERT(top + 2 <= Containers::arraySize(stack));
+            stack[top++] = Entry{node.first, mask};
+            stack[top++] = Entry{entry.node + 1, mask};
+            continue;
+        }
+
+        for(UnsignedInt i = node.first; i != node.first + node.count; ++i) {
+            const UnsignedInt id = _ids[i];
+            bool visible = true;
+            for(std::size_t j = 0; j != planes.size() && visible; ++j)
+                if(mask & (1u << j))
+                    visible = Math::dot(planes[j].xyz(), _centers[id]) + planes[j].w() >= -_radii[id];
+            if(visible) ids.push_back(id);
+        }
+    }
+}
+
+}}
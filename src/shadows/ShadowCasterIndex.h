@@ -0,0 +1,115 @@
+#ifndef Magnum_Examples_Shadows_ShadowCasterIndex_h
+#define Magnum_Examples_Shadows_ShadowCasterIndex_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+        2016 — Bill Robinson <airbaggins@gmail.com>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Vector4.h>
+
+namespace Magnum { namespace Examples {
+
+/* Bounding volume hierarchy over shadow caster bounding spheres, used to
+   find casters that intersect a shadow cascade without testing all of them.
+   Nodes are axis-aligned boxes stored in depth-first order, with the left
+   child right after its parent. When only a few spheres move, the boxes are
+   just refitted bottom-up, the tree is built again only when the sphere
+   count changes or too many spheres moved since the last build. */
+class ShadowCasterIndex {
+    public:
+        /* Max spheres in a leaf */
+        enum: UnsignedInt { LeafSize = 4 };
+
+        std::size_t sphereCount() const { return _radii.size(); }
+
+        /* Resizes the sphere arrays, new spheres have a zero radius at the
+           origin. The tree gets rebuilt on next update(). */
+        void setSphereCount(std::size_t count);
+
+        void setSphere(std::size_t id, const Vector3& center, Float radius);
+
+        const Vector3& center(std::size_t id) const { return _centers[id]; }
+        Float radius(std::size_t id) const { return _radii[id]; }
+
+        /* Rebuilds or refits the tree if any sphere changed since the last
+           call, does nothing otherwise */
+        void update();
+
+        std::size_t nodeCount() const { return _nodes.size(); }
+
+        /* Number of spheres that changed before the last update() and
+           whether it built the whole tree again */
+        std::size_t lastUpdateCount() const { return _lastUpdateCount; }
+        bool lastUpdateRebuilt() const { return _lastUpdateRebuilt; }
+
+        /* Appends IDs of spheres that aren't completely on the negative side
+           of any of the planes to ids, in no particular order. The planes
+           are expected to be normalized and pointing inside, at most 32 of
+           them. Has to be called after update(). */
+        void query(Containers::ArrayView<const Vector4> planes, std::vector<UnsignedInt>& ids) const;
+
+    private:
+        struct Node {
+            Vector3 min, max;
+            /* For leaves a range in _ids, for inner nodes count is zero and
+               first is the right child */
+            UnsignedInt first, count;
+        };
+
+        UnsignedInt build(UnsignedInt begin, UnsignedInt end, UnsignedInt parent);
+        void leafBounds(Node& node) const;
+        /* Updates the leaf containing given sphere and boxes above it */
+        void refit(UnsignedInt id);
+
+        std::vector<Vector3> _centers;
+        std::vector<Float> _radii;
+
+        std::vector<Node> _nodes;
+        /* Parent of each node, ~0 for the root */
+        std::vector<UnsignedInt> _parents;
+        /* Sphere IDs ordered by the leaves they're in */
+        std::vector<UnsignedInt> _ids;
+        /* Leaf node of each sphere */
+        std::vector<UnsignedInt> _leaves;
+
+        /* Spheres changed since the last update(), deduplicated through the
+           flags */
+        std::vector<UnsignedInt> _dirty;
+        std::vector<char> _dirtyFlags;
+        bool _needsRebuild = true;
+        std::size_t _refittedCount = 0;
+        std::size_t _lastUpdateCount = 0;
+        bool _lastUpdateRebuilt = false;
+};
+
+}}
+
+#endif
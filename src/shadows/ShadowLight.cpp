@@ -31,6 +31,7 @@
 #include "ShadowLight.h"
 
 #include <algorithm>
+#include <iterator>
 #include <limits>
 #include <Magnum/ImageView.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
@@ -45,7 +46,24 @@
 
 namespace Magnum { namespace Examples {
 
-ShadowLight::ShadowLight(SceneGraph::Object<SceneGraph::MatrixTransformation3D>& parent): SceneGraph::Camera3D{parent}, _object(parent), _shadowTexture{NoCreate} {
+namespace {
+
+/* Fraction of the frustum slice size added on each side when fitting a
+   layer. More means fewer refits when the camera moves but less shadow map
+   resolution. */
+constexpr Float CascadePadding = 0.1f;
+
+/* Skips the near plane, same as the caster query */
+bool intersects(const Vector4(&planes)[6], const Vector3& center, const Float radius) {
+    for(std::size_t i = 1; i != 6; ++i)
+        if(Math::dot(planes[i].xyz(), center) + planes[i].w() < -radius)
+            return false;
+    return true;
+}
+
+}
+
+ShadowLight::ShadowLight(SceneGraph::Object<SceneGraph::MatrixTransformation3D>& parent): SceneGraph::Camera3D{parent}, _object(parent), _shadowTexture{NoCreate}, _staticShadowTexture{NoCreate} {
     setAspectRatioPolicy(SceneGraph::AspectRatioPolicy::NotPreserved);
 }
 
@@ -60,6 +78,13 @@ void ShadowLight::setupShadowmaps(Int numShadowLevels, const Vector2i& size) {
         .setMinificationFilter(GL::SamplerFilter::Linear, GL::SamplerMipmap::Base)
         .setMagnificationFilter(GL::SamplerFilter::Linear);
 
+    /* Only ever copied from, has to have the same format for the blit */
+    (_staticShadowTexture = GL::Texture2DArray{})
+        .setImage(0, GL::TextureFormat::DepthComponent, ImageView3D{GL::PixelFormat::DepthComponent, GL::PixelType::Float, {size, numShadowLevels}})
+        .setMaxLevel(0)
+        .setMinificationFilter(GL::SamplerFilter::Nearest, GL::SamplerMipmap::Base)
+        .setMagnificationFilter(GL::SamplerFilter::Nearest);
+
     for(std::int_fast32_t i = 0; i < numShadowLevels; ++i) {
         _layers.emplace_back(size);
         GL::Framebuffer& shadowFramebuffer = _layers.back().shadowFramebuffer;
@@ -67,10 +92,17 @@ void ShadowLight::setupShadowmaps(Int numShadowLevels, const Vector2i& size) {
             .mapForDraw(GL::Framebuffer::DrawAttachment::None)
             .bind();
         CORRADE_INTERNAL_ASSERT(shadowFramebuffer.checkStatus(GL::FramebufferTarget::Draw) == GL::Framebuffer::Status::Complete);
+        GL::Framebuffer& staticFramebuffer = _layers.back().staticFramebuffer;
+        staticFramebuffer.attachTextureLayer(GL::Framebuffer::BufferAttachment::Depth, _staticShadowTexture, 0, i)
+            .mapForDraw(GL::Framebuffer::DrawAttachment::None)
+            .bind();
+        CORRADE_INTERNAL_ASSERT(staticFramebuffer.checkStatus(GL::FramebufferTarget::Draw) == GL::Framebuffer::Status::Complete);
     }
+
+    _scheduler.setLayerCount(_layers.size());
 }
 
-ShadowLight::ShadowLayerData::ShadowLayerData(const Vector2i& size): shadowFramebuffer{{{}, size}} {}
+ShadowLight::ShadowLayerData::ShadowLayerData(const Vector2i& size): shadowFramebuffer{{{}, size}}, staticFramebuffer{{{}, size}} {}
 
 void ShadowLight::setTarget(const Vector3& lightDirection, const Vector3& screenDirection, SceneGraph::Camera3D& mainCamera) {
     Matrix4 cameraMatrix = Matrix4::lookAt({}, -lightDirection, screenDirection);
@@ -89,6 +121,19 @@ void ShadowLight::setTarget(const Vector3& lightDirection, const Vector3& screen
             max = Math::max(max, cameraPoint);
         }
 
+        /* Keep the layer while the frustum slice stays inside the padded
+           box it was fitted to, small camera movements then don't need the
+           static casters drawn again */
+        if(layer.fitted && layer.shadowCameraMatrix.rotationScaling() == cameraMatrix.rotationScaling() && (min >= layer.boxMin).all() && (max <= layer.boxMax).all())
+            continue;
+
+        const Vector3 padding = (max - min)*CascadePadding;
+        min -= padding;
+        max += padding;
+        layer.boxMin = min;
+        layer.boxMax = max;
+        layer.fitted = true;
+
         /* Place the shadow camera at the mid-point of the camera box */
         const Vector3 mid = (min + max)*0.5f;
         const Vector3 cameraPosition = cameraRotationMatrix*mid;
@@ -101,6 +146,11 @@ void ShadowLight::setTarget(const Vector3& lightDirection, const Vector3& screen
         layer.orthographicFar =  0.5f*range.z();
         cameraMatrix.translation() = cameraPosition;
         layer.shadowCameraMatrix = cameraMatrix;
+
+        /* World-space planes for picking casters. The near plane isn't used
+           so it doesn't matter that it gets extended later. */
+        calculateClipPlanes(Matrix4::orthographicProjection(layer.orthographicSize, layer.orthographicNear, layer.orthographicFar)*cameraMatrix.invertedRigid(), layer.clipPlanes);
+        _scheduler.invalidate(layerIndex);
     }
 }
 
@@ -114,6 +164,9 @@ void ShadowLight::setupSplitDistances(const Float zNear, const Float zFar, const
         const Float linearDepth = zNear + std::pow(Float(i + 1)/_layers.size(), power)*(zFar - zNear);
         const Float nonLinearDepth = (zFar + zNear - 2.0f*zNear*zFar/linearDepth)/(zFar - zNear);
         _layers[i].cutPlane = (nonLinearDepth + 1.0f)/2.0f;
+        /* Fit the layer again in next setTarget(), a smaller slice would
+           still fit into the old box but waste resolution */
+        _layers[i].fitted = false;
     }
 }
 
@@ -146,26 +199,107 @@ std::vector<Vector3> ShadowLight::frustumCorners(const Matrix4& imvp, const Floa
 }
 
 std::vector<Vector4> ShadowLight::calculateClipPlanes() {
-    const Matrix4 pm = projectionMatrix();
-    std::vector<Vector4> clipPlanes{
-        {pm[3][0] + pm[2][0], pm[3][1] + pm[2][1], pm[3][2] + pm[2][2], pm[3][3] + pm[2][3]},   /* near */
-        {pm[3][0] - pm[2][0], pm[3][1] - pm[2][1], pm[3][2] - pm[2][2], pm[3][3] - pm[2][3]},   /* far */
-        {pm[3][0] + pm[0][0], pm[3][1] + pm[0][1], pm[3][2] + pm[0][2], pm[3][3] + pm[0][3]},   /* left */
-        {pm[3][0] - pm[0][0], pm[3][1] - pm[0][1], pm[3][2] - pm[0][2], pm[3][3] - pm[0][3]},   /* right */
-        {pm[3][0] + pm[1][0], pm[3][1] + pm[1][1], pm[3][2] + pm[1][2], pm[3][3] + pm[1][3]},   /* bottom */
-        {pm[3][0] - pm[1][0], pm[3][1] - pm[1][1], pm[3][2] - pm[1][2], pm[3][3] - pm[1][3]}};  /* top */
+    Vector4 clipPlanes[6];
+    calculateClipPlanes(projectionMatrix(), clipPlanes);
+    return std::vector<Vector4>{std::begin(clipPlanes), std::end(clipPlanes)};
+}
+
+void ShadowLight::calculateClipPlanes(const Matrix4& pm, Vector4(&clipPlanes)[6]) {
+    clipPlanes[0] = {pm[3][0] + pm[2][0], pm[3][1] + pm[2][1], pm[3][2] + pm[2][2], pm[3][3] + pm[2][3]};   /* near */
+    clipPlanes[1] = {pm[3][0] - pm[2][0], pm[3][1] - pm[2][1], pm[3][2] - pm[2][2], pm[3][3] - pm[2][3]};   /* far */
+    clipPlanes[2] = {pm[3][0] + pm[0][0], pm[3][1] + pm[0][1], pm[3][2] + pm[0][2], pm[3][3] + pm[0][3]};   /* left */
+    clipPlanes[3] = {pm[3][0] - pm[0][0], pm[3][1] - pm[0][1], pm[3][2] - pm[0][2], pm[3][3] - pm[0][3]};   /* right */
+    clipPlanes[4] = {pm[3][0] + pm[1][0], pm[3][1] + pm[1][1], pm[3][2] + pm[1][2], pm[3][3] + pm[1][3]};   /* bottom */
+    clipPlanes[5] = {pm[3][0] - pm[1][0], pm[3][1] - pm[1][1], pm[3][2] - pm[1][2], pm[3][3] - pm[1][3]};   /* top */
     for(Vector4& plane: clipPlanes)
         plane *= plane.xyz().lengthInverted();
-    return clipPlanes;
+}
+
+void ShadowLight::updateCasters(SceneGraph::DrawableGroup3D& drawables) {
+    /* If casters were added or removed, start from scratch. Make sure even
+       objects that were cleaned before they got a caster calculate their
+       transformation again. */
+    bool changed = drawables.size() != _casters.size();
+    for(std::size_t i = 0; i != drawables.size() && !changed; ++i)
+        changed = &drawables[i] != _casters[i];
+    if(changed) {
+        _casters.clear();
+        _casterObjects.clear();
+        for(std::size_t i = 0; i != drawables.size(); ++i) {
+            _casters.push_back(static_cast<ShadowCasterDrawable*>(&drawables[i]));
+            _casterObjects.push_back(drawables[i].object());
+            drawables[i].object().setDirty();
+        }
+        _casterStatic.assign(_casters.size(), false);
+        _casterIndex.setSphereCount(_casters.size());
+        _scheduler.invalidateAll();
+    }
+
+    /* Calculates absolute transformation only of objects that are dirty,
+       which calls ShadowCasterDrawable::clean() on their casters */
+    if(!_casterObjects.empty())
+        SceneGraph::AbstractObject3D::setClean(_casterObjects);
+
+    /* Bounding sphere in world space, with the radius scaled by the largest
+       axis scale */
+    for(std::size_t i = 0; i != _casters.size(); ++i) {
+        ShadowCasterDrawable& caster = *_casters[i];
+        if(!caster.hasMoved() && !changed) continue;
+
+        /* A static caster moved or stopped being static, the caches of
+           layers it was in before and is in now are no longer valid */
+        const bool invalidates = !changed && (caster.isStatic() || _casterStatic[i]);
+        if(invalidates) for(std::size_t layer = 0; layer != _layers.size(); ++layer)
+            if(intersects(_layers[layer].clipPlanes, _casterIndex.center(i), _casterIndex.radius(i)))
+                _scheduler.invalidate(layer);
+
+        const Matrix4& transformation = caster.absoluteTransformation();
+        _casterIndex.setSphere(i, transformation.translation(),
+            caster.radius()*transformation.scaling().max());
+        _casterStatic[i] = caster.isStatic();
+        caster.resetMoved();
+
+        if(invalidates) for(std::size_t layer = 0; layer != _layers.size(); ++layer)
+            if(intersects(_layers[layer].clipPlanes, _casterIndex.center(i), _casterIndex.radius(i)))
+                _scheduler.invalidate(layer);
+    }
+
+    _casterIndex.update();
 }
 
 void ShadowLight::render(SceneGraph::DrawableGroup3D& drawables) {
-    /* Compute transformations of all objects in the group relative to the camera */
-    std::vector<std::reference_wrapper<Object3D>> objects;
-    objects.reserve(drawables.size());
-    for(std::size_t i = 0; i != drawables.size(); ++i)
-        objects.push_back(static_cast<Object3D&>(drawables[i].object()));
-    std::vector<ShadowCasterDrawable*> filteredDrawables;
+    /* Caster bounds are shared by all layers */
+    updateCasters(drawables);
+
+    for(std::size_t layer = 0; layer != _layers.size(); ++layer) {
+        ShadowLayerData& d = _layers[layer];
+
+        /* Pick the casters that intersect the shadow camera's planes, in
+           world space as that's what the caster bounds are in. Skip the
+           near plane because we need to include shadow casters traveling
+           the direction the camera is facing. */
+        d.casters.clear();
+        _casterIndex.query(Containers::arrayView(d.clipPlanes + 1, 5), d.casters);
+
+        /* If any object extends in front of the near plane, extend the near
+           plane. We negate the z because the negative z is forward away from
+           the camera, but the near/far planes are measured forwards. */
+        const Matrix4 shadowCameraMatrix = d.shadowCameraMatrix.invertedRigid();
+        bool dynamicCasters = false;
+        d.requiredNear = d.orthographicNear;
+        for(const UnsignedInt id: d.casters) {
+            const Float nearestPoint = -shadowCameraMatrix.transformPoint(_casterIndex.center(id)).z() - _casterIndex.radius(id);
+            d.requiredNear = Math::min(d.requiredNear, nearestPoint);
+            dynamicCasters = dynamicCasters || !_casters[id]->isStatic();
+        }
+
+        /* A caster is in front of the near plane the cache was drawn with,
+           the whole layer has to be drawn again */
+        if(d.requiredNear < d.projectionNear) _scheduler.invalidate(layer);
+        _scheduler.setDynamicCasters(layer, dynamicCasters);
+    }
+
+    _scheduler.schedule();
 
     /* Projecting world points normalized device coordinates means they range
        -1 -> 1. Use this bias matrix so we go straight from world -> texture
@@ -178,65 +312,42 @@ void ShadowLight::render(SceneGraph::DrawableGroup3D& drawables) {
     GL::Renderer::setDepthMask(true);
 
     for(std::size_t layer = 0; layer != _layers.size(); ++layer) {
+        const ShadowCascadeScheduler::Update update = _scheduler.update(layer);
+        if(update == ShadowCascadeScheduler::Update::None) continue;
+
         ShadowLayerData& d = _layers[layer];
-        Float orthographicNear = d.orthographicNear;
-        const Float orthographicFar = d.orthographicFar;
 
         /* Move this whole object to the right place to render each layer */
         _object.setTransformation(d.shadowCameraMatrix)
             .setClean();
-        setProjectionMatrix(Matrix4::orthographicProjection(d.orthographicSize, orthographicNear, orthographicFar));
-
-        const std::vector<Vector4> clipPlanes = calculateClipPlanes();
-        std::vector<Matrix4> transformations = _object.scene()->transformationMatrices(objects, cameraMatrix());
-
-        /* Rebuild the list of objects we will draw by clipping them with the
-           shadow camera's planes */
-        std::size_t transformationsOutIndex = 0;
-        filteredDrawables.clear();
-        for(std::size_t drawableIndex = 0; drawableIndex != drawables.size(); ++drawableIndex) {
-            auto& drawable = static_cast<ShadowCasterDrawable&>(drawables[drawableIndex]);
-            const Matrix4 transform = transformations[drawableIndex];
-
-            /* If your centre is offset, inject it here */
-            const Vector4 localCentre{0.0f, 0.0f, 0.0f, 1.0f};
-            const Vector4 drawableCentre = transform*localCentre;
-
-            /* Start at 1, not 0 to skip out the near plane because we need to
-               include shadow casters traveling the direction the camera is
-               facing. */
-            for(std::size_t clipPlaneIndex = 1; clipPlaneIndex != clipPlanes.size(); ++clipPlaneIndex) {
-                const Float distance = Math::dot(clipPlanes[clipPlaneIndex], drawableCentre);
-
-                /* If the object is on the useless side of any one plane, we can skip it */
-                if(distance < -drawable.radius())
-                    goto next;
-            }
-
-            {
-                /* If this object extends in front of the near plane, extend
-                   the near plane. We negate the z because the negative z is
-                   forward away from the camera, but the near/far planes are
-                   measured forwards. */
-                const Float nearestPoint = -drawableCentre.z() - drawable.radius();
-                orthographicNear = Math::min(orthographicNear, nearestPoint);
-                filteredDrawables.push_back(&drawable);
-                transformations[transformationsOutIndex++] = transform;
+        const Matrix4 shadowCameraMatrix = cameraMatrix();
+
+        /* The shadow matrix changes only together with the cache, layers
+           that aren't drawn keep the one their content matches */
+        if(update == ShadowCascadeScheduler::Update::Full) {
+            d.projectionNear = d.requiredNear;
+            setProjectionMatrix(Matrix4::orthographicProjection(d.orthographicSize, d.projectionNear, d.orthographicFar));
+            d.shadowMatrix = bias*projectionMatrix()*shadowCameraMatrix;
+
+            d.staticFramebuffer.clear(GL::FramebufferClear::Depth)
+                .bind();
+            for(const UnsignedInt id: d.casters) {
+                ShadowCasterDrawable& caster = *_casters[id];
+                if(caster.isStatic())
+                    caster.draw(shadowCameraMatrix*caster.absoluteTransformation(), *this);
             }
-
-            next:;
+        } else setProjectionMatrix(Matrix4::orthographicProjection(d.orthographicSize, d.projectionNear, d.orthographicFar));
+
+        /* Start from a copy of the static casters and draw dynamic ones on
+           top */
+        GL::AbstractFramebuffer::blit(d.staticFramebuffer, d.shadowFramebuffer,
+            d.shadowFramebuffer.viewport(), GL::FramebufferBlit::Depth);
+        d.shadowFramebuffer.bind();
+        for(const UnsignedInt id: d.casters) {
+            ShadowCasterDrawable& caster = *_casters[id];
+            if(!caster.isStatic())
+                caster.draw(shadowCameraMatrix*caster.absoluteTransformation(), *this);
         }
-
-        /* Recalculate the projection matrix with new near plane. */
-        const Matrix4 shadowCameraProjectionMatrix =
-            Matrix4::orthographicProjection(d.orthographicSize, orthographicNear, orthographicFar);
-        d.shadowMatrix = bias*shadowCameraProjectionMatrix*cameraMatrix();
-        setProjectionMatrix(shadowCameraProjectionMatrix);
-
-        d.shadowFramebuffer.clear(GL::FramebufferClear::Depth)
-            .bind();
-        for(std::size_t i = 0; i != transformationsOutIndex; ++i)
-            filteredDrawables[i]->draw(transformations[i], *this);
     }
 
     GL::defaultFramebuffer.bind();
@@ -30,6 +30,7 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <functional>
 #include <Magnum/Resource.h>
 #include <Magnum/GL/Framebuffer.h>
 #include <Magnum/GL/TextureArray.h>
@@ -37,10 +38,14 @@
 #include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/AbstractFeature.h>
 
+#include "ShadowCascadeScheduler.h"
+#include "ShadowCasterIndex.h"
 #include "Types.h"
 
 namespace Magnum { namespace Examples {
 
+class ShadowCasterDrawable;
+
 /**
 @brief A special camera used to render shadow maps
 
@@ -80,15 +85,37 @@ class ShadowLight: public SceneGraph::Camera3D {
          *      splits (normally, the main camera that the shadows will be
          *      rendered to)
          *
-         * Should be called whenever your camera moves.
+         * Should be called whenever your camera moves. A layer is fitted
+         * with some padding around the camera frustum slice and stays the
+         * same until the slice leaves it, so its cached static casters can
+         * be reused.
          */
         void setTarget(const Vector3& lightDirection, const Vector3& screenDirection, SceneGraph::Camera3D& mainCamera);
 
         /**
          * @brief Render a group of shadow-casting drawables to the shadow maps
+         *
+         * Bounds of the casters are updated once for all layers, only for
+         * objects that moved since the last call. Casters for each layer
+         * are then picked from a @ref ShadowCasterIndex.
+         *
+         * Casters marked with @ref ShadowCasterDrawable::setStatic() are
+         * drawn into a per-layer cache only when the layer changes or one
+         * of them moves, the others are drawn on top of a copy of the cache.
+         * Which layers get updated is decided by a
+         * @ref ShadowCascadeScheduler, far layers with dynamic casters take
+         * turns.
          */
         void render(SceneGraph::DrawableGroup3D& drawables);
 
+        /**
+         * @brief Draw all cached static casters again in the next render
+         *
+         * Needed when something that isn't tracked changes, such as the
+         * face culling mode.
+         */
+        void invalidateCache() { _scheduler.invalidateAll(); }
+
         std::vector<Vector3> layerFrustumCorners(SceneGraph::Camera3D& mainCamera, Int layer);
 
         Float cutZ(Int layer) const;
@@ -103,24 +130,58 @@ class ShadowLight: public SceneGraph::Camera3D {
 
         std::vector<Vector4> calculateClipPlanes();
 
+        /* Normalized planes of a frustum given by a projection matrix,
+           optionally multiplied with a camera matrix to get them in world
+           space. Order is near, far, left, right, bottom, top. */
+        static void calculateClipPlanes(const Matrix4& projectionMatrix, Vector4(&planes)[6]);
+
         GL::Texture2DArray& shadowTexture() { return _shadowTexture; }
 
     private:
         Object3D& _object;
         GL::Texture2DArray _shadowTexture;
+        /* Same layout as _shadowTexture, with just the static casters */
+        GL::Texture2DArray _staticShadowTexture;
 
         struct ShadowLayerData {
             GL::Framebuffer shadowFramebuffer;
+            GL::Framebuffer staticFramebuffer;
             Matrix4 shadowCameraMatrix;
             Matrix4 shadowMatrix;
             Vector2 orthographicSize;
             Float orthographicNear, orthographicFar;
             Float cutPlane;
 
+            /* Padded light-space box the layer was fitted to in setTarget()
+               and its world-space planes */
+            bool fitted = false;
+            Vector3 boxMin, boxMax;
+            Vector4 clipPlanes[6];
+
+            /* Near plane the cache was drawn with, extended to include all
+               casters in front, and the one needed in this frame */
+            Float projectionNear{}, requiredNear{};
+
+            /* Casters intersecting the layer in this frame */
+            std::vector<UnsignedInt> casters;
+
             explicit ShadowLayerData(const Vector2i& size);
         };
 
+        void updateCasters(SceneGraph::DrawableGroup3D& drawables);
+
         std::vector<ShadowLayerData> _layers;
+
+        /* Casters from the last render(), their objects, bounding spheres
+           and whether they were static, in the same order. Kept between
+           frames so only the objects that moved need their bounds updated
+           and only the layers they were or are in get invalidated. */
+        std::vector<ShadowCasterDrawable*> _casters;
+        std::vector<std::reference_wrapper<SceneGraph::AbstractObject3D>> _casterObjects;
+        std::vector<bool> _casterStatic;
+        ShadowCasterIndex _casterIndex;
+
+        ShadowCascadeScheduler _scheduler;
 };
 
 }}
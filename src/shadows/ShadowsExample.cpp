@@ -44,6 +44,7 @@
 #include <Magnum/SceneGraph/AbstractObject.h>
 #include <Magnum/SceneGraph/Scene.h>
 #include <Magnum/SceneGraph/MatrixTransformation3D.h>
+#include <Magnum/Timeline.h>
 #include <Magnum/Trade/MeshData.h>
 
 #include "DebugLines.h"
@@ -71,6 +72,13 @@ class ShadowsExample: public Platform::Application {
             Float radius;
         };
 
+        /* Object circling around a point, its caster is dynamic */
+        struct MovingObject {
+            Object3D* object;
+            Vector3 center;
+            Rad phase;
+        };
+
         void drawEvent() override;
         void mousePressEvent(MouseEvent& event) override;
         void mouseReleaseEvent(MouseEvent& event) override;
@@ -80,7 +88,8 @@ class ShadowsExample: public Platform::Application {
 
         void addModel(const Trade::MeshData& meshData3D);
         void renderDebugLines();
-        Object3D* createSceneObject(Model& model, bool makeCaster, bool makeReceiver);
+        Object3D* createSceneObject(Model& model, bool makeCaster, bool makeReceiver, bool staticCaster = true);
+        void moveObjects();
         void recompileReceiverShader(std::size_t numLayers);
         void setShadowMapSize(const Vector2i& shadowMapSize);
         void setShadowSplitExponent(Float power);
@@ -104,6 +113,11 @@ class ShadowsExample: public Platform::Application {
         SceneGraph::Camera3D* _activeCamera;
 
         std::vector<Model> _models;
+        std::vector<MovingObject> _movingObjects;
+
+        Timeline _timeline;
+        Float _time{};
+        bool _paused{};
 
         Vector3 _mainCameraVelocity;
 
@@ -142,13 +156,19 @@ ShadowsExample::ShadowsExample(const Arguments& arguments):
     Object3D* ground = createSceneObject(_models[0], false, true);
     ground->setTransformation(Matrix4::scaling({100,1,100}));
 
+    /* Every tenth object moves, so its shadow is drawn on top of the cached
+       static ones in every layer it passes through */
     for(std::size_t i = 0; i != 200; ++i) {
         Model& model = _models[std::rand()%_models.size()];
-        Object3D* object = createSceneObject(model, true, true);
-        object->setTransformation(Matrix4::translation({
+        const bool moving = i % 10 == 0;
+        Object3D* object = createSceneObject(model, true, true, !moving);
+        const Vector3 position{
             std::rand()*100.0f/RAND_MAX - 50.0f,
             std::rand()*5.0f/RAND_MAX,
-            std::rand()*100.0f/RAND_MAX - 50.0f}));
+            std::rand()*100.0f/RAND_MAX - 50.0f};
+        object->setTransformation(Matrix4::translation(position));
+        if(moving) _movingObjects.push_back({object, position,
+            Rad{std::rand()*Constants::tau()/RAND_MAX}});
     }
 
     _shadowLight.setupSplitDistances(MainCameraNear, MainCameraFar, _layerSplitExponent);
@@ -169,15 +189,19 @@ ShadowsExample::ShadowsExample(const Arguments& arguments):
 
     _shadowLightObject.setTransformation(Matrix4::lookAt(
         {3.0f, 1.0f, 2.0f}, {}, Vector3::yAxis()));
+
+    _timeline.start();
 }
 
-Object3D* ShadowsExample::createSceneObject(Model& model, bool makeCaster, bool makeReceiver) {
+Object3D* ShadowsExample::createSceneObject(Model& model, bool makeCaster, bool makeReceiver, bool staticCaster) {
     auto* object = new Object3D(&_scene);
 
     if(makeCaster) {
         auto caster = new ShadowCasterDrawable(*object, &_shadowCasterDrawables);
         caster->setShader(_shadowCasterShader);
         caster->setMesh(model.mesh, model.radius);
+        /* Casters of objects that don't move are cached */
+        caster->setStatic(staticCaster);
     }
 
     if(makeReceiver) {
@@ -206,7 +230,20 @@ void ShadowsExample::addModel(const Trade::MeshData& meshData) {
     model.mesh = MeshTools::compile(MeshTools::compressIndices(meshData));
 }
 
+void ShadowsExample::moveObjects() {
+    for(const MovingObject& moving: _movingObjects) {
+        const Rad angle = Rad{_time} + moving.phase;
+        moving.object->setTransformation(Matrix4::translation(moving.center +
+            Vector3{Math::cos(angle), 0.0f, Math::sin(angle)}*3.0f));
+    }
+}
+
 void ShadowsExample::drawEvent() {
+    if(!_paused) {
+        _time += _timeline.previousFrameDuration();
+        moveObjects();
+    }
+
     if(!_mainCameraVelocity.isZero()) {
         Matrix4 transform = _activeCameraObject->transformation();
         transform.translation() += transform.rotation()*_mainCameraVelocity*0.3f;
@@ -257,6 +294,8 @@ void ShadowsExample::drawEvent() {
     renderDebugLines();
 
     swapBuffers();
+    _timeline.nextFrame();
+    if(!_paused) redraw();
 }
 
 void ShadowsExample::renderDebugLines() {
@@ -332,6 +371,10 @@ void ShadowsExample::keyPressEvent(KeyEvent& event) {
     } else if(event.key() == KeyEvent::Key::Left) {
         _mainCameraVelocity.x() = -1.0f;
 
+    } else if(event.key() == KeyEvent::Key::Space) {
+        _paused = !_paused;
+        Debug() << "Moving objects" << (_paused ? "paused" : "resumed");
+
     } else if(event.key() == KeyEvent::Key::F1) {
         _activeCamera = &_mainCamera;
         _activeCameraObject = &_mainCameraObject;
@@ -342,6 +385,7 @@ void ShadowsExample::keyPressEvent(KeyEvent& event) {
 
     } else if(event.key() == KeyEvent::Key::F3) {
         _shadowMapFaceCullMode = (_shadowMapFaceCullMode + 1) % 3;
+        _shadowLight.invalidateCache();
         Debug() << "Face cull mode:"
             << (_shadowMapFaceCullMode == 0 ? "no cull" : _shadowMapFaceCullMode == 1 ? "cull back" : "cull front");
 
@@ -0,0 +1,229 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "AssetLoader.h"
+
+#include <chrono>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/MeshTools/Duplicate.h>
+#include <Magnum/MeshTools/GenerateNormals.h>
+#include <Magnum/MeshTools/Interleave.h>
+#include <Magnum/Trade/AbstractImporter.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+Double secondsSince(const Clock::time_point begin) {
+    return std::chrono::duration<Double>(Clock::now() - begin).count();
+}
+
+/* Channel count of formats that can be downsampled on the CPU, zero for
+   others. sRGB formats are averaged as if they were linear, which is what
+   most drivers do in glGenerateMipmap() as well. */
+UnsignedInt downsampledChannelCount(const PixelFormat format) {
+    switch(format) {
+        case PixelFormat::R8Unorm:
+        case PixelFormat::R8Srgb:
+            return 1;
+        case PixelFormat::RG8Unorm:
+        case PixelFormat::RG8Srgb:
+            return 2;
+        case PixelFormat::RGB8Unorm:
+        case PixelFormat::RGB8Srgb:
+            return 3;
+        case PixelFormat::RGBA8Unorm:
+        case PixelFormat::RGBA8Srgb:
+            return 4;
+        default:
+            return 0;
+    }
+}
+
+/* Full mip chain down to 1x1, each level a 2x2 box filter of the previous
+   one. Odd sizes repeat the last row or column. */
+void generateMipLevels(std::vector<Trade::ImageData2D>& levels) {
+    const PixelFormat format = levels.front().format();
+    const UnsignedInt channels = downsampledChannelCount(format);
+    if(!channels) return;
+
+    while(levels.back().size().max() > 1) {
+        const Containers::StridedArrayView3D<const char> src = levels.back().pixels();
+        const Vector2i srcSize = levels.back().size();
+        const Vector2i size = Math::max(srcSize/2, Vector2i{1});
+
+        Containers::Array<char> data{NoInit, std::size_t(size.product()*channels)};
+        char* out = data.data();
+        for(Int y = 0; y != size.y(); ++y) {
+            const std::size_t y0 = std::size_t(Math::min(2*y, srcSize.y() - 1));
+            const std::size_t y1 = std::size_t(Math::min(2*y + 1, srcSize.y() - 1));
+            for(Int x = 0; x != size.x(); ++x) {
+                const std::size_t x0 = std::size_t(Math::min(2*x, srcSize.x() - 1));
+                const std::size_t x1 = std::size_t(Math::min(2*x + 1, srcSize.x() - 1));
+                for(std::size_t c = 0; c != channels; ++c) {
+                    const UnsignedInt sum =
+                        UnsignedByte(src[y0][x0][c]) + UnsignedByte(src[y0][x1][c]) +
+                        UnsignedByte(src[y1][x0][c]) + UnsignedByte(src[y1][x1][c]);
+                    *out++ = char((sum + 2)/4);
+                }
+            }
+        }
+
+        /* Rows are tightly packed, which may not be four-byte aligned */
+        levels.emplace_back(PixelStorage{}.setAlignment(1), format, size, std::move(data));
+    }
+}
+
+/* Same as what MeshTools::compile() does with GenerateFlatNormals, just
+   without the GL upload */
+Trade::MeshData generateNormals(Trade::MeshData&& mesh) {
+    if(mesh.primitive() != MeshPrimitive::Triangles ||
+       !mesh.hasAttribute(Trade::MeshAttribute::Position) ||
+       mesh.hasAttribute(Trade::MeshAttribute::Normal))
+        return std::move(mesh);
+
+    Trade::MeshData unindexed = mesh.isIndexed() ?
+        MeshTools::duplicate(mesh) : std::move(mesh);
+    const Containers::Array<Vector3> normals =
+        MeshTools::generateFlatNormals(unindexed.positions3DAsArray());
+    return MeshTools::interleave(std::move(unindexed), {
+        Trade::MeshAttributeData{Trade::MeshAttribute::Normal,
+            Containers::arrayView(normals)}
+    });
+}
+
+Range3D positionBounds(const Trade::MeshData& mesh) {
+    const Containers::Array<Vector3> positions = mesh.positions3DAsArray();
+    if(positions.isEmpty()) return {};
+
+    Range3D bounds{positions[0], positions[0]};
+    for(const Vector3& position: positions) {
+        bounds.min() = Math::min(bounds.min(), position);
+        bounds.max() = Math::max(bounds.max(), position);
+    }
+    return bounds;
+}
+
+}
+
+AssetLoader::AssetLoader(const Containers::StringView importerName, const Containers::StringView filename, const UnsignedInt imageCount, const UnsignedInt meshCount, const std::size_t threadCount): _importerName{importerName}, _filename{filename}, _imageCount{imageCount}, _meshCount{meshCount} {
+    std::size_t count = threadCount ? threadCount : std::thread::hardware_concurrency();
+    /* No point in having more threads than assets, but at least one so the
+       loading doesn't block the caller */
+    count = Math::max(Math::min(count, std::size_t(assetCount())), std::size_t(1));
+    for(std::size_t i = 0; i != count; ++i)
+        _workers.emplace_back([this] { work(); });
+}
+
+AssetLoader::~AssetLoader() {
+    _stop = true;
+    for(std::thread& worker: _workers) worker.join();
+}
+
+void AssetLoader::work() {
+    /* If the file fails to open, assets picked by this worker are reported
+       as failed, so the others still finish and waitFinished() returns */
+    PluginManager::Manager<Trade::AbstractImporter> manager;
+    Containers::Pointer<Trade::AbstractImporter> importer =
+        manager.loadAndInstantiate(_importerName);
+    if(importer && !importer->openFile(_filename))
+        importer = nullptr;
+
+    for(;;) {
+        const std::size_t index = _nextAsset++;
+        if(_stop || index >= assetCount()) return;
+
+        Asset asset{};
+        Clock::time_point begin = Clock::now();
+        if(index < _imageCount) {
+            asset.type = AssetType::Image;
+            asset.id = UnsignedInt(index);
+
+            Containers::Optional<Trade::ImageData2D> image;
+            if(importer && (image = importer->image2D(asset.id)) && !image->isCompressed()) {
+                asset.imageLevels.push_back(std::move(*image));
+                asset.decodeTime = secondsSince(begin);
+                begin = Clock::now();
+                generateMipLevels(asset.imageLevels);
+                asset.preprocessTime = secondsSince(begin);
+            } else asset.decodeTime = secondsSince(begin);
+
+        } else {
+            asset.type = AssetType::Mesh;
+            asset.id = UnsignedInt(index - _imageCount);
+
+            Containers::Optional<Trade::MeshData> mesh;
+            if(importer && (mesh = importer->mesh(asset.id))) {
+                asset.decodeTime = secondsSince(begin);
+                begin = Clock::now();
+                asset.mesh = generateNormals(std::move(*mesh));
+                if(asset.mesh->hasAttribute(Trade::MeshAttribute::Position))
+                    asset.bounds = positionBounds(*asset.mesh);
+                asset.preprocessTime = secondsSince(begin);
+            } else asset.decodeTime = secondsSince(begin);
+        }
+
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _finished.push_back(std::move(asset));
+        }
+        _condition.notify_one();
+    }
+}
+
+Containers::Optional<AssetLoader::Asset> AssetLoader::takeFinished() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    if(_finished.empty()) return {};
+
+    Asset asset = std::move(_finished.front());
+    _finished.pop_front();
+    ++_takenCount;
+    return Containers::Optional<Asset>{std::move(asset)};
+}
+
+Containers::Optional<AssetLoader::Asset> AssetLoader::waitFinished() {
+    std::unique_lock<std::mutex> lock{_mutex};
+    if(_takenCount == assetCount()) return {};
+    _condition.wait(lock, [this] { return !_finished.empty(); });
+
+    Asset asset = std::move(_finished.front());
+    _finished.pop_front();
+    ++_takenCount;
+    return Containers::Optional<Asset>{std::move(asset)};
+}
+
+}}
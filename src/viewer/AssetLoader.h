@@ -0,0 +1,115 @@
+#ifndef Magnum_Examples_Viewer_AssetLoader_h
+#define Magnum_Examples_Viewer_AssetLoader_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/String.h>
+#include <Corrade/Containers/StringView.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MeshData.h>
+
+namespace Magnum { namespace Examples {
+
+/* Decodes all images and meshes of a scene file on worker threads, without
+   touching GL. Importers aren't thread-safe, so each worker has its own
+   plugin manager and importer instance with the file opened. Images get
+   their mip levels generated and meshes their normals, if needed, and
+   bounds on the worker as well. The application then picks up finished
+   assets one by one with takeFinished() and uploads them at its own pace. */
+class AssetLoader {
+    public:
+        enum class AssetType: UnsignedByte { Image, Mesh };
+
+        struct Asset {
+            AssetType type;
+            UnsignedInt id;
+
+            /* All mip levels, starting with the base one, or just the base
+               level if the format isn't supported by the CPU downsampling.
+               Empty if the image failed to load or is compressed. */
+            std::vector<Trade::ImageData2D> imageLevels;
+            /* NullOpt if the mesh failed to load */
+            Containers::Optional<Trade::MeshData> mesh;
+            /* Bounds of mesh positions, empty if there are none */
+            Range3D bounds;
+
+            /* Time spent decoding the data and preprocessing them, in
+               seconds */
+            Double decodeTime;
+            Double preprocessTime;
+        };
+
+        /* Zero thread count means all hardware threads. Starts decoding right
+           away, images first. */
+        explicit AssetLoader(Containers::StringView importerName, Containers::StringView filename, UnsignedInt imageCount, UnsignedInt meshCount, std::size_t threadCount = 0);
+
+        /* Waits for the workers to finish their current asset */
+        ~AssetLoader();
+
+        std::size_t threadCount() const { return _workers.size(); }
+
+        /* Count of all assets and of assets that were already taken */
+        std::size_t assetCount() const { return _imageCount + _meshCount; }
+        std::size_t takenCount() const { return _takenCount; }
+        bool isFinished() const { return _takenCount == assetCount(); }
+
+        /* Next finished asset, or NullOpt if there's none yet */
+        Containers::Optional<Asset> takeFinished();
+
+        /* Next finished asset, waiting for it if there's none yet. NullOpt
+           if all assets were already taken. */
+        Containers::Optional<Asset> waitFinished();
+
+    private:
+        void work();
+
+        Containers::String _importerName, _filename;
+        UnsignedInt _imageCount, _meshCount;
+
+        std::vector<std::thread> _workers;
+        std::atomic<std::size_t> _nextAsset{0};
+        std::atomic<bool> _stop{false};
+        std::size_t _takenCount = 0;
+
+        std::mutex _mutex;
+        std::condition_variable _condition;
+        std::deque<Asset> _finished;
+};
+
+}}
+
+#endif
@@ -0,0 +1,317 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "Culler.h"
+
+#include <algorithm>
+#include <limits>
+#include <Corrade/Utility/Assert.h>
+#include <Magnum/Math/Functions.h>
+
+namespace Magnum { namespace Examples {
+
+Culler::Culler(const std::size_t threadCount) {
+    const std::size_t count = threadCount ? threadCount :
+        std::max(std::size_t(std::thread::hardware_concurrency()), std::size_t(1));
+    for(std::size_t i = 1; i < count; ++i)
+        _workers.emplace_back([this]{ work(); });
+    setDepthBufferSize(_depthBufferSize);
+}
+
+Culler::~Culler() {
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _stop = true;
+    }
+    _taskCondition.notify_all();
+    for(std::thread& worker: _workers) worker.join();
+}
+
+void Culler::setSphereCount(const std::size_t count) {
+    _centersX.resize(count);
+    _centersY.resize(count);
+    _centersZ.resize(count);
+    _radii.resize(count);
+}
+
+void Culler::setDepthBufferSize(const Vector2i& size) {
+    CORRADE_INTERNAL_ASSERT(size.product() > 0);
+    _depthBufferSize = size;
+    _depth.assign(std::size_t(size.product()), 1.0f);
+}
+
+void Culler::addOccluder(const Matrix4& transformation, const Containers::ArrayView<const Vector3> positions, const Containers::ArrayView<const UnsignedInt> indices) {
+    CORRADE_INTERNAL_ASSERT(indices.size() % 3 == 0);
+    _occluders.push_back(Occluder{transformation, positions, indices});
+}
+
+void Culler::work() {
+    std::size_t generation = 0;
+    for(;;) {
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            _taskCondition.wait(lock, [&]{ return _stop || _generation != generation; });
+            if(_stop) return;
+            generation = _generation;
+        }
+
+        for(std::size_t i; (i = _nextTask++) < _taskCount; )
+            (*_task)(i);
+
+        {
+            std::unique_lock<std::mutex> lock{_mutex};
+            if(--_busyWorkers) continue;
+        }
+        _doneCondition.notify_one();
+    }
+}
+
+void Culler::run(const std::size_t count, const std::function<void(std::size_t)>& task) {
+    /* Waking the workers up costs more than a single task */
+    if(_workers.empty() || count < 2) {
+        for(std::size_t i = 0; i != count; ++i) task(i);
+        return;
+    }
+
+    {
+        std::unique_lock<std::mutex> lock{_mutex};
+        _task = &task;
+        _taskCount = count;
+        _nextTask = 0;
+        _busyWorkers = _workers.size();
+        ++_generation;
+    }
+    _taskCondition.notify_all();
+
+    for(std::size_t i; (i = _nextTask++) < count; )
+        task(i);
+
+    std::unique_lock<std::mutex> lock{_mutex};
+    _doneCondition.wait(lock, [this]{ return _busyWorkers == 0; });
+}
+
+void Culler::cull(const Matrix4& viewProjection, std::vector<UnsignedInt>& visible) {
+    _viewProjection = viewProjection;
+
+    /* Frustum planes with the normals pointing inside, normalized so the
+       distance to a plane can be compared to the radius directly */
+    const Vector4 rows[]{viewProjection.row(0), viewProjection.row(1),
+                         viewProjection.row(2), viewProjection.row(3)};
+    for(std::size_t i = 0; i != 3; ++i) {
+        _planes[2*i + 0] = rows[3] + rows[i];
+        _planes[2*i + 1] = rows[3] - rows[i];
+    }
+    for(Vector4& plane: _planes) plane /= plane.xyz().length();
+
+    /* The depth buffer is used only if there's anything to rasterize */
+    setupTriangles();
+    if(!_triangles.empty()) {
+        std::fill(_depth.begin(), _depth.end(), 1.0f);
+        run(std::size_t((_depthBufferSize.y() + BandHeight - 1)/BandHeight),
+            [this](std::size_t band) { rasterizeBand(band); });
+    }
+
+    const std::size_t chunkCount = (sphereCount() + ChunkSize - 1)/ChunkSize;
+    _chunkVisible.resize(sphereCount());
+    _chunkVisibleCounts.assign(chunkCount, 0);
+    _chunkOccludedCounts.assign(chunkCount, 0);
+    run(chunkCount, [this](std::size_t chunk) { cullChunk(chunk); });
+
+    /* Compact the per-chunk ranges into a single list */
+    visible.clear();
+    _occlusionCulledCount = 0;
+    for(std::size_t chunk = 0; chunk != chunkCount; ++chunk) {
+        const UnsignedInt* begin = _chunkVisible.data() + chunk*ChunkSize;
+        visible.insert(visible.end(), begin, begin + _chunkVisibleCounts[chunk]);
+        _occlusionCulledCount += _chunkOccludedCounts[chunk];
+    }
+    _frustumCulledCount = sphereCount() - visible.size() - _occlusionCulledCount;
+
+    _occluders.clear();
+}
+
+void Culler::setupTriangles() {
+    _triangles.clear();
+    const Vector2 size{_depthBufferSize};
+    for(const Occluder& occluder: _occluders) {
+        const Matrix4 transformation = _viewProjection*occluder.transformation;
+        for(std::size_t i = 0; i + 2 < occluder.indices.size(); i += 3) {
+            Triangle triangle;
+            triangle.depth = -std::numeric_limits<Float>::infinity();
+            bool clipped = false;
+            for(std::size_t j = 0; j != 3; ++j) {
+                const UnsignedInt index = occluder.indices[i + j];
+                CORRADE_INTERNAL_ASSERT(index < occluder.positions.size());
+                const Vector4 clip = transformation*Vector4{occluder.positions[index], 1.0f};
+
+                /* Clipping against the near plane would only make the
+                   triangle smaller, leaving it out entirely is still
+                   correct, it just hides less */
+                if(clip.z() < -clip.w() || clip.w() <= 0.0f) {
+                    clipped = true;
+                    break;
+                }
+
+                const Vector3 ndc = clip.xyz()/clip.w();
+                triangle.vertices[j] = (ndc.xy()*0.5f + Vector2{0.5f})*size;
+                triangle.depth = Math::max(triangle.depth, ndc.z());
+            }
+
+            /* Beyond the far plane it wouldn't hide anything */
+            if(clipped || triangle.depth >= 1.0f) continue;
+
+            const Vector2 a = triangle.vertices[1] - triangle.vertices[0];
+            const Vector2 b = triangle.vertices[2] - triangle.vertices[0];
+            /* Back-facing triangles are culled when drawing, so they don't
+               hide anything. Leave them out together with degenerate ones,
+               which also leaves the rasterizer only with counterclockwise
+               triangles. */
+            if(Math::cross(a, b) < 1.0e-6f) continue;
+
+            _triangles.push_back(triangle);
+        }
+    }
+}
+
+void Culler::rasterizeBand(const std::size_t band) {
+    const Int yBegin = Int(band)*BandHeight;
+    const Int yEnd = Math::min(yBegin + BandHeight, _depthBufferSize.y());
+    const Int width = _depthBufferSize.x();
+
+    for(const Triangle& triangle: _triangles) {
+        const Vector2* v = triangle.vertices;
+        const Vector2 min = Math::min(Math::min(v[0], v[1]), v[2]);
+        const Vector2 max = Math::max(Math::max(v[0], v[1]), v[2]);
+        const Int x0 = Math::max(Int(min.x()), 0);
+        const Int x1 = Math::min(Int(Math::ceil(max.x())), width);
+        const Int y0 = Math::max(Int(min.y()), yBegin);
+        const Int y1 = Math::min(Int(Math::ceil(max.y())), yEnd);
+        if(x0 >= x1 || y0 >= y1) continue;
+
+        /* Edge functions that are positive inside, a pixel is written if its
+           center is inside. Requiring the whole pixel to be covered would
+           leave holes along edges shared by two triangles. */
+        Float edgeX[3], edgeY[3], edgeOffset[3];
+        for(std::size_t i = 0; i != 3; ++i) {
+            const Vector2& a = v[i];
+            const Vector2& b = v[(i + 1) % 3];
+            edgeX[i] = a.y() - b.y();
+            edgeY[i] = b.x() - a.x();
+            edgeOffset[i] = -edgeX[i]*a.x() - edgeY[i]*a.y();
+        }
+
+        for(Int y = y0; y != y1; ++y) {
+            Float* row = _depth.data() + std::size_t(y)*width;
+            const Float cy = Float(y) + 0.5f;
+            for(Int x = x0; x != x1; ++x) {
+                const Float cx = Float(x) + 0.5f;
+                bool inside = true;
+                for(std::size_t i = 0; i != 3; ++i)
+                    inside = inside && edgeX[i]*cx + edgeY[i]*cy + edgeOffset[i] >= 0.0f;
+                if(inside) row[x] = Math::min(row[x], triangle.depth);
+            }
+        }
+    }
+}
+
+void Culler::cullChunk(const std::size_t chunk) {
+    const std::size_t begin = chunk*ChunkSize;
+    const std::size_t count = Math::min(std::size_t(ChunkSize), sphereCount() - begin);
+    const Float* x = _centersX.data() + begin;
+    const Float* y = _centersY.data() + begin;
+    const Float* z = _centersZ.data() + begin;
+    const Float* r = _radii.data() + begin;
+
+    /* One plane at a time over the whole chunk, with no early exits so it
+       stays a straight loop */
+    UnsignedByte inside[ChunkSize];
+    std::fill_n(inside, count, UnsignedByte(1));
+    for(const Vector4& plane: _planes) {
+        for(std::size_t i = 0; i != count; ++i)
+            inside[i] &= UnsignedByte(plane.x()*x[i] + plane.y()*y[i] + plane.z()*z[i] + plane.w() >= -r[i]);
+    }
+
+    UnsignedInt* out = _chunkVisible.data() + begin;
+    UnsignedInt visibleCount = 0, occludedCount = 0;
+    for(std::size_t i = 0; i != count; ++i) {
+        if(!inside[i]) continue;
+        if(!_triangles.empty() && isOccluded(begin + i)) {
+            ++occludedCount;
+            continue;
+        }
+        out[visibleCount++] = UnsignedInt(begin + i);
+    }
+    _chunkVisibleCounts[chunk] = visibleCount;
+    _chunkOccludedCounts[chunk] = occludedCount;
+}
+
+bool Culler::isOccluded(const std::size_t id) const {
+    /* Screen rectangle and the nearest depth of the box around the sphere.
+       Perspective keeps the nearest point of a box at one of its corners. */
+    const Vector3 center{_centersX[id], _centersY[id], _centersZ[id]};
+    const Float radius = _radii[id];
+    Vector2 min{std::numeric_limits<Float>::infinity()};
+    Vector2 max{-std::numeric_limits<Float>::infinity()};
+    Float nearest = std::numeric_limits<Float>::infinity();
+    for(UnsignedInt corner = 0; corner != 8; ++corner) {
+        const Vector3 position = center + radius*Vector3{
+            corner & 1 ? 1.0f : -1.0f,
+            corner & 2 ? 1.0f : -1.0f,
+            corner & 4 ? 1.0f : -1.0f};
+        const Vector4 clip = _viewProjection*Vector4{position, 1.0f};
+
+        /* Reaches in front of the near plane, can't be hidden */
+        if(clip.z() < -clip.w() || clip.w() <= 0.0f) return false;
+
+        const Vector3 ndc = clip.xyz()/clip.w();
+        min = Math::min(min, ndc.xy());
+        max = Math::max(max, ndc.xy());
+        nearest = Math::min(nearest, ndc.z());
+    }
+
+    /* Visible if any pixel the rectangle touches has the occluders
+       farther. The occluders are sampled only at pixel centers, so the
+       rectangle is grown by a pixel on each side to see past an occluder
+       edge that covers a pixel center but not the whole pixel. */
+    const Vector2 size{_depthBufferSize};
+    const Vector2 pixelMin = (min*0.5f + Vector2{0.5f})*size;
+    const Vector2 pixelMax = (max*0.5f + Vector2{0.5f})*size;
+    const Int x0 = Math::max(Int(Math::floor(pixelMin.x())) - 1, 0);
+    const Int x1 = Math::min(Int(Math::floor(pixelMax.x())) + 2, _depthBufferSize.x());
+    const Int y0 = Math::max(Int(Math::floor(pixelMin.y())) - 1, 0);
+    const Int y1 = Math::min(Int(Math::floor(pixelMax.y())) + 2, _depthBufferSize.y());
+    for(Int y = y0; y < y1; ++y) {
+        const Float* row = _depth.data() + std::size_t(y)*_depthBufferSize.x();
+        for(Int x = x0; x < x1; ++x)
+            if(row[x] >= nearest) return false;
+    }
+    return true;
+}
+
+}}
@@ -0,0 +1,160 @@
+#ifndef Magnum_Examples_Viewer_Culler_h
+#define Magnum_Examples_Viewer_Culler_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <Corrade/Containers/ArrayView.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+
+namespace Magnum { namespace Examples {
+
+/* Visibility test of bounding spheres against a view frustum and,
+   optionally, against a small depth buffer with a few large occluders
+   rasterized into it, all on the CPU and without GL. Sphere centers and
+   radii are stored in separate arrays and tested in fixed-size chunks, with
+   each frustum plane applied to a whole chunk in a single loop the compiler
+   can vectorize. Occluder rasterization is split into horizontal bands and
+   the sphere chunks are spread over worker threads. */
+class Culler {
+    public:
+        /* Spheres tested together */
+        enum: std::size_t { ChunkSize = 1024 };
+        /* Depth buffer rows rasterized together */
+        enum: Int { BandHeight = 8 };
+
+        /* Zero thread count means all hardware threads. The calling thread
+           counts as one, so there's one worker less. */
+        explicit Culler(std::size_t threadCount = 0);
+
+        ~Culler();
+
+        std::size_t threadCount() const { return _workers.size() + 1; }
+
+        std::size_t sphereCount() const { return _radii.size(); }
+
+        /* Resizes the sphere arrays, new spheres have a zero radius at the
+           origin */
+        void setSphereCount(std::size_t count);
+
+        void setSphere(std::size_t id, const Vector3& center, Float radius) {
+            _centersX[id] = center.x();
+            _centersY[id] = center.y();
+            _centersZ[id] = center.z();
+            _radii[id] = radius;
+        }
+
+        /* Resolution of the occlusion depth buffer, 256x128 by default */
+        Vector2i depthBufferSize() const { return _depthBufferSize; }
+        void setDepthBufferSize(const Vector2i& size);
+
+        /* Adds an indexed triangle mesh that hides whatever is behind it in
+           the next cull(). Only the views are stored, so the data have to
+           stay alive until then. Should be a few simple meshes that cover a
+           lot of the screen, everything else is better left out. Like when
+           drawing with face culling, triangles are expected to be
+           counterclockwise and back-facing ones hide nothing. If there are
+           no occluders, only the frustum test is done. */
+        void addOccluder(const Matrix4& transformation, Containers::ArrayView<const Vector3> positions, Containers::ArrayView<const UnsignedInt> indices);
+
+        std::size_t occluderCount() const { return _occluders.size(); }
+
+        /* Fills visible with IDs of spheres that intersect the frustum of
+           given projection and view matrix and aren't completely behind the
+           occluders, in increasing order. Clears the occluders afterwards. */
+        void cull(const Matrix4& viewProjection, std::vector<UnsignedInt>& visible);
+
+        /* Statistics of the last cull() */
+        std::size_t frustumCulledCount() const { return _frustumCulledCount; }
+        std::size_t occlusionCulledCount() const { return _occlusionCulledCount; }
+        std::size_t occluderTriangleCount() const { return _triangles.size(); }
+
+        /* Depth buffer of the last cull() in normalized device coordinates,
+           row by row from the bottom, 1.0f where there's no occluder */
+        Containers::ArrayView<const Float> depthBuffer() const { return _depth; }
+
+    private:
+        struct Occluder {
+            Matrix4 transformation;
+            Containers::ArrayView<const Vector3> positions;
+            Containers::ArrayView<const UnsignedInt> indices;
+        };
+
+        /* Triangle in depth buffer pixel coordinates, counterclockwise, with
+           the depth of its farthest vertex */
+        struct Triangle {
+            Vector2 vertices[3];
+            Float depth;
+        };
+
+        /* Calls task(i) for i in [0, count), spread over the workers and
+           the calling thread */
+        void run(std::size_t count, const std::function<void(std::size_t)>& task);
+        void work();
+
+        void setupTriangles();
+        void rasterizeBand(std::size_t band);
+        void cullChunk(std::size_t chunk);
+        bool isOccluded(std::size_t id) const;
+
+        std::vector<Float> _centersX, _centersY, _centersZ, _radii;
+
+        Vector2i _depthBufferSize{256, 128};
+        std::vector<Float> _depth;
+        std::vector<Occluder> _occluders;
+        std::vector<Triangle> _triangles;
+
+        /* State of the current cull(). Each chunk writes its visible IDs to
+           its own range of _chunkVisible and counts to its own slots, so the
+           workers don't need to synchronize. */
+        Matrix4 _viewProjection;
+        Vector4 _planes[6];
+        std::vector<UnsignedInt> _chunkVisible;
+        std::vector<UnsignedInt> _chunkVisibleCounts, _chunkOccludedCounts;
+        std::size_t _frustumCulledCount = 0, _occlusionCulledCount = 0;
+
+        std::vector<std::thread> _workers;
+        std::mutex _mutex;
+        std::condition_variable _taskCondition, _doneCondition;
+        const std::function<void(std::size_t)>* _task = nullptr;
+        std::size_t _taskCount = 0;
+        std::atomic<std::size_t> _nextTask{0};
+        std::size_t _generation = 0, _busyWorkers = 0;
+        bool _stop = false;
+};
+
+}}
+
+#endif
@@ -0,0 +1,90 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Math/Matrix4.h>
+
+#include "Culler.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+namespace {
+
+/* A quad facing the camera, and the same quad with the opposite winding */
+const Vector3 QuadPositions[]{
+    {-1.0f, -1.0f, 0.0f}, { 1.0f, -1.0f, 0.0f},
+    {-1.0f,  1.0f, 0.0f}, { 1.0f,  1.0f, 0.0f}
+};
+const UnsignedInt FrontQuadIndices[]{0, 1, 2, 2, 1, 3};
+const UnsignedInt BackQuadIndices[]{0, 2, 1, 2, 3, 1};
+
+/* Camera in the origin looking down -Z, with a sphere far in front of it
+   and optionally a quad between the two that covers the sphere. Returns
+   whether the sphere was reported visible. */
+bool sphereVisible(Culler& culler, Containers::ArrayView<const UnsignedInt> quadIndices) {
+    culler.setSphereCount(1);
+    culler.setSphere(0, {0.0f, 0.0f, -20.0f}, 1.0f);
+    if(!quadIndices.isEmpty())
+        culler.addOccluder(
+            Matrix4::translation(Vector3::zAxis(-5.0f))*Matrix4::scaling(Vector3{4.0f}),
+            QuadPositions, quadIndices);
+
+    std::vector<UnsignedInt> visible;
+    culler.cull(Matrix4::perspectiveProjection(Deg(35.0f), 16.0f/9.0f, 0.1f, 100.0f), visible);
+    return visible.size() == 1;
+}
+
+}
+
+/* Checks the occlusion culling against the GL drawing without a window or
+   GPU. A quad occludes only if it's front-facing, as a back-facing one gets
+   culled when drawing. Exits with a non-zero code on a mismatch. */
+int main() {
+    Culler culler;
+
+    bool failed = false;
+    if(!sphereVisible(culler, nullptr)) {
+        Error{} << "Sphere with no occluder is not visible";
+        failed = true;
+    }
+    if(sphereVisible(culler, FrontQuadIndices)) {
+        Error{} << "Sphere behind a front-facing quad is visible";
+        failed = true;
+    }
+    if(!sphereVisible(culler, BackQuadIndices)) {
+        Error{} << "Sphere behind a back-facing quad is not visible";
+        failed = true;
+    }
+    if(failed) return 1;
+
+    Debug{} << "Occlusion culling matches the drawing";
+    return 0;
+}
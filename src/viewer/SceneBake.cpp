@@ -0,0 +1,184 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <chrono>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/Pair.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Format.h>
+#include <Magnum/Trade/AbstractImporter.h>
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MeshData.h>
+#include <Magnum/Trade/PhongMaterialData.h>
+#include <Magnum/Trade/SceneData.h>
+#include <Magnum/Trade/TextureData.h>
+
+#include "AssetLoader.h"
+#include "SceneCache.h"
+#include "TransformHierarchy.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+using namespace Math::Literals;
+
+/* Imports a scene the same way as the viewer does and saves everything the
+   viewer needs into a scene cache. Decoding and preprocessing is done by
+   the same AssetLoader, on all threads. */
+int main(int argc, char** argv) {
+    Utility::Arguments args;
+    args.addArgument("input").setHelp("input", "file to bake")
+        .addArgument("output").setHelp("output", "scene cache to write")
+        .addOption("importer", "AnySceneImporter")
+            .setHelp("importer", "importer plugin to use")
+        .addOption("threads", "0")
+            .setHelp("threads", "number of loading threads, 0 for all hardware threads", "N")
+        .setGlobalHelp("Bakes a 3D scene file into a cache for the viewer.")
+        .parse(argc, argv);
+
+    const auto begin = std::chrono::steady_clock::now();
+
+    PluginManager::Manager<Trade::AbstractImporter> manager;
+    Containers::Pointer<Trade::AbstractImporter> importer =
+        manager.loadAndInstantiate(args.value("importer"));
+    if(!importer || !importer->openFile(args.value("input")))
+        return 1;
+
+    AssetLoader loader{args.value("importer"), args.value("input"),
+        importer->image2DCount(), importer->meshCount(),
+        args.value<std::size_t>("threads")};
+
+    /* Texture parameters and materials, same as in the viewer */
+    Containers::Array<Containers::Optional<Trade::TextureData>> textures{importer->textureCount()};
+    for(UnsignedInt i = 0; i != importer->textureCount(); ++i) {
+        Containers::Optional<Trade::TextureData> textureData = importer->texture(i);
+        if(!textureData || textureData->type() != Trade::TextureType::Texture2D ||
+           textureData->image() >= importer->image2DCount()) {
+            Warning{} << "Cannot load texture" << i << importer->textureName(i);
+            continue;
+        }
+        textures[i] = std::move(textureData);
+    }
+    Containers::Array<Containers::Optional<Trade::PhongMaterialData>> materials{importer->materialCount()};
+    for(UnsignedInt i = 0; i != importer->materialCount(); ++i) {
+        Containers::Optional<Trade::MaterialData> materialData;
+        if(!(materialData = importer->material(i))) {
+            Warning{} << "Cannot load material" << i << importer->materialName(i);
+            continue;
+        }
+        materials[i] = std::move(*materialData).as<Trade::PhongMaterialData>();
+    }
+
+    /* Drawables with absolute transformations. Materials with a texture that
+       failed to load use their diffuse color, same as in the viewer. */
+    std::vector<SceneCacheDrawable> drawables;
+    const auto addDrawable = [&](const Matrix4& transformation, UnsignedInt mesh, Int materialId) {
+        SceneCacheDrawable drawable{};
+        drawable.transformation = transformation;
+        drawable.mesh = mesh;
+        drawable.texture = -1;
+        drawable.color = 0xffffffff_rgbaf;
+        if(materialId != -1 && materials[materialId]) {
+            const Trade::PhongMaterialData& material = *materials[materialId];
+            if(material.hasAttribute(Trade::MaterialAttribute::DiffuseTexture) &&
+               textures[material.diffuseTexture()])
+                drawable.texture = Int(material.diffuseTexture());
+            else drawable.color = material.diffuseColor();
+        }
+        drawables.push_back(drawable);
+    };
+    if(importer->defaultScene() == -1) {
+        if(importer->meshCount()) addDrawable({}, 0, -1);
+    } else {
+        Containers::Optional<Trade::SceneData> scene;
+        if(!(scene = importer->scene(importer->defaultScene())) ||
+           !scene->is3D() ||
+           !scene->hasField(Trade::SceneField::Parent) ||
+           !scene->hasField(Trade::SceneField::Mesh))
+        {
+            Error{} << "Cannot load scene" << importer->defaultScene()
+                << importer->sceneName(importer->defaultScene());
+            return 2;
+        }
+
+        /* Same hierarchy as the viewer builds, parent -2 marks objects that
+           aren't part of it */
+        std::vector<Int> parents(std::size_t(scene->mappingBound()), -2);
+        for(const Containers::Pair<UnsignedInt, Int>& parent: scene->parentsAsArray())
+            parents[parent.first()] = parent.second();
+        TransformHierarchy hierarchy{parents};
+        for(const Containers::Pair<UnsignedInt, Matrix4>& transformation: scene->transformations3DAsArray()) {
+            const UnsignedInt node = hierarchy.node(transformation.first());
+            if(node != TransformHierarchy::NoNode)
+                hierarchy.setTransformation(node, transformation.second());
+        }
+        hierarchy.update();
+
+        for(const Containers::Pair<UnsignedInt, Containers::Pair<UnsignedInt, Int>>&
+            meshMaterial: scene->meshesMaterialsAsArray())
+        {
+            const UnsignedInt node = hierarchy.node(meshMaterial.first());
+            if(node == TransformHierarchy::NoNode) continue;
+            addDrawable(hierarchy.absoluteTransformation(node),
+                meshMaterial.second().first(), meshMaterial.second().second());
+        }
+    }
+
+    /* Collect the decoded assets, they finish in arbitrary order */
+    Containers::Array<Containers::Optional<Trade::MeshData>> meshes{importer->meshCount()};
+    std::vector<std::vector<Trade::ImageData2D>> images(importer->image2DCount());
+    while(Containers::Optional<AssetLoader::Asset> asset = loader.waitFinished()) {
+        if(asset->type == AssetLoader::AssetType::Mesh) {
+            if(!asset->mesh) Warning{} << "Cannot load mesh" << asset->id;
+            meshes[asset->id] = std::move(asset->mesh);
+        } else {
+            if(asset->imageLevels.empty()) Warning{} << "Cannot load image" << asset->id;
+            images[asset->id] = std::move(asset->imageLevels);
+        }
+    }
+
+    SceneCacheWriter writer;
+    for(const Containers::Optional<Trade::MeshData>& mesh: meshes)
+        writer.addMesh(mesh);
+    for(const std::vector<Trade::ImageData2D>& levels: images)
+        writer.addImage(levels);
+    for(const Containers::Optional<Trade::TextureData>& texture: textures)
+        writer.addTexture(texture);
+    for(const SceneCacheDrawable& drawable: drawables)
+        writer.addDrawable(drawable);
+    if(!writer.write(args.value("output")))
+        return 3;
+
+    Utility::print("Baked {} meshes, {} images and {} drawables into {} kB in {} s\n",
+        meshes.size(), images.size(), drawables.size(), writer.dataSize()/1024,
+        std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count());
+}
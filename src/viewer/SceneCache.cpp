@@ -0,0 +1,352 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "SceneCache.h"
+
+#include <cstring>
+#include <Corrade/Containers/ArrayViewStl.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Utility/Assert.h>
+#include <Corrade/Utility/Debug.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Sampler.h>
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MeshData.h>
+#include <Magnum/Trade/TextureData.h>
+
+namespace Magnum { namespace Examples {
+
+namespace {
+
+constexpr char Magic[8]{'M', 'N', 'V', 'I', 'E', 'W', 'E', 'R'};
+
+std::size_t aligned(std::size_t offset) {
+    return (offset + SceneCacheAlignment - 1)/SceneCacheAlignment*SceneCacheAlignment;
+}
+
+}
+
+UnsignedLong SceneCacheWriter::append(const Containers::ArrayView<const char> data) {
+    /* Offsets are relative to the file start, which is header size before
+       the data */
+    _data.resize(aligned(_data.size()));
+    const UnsignedLong offset = sizeof(Header) + _data.size();
+    _data.insert(_data.end(), data.begin(), data.end());
+    return offset;
+}
+
+SceneCacheWriter& SceneCacheWriter::addMesh(const Containers::Optional<Trade::MeshData>& mesh) {
+    SceneCacheMesh out{};
+    /* Primitives the viewer can't draw are treated as a failed import, see
+       SceneCache::open() */
+    if(!mesh || !mesh->hasAttribute(Trade::MeshAttribute::Position) ||
+       UnsignedInt(mesh->primitive()) > UnsignedInt(MeshPrimitive::TriangleFan)) {
+        _meshes.push_back(out);
+        return *this;
+    }
+
+    /* Convert to the fixed layout */
+    std::vector<SceneCacheVertex> vertices(mesh->vertexCount());
+    {
+        const Containers::Array<Vector3> positions = mesh->positions3DAsArray();
+        if(!positions.isEmpty())
+            out.bounds = {positions[0], positions[0]};
+        for(std::size_t i = 0; i != vertices.size(); ++i) {
+            vertices[i].position = positions[i];
+            out.bounds.min() = Math::min(out.bounds.min(), positions[i]);
+            out.bounds.max() = Math::max(out.bounds.max(), positions[i]);
+        }
+    }
+    if(mesh->hasAttribute(Trade::MeshAttribute::Normal)) {
+        const Containers::Array<Vector3> normals = mesh->normalsAsArray();
+        for(std::size_t i = 0; i != vertices.size(); ++i)
+            vertices[i].normal = normals[i];
+    }
+    if(mesh->hasAttribute(Trade::MeshAttribute::TextureCoordinates)) {
+        const Containers::Array<Vector2> textureCoordinates = mesh->textureCoordinates2DAsArray();
+        for(std::size_t i = 0; i != vertices.size(); ++i)
+            vertices[i].textureCoordinates = textureCoordinates[i];
+    }
+
+    out.primitive = UnsignedInt(mesh->primitive());
+    out.vertexCount = UnsignedInt(vertices.size());
+    out.vertexOffset = append(Containers::arrayCast<const char>(Containers::arrayView(vertices)));
+    if(mesh->isIndexed()) {
+        const Containers::Array<UnsignedInt> indices = mesh->indicesAsArray();
+        out.indexCount = UnsignedInt(indices.size());
+        out.indexOffset = append(Containers::arrayCast<const char>(Containers::arrayView(indices)));
+    }
+    _meshes.push_back(out);
+    return *this;
+}
+
+SceneCacheWriter& SceneCacheWriter::addImage(const std::vector<Trade::ImageData2D>& levels) {
+    SceneCacheImage out{};
+    out.firstLevel = UnsignedInt(_levels.size());
+    /* Implementation-specific formats are treated as a failed import, see
+       SceneCache::open() */
+    if(levels.empty() || isPixelFormatImplementationSpecific(levels.front().format())) {
+        _images.push_back(out);
+        return *this;
+    }
+    out.levelCount = UnsignedInt(levels.size());
+    out.format = UnsignedInt(levels.front().format());
+
+    for(const Trade::ImageData2D& level: levels) {
+        CORRADE_INTERNAL_ASSERT(!level.isCompressed() && level.format() == levels.front().format());
+
+        /* Drop any row padding, so the level can be uploaded with one-byte
+           alignment */
+        const Containers::StridedArrayView3D<const char> pixels = level.pixels();
+        std::vector<char> data;
+        data.reserve(pixels.size()[0]*pixels.size()[1]*pixels.size()[2]);
+        for(std::size_t y = 0; y != pixels.size()[0]; ++y)
+            for(std::size_t x = 0; x != pixels.size()[1]; ++x)
+                for(std::size_t c = 0; c != pixels.size()[2]; ++c)
+                    data.push_back(pixels[y][x][c]);
+
+        SceneCacheImageLevel levelOut{};
+        levelOut.size = level.size();
+        levelOut.dataSize = data.size();
+        levelOut.dataOffset = append(Containers::arrayView(data));
+        _levels.push_back(levelOut);
+    }
+
+    _images.push_back(out);
+    return *this;
+}
+
+SceneCacheWriter& SceneCacheWriter::addTexture(const Containers::Optional<Trade::TextureData>& texture) {
+    SceneCacheTexture out{};
+    out.image = ~UnsignedInt{};
+    if(texture) {
+        out.image = texture->image();
+        out.magnificationFilter = UnsignedInt(texture->magnificationFilter());
+        out.minificationFilter = UnsignedInt(texture->minificationFilter());
+        out.mipmapFilter = UnsignedInt(texture->mipmapFilter());
+        out.wrapping[0] = UnsignedInt(texture->wrapping()[0]);
+        out.wrapping[1] = UnsignedInt(texture->wrapping()[1]);
+    }
+    _textures.push_back(out);
+    return *this;
+}
+
+SceneCacheWriter& SceneCacheWriter::addDrawable(const SceneCacheDrawable& drawable) {
+    _drawables.push_back(drawable);
+    return *this;
+}
+
+bool SceneCacheWriter::write(const Containers::StringView filename) const {
+    /* The tables go after the data, each aligned as well */
+    std::vector<char> tables;
+    const auto appendTable = [&](const void* data, std::size_t size) {
+        tables.resize(aligned(sizeof(Header) + _data.size() + tables.size()) - sizeof(Header) - _data.size());
+        const UnsignedLong offset = sizeof(Header) + _data.size() + tables.size();
+        const char* const bytes = static_cast<const char*>(data);
+        tables.insert(tables.end(), bytes, bytes + size);
+        return offset;
+    };
+
+    Header header{};
+    std::memcpy(header.magic, Magic, sizeof(Magic));
+    header.version = SceneCacheVersion;
+    header.meshCount = UnsignedInt(_meshes.size());
+    header.imageCount = UnsignedInt(_images.size());
+    header.levelCount = UnsignedInt(_levels.size());
+    header.textureCount = UnsignedInt(_textures.size());
+    header.drawableCount = UnsignedInt(_drawables.size());
+    header.meshOffset = appendTable(_meshes.data(), _meshes.size()*sizeof(SceneCacheMesh));
+    header.imageOffset = appendTable(_images.data(), _images.size()*sizeof(SceneCacheImage));
+    header.levelOffset = appendTable(_levels.data(), _levels.size()*sizeof(SceneCacheImageLevel));
+    header.textureOffset = appendTable(_textures.data(), _textures.size()*sizeof(SceneCacheTexture));
+    header.drawableOffset = appendTable(_drawables.data(), _drawables.size()*sizeof(SceneCacheDrawable));
+    header.fileSize = sizeof(Header) + _data.size() + tables.size();
+
+    return Utility::Path::write(filename, Containers::arrayView(&header, 1)) &&
+        Utility::Path::append(filename, Containers::arrayView(_data)) &&
+        Utility::Path::append(filename, Containers::arrayView(tables));
+}
+
+bool SceneCache::isSceneCache(const Containers::StringView filename) {
+    if(!Utility::Path::exists(filename)) return false;
+    Containers::Optional<Containers::Array<const char, Utility::Path::MapDeleter>> data = Utility::Path::mapRead(filename);
+    return data && data->size() >= sizeof(Magic) &&
+        std::memcmp(data->data(), Magic, sizeof(Magic)) == 0;
+}
+
+Containers::Optional<SceneCache> SceneCache::open(const Containers::StringView filename) {
+    Containers::Optional<Containers::Array<const char, Utility::Path::MapDeleter>> data = Utility::Path::mapRead(filename);
+    if(!data) return {};
+
+    if(data->size() < sizeof(Header)) {
+        Error{} << "SceneCache:" << filename << "is too short";
+        return {};
+    }
+    const Header& header = *reinterpret_cast<const Header*>(data->data());
+    if(std::memcmp(header.magic, Magic, sizeof(Magic)) != 0) {
+        Error{} << "SceneCache:" << filename << "is not a scene cache";
+        return {};
+    }
+    if(header.version != SceneCacheVersion) {
+        Error{} << "SceneCache: unsupported version" << header.version << "of" << filename;
+        return {};
+    }
+    if(header.fileSize != data->size()) {
+        Error{} << "SceneCache: expected" << header.fileSize << "bytes in" << filename << "but got" << data->size();
+        return {};
+    }
+
+    /* Check that everything is in bounds and all enums are valid, so the
+       accessors and the viewer don't need to */
+    const std::size_t size = data->size();
+    const auto inBounds = [size](UnsignedLong offset, UnsignedLong count, std::size_t elementSize) {
+        return offset % SceneCacheAlignment == 0 && offset <= size &&
+            count <= (size - offset)/elementSize;
+    };
+    if(!inBounds(header.meshOffset, header.meshCount, sizeof(SceneCacheMesh)) ||
+       !inBounds(header.imageOffset, header.imageCount, sizeof(SceneCacheImage)) ||
+       !inBounds(header.levelOffset, header.levelCount, sizeof(SceneCacheImageLevel)) ||
+       !inBounds(header.textureOffset, header.textureCount, sizeof(SceneCacheTexture)) ||
+       !inBounds(header.drawableOffset, header.drawableCount, sizeof(SceneCacheDrawable))) {
+        Error{} << "SceneCache: table out of bounds in" << filename;
+        return {};
+    }
+
+    SceneCache cache{std::move(*data)};
+    for(const SceneCacheMesh& mesh: cache.meshes()) {
+        if(!inBounds(mesh.vertexOffset, mesh.vertexCount, sizeof(SceneCacheVertex)) ||
+           !inBounds(mesh.indexOffset, mesh.indexCount, sizeof(UnsignedInt))) {
+            Error{} << "SceneCache: mesh data out of bounds in" << filename;
+            return {};
+        }
+        /* Meshes that failed to import have everything zero */
+        if(!mesh.vertexCount) continue;
+
+        /* Only primitives that the viewer can draw */
+        if(mesh.primitive < UnsignedInt(MeshPrimitive::Points) ||
+           mesh.primitive > UnsignedInt(MeshPrimitive::TriangleFan)) {
+            Error{} << "SceneCache: invalid mesh primitive" << mesh.primitive << "in" << filename;
+            return {};
+        }
+        /* The index buffer goes to the GPU as-is and the culler reads the
+           vertices through it, so this has to go through all of them */
+        const auto indices = Containers::arrayCast<const UnsignedInt>(
+            cache.data(mesh.indexOffset, mesh.indexCount*sizeof(UnsignedInt)));
+        for(const UnsignedInt index: indices) {
+            if(index >= mesh.vertexCount) {
+                Error{} << "SceneCache: mesh index out of bounds in" << filename;
+                return {};
+            }
+        }
+    }
+    for(const SceneCacheImage& image: cache.images()) {
+        if(image.firstLevel > header.levelCount || image.levelCount > header.levelCount - image.firstLevel) {
+            Error{} << "SceneCache: image levels out of bounds in" << filename;
+            return {};
+        }
+        /* Images that failed to import have no levels */
+        if(!image.levelCount) continue;
+
+        /* Only generic formats, those have a known size */
+        if(image.format < UnsignedInt(PixelFormat::R8Unorm) ||
+           image.format > UnsignedInt(PixelFormat::Depth32FStencil8UI)) {
+            Error{} << "SceneCache: invalid image format" << image.format << "in" << filename;
+            return {};
+        }
+        const UnsignedInt pixelSize = pixelFormatSize(PixelFormat(image.format));
+
+        /* The viewer allocates the texture storage from the base level size
+           and uploads the levels into it, so they have to fit the mip
+           chain */
+        const Vector2i baseSize = cache.levels()[image.firstLevel].size;
+        if(baseSize.x() <= 0 || baseSize.y() <= 0 ||
+           image.levelCount > UnsignedInt(Math::log2(baseSize.max()) + 1)) {
+            Error{} << "SceneCache: invalid image size in" << filename;
+            return {};
+        }
+        for(UnsignedInt i = 0; i != image.levelCount; ++i) {
+            const SceneCacheImageLevel& level = cache.levels()[image.firstLevel + i];
+            if(level.size != Math::max(baseSize >> Int(i), Vector2i{1})) {
+                Error{} << "SceneCache: invalid image size in" << filename;
+                return {};
+            }
+            if(!inBounds(level.dataOffset, level.dataSize, 1) ||
+               level.dataSize != UnsignedLong(level.size.x())*UnsignedLong(level.size.y())*pixelSize) {
+                Error{} << "SceneCache: image data out of bounds in" << filename;
+                return {};
+            }
+        }
+    }
+    for(const SceneCacheTexture& texture: cache.textures()) {
+        if(texture.image != ~UnsignedInt{} && texture.image >= header.imageCount) {
+            Error{} << "SceneCache: texture image out of bounds in" << filename;
+            return {};
+        }
+        if(texture.magnificationFilter > UnsignedInt(SamplerFilter::Linear) ||
+           texture.minificationFilter > UnsignedInt(SamplerFilter::Linear) ||
+           texture.mipmapFilter > UnsignedInt(SamplerMipmap::Linear) ||
+           texture.wrapping[0] > UnsignedInt(SamplerWrapping::MirrorClampToEdge) ||
+           texture.wrapping[1] > UnsignedInt(SamplerWrapping::MirrorClampToEdge)) {
+            Error{} << "SceneCache: invalid texture sampler in" << filename;
+            return {};
+        }
+    }
+    for(const SceneCacheDrawable& drawable: cache.drawables()) {
+        if(drawable.mesh >= header.meshCount || drawable.texture >= Int(header.textureCount) || drawable.texture < -1) {
+            Error{} << "SceneCache: drawable references out of bounds in" << filename;
+            return {};
+        }
+    }
+
+    return Containers::Optional<SceneCache>{std::move(cache)};
+}
+
+Containers::ArrayView<const SceneCacheMesh> SceneCache::meshes() const {
+    return {reinterpret_cast<const SceneCacheMesh*>(_data.data() + header().meshOffset), header().meshCount};
+}
+
+Containers::ArrayView<const SceneCacheImage> SceneCache::images() const {
+    return {reinterpret_cast<const SceneCacheImage*>(_data.data() + header().imageOffset), header().imageCount};
+}
+
+Containers::ArrayView<const SceneCacheImageLevel> SceneCache::levels() const {
+    return {reinterpret_cast<const SceneCacheImageLevel*>(_data.data() + header().levelOffset), header().levelCount};
+}
+
+Containers::ArrayView<const SceneCacheTexture> SceneCache::textures() const {
+    return {reinterpret_cast<const SceneCacheTexture*>(_data.data() + header().textureOffset), header().textureCount};
+}
+
+Containers::ArrayView<const SceneCacheDrawable> SceneCache::drawables() const {
+    return {reinterpret_cast<const SceneCacheDrawable*>(_data.data() + header().drawableOffset), header().drawableCount};
+}
+
+}}
@@ -0,0 +1,195 @@
+#ifndef Magnum_Examples_Viewer_SceneCache_h
+#define Magnum_Examples_Viewer_SceneCache_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayView.h>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/StringView.h>
+#include <Corrade/Utility/Path.h>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Math/Matrix4.h>
+#include <Magnum/Math/Range.h>
+#include <Magnum/Trade/Trade.h>
+
+namespace Magnum { namespace Examples {
+
+/* Scene preprocessed for the viewer. The file consists of a header, the
+   vertex, index and pixel data and tables describing them, everything at a
+   64-byte aligned offset. Meshes are stored in a single fixed vertex layout
+   that can be uploaded to a GL buffer as-is, images with all their mip
+   levels and the hierarchy is flattened into a list of drawables with
+   absolute transformations. Nothing is parsed on load, the file is just
+   mapped into memory. Like with the importers, enum values are stored with
+   their numeric values in Magnum and all data in native byte order, so the
+   cache is meant for the same platform and Magnum version. */
+enum: UnsignedInt { SceneCacheVersion = 3 };
+enum: std::size_t { SceneCacheAlignment = 64 };
+
+struct SceneCacheVertex {
+    Vector3 position;
+    Vector3 normal;
+    Vector2 textureCoordinates;
+};
+
+struct SceneCacheMesh {
+    UnsignedInt primitive;      /* MeshPrimitive */
+    UnsignedInt indexCount;     /* UnsignedInt indices, 0 if not indexed */
+    UnsignedInt vertexCount;    /* 0 if the mesh failed to import */
+    UnsignedInt padding;
+    Range3D bounds;             /* Of all positions */
+    UnsignedLong indexOffset;
+    UnsignedLong vertexOffset;
+};
+
+struct SceneCacheImage {
+    UnsignedInt format;         /* PixelFormat */
+    UnsignedInt firstLevel;     /* Index into the level table */
+    UnsignedInt levelCount;     /* 0 if the image failed to import */
+    UnsignedInt padding;
+};
+
+struct SceneCacheImageLevel {
+    Vector2i size;              /* Rows are tightly packed */
+    UnsignedLong dataOffset;
+    UnsignedLong dataSize;
+};
+
+struct SceneCacheTexture {
+    UnsignedInt image;                  /* ~0u if the texture failed to import */
+    UnsignedInt magnificationFilter;    /* SamplerFilter */
+    UnsignedInt minificationFilter;     /* SamplerFilter */
+    UnsignedInt mipmapFilter;           /* SamplerMipmap */
+    UnsignedInt wrapping[2];            /* SamplerWrapping */
+};
+
+struct SceneCacheDrawable {
+    Matrix4 transformation;
+    Color4 color;
+    UnsignedInt mesh;
+    Int texture;                /* -1 for a colored drawable */
+    UnsignedInt padding[2];
+};
+
+class SceneCacheWriter {
+    public:
+        /* Meshes, images and textures are referenced by their order of
+           addition. Pass an empty optional or vector for an asset that
+           failed to import to keep the numbering. Meshes are expected to
+           have normals already, as AssetLoader makes them, missing normals
+           and texture coordinates are zero. The data are copied, so they
+           don't need to stay alive. */
+        SceneCacheWriter& addMesh(const Containers::Optional<Trade::MeshData>& mesh);
+        SceneCacheWriter& addImage(const std::vector<Trade::ImageData2D>& levels);
+        SceneCacheWriter& addTexture(const Containers::Optional<Trade::TextureData>& texture);
+        SceneCacheWriter& addDrawable(const SceneCacheDrawable& drawable);
+
+        std::size_t dataSize() const { return _data.size(); }
+
+        bool write(Containers::StringView filename) const;
+
+    private:
+        friend class SceneCache;
+
+        struct Header {
+            char magic[8];
+            UnsignedInt version;
+            UnsignedInt meshCount;
+            UnsignedInt imageCount;
+            UnsignedInt levelCount;
+            UnsignedInt textureCount;
+            UnsignedInt drawableCount;
+            UnsignedLong fileSize;
+            UnsignedLong meshOffset;
+            UnsignedLong imageOffset;
+            UnsignedLong levelOffset;
+            UnsignedLong textureOffset;
+            UnsignedLong drawableOffset;
+            /* So the data right after the header is aligned */
+            char padding[48];
+        };
+
+        /* Offsets in the file are the header size plus an aligned offset in
+           the data, which is aligned only if the header size is */
+        static_assert(sizeof(Header) % SceneCacheAlignment == 0,
+            "header size has to be a multiple of the alignment");
+
+        /* Appends to _data at an aligned offset, returns the offset in the
+           file */
+        UnsignedLong append(Containers::ArrayView<const char> data);
+
+        std::vector<char> _data;
+        std::vector<SceneCacheMesh> _meshes;
+        std::vector<SceneCacheImage> _images;
+        std::vector<SceneCacheImageLevel> _levels;
+        std::vector<SceneCacheTexture> _textures;
+        std::vector<SceneCacheDrawable> _drawables;
+};
+
+class SceneCache {
+    public:
+        /* Whether the file starts like a scene cache, without checking
+           anything else. Doesn't print anything if it doesn't. */
+        static bool isSceneCache(Containers::StringView filename);
+
+        /* Map the file and check that everything referenced from the tables
+           is in bounds, all indices are in range of their mesh, image levels
+           form a valid mip chain and the stored enums are valid. Prints a
+           message and returns an empty optional on failure. */
+        static Containers::Optional<SceneCache> open(Containers::StringView filename);
+
+        Containers::ArrayView<const SceneCacheMesh> meshes() const;
+        Containers::ArrayView<const SceneCacheImage> images() const;
+        Containers::ArrayView<const SceneCacheImageLevel> levels() const;
+        Containers::ArrayView<const SceneCacheTexture> textures() const;
+        Containers::ArrayView<const SceneCacheDrawable> drawables() const;
+
+        /* View on data in the mapped file */
+        Containers::ArrayView<const char> data(UnsignedLong offset, UnsignedLong size) const {
+            return {_data.data() + offset, std::size_t(size)};
+        }
+
+    private:
+        using Header = SceneCacheWriter::Header;
+
+        explicit SceneCache(Containers::Array<const char, Utility::Path::MapDeleter>&& data): _data{std::move(data)} {}
+
+        const Header& header() const {
+            return *reinterpret_cast<const Header*>(_data.data());
+        }
+
+        Containers::Array<const char, Utility::Path::MapDeleter> _data;
+};
+
+}}
+
+#endif
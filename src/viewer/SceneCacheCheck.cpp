@@ -0,0 +1,192 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <cstring>
+#include <vector>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/StridedArrayView.h>
+#include <Corrade/Containers/StringView.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Path.h>
+#include <Magnum/Mesh.h>
+#include <Magnum/PixelFormat.h>
+#include <Magnum/Sampler.h>
+#include <Magnum/Math/Color.h>
+#include <Magnum/Trade/ImageData.h>
+#include <Magnum/Trade/MeshData.h>
+#include <Magnum/Trade/TextureData.h>
+
+#include "SceneCache.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+using namespace Math::Literals;
+
+namespace {
+
+const Vector3 QuadPositions[]{
+    {-1.0f, -1.0f, 0.0f}, { 1.0f, -1.0f, 0.0f},
+    {-1.0f,  1.0f, 0.5f}, { 1.0f,  1.0f, 0.5f}
+};
+const UnsignedInt QuadIndices[]{0, 1, 2, 2, 1, 3};
+
+/* A 2x2 RGBA image and its 1x1 mip level */
+const char BaseLevel[]{
+     0,  1,  2,  3,  4,  5,  6,  7,
+     8,  9, 10, 11, 12, 13, 14, 15
+};
+const char SmallLevel[]{16, 17, 18, 19};
+
+template<class T> Containers::Array<char> copy(const T& data) {
+    Containers::Array<char> out{NoInit, sizeof(data)};
+    std::memcpy(out.data(), &data, sizeof(data));
+    return out;
+}
+
+}
+
+/* Bakes a scene cache with a mesh, an image with two levels, a texture and
+   a drawable, plus a mesh and an image that failed to import, opens it again
+   and compares the contents, without a window or GPU. Exits with a non-zero
+   code on a mismatch. */
+int main() {
+    SceneCacheWriter writer;
+    {
+        Containers::Array<char> indexData = copy(QuadIndices);
+        Containers::Array<char> vertexData = copy(QuadPositions);
+        const Trade::MeshIndexData indices{Containers::arrayCast<const UnsignedInt>(indexData)};
+        const Trade::MeshAttributeData positions{Trade::MeshAttribute::Position,
+            Containers::arrayCast<const Vector3>(vertexData)};
+        writer.addMesh(Trade::MeshData{MeshPrimitive::Triangles,
+            std::move(indexData), indices,
+            std::move(vertexData), {positions}});
+    }
+    writer.addMesh(Containers::NullOpt);
+    {
+        std::vector<Trade::ImageData2D> levels;
+        levels.emplace_back(PixelFormat::RGBA8Unorm, Vector2i{2, 2}, copy(BaseLevel));
+        levels.emplace_back(PixelFormat::RGBA8Unorm, Vector2i{1, 1}, copy(SmallLevel));
+        writer.addImage(levels);
+    }
+    writer.addImage({});
+    writer.addTexture(Trade::TextureData{Trade::TextureType::Texture2D,
+        SamplerFilter::Linear, SamplerFilter::Nearest, SamplerMipmap::Linear,
+        SamplerWrapping::ClampToEdge, 0});
+    SceneCacheDrawable drawable{};
+    drawable.transformation = Matrix4::translation({1.0f, 2.0f, 3.0f});
+    drawable.color = 0x3bd267ff_rgbaf;
+    drawable.mesh = 0;
+    drawable.texture = 0;
+    writer.addDrawable(drawable);
+
+    const Containers::StringView filename = "viewer-scenecache-check.bin";
+    if(!writer.write(filename)) return 2;
+    Containers::Optional<SceneCache> cache = SceneCache::open(filename);
+    Utility::Path::remove(filename);
+    if(!cache) {
+        Error{} << "Baked scene cache can't be opened";
+        return 1;
+    }
+
+    bool failed = false;
+    const auto check = [&failed](bool condition, const char* message) {
+        if(condition) return;
+        Error{} << message;
+        failed = true;
+    };
+
+    check(cache->meshes().size() == 2, "Mesh count doesn't match");
+    if(cache->meshes().size() == 2) {
+        const SceneCacheMesh& mesh = cache->meshes()[0];
+        check(MeshPrimitive(mesh.primitive) == MeshPrimitive::Triangles,
+            "Mesh primitive doesn't match");
+        check(mesh.vertexCount == 4 && mesh.indexCount == 6,
+            "Mesh vertex or index count doesn't match");
+        check(mesh.bounds == Range3D{{-1.0f, -1.0f, 0.0f}, {1.0f, 1.0f, 0.5f}},
+            "Mesh bounds don't match");
+        if(mesh.vertexCount == 4 && mesh.indexCount == 6) {
+            const auto vertices = Containers::arrayCast<const SceneCacheVertex>(
+                cache->data(mesh.vertexOffset, mesh.vertexCount*sizeof(SceneCacheVertex)));
+            for(std::size_t i = 0; i != vertices.size(); ++i)
+                check(vertices[i].position == QuadPositions[i], "Mesh positions don't match");
+            check(std::memcmp(cache->data(mesh.indexOffset, sizeof(QuadIndices)).data(),
+                QuadIndices, sizeof(QuadIndices)) == 0, "Mesh indices don't match");
+        }
+        check(!cache->meshes()[1].vertexCount, "Failed mesh is not empty");
+    }
+
+    check(cache->images().size() == 2, "Image count doesn't match");
+    if(cache->images().size() == 2) {
+        const SceneCacheImage& image = cache->images()[0];
+        check(PixelFormat(image.format) == PixelFormat::RGBA8Unorm,
+            "Image format doesn't match");
+        check(image.levelCount == 2, "Image level count doesn't match");
+        if(image.levelCount == 2) {
+            const SceneCacheImageLevel& base = cache->levels()[image.firstLevel];
+            const SceneCacheImageLevel& small = cache->levels()[image.firstLevel + 1];
+            check(base.size == Vector2i{2, 2} && small.size == Vector2i{1, 1},
+                "Image level sizes don't match");
+            check(base.dataSize == sizeof(BaseLevel) && std::memcmp(
+                cache->data(base.dataOffset, base.dataSize).data(),
+                BaseLevel, sizeof(BaseLevel)) == 0,
+                "Image base level data don't match");
+            check(small.dataSize == sizeof(SmallLevel) && std::memcmp(
+                cache->data(small.dataOffset, small.dataSize).data(),
+                SmallLevel, sizeof(SmallLevel)) == 0,
+                "Image second level data don't match");
+        }
+        check(!cache->images()[1].levelCount, "Failed image is not empty");
+    }
+
+    check(cache->textures().size() == 1, "Texture count doesn't match");
+    if(cache->textures().size() == 1) {
+        const SceneCacheTexture& texture = cache->textures()[0];
+        check(texture.image == 0, "Texture image doesn't match");
+        check(SamplerFilter(texture.minificationFilter) == SamplerFilter::Linear &&
+              SamplerFilter(texture.magnificationFilter) == SamplerFilter::Nearest &&
+              SamplerMipmap(texture.mipmapFilter) == SamplerMipmap::Linear,
+            "Texture filters don't match");
+        check(SamplerWrapping(texture.wrapping[0]) == SamplerWrapping::ClampToEdge &&
+              SamplerWrapping(texture.wrapping[1]) == SamplerWrapping::ClampToEdge,
+            "Texture wrapping doesn't match");
+    }
+
+    check(cache->drawables().size() == 1, "Drawable count doesn't match");
+    if(cache->drawables().size() == 1) {
+        const SceneCacheDrawable& out = cache->drawables()[0];
+        check(out.transformation == drawable.transformation &&
+              out.color == drawable.color && out.mesh == 0 && out.texture == 0,
+            "Drawable doesn't match");
+    }
+
+    if(failed) return 1;
+
+    Debug{} << "Baked scene cache opens with the same contents";
+    return 0;
+}
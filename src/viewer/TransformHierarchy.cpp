@@ -0,0 +1,125 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "TransformHierarchy.h"
+
+#include <algorithm>
+#include <Corrade/Utility/Assert.h>
+
+namespace Magnum { namespace Examples {
+
+TransformHierarchy::TransformHierarchy(const std::vector<Int>& parents): _nodes(parents.size(), NoNode) {
+    /* Children of each object, in the same order as they appear in the
+       parent list. Parents outside of the object range are treated the same
+       as objects that aren't in the hierarchy, the child gets dropped. */
+    std::vector<UnsignedInt> childOffsets(parents.size() + 1);
+    for(const Int parent: parents)
+        if(parent >= 0 && std::size_t(parent) < parents.size())
+            ++childOffsets[parent + 1];
+    for(std::size_t i = 0; i != parents.size(); ++i)
+        childOffsets[i + 1] += childOffsets[i];
+    std::vector<UnsignedInt> children(childOffsets.back());
+    {
+        std::vector<UnsignedInt> next{childOffsets.begin(), childOffsets.end() - 1};
+        for(std::size_t i = 0; i != parents.size(); ++i)
+            if(parents[i] >= 0 && std::size_t(parents[i]) < parents.size())
+                children[next[parents[i]]++] = UnsignedInt(i);
+    }
+
+    /* Depth-first walk from all roots, without recursion as the hierarchy
+       can be arbitrarily deep. Pushing in reverse makes the nodes come out in
+       the original order of siblings. Objects in a cycle are never reached
+       from a root. */
+    std::vector<UnsignedInt> stack;
+    for(std::size_t i = parents.size(); i != 0; --i)
+        if(parents[i - 1] == -1) stack.push_back(UnsignedInt(i - 1));
+    _parents.reserve(parents.size());
+    while(!stack.empty()) {
+        const UnsignedInt object = stack.back();
+        stack.pop_back();
+
+        _nodes[object] = UnsignedInt(_parents.size());
+        _parents.push_back(parents[object] == -1 ? -1 : Int(_nodes[parents[object]]));
+        for(UnsignedInt i = childOffsets[object + 1]; i != childOffsets[object]; --i)
+            stack.push_back(children[i - 1]);
+    }
+
+    /* Descendants are right after the node, so the end of a subtree is the
+       furthest end of any of its children's subtrees */
+    const std::size_t nodeCount = _parents.size();
+    _subtreeEnds.resize(nodeCount);
+    for(std::size_t i = nodeCount; i != 0; --i) {
+        const std::size_t node = i - 1;
+        _subtreeEnds[node] = std::max(_subtreeEnds[node], UnsignedInt(node + 1));
+        if(_parents[node] != -1)
+            _subtreeEnds[_parents[node]] = std::max(_subtreeEnds[_parents[node]], _subtreeEnds[node]);
+    }
+
+    _transformations.resize(nodeCount);
+    _absoluteTransformations.resize(nodeCount);
+    _dirtyFlags.resize(nodeCount);
+}
+
+void TransformHierarchy::setTransformation(const UnsignedInt node, const Matrix4& transformation) {
+    CORRADE_INTERNAL_ASSERT(node < _transformations.size());
+    _transformations[node] = transformation;
+    if(_dirtyFlags[node]) return;
+    _dirtyFlags[node] = true;
+    _dirty.push_back(node);
+}
+
+std::size_t TransformHierarchy::update() {
+    if(_dirty.empty()) return 0;
+
+    /* With the dirty nodes sorted, a node that's inside the range of the
+       previously updated one is its descendant and was already recalculated
+       with it */
+    std::sort(_dirty.begin(), _dirty.end());
+    std::size_t updated = 0;
+    UnsignedInt end = 0;
+    for(const UnsignedInt dirty: _dirty) {
+        _dirtyFlags[dirty] = false;
+        if(dirty < end) continue;
+
+        end = _subtreeEnds[dirty];
+        const Int parent = _parents[dirty];
+        _absoluteTransformations[dirty] = parent == -1 ?
+            _transformations[dirty] :
+            _absoluteTransformations[parent]*_transformations[dirty];
+        for(UnsignedInt node = dirty + 1; node != end; ++node)
+            _absoluteTransformations[node] =
+                _absoluteTransformations[_parents[node]]*_transformations[node];
+        updated += end - dirty;
+    }
+
+    _dirty.clear();
+    return updated;
+}
+
+}}
@@ -0,0 +1,100 @@
+#ifndef Magnum_Examples_Viewer_TransformHierarchy_h
+#define Magnum_Examples_Viewer_TransformHierarchy_h
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <vector>
+#include <Magnum/Magnum.h>
+#include <Magnum/Math/Matrix4.h>
+
+namespace Magnum { namespace Examples {
+
+/* Transformation hierarchy of a scene, without any per-object allocations.
+   Nodes are stored in depth-first order, so every node comes after its
+   parent and all descendants of a node form a contiguous range right after
+   it. Absolute transformations are then recalculated in a single linear pass
+   over each changed range, reading the parent from an already updated slot,
+   and only for nodes whose transformation or a parent transformation changed
+   since the last update(). */
+class TransformHierarchy {
+    public:
+        /* Returned from node() for objects that aren't in the hierarchy */
+        enum: UnsignedInt { NoNode = ~UnsignedInt{} };
+
+        explicit TransformHierarchy() = default;
+
+        /* Parent object ID for each object, -1 for root objects and -2 for
+           objects that aren't part of the hierarchy. Objects that don't have
+           a path to a root, such as when their parents form a cycle, are
+           left out as well. All transformations are initially identity. */
+        explicit TransformHierarchy(const std::vector<Int>& parents);
+
+        std::size_t nodeCount() const { return _parents.size(); }
+
+        /* Node index corresponding to given object ID, or NoNode */
+        UnsignedInt node(UnsignedInt object) const {
+            return object < _nodes.size() ? _nodes[object] : UnsignedInt(NoNode);
+        }
+
+        /* Parent node index, always less than the node itself, or -1 */
+        Int parent(UnsignedInt node) const { return _parents[node]; }
+
+        const Matrix4& transformation(UnsignedInt node) const {
+            return _transformations[node];
+        }
+
+        /* Marks the node and everything under it for update */
+        void setTransformation(UnsignedInt node, const Matrix4& transformation);
+
+        /* Up to date only after update() */
+        const Matrix4& absoluteTransformation(UnsignedInt node) const {
+            return _absoluteTransformations[node];
+        }
+
+        /* Count of nodes that are waiting for update() */
+        std::size_t dirtyCount() const { return _dirty.size(); }
+
+        /* Recalculates absolute transformations of changed nodes and their
+           descendants, returns how many nodes were recalculated */
+        std::size_t update();
+
+    private:
+        std::vector<UnsignedInt> _nodes;
+        std::vector<Int> _parents;
+        /* One past the last descendant of each node */
+        std::vector<UnsignedInt> _subtreeEnds;
+        std::vector<Matrix4> _transformations, _absoluteTransformations;
+        /* Nodes changed since the last update(), each listed just once */
+        std::vector<UnsignedInt> _dirty;
+        std::vector<bool> _dirtyFlags;
+};
+
+}}
+
+#endif
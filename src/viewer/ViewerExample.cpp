@@ -27,25 +27,35 @@
     CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
+#include <chrono>
+#include <numeric>
+#include <vector>
 #include <Corrade/Containers/Array.h>
+#include <Corrade/Containers/ArrayViewStl.h>
 #include <Corrade/Containers/Optional.h>
 #include <Corrade/Containers/Pair.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/Containers/StridedArrayView.h>
 #include <Corrade/PluginManager/Manager.h>
 #include <Corrade/Utility/Arguments.h>
 #include <Corrade/Utility/DebugStl.h>
+#include <Corrade/Utility/Format.h>
 #include <Magnum/ImageView.h>
 #include <Magnum/Mesh.h>
 #include <Magnum/PixelFormat.h>
+#include <Magnum/GL/Buffer.h>
 #include <Magnum/GL/DefaultFramebuffer.h>
 #include <Magnum/GL/Mesh.h>
 #include <Magnum/GL/Renderer.h>
 #include <Magnum/GL/Texture.h>
 #include <Magnum/GL/TextureFormat.h>
 #include <Magnum/Math/Color.h>
+#include <Magnum/Math/Functions.h>
+#include <Magnum/Math/Range.h>
 #include <Magnum/MeshTools/Compile.h>
 #include <Magnum/Platform/Sdl2Application.h>
 #include <Magnum/SceneGraph/Camera.h>
-#include <Magnum/SceneGraph/Drawable.h>
 #include <Magnum/SceneGraph/MatrixTransformation3D.h>
 #include <Magnum/SceneGraph/Scene.h>
 #include <Magnum/Shaders/PhongGL.h>
@@ -56,6 +66,11 @@
 #include <Magnum/Trade/SceneData.h>
 #include <Magnum/Trade/TextureData.h>
 
+#include "AssetLoader.h"
+#include "Culler.h"
+#include "SceneCache.h"
+#include "TransformHierarchy.h"
+
 namespace Magnum { namespace Examples {
 
 using namespace Math::Literals;
@@ -63,6 +78,26 @@ using namespace Math::Literals;
 typedef SceneGraph::Object<SceneGraph::MatrixTransformation3D> Object3D;
 typedef SceneGraph::Scene<SceneGraph::MatrixTransformation3D> Scene3D;
 
+/* A mesh drawn at given node of the transformation hierarchy. The mesh and
+   texture are indices into slots that get filled as the assets finish
+   loading, texture is -1 for a draw with just a color. */
+struct Draw {
+    UnsignedInt node;
+    UnsignedInt mesh;
+    Int texture;
+    Color4 color;
+};
+
+/* Small triangle meshes keep their positions and indices on the CPU to be
+   used as occluders, empty for others */
+struct OccluderMesh {
+    std::vector<Vector3> positions;
+    std::vector<UnsignedInt> indices;
+};
+
+constexpr UnsignedInt MaxOccluderTriangles = 1024;
+constexpr std::size_t MaxOccludersPerFrame = 8;
+
 class ViewerExample: public Platform::Application {
     public:
         explicit ViewerExample(const Arguments& arguments);
@@ -76,6 +111,13 @@ class ViewerExample: public Platform::Application {
         void mouseScrollEvent(MouseScrollEvent& event) override;
 
         Vector3 positionOnSphere(const Vector2i& position) const;
+        void uploadFinishedAssets();
+        void loadSceneCache(Containers::StringView filename);
+        void sortDraws();
+        void setOccluderMesh(UnsignedInt id, const Containers::StridedArrayView1D<const Vector3>& positions, Containers::ArrayView<const UnsignedInt> indices);
+        void updateBounds();
+        void cullScene();
+        void drawScene();
 
         Shaders::PhongGL _coloredShader;
         Shaders::PhongGL _texturedShader{Shaders::PhongGL::Configuration{}
@@ -83,35 +125,32 @@ class ViewerExample: public Platform::Application {
         Containers::Array<Containers::Optional<GL::Mesh>> _meshes;
         Containers::Array<Containers::Optional<GL::Texture2D>> _textures;
 
+        /* Images and meshes are decoded in the background and uploaded a few
+           at a time in each frame. Texture parameters are kept until the
+           image they reference arrives. */
+        Containers::Pointer<AssetLoader> _loader;
+        Containers::Array<Containers::Optional<Trade::TextureData>> _textureData;
+        std::chrono::steady_clock::time_point _loadingBegin;
+        Double _uploadTime = 0.0;
+
         Scene3D _scene;
         Object3D _manipulator, _cameraObject;
         SceneGraph::Camera3D* _camera;
-        SceneGraph::DrawableGroup3D _drawables;
         Vector3 _previousPosition;
-};
-
-class ColoredDrawable: public SceneGraph::Drawable3D {
-    public:
-        explicit ColoredDrawable(Object3D& object, Shaders::PhongGL& shader, GL::Mesh& mesh, const Color4& color, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _shader(shader), _mesh(mesh), _color{color} {}
-
-    private:
-        void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) override;
 
-        Shaders::PhongGL& _shader;
-        GL::Mesh& _mesh;
-        Color4 _color;
-};
-
-class TexturedDrawable: public SceneGraph::Drawable3D {
-    public:
-        explicit TexturedDrawable(Object3D& object, Shaders::PhongGL& shader, GL::Mesh& mesh, GL::Texture2D& texture, SceneGraph::DrawableGroup3D& group): SceneGraph::Drawable3D{object, &group}, _shader(shader), _mesh(mesh), _texture(texture) {}
-
-    private:
-        void draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) override;
-
-        Shaders::PhongGL& _shader;
-        GL::Mesh& _mesh;
-        GL::Texture2D& _texture;
+        /* Imported objects are nodes of a flat hierarchy instead of scene
+           graph objects, with everything drawn in a single sorted list */
+        TransformHierarchy _hierarchy;
+        std::vector<Draw> _draws;
+
+        /* Only draws that pass the culling get drawn. Bounds of each mesh
+           are known once it's loaded. */
+        Culler _culler;
+        bool _culling = true, _occlusionCulling = true;
+        bool _boundsDirty = true;
+        Containers::Array<Range3D> _meshBounds;
+        Containers::Array<OccluderMesh> _occluderMeshes;
+        std::vector<UnsignedInt> _occluderCandidates, _visibleDraws;
 };
 
 ViewerExample::ViewerExample(const Arguments& arguments):
@@ -123,10 +162,19 @@ ViewerExample::ViewerExample(const Arguments& arguments):
     args.addArgument("file").setHelp("file", "file to load")
         .addOption("importer", "AnySceneImporter")
             .setHelp("importer", "importer plugin to use")
+        .addOption("threads", "0")
+            .setHelp("threads", "number of loading threads, 0 for all hardware threads", "N")
+        .addBooleanOption("no-culling")
+            .setHelp("no-culling", "draw everything, without frustum and occlusion culling")
+        .addBooleanOption("no-occlusion-culling")
+            .setHelp("no-occlusion-culling", "do just frustum culling")
         .addSkippedPrefix("magnum", "engine-specific options")
         .setGlobalHelp("Displays a 3D scene file provided on command line.")
         .parse(arguments.argc, arguments.argv);
 
+    _culling = !args.isSet("no-culling");
+    _occlusionCulling = !args.isSet("no-occlusion-culling");
+
     _cameraObject
         .setParent(&_scene)
         .translate(Vector3::zAxis(5.0f));
@@ -151,6 +199,13 @@ ViewerExample::ViewerExample(const Arguments& arguments):
         .setSpecularColor(0x111111_rgbf)
         .setShininess(80.0f);
 
+    /* A scene baked with magnum-viewer-bake is uploaded directly, without
+       any importer */
+    if(SceneCache::isSceneCache(args.value("file"))) {
+        loadSceneCache(args.value("file"));
+        return;
+    }
+
     /* Load a scene importer plugin */
     PluginManager::Manager<Trade::AbstractImporter> manager;
     Containers::Pointer<Trade::AbstractImporter> importer =
@@ -159,9 +214,19 @@ ViewerExample::ViewerExample(const Arguments& arguments):
     if(!importer || !importer->openFile(args.value("file")))
         std::exit(1);
 
-    /* Load all textures. Textures that fail to load will be NullOpt. */
+    /* Decode all images and meshes on worker threads while the rest is set
+       up here. They get uploaded a few at a time in drawEvent(). */
+    _loadingBegin = std::chrono::steady_clock::now();
+    _loader.emplace(args.value("importer"), args.value("file"),
+        importer->image2DCount(), importer->meshCount(),
+        args.value<std::size_t>("threads"));
+
+    /* Load all texture parameters, the textures themselves get created once
+       their image is decoded. Textures that fail to load will be NullOpt. */
     _textures = Containers::Array<Containers::Optional<GL::Texture2D>>{
         importer->textureCount()};
+    _textureData = Containers::Array<Containers::Optional<Trade::TextureData>>{
+        importer->textureCount()};
     for(UnsignedInt i = 0; i != importer->textureCount(); ++i) {
         Containers::Optional<Trade::TextureData> textureData =
             importer->texture(i);
@@ -171,23 +236,7 @@ ViewerExample::ViewerExample(const Arguments& arguments):
             continue;
         }
 
-        Containers::Optional<Trade::ImageData2D> imageData =
-            importer->image2D(textureData->image());
-        if(!imageData || !imageData->isCompressed()) {
-            Warning{} << "Cannot load image" << textureData->image()
-                << importer->image2DName(textureData->image());
-            continue;
-        }
-
-        (*(_textures[i] = GL::Texture2D{}))
-            .setMagnificationFilter(textureData->magnificationFilter())
-            .setMinificationFilter(textureData->minificationFilter(),
-                                   textureData->mipmapFilter())
-            .setWrapping(textureData->wrapping().xy())
-            .setStorage(Math::log2(imageData->size().max()) + 1,
-                GL::textureFormat(imageData->format()), imageData->size())
-            .setSubImage(0, {}, *imageData)
-            .generateMipmap();
+        _textureData[i] = std::move(textureData);
     }
 
     /* Load all materials. Materials that fail to load will be NullOpt. Only a
@@ -206,29 +255,20 @@ ViewerExample::ViewerExample(const Arguments& arguments):
         materials[i] = std::move(*materialData).as<Trade::PhongMaterialData>();
     }
 
-    /* Load all meshes. Meshes that fail to load will be NullOpt. Generate
-       normals if not present. */
+    /* Meshes get filled in as they finish loading. Meshes that fail to load
+       will stay NullOpt. */
     _meshes = Containers::Array<Containers::Optional<GL::Mesh>>{
         importer->meshCount()};
-    for(UnsignedInt i = 0; i != importer->meshCount(); ++i) {
-        Containers::Optional<Trade::MeshData> meshData;
-        if(!(meshData = importer->mesh(i))) {
-            Warning{} << "Cannot load mesh" << i << importer->meshName(i);
-            continue;
-        }
-
-        MeshTools::CompileFlags flags;
-        if(!meshData->hasAttribute(Trade::MeshAttribute::Normal))
-            flags |= MeshTools::CompileFlag::GenerateFlatNormals;
-        _meshes[i] = MeshTools::compile(*meshData, flags);
-    }
+    _meshBounds = Containers::Array<Range3D>{importer->meshCount()};
+    _occluderMeshes = Containers::Array<OccluderMesh>{importer->meshCount()};
 
     /* The format has no scene support, display just the first loaded mesh with
        a default material (if it's there) and be done with it. */
     if(importer->defaultScene() == -1) {
-        if(!_meshes.isEmpty() && _meshes[0])
-            new ColoredDrawable{_manipulator, _coloredShader, *_meshes[0],
-                0xffffff_rgbf, _drawables};
+        if(!_meshes.isEmpty()) {
+            _hierarchy = TransformHierarchy{std::vector<Int>{-1}};
+            _draws.push_back(Draw{0, 0, -1, 0xffffff_rgbf});
+        }
         return;
     }
 
@@ -243,17 +283,13 @@ ViewerExample::ViewerExample(const Arguments& arguments):
             << importer->sceneName(importer->defaultScene());
     }
 
-    /* Allocate objects that are part of the hierarchy */
-    Containers::Array<Object3D*> objects{std::size_t(scene->mappingBound())};
-    Containers::Array<Containers::Pair<UnsignedInt, Int>> parents
-        = scene->parentsAsArray();
-    for(const Containers::Pair<UnsignedInt, Int>& parent: parents)
-        objects[parent.first()] = new Object3D{};
-
-    /* Assign parent references */
-    for(const Containers::Pair<UnsignedInt, Int>& parent: parents)
-        objects[parent.first()]->setParent(parent.second() == -1 ?
-            &_manipulator : objects[parent.second()]);
+    /* Build the hierarchy from objects that have a parent. Objects that
+       aren't a part of it are marked with -2. */
+    std::vector<Int> parents(std::size_t(scene->mappingBound()), -2);
+    for(const Containers::Pair<UnsignedInt, Int>& parent:
+        scene->parentsAsArray())
+        parents[parent.first()] = parent.second();
+    _hierarchy = TransformHierarchy{parents};
 
     /* Set transformations. Objects that are not part of the hierarchy are
        ignored, objects that have no transformation entry retain an identity
@@ -261,75 +297,341 @@ ViewerExample::ViewerExample(const Arguments& arguments):
     for(const Containers::Pair<UnsignedInt, Matrix4>& transformation:
         scene->transformations3DAsArray())
     {
-        if(Object3D* object = objects[transformation.first()])
-            object->setTransformation(transformation.second());
+        const UnsignedInt node = _hierarchy.node(transformation.first());
+        if(node != TransformHierarchy::NoNode)
+            _hierarchy.setTransformation(node, transformation.second());
     }
 
-    /* Add drawables for objects that have a mesh, again ignoring objects that
+    /* Add draws for objects that have a mesh, again ignoring objects that
        are not part of the hierarchy. There can be multiple mesh assignments
-       for one object, simply add one drawable for each. */
+       for one object, simply add one draw for each. */
     for(const Containers::Pair<UnsignedInt, Containers::Pair<UnsignedInt, Int>>&
         meshMaterial: scene->meshesMaterialsAsArray())
     {
-        Object3D* object = objects[meshMaterial.first()];
-        Containers::Optional<GL::Mesh>& mesh =
-            _meshes[meshMaterial.second().first()];
-        if(!object || !mesh) continue;
-
-        Int materialId = meshMaterial.second().second();
-
-        /* Material not available / not loaded, use a default material */
-        if(materialId == -1 || !materials[materialId]) {
-            new ColoredDrawable{*object, _coloredShader, *mesh, 0xffffff_rgbf,
-                _drawables};
-
-        /* Textured material, if the texture loaded correctly */
-        } else if(materials[materialId]->hasAttribute(
-                Trade::MaterialAttribute::DiffuseTexture
-            ) && _textures[materials[materialId]->diffuseTexture()])
-        {
-            new TexturedDrawable{*object, _texturedShader, *mesh,
-                *_textures[materials[materialId]->diffuseTexture()],
-                _drawables};
-
-        /* Color-only material */
-        } else {
-            new ColoredDrawable{*object, _coloredShader, *mesh,
-                materials[materialId]->diffuseColor(), _drawables};
+        const UnsignedInt node = _hierarchy.node(meshMaterial.first());
+        if(node == TransformHierarchy::NoNode) continue;
+
+        /* A default white if the material is not available / not loaded */
+        Draw draw{node, meshMaterial.second().first(), -1, 0xffffff_rgbf};
+        const Int materialId = meshMaterial.second().second();
+        if(materialId != -1 && materials[materialId]) {
+            /* Textured material, if the texture parameters loaded
+               correctly */
+            if(materials[materialId]->hasAttribute(
+                    Trade::MaterialAttribute::DiffuseTexture
+                ) && _textureData[materials[materialId]->diffuseTexture()])
+                draw.texture = Int(materials[materialId]->diffuseTexture());
+
+            /* Color-only material */
+            else draw.color = materials[materialId]->diffuseColor();
         }
+
+        _draws.push_back(draw);
     }
+
+    sortDraws();
 }
 
-void ColoredDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) {
-    _shader
-        .setDiffuseColor(_color)
-        .setLightPositions({
-            {camera.cameraMatrix().transformPoint({-3.0f, 10.0f, 10.0f}), 0.0f}
-        })
-        .setTransformationMatrix(transformationMatrix)
-        .setNormalMatrix(transformationMatrix.normalMatrix())
-        .setProjectionMatrix(camera.projectionMatrix())
-        .draw(_mesh);
+void ViewerExample::loadSceneCache(const Containers::StringView filename) {
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    Containers::Optional<SceneCache> cache = SceneCache::open(filename);
+    if(!cache) std::exit(1);
+
+    /* Vertex and index data are in the layout the shaders expect, straight
+       from the mapped file */
+    _meshes = Containers::Array<Containers::Optional<GL::Mesh>>{
+        cache->meshes().size()};
+    _meshBounds = Containers::Array<Range3D>{cache->meshes().size()};
+    _occluderMeshes = Containers::Array<OccluderMesh>{cache->meshes().size()};
+    for(std::size_t i = 0; i != cache->meshes().size(); ++i) {
+        const SceneCacheMesh& mesh = cache->meshes()[i];
+        if(!mesh.vertexCount) continue;
+
+        _meshBounds[i] = mesh.bounds;
+        if(MeshPrimitive(mesh.primitive) == MeshPrimitive::Triangles &&
+           (mesh.indexCount ? mesh.indexCount : mesh.vertexCount) <= 3*MaxOccluderTriangles)
+        {
+            const auto vertices = Containers::arrayCast<const SceneCacheVertex>(
+                cache->data(mesh.vertexOffset, mesh.vertexCount*sizeof(SceneCacheVertex)));
+            setOccluderMesh(UnsignedInt(i),
+                Containers::StridedArrayView1D<const Vector3>{vertices,
+                    &vertices[0].position, vertices.size(), sizeof(SceneCacheVertex)},
+                Containers::arrayCast<const UnsignedInt>(
+                    cache->data(mesh.indexOffset, mesh.indexCount*sizeof(UnsignedInt))));
+        }
+
+        GL::Buffer vertices{GL::Buffer::TargetHint::Array};
+        vertices.setData(cache->data(mesh.vertexOffset,
+            mesh.vertexCount*sizeof(SceneCacheVertex)));
+        (*(_meshes[i] = GL::Mesh{MeshPrimitive(mesh.primitive)}))
+            .addVertexBuffer(std::move(vertices), 0,
+                Shaders::PhongGL::Position{},
+                Shaders::PhongGL::Normal{},
+                Shaders::PhongGL::TextureCoordinates{})
+            .setCount(mesh.indexCount ? mesh.indexCount : mesh.vertexCount);
+        if(mesh.indexCount) {
+            GL::Buffer indices{GL::Buffer::TargetHint::ElementArray};
+            indices.setData(cache->data(mesh.indexOffset,
+                mesh.indexCount*sizeof(UnsignedInt)));
+            _meshes[i]->setIndexBuffer(std::move(indices), 0,
+                MeshIndexType::UnsignedInt);
+        }
+    }
+
+    /* Images have all their mip levels already */
+    _textures = Containers::Array<Containers::Optional<GL::Texture2D>>{
+        cache->textures().size()};
+    for(std::size_t i = 0; i != cache->textures().size(); ++i) {
+        const SceneCacheTexture& texture = cache->textures()[i];
+        if(texture.image == ~UnsignedInt{} ||
+           !cache->images()[texture.image].levelCount) continue;
+
+        const SceneCacheImage& image = cache->images()[texture.image];
+        const PixelFormat format = PixelFormat(image.format);
+        const SceneCacheImageLevel& base = cache->levels()[image.firstLevel];
+        (*(_textures[i] = GL::Texture2D{}))
+            .setMagnificationFilter(SamplerFilter(texture.magnificationFilter))
+            .setMinificationFilter(SamplerFilter(texture.minificationFilter),
+                                   SamplerMipmap(texture.mipmapFilter))
+            .setWrapping(Math::Vector2<SamplerWrapping>{
+                SamplerWrapping(texture.wrapping[0]),
+                SamplerWrapping(texture.wrapping[1])})
+            .setStorage(Math::log2(base.size.max()) + 1,
+                GL::textureFormat(format), base.size);
+        for(UnsignedInt level = 0; level != image.levelCount; ++level) {
+            const SceneCacheImageLevel& levelData = cache->levels()[image.firstLevel + level];
+            _textures[i]->setSubImage(Int(level), {}, ImageView2D{
+                PixelStorage{}.setAlignment(1), format, levelData.size,
+                cache->data(levelData.dataOffset, levelData.dataSize)});
+        }
+        if(image.levelCount == 1) _textures[i]->generateMipmap();
+    }
+
+    /* The hierarchy is flattened already, each drawable is a root node with
+       its absolute transformation */
+    _hierarchy = TransformHierarchy{
+        std::vector<Int>(cache->drawables().size(), -1)};
+    for(std::size_t i = 0; i != cache->drawables().size(); ++i) {
+        const SceneCacheDrawable& drawable = cache->drawables()[i];
+        _hierarchy.setTransformation(UnsignedInt(i), drawable.transformation);
+        _draws.push_back(Draw{UnsignedInt(i), drawable.mesh, drawable.texture,
+            drawable.color});
+    }
+    sortDraws();
+
+    Debug{} << "Loaded" << filename << "in"
+        << std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count()
+        << "seconds";
 }
 
-void TexturedDrawable::draw(const Matrix4& transformationMatrix, SceneGraph::Camera3D& camera) {
-    _shader
-        .setLightPositions({
-            {camera.cameraMatrix().transformPoint({-3.0f, 10.0f, 10.0f}), 0.0f}
-        })
-        .setTransformationMatrix(transformationMatrix)
-        .setNormalMatrix(transformationMatrix.normalMatrix())
-        .setProjectionMatrix(camera.projectionMatrix())
-        .bindDiffuseTexture(_texture)
-        .draw(_mesh);
+void ViewerExample::sortDraws() {
+    /* Colored draws first, then grouped by texture, and by mesh in each
+       group, so each texture is bound just once */
+    std::sort(_draws.begin(), _draws.end(), [](const Draw& a, const Draw& b) {
+        return a.texture != b.texture ? a.texture < b.texture : a.mesh < b.mesh;
+    });
 }
 
 void ViewerExample::drawEvent() {
     GL::defaultFramebuffer.clear(GL::FramebufferClear::Color|GL::FramebufferClear::Depth);
 
-    _camera->draw(_drawables);
+    if(_loader) uploadFinishedAssets();
+
+    /* Only nodes that changed since the last frame get recalculated */
+    if(_hierarchy.update()) _boundsDirty = true;
+    cullScene();
+    drawScene();
 
     swapBuffers();
+
+    /* Keep drawing while there's something left to upload */
+    if(_loader) redraw();
+}
+
+void ViewerExample::setOccluderMesh(const UnsignedInt id, const Containers::StridedArrayView1D<const Vector3>& positions, const Containers::ArrayView<const UnsignedInt> indices) {
+    OccluderMesh& occluder = _occluderMeshes[id];
+    occluder.positions.assign(positions.begin(), positions.end());
+    if(indices.isEmpty()) {
+        occluder.indices.resize(positions.size());
+        std::iota(occluder.indices.begin(), occluder.indices.end(), 0u);
+    } else occluder.indices.assign(indices.begin(), indices.end());
+}
+
+void ViewerExample::updateBounds() {
+    /* Bounding sphere of each draw in the hierarchy space, scaled by the
+       largest axis scale of the node. Meshes that aren't loaded yet have
+       empty bounds, but those aren't drawn anyway. */
+    _culler.setSphereCount(_draws.size());
+    _occluderCandidates.clear();
+    for(std::size_t i = 0; i != _draws.size(); ++i) {
+        const Draw& draw = _draws[i];
+        const Range3D& bounds = _meshBounds[draw.mesh];
+        const Matrix4& transformation = _hierarchy.absoluteTransformation(draw.node);
+        const Float scale = Math::sqrt(Math::max({
+            transformation[0].xyz().dot(),
+            transformation[1].xyz().dot(),
+            transformation[2].xyz().dot()}));
+        _culler.setSphere(i, transformation.transformPoint(bounds.center()),
+            0.5f*bounds.size().length()*scale);
+
+        if(!_occluderMeshes[draw.mesh].indices.empty())
+            _occluderCandidates.push_back(UnsignedInt(i));
+    }
+}
+
+void ViewerExample::cullScene() {
+    if(!_culling) {
+        _visibleDraws.resize(_draws.size());
+        std::iota(_visibleDraws.begin(), _visibleDraws.end(), 0u);
+        return;
+    }
+
+    /* Bounding spheres follow the nodes, so they need updating only when a
+       node or a mesh changes */
+    if(_boundsDirty) {
+        updateBounds();
+        _boundsDirty = false;
+    }
+
+    const Matrix4 view = _camera->cameraMatrix()*_manipulator.transformation();
+
+    /* The occluders are the candidates that appear the largest from the
+       camera, with anything the camera is inside of first */
+    if(_occlusionCulling && !_occluderCandidates.empty()) {
+        const Vector3 cameraPosition = view.inverted().translation();
+        const auto apparentSize = [&](UnsignedInt id) {
+            const Draw& draw = _draws[id];
+            const Matrix4& transformation = _hierarchy.absoluteTransformation(draw.node);
+            const Range3D& bounds = _meshBounds[draw.mesh];
+            const Float distance = (transformation.transformPoint(bounds.center()) - cameraPosition).length();
+            const Float radius = 0.5f*bounds.size().length();
+            return distance > radius ? radius/distance : 1.0f;
+        };
+        const std::size_t occluderCount = Math::min(_occluderCandidates.size(), MaxOccludersPerFrame);
+        std::partial_sort(_occluderCandidates.begin(),
+            _occluderCandidates.begin() + occluderCount, _occluderCandidates.end(),
+            [&](UnsignedInt a, UnsignedInt b) {
+                return apparentSize(a) > apparentSize(b);
+            });
+        for(std::size_t i = 0; i != occluderCount; ++i) {
+            const Draw& draw = _draws[_occluderCandidates[i]];
+            const OccluderMesh& occluder = _occluderMeshes[draw.mesh];
+            _culler.addOccluder(_hierarchy.absoluteTransformation(draw.node),
+                occluder.positions, occluder.indices);
+        }
+    }
+
+    _culler.cull(_camera->projectionMatrix()*view, _visibleDraws);
+}
+
+void ViewerExample::drawScene() {
+    /* The manipulator rotates the whole scene without touching any node,
+       the light stays fixed relative to the camera */
+    const Matrix4 view = _camera->cameraMatrix()*_manipulator.transformation();
+    const Vector4 light{_camera->cameraMatrix().transformPoint({-3.0f, 10.0f, 10.0f}), 0.0f};
+    for(Shaders::PhongGL* shader: {&_coloredShader, &_texturedShader})
+        shader->setLightPositions({light})
+            .setProjectionMatrix(_camera->projectionMatrix());
+
+    Int boundTexture = -1;
+    for(const UnsignedInt id: _visibleDraws) {
+        const Draw& draw = _draws[id];
+        if(!_meshes[draw.mesh]) continue;
+
+        /* Neutral gray until the texture is loaded */
+        Shaders::PhongGL* shader = &_coloredShader;
+        if(draw.texture == -1)
+            _coloredShader.setDiffuseColor(draw.color);
+        else if(!_textures[draw.texture])
+            _coloredShader.setDiffuseColor(0x7f7f7f_rgbf);
+        else {
+            if(draw.texture != boundTexture) {
+                _texturedShader.bindDiffuseTexture(*_textures[draw.texture]);
+                boundTexture = draw.texture;
+            }
+            shader = &_texturedShader;
+        }
+
+        const Matrix4 transformation = view*_hierarchy.absoluteTransformation(draw.node);
+        shader->setTransformationMatrix(transformation)
+            .setNormalMatrix(transformation.normalMatrix())
+            .draw(*_meshes[draw.mesh]);
+    }
+}
+
+void ViewerExample::uploadFinishedAssets() {
+    /* Upload whatever finished decoding since the last frame, but stop once
+       the frame time budget is exceeded so the app stays responsive */
+    constexpr Double UploadBudget = 0.004;
+    const std::chrono::steady_clock::time_point begin = std::chrono::steady_clock::now();
+    const auto secondsSince = [](std::chrono::steady_clock::time_point since) {
+        return std::chrono::duration<Double>(std::chrono::steady_clock::now() - since).count();
+    };
+    while(secondsSince(begin) < UploadBudget) {
+        Containers::Optional<AssetLoader::Asset> asset = _loader->takeFinished();
+        if(!asset) break;
+
+        if(asset->type == AssetLoader::AssetType::Mesh) {
+            if(!asset->mesh) {
+                Warning{} << "Cannot load mesh" << asset->id;
+                continue;
+            }
+
+            const Trade::MeshData& mesh = *asset->mesh;
+            _meshes[asset->id] = MeshTools::compile(mesh);
+            _meshBounds[asset->id] = asset->bounds;
+            if(mesh.primitive() == MeshPrimitive::Triangles &&
+               mesh.hasAttribute(Trade::MeshAttribute::Position) &&
+               (mesh.isIndexed() ? mesh.indexCount() : mesh.vertexCount()) <= 3*MaxOccluderTriangles)
+            {
+                const Containers::Array<Vector3> positions = mesh.positions3DAsArray();
+                const Containers::Array<UnsignedInt> indices = mesh.isIndexed() ?
+                    mesh.indicesAsArray() : Containers::Array<UnsignedInt>{};
+                setOccluderMesh(asset->id, Containers::arrayView(positions), indices);
+            }
+            _boundsDirty = true;
+            continue;
+        }
+
+        /* Create all textures that use this image */
+        const std::vector<Trade::ImageData2D>& levels = asset->imageLevels;
+        for(std::size_t i = 0; i != _textureData.size(); ++i) {
+            const Containers::Optional<Trade::TextureData>& textureData = _textureData[i];
+            if(!textureData || textureData->image() != asset->id) continue;
+
+            if(levels.empty()) {
+                Warning{} << "Cannot load image" << asset->id;
+                break;
+            }
+
+            (*(_textures[i] = GL::Texture2D{}))
+                .setMagnificationFilter(textureData->magnificationFilter())
+                .setMinificationFilter(textureData->minificationFilter(),
+                                       textureData->mipmapFilter())
+                .setWrapping(textureData->wrapping().xy())
+                .setStorage(Math::log2(levels[0].size().max()) + 1,
+                    GL::textureFormat(levels[0].format()), levels[0].size());
+            for(std::size_t level = 0; level != levels.size(); ++level)
+                _textures[i]->setSubImage(Int(level), {}, levels[level]);
+
+            /* The loader couldn't downsample this format */
+            if(levels.size() == 1) _textures[i]->generateMipmap();
+        }
+    }
+    _uploadTime += secondsSince(begin);
+
+    if(!_loader->isFinished()) {
+        setWindowTitle(Utility::format("Magnum Viewer Example ({}/{})",
+            _loader->takenCount(), _loader->assetCount()));
+        return;
+    }
+
+    Debug{} << "Loaded" << _loader->assetCount() << "assets on"
+        << _loader->threadCount() << "threads in"
+        << secondsSince(_loadingBegin) << "seconds," << _uploadTime
+        << "seconds of that uploading";
+    setWindowTitle("Magnum Viewer Example");
+    _loader = nullptr;
 }
 
 void ViewerExample::viewportEvent(ViewportEvent& event) {
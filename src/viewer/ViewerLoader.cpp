@@ -0,0 +1,91 @@
+/*
+    This file is part of Magnum.
+
+    Original authors — credit is appreciated but not required:
+
+        2010, 2011, 2012, 2013, 2014, 2015, 2016, 2017, 2018, 2019,
+        2020, 2021, 2022, 2023 — Vladimír Vondruš <mosra@centrum.cz>
+
+    This is free and unencumbered software released into the public domain.
+
+    Anyone is free to copy, modify, publish, use, compile, sell, or distribute
+    this software, either in source code form or as a compiled binary, for any
+    purpose, commercial or non-commercial, and by any means.
+
+    In jurisdictions that recognize copyright laws, the author or authors of
+    this software dedicate any and all copyright interest in the software to
+    the public domain. We make this dedication for the benefit of the public
+    at large and to the detriment of our heirs and successors. We intend this
+    dedication to be an overt act of relinquishment in perpetuity of all
+    present and future rights to this software under copyright law.
+
+    THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+    IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+    FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL
+    THE AUTHORS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+    IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+    CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <chrono>
+#include <Corrade/Containers/Optional.h>
+#include <Corrade/Containers/Pointer.h>
+#include <Corrade/PluginManager/Manager.h>
+#include <Corrade/Utility/Arguments.h>
+#include <Corrade/Utility/Debug.h>
+#include <Corrade/Utility/Format.h>
+#include <Magnum/Trade/AbstractImporter.h>
+
+#include "AssetLoader.h"
+
+using namespace Magnum;
+using namespace Magnum::Examples;
+
+/* Runs the background loading of the viewer without a window or GPU and
+   prints how long each image and mesh took to decode and preprocess, in the
+   order they finished. Comparing --threads 1 with more shows how well the
+   loading scales for given file. */
+int main(int argc, char** argv) {
+    Utility::Arguments args;
+    args.addArgument("file").setHelp("file", "file to load")
+        .addOption("importer", "AnySceneImporter")
+            .setHelp("importer", "importer plugin to use")
+        .addOption("threads", "0")
+            .setHelp("threads", "number of loading threads, 0 for all hardware threads", "N")
+        .setGlobalHelp("Measures loading of a 3D scene file as done by the viewer, headless.")
+        .parse(argc, argv);
+
+    /* The asset counts come from a separate importer, same as in the viewer */
+    PluginManager::Manager<Trade::AbstractImporter> manager;
+    Containers::Pointer<Trade::AbstractImporter> importer =
+        manager.loadAndInstantiate(args.value("importer"));
+    if(!importer || !importer->openFile(args.value("file")))
+        return 1;
+
+    const auto begin = std::chrono::steady_clock::now();
+    AssetLoader loader{args.value("importer"), args.value("file"),
+        importer->image2DCount(), importer->meshCount(),
+        args.value<std::size_t>("threads")};
+
+    Double decodeTime{}, preprocessTime{};
+    std::size_t failed = 0;
+    while(Containers::Optional<AssetLoader::Asset> asset = loader.waitFinished()) {
+        const bool image = asset->type == AssetLoader::AssetType::Image;
+        const bool loaded = image ? !asset->imageLevels.empty() : !!asset->mesh;
+        if(!loaded) ++failed;
+        decodeTime += asset->decodeTime;
+        preprocessTime += asset->preprocessTime;
+
+        Utility::print("{}/{} {} {}: decode {} ms, preprocess {} ms{}\n",
+            loader.takenCount(), loader.assetCount(),
+            image ? "image" : "mesh", asset->id,
+            asset->decodeTime*1000.0, asset->preprocessTime*1000.0,
+            loaded ? "" : ", failed");
+    }
+    const Double wallTime = std::chrono::duration<Double>(std::chrono::steady_clock::now() - begin).count();
+
+    Utility::print("{} assets ({} failed) on {} threads in {} ms, {} ms decoding and {} ms preprocessing in total\n",
+        loader.assetCount(), failed, loader.threadCount(), wallTime*1000.0,
+        decodeTime*1000.0, preprocessTime*1000.0);
+    return failed ? 2 : 0;
+}